@@ -0,0 +1,100 @@
+#ifndef RF_BASELINE_DECODER_H
+#define RF_BASELINE_DECODER_H
+
+#include <stdint.h>
+#include <string.h>
+#include "rf_decoder.h"
+#include "rf_protocol.h"
+
+/**
+ * The buffered decoder RfDecoder replaced, kept only as the benchmark's
+ * baseline. A frame's timings are buffered until the second separation gap
+ * of matching length, then ReceiveProtocol() walks them again for every
+ * protocol in turn until one matches (the rc-switch retry loop). Codes of
+ * up to 32 bits; the frame is reported on that second gap.
+ */
+class RfBaselineDecoder {
+public:
+    static constexpr unsigned int kMaxChanges = 67;
+
+    RfBaselineDecoder(const RfProtocol* protocols, unsigned int protocol_count)
+        : protocols_(protocols), protocol_count_(protocol_count), receive_tolerance_(60) {
+        Reset();
+    }
+
+    void Reset() {
+        last_time_ = 0;
+        change_count_ = 0;
+        repeat_count_ = 0;
+        memset(timings_, 0, sizeof(timings_));
+    }
+
+    bool ProcessEdge(uint32_t timestamp, RfDecodedFrame& frame) {
+        bool decoded = false;
+        const unsigned int duration = timestamp - last_time_;
+        if (duration > RfDecoder::kSeparationLimit) {
+            if (repeat_count_ == 0 || Diff(duration, timings_[0]) < 200) {
+                repeat_count_++;
+                if (repeat_count_ == 2) {
+                    for (unsigned int i = 1; i <= protocol_count_; i++) {
+                        if (ReceiveProtocol(i, change_count_, frame)) {
+                            frame.timestamp = timestamp;
+                            decoded = true;
+                            break;
+                        }
+                    }
+                    repeat_count_ = 0;
+                }
+            }
+            change_count_ = 0;
+        }
+        if (change_count_ >= kMaxChanges) {
+            change_count_ = 0;
+            repeat_count_ = 0;
+        }
+        timings_[change_count_++] = duration;
+        last_time_ = timestamp;
+        return decoded;
+    }
+
+private:
+    static unsigned int Diff(int a, int b) { return a > b ? a - b : b - a; }
+
+    bool ReceiveProtocol(unsigned int p, unsigned int change_count, RfDecodedFrame& frame) const {
+        if (p < 1 || p > protocol_count_ || change_count <= 7) {
+            return false;
+        }
+        const RfProtocol& pro = protocols_[p - 1];
+        uint64_t code = 0;
+        const unsigned int sync_length = pro.syncFactor.low > pro.syncFactor.high ? pro.syncFactor.low : pro.syncFactor.high;
+        const unsigned int delay = timings_[0] / sync_length;
+        const unsigned int tolerance = delay * receive_tolerance_ / 100;
+        const unsigned int first_data_timing = pro.invertedSignal ? 2 : 1;
+        for (unsigned int i = first_data_timing; i < change_count - 1; i += 2) {
+            code <<= 1;
+            if (Diff(timings_[i], delay * pro.zero.high) < tolerance && Diff(timings_[i + 1], delay * pro.zero.low) < tolerance) {
+                // Zero bit
+            } else if (Diff(timings_[i], delay * pro.one.high) < tolerance &&
+                       Diff(timings_[i + 1], delay * pro.one.low) < tolerance) {
+                code |= 1;
+            } else {
+                return false;
+            }
+        }
+        frame.value = code;
+        frame.bitlength = (change_count - 1) / 2;
+        frame.delay = delay;
+        frame.protocol = p;
+        return true;
+    }
+
+    const RfProtocol* protocols_;
+    unsigned int protocol_count_;
+    int receive_tolerance_;
+    uint32_t last_time_;
+    unsigned int change_count_;
+    unsigned int repeat_count_;
+    unsigned int timings_[kMaxChanges];
+};
+
+#endif // RF_BASELINE_DECODER_H
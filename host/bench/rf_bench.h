@@ -0,0 +1,50 @@
+#ifndef RF_BENCH_H
+#define RF_BENCH_H
+
+#include <stdint.h>
+#include <chrono>
+
+/**
+ * Timing helpers for the host benchmarks in this directory. They are
+ * built with the host library (RelWithDebInfo, i.e. -O2, unless
+ * CMAKE_BUILD_TYPE says otherwise) but not run by ctest: run them by hand
+ * on an idle machine and compare figures from the same build only.
+ */
+
+// Nanoseconds taken by the fastest of `runs` calls to `body`
+template <typename Body>
+double RfBenchBest(int runs, Body body) {
+    double best = 0;
+    for (int run = 0; run < runs; run++) {
+        const auto start = std::chrono::steady_clock::now();
+        body();
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (run == 0 || ns < best) {
+            best = ns;
+        }
+    }
+    return best;
+}
+
+// Keeps results alive so the compiler cannot drop the work that produced them
+inline void RfBenchKeep(uint64_t value) {
+    static volatile uint64_t sink;
+    sink = sink + value;
+}
+
+// Deterministic pseudo-random numbers (xorshift64), so every run sees the same input
+class RfBenchRandom {
+public:
+    explicit RfBenchRandom(uint64_t seed) : state_(seed ? seed : 1) {}
+    uint64_t Next() {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return state_;
+    }
+
+private:
+    uint64_t state_;
+};
+
+#endif // RF_BENCH_H
@@ -0,0 +1,115 @@
+// RfDecoder throughput on encoder-generated edge streams, against the
+// buffered per-protocol decoder it replaced (rf_baseline_decoder.h). Both
+// try protocols 1-5, as the old receive path did. Each press is 8 frames
+// exactly as RfRadioChannel sends them (RfPulseEncoder::AddFrame), after
+// 50 ms of idle. The corrupted stream has the same frames with every pulse
+// stretched or shrunk by 35-60%, so no protocol accepts any of them; its
+// gaps rarely repeat within 200 us either, so the baseline seldom gets as
+// far as matching protocols. frames/s counts the frames fed in, whatever
+// was reported. Best of 5 runs over 1000 presses.
+
+#include <stdio.h>
+#include <vector>
+#include "rf_baseline_decoder.h"
+#include "rf_bench.h"
+#include "rf_decoder.h"
+#include "rf_pulse_encoder.h"
+
+static const int kPresses = 1000;
+static const int kRepeats = 8;
+
+struct Stream {
+    std::vector<RfEdge> edges;
+    size_t frames = 0;
+};
+
+// Appends one press; `distort` scales every pulse of it
+template <typename Distort>
+static void AddPress(Stream& stream, const RfProtocol& protocol, uint64_t code, unsigned int bits, uint32_t& time,
+                     Distort distort) {
+    std::vector<RfSymbol> symbols(kRepeats * RfPulseEncoder::SymbolsPerFrame(bits) + 1);
+    RfPulseEncoder encoder(symbols.data(), symbols.size());
+    for (int repeat = 0; repeat < kRepeats; repeat++) {
+        encoder.AddFrame(protocol, code, bits);
+    }
+    encoder.Finish();
+    time += 50000;
+    for (size_t i = 0; i < encoder.Size(); i++) {
+        const RfSymbol& symbol = encoder.Data()[i];
+        const uint32_t halves[2][2] = { { symbol.duration0, symbol.level0 }, { symbol.duration1, symbol.level1 } };
+        for (const auto& half : halves) {
+            if (half[0] == 0) {
+                continue;
+            }
+            stream.edges.push_back({ time, static_cast<uint8_t>(half[1]) });
+            time += distort(half[0]);
+        }
+    }
+    stream.edges.push_back({ time, static_cast<uint8_t>(protocol.invertedSignal ? 1 : 0) });  // Back to idle
+    stream.frames += kRepeats;
+}
+
+static bool Process(RfDecoder& decoder, const RfEdge& edge, RfDecodedFrame& frame) {
+    return decoder.ProcessEdge(edge.timestamp, edge.level, frame);
+}
+
+static bool Process(RfBaselineDecoder& decoder, const RfEdge& edge, RfDecodedFrame& frame) {
+    return decoder.ProcessEdge(edge.timestamp, frame);  // Timings only, no levels
+}
+
+template <typename Decoder>
+static size_t Feed(Decoder& decoder, const Stream& stream) {
+    decoder.Reset();
+    RfDecodedFrame frame;
+    size_t reported = 0;
+    for (const RfEdge& edge : stream.edges) {
+        reported += Process(decoder, edge, frame) ? 1 : 0;
+    }
+    return reported;
+}
+
+int main() {
+    RfProtocolRegistry& registry = RfProtocolRegistry::GetInstance();
+    static const unsigned int kProtocols = 5;
+    RfProtocol protocols[kProtocols];
+    for (unsigned int number = 1; number <= kProtocols; number++) {
+        registry.Get(number, protocols[number - 1]);
+    }
+    RfBaselineDecoder baseline(protocols, kProtocols);
+    RfDecoder decoder(registry, (1UL << kProtocols) - 1);
+    printf("Decoders, %d presses of %d frames, best of 5 runs\n", kPresses, kRepeats);
+    printf("  stream        decoder      frames/s    Medges/s   reported\n");
+    for (unsigned int number : { 1u, 3u, 5u, 0u }) {
+        const bool corrupted = number == 0;
+        RfProtocol protocol;
+        registry.Get(corrupted ? 1 : number, protocol);
+        Stream stream;
+        RfBenchRandom random(number + 1);
+        uint32_t time = 0;
+        for (int press = 0; press < kPresses; press++) {
+            const unsigned int bits = press % 2 ? 32 : 24;
+            const uint64_t code = random.Next() & ((1ULL << bits) - 1);
+            AddPress(stream, protocol, code, bits, time, [&](uint32_t us) -> uint32_t {
+                if (!corrupted) {
+                    return us;
+                }
+                const uint32_t percent = 35 + random.Next() % 26;
+                return random.Next() & 1 ? us + us * percent / 100 : us - us * percent / 100;
+            });
+        }
+        char name[32];
+        if (corrupted) {
+            snprintf(name, sizeof(name), "corrupted");
+        } else {
+            snprintf(name, sizeof(name), "protocol %u", number);
+        }
+        size_t reported = 0;
+        double ns = RfBenchBest(5, [&]() { reported = Feed(baseline, stream); });
+        printf("  %-13s %-9s %10.2fM  %10.1f   %8zu\n", name, "baseline", stream.frames / ns * 1e3,
+               stream.edges.size() / ns * 1e3, reported);
+        ns = RfBenchBest(5, [&]() { reported = Feed(decoder, stream); });
+        printf("  %-13s %-9s %10.2fM  %10.1f   %8zu\n", "", "RfDecoder", stream.frames / ns * 1e3,
+               stream.edges.size() / ns * 1e3, reported);
+    }
+    return 0;
+}
@@ -0,0 +1,222 @@
+// Flash cost of stored signals, counted on the host NVS (RfHost::NvsCounters()).
+//
+// Layouts: the original one (six keys per signal plus count/index/has_signal
+// metadata) against one RfSignalRecord blob per signal, for saving one signal,
+// reading one and listing all N; list CPU time is the best of 5 runs.
+// Then RFModule as built: 10 codes received over a loopback and saved, with a
+// Flush() after each save or only at the end, when the persist task batches
+// what arrives within its commit window. The manual clock makes the time
+// between saves the transmit time, so the batches are the same on every run.
+
+#include <esp_log.h>
+#include <nvs.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "rf_bench.h"
+#include "rf_host.h"
+#include "rf_module.h"
+
+// Original layout: strings with a size probe and a heap copy each, as the original firmware read them
+static std::string ReadString(nvs_handle_t nvs, const char* key) {
+    size_t size = 0;
+    if (nvs_get_str(nvs, key, nullptr, &size) != ESP_OK) {
+        return std::string();
+    }
+    char* buffer = new char[size];
+    nvs_get_str(nvs, key, buffer, &size);
+    std::string value(buffer);
+    delete[] buffer;
+    return value;
+}
+
+static void SaveSixKeys(nvs_handle_t nvs, uint8_t slot, uint8_t count, const RFSignal& signal) {
+    char key[16];
+    snprintf(key, sizeof(key), "sig_%d_addr", slot);
+    nvs_set_str(nvs, key, signal.AddressHex().c_str());
+    snprintf(key, sizeof(key), "sig_%d_key", slot);
+    nvs_set_str(nvs, key, signal.KeyHex().c_str());
+    snprintf(key, sizeof(key), "sig_%d_freq", slot);
+    nvs_set_u8(nvs, key, signal.frequency);
+    snprintf(key, sizeof(key), "sig_%d_proto", slot);
+    nvs_set_u8(nvs, key, signal.protocol);
+    snprintf(key, sizeof(key), "sig_%d_pulse", slot);
+    nvs_set_u16(nvs, key, signal.pulse_length);
+    snprintf(key, sizeof(key), "sig_%d_name", slot);
+    nvs_set_str(nvs, key, signal.name);
+    nvs_set_u8(nvs, "count", count);
+    nvs_set_u8(nvs, "index", static_cast<uint8_t>(slot + 1));
+    nvs_set_u8(nvs, "has_signal", 1);
+    nvs_commit(nvs);
+}
+
+static bool ReadSixKeys(nvs_handle_t nvs, uint8_t slot, RFSignal& signal) {
+    char key[16];
+    snprintf(key, sizeof(key), "sig_%d_addr", slot);
+    const std::string address = ReadString(nvs, key);
+    snprintf(key, sizeof(key), "sig_%d_key", slot);
+    const std::string key_hex = ReadString(nvs, key);
+    if (address.empty() || key_hex.empty()) {
+        return false;
+    }
+    signal.code = strtoull(address.c_str(), nullptr, 16);
+    uint8_t freq = 0;
+    snprintf(key, sizeof(key), "sig_%d_freq", slot);
+    nvs_get_u8(nvs, key, &freq);
+    signal.frequency = static_cast<RFFrequency>(freq);
+    snprintf(key, sizeof(key), "sig_%d_proto", slot);
+    nvs_get_u8(nvs, key, &signal.protocol);
+    snprintf(key, sizeof(key), "sig_%d_pulse", slot);
+    nvs_get_u16(nvs, key, &signal.pulse_length);
+    snprintf(key, sizeof(key), "sig_%d_name", slot);
+    signal.SetName(ReadString(nvs, key).c_str());
+    return true;
+}
+
+static size_t SaveRecord(nvs_handle_t nvs, uint16_t slot, const RFSignal& signal, uint32_t sequence) {
+    uint8_t record[RfSignalRecord::kMaxSize];
+    const size_t size = RfSignalRecord::Encode(signal, nullptr, sequence, record, sizeof(record));
+    char key[16];
+    snprintf(key, sizeof(key), "sig_%d", slot);
+    nvs_set_blob(nvs, key, record, size);
+    nvs_commit(nvs);
+    return size;
+}
+
+static bool ReadRecord(nvs_handle_t nvs, uint16_t slot, RFSignal& signal) {
+    uint8_t record[RfSignalRecord::kMaxSize];
+    size_t size = sizeof(record);
+    char key[16];
+    snprintf(key, sizeof(key), "sig_%d", slot);
+    return nvs_get_blob(nvs, key, record, &size) == ESP_OK && RfSignalRecord::Decode(record, size, signal, nullptr);
+}
+
+static RFSignal Named(uint16_t i) {
+    RFSignal signal;
+    signal.code = 0x500000 + i;
+    signal.bit_length = 24;
+    signal.protocol = 1;
+    signal.pulse_length = 350;
+    char name[16];
+    snprintf(name, sizeof(name), "lamp %u", i);
+    signal.SetName(name);
+    return signal;
+}
+
+static void Layouts() {
+    printf("NVS calls per operation, original six-key layout vs one record\n");
+    printf("             save writes  save commits  read reads  list reads    list CPU\n");
+    for (uint16_t stored : { 10, 100 }) {
+        for (bool record : { false, true }) {
+            RfHost::ClearNvs();
+            nvs_handle_t nvs = 0;
+            nvs_open("bench", NVS_READWRITE, &nvs);
+            const uint16_t last = stored - 1;
+            for (uint16_t i = 0; i < stored; i++) {
+                if (i == last) {
+                    RfHost::ResetNvsCounters();  // Only the last save is counted
+                }
+                if (record) {
+                    SaveRecord(nvs, i, Named(i), i + 1);
+                } else {
+                    SaveSixKeys(nvs, static_cast<uint8_t>(i), static_cast<uint8_t>(i + 1), Named(i));
+                }
+            }
+            const RfHostNvsCounters save = RfHost::NvsCounters();
+
+            RfHost::ResetNvsCounters();
+            RFSignal signal;
+            if (record) {
+                ReadRecord(nvs, last, signal);
+            } else {
+                ReadSixKeys(nvs, static_cast<uint8_t>(last), signal);
+            }
+            const RfHostNvsCounters read = RfHost::NvsCounters();
+
+            RfHost::ResetNvsCounters();
+            auto list = [&]() {
+                uint64_t codes = 0;
+                for (uint16_t slot = 0; slot < stored; slot++) {
+                    if (record ? ReadRecord(nvs, slot, signal) : ReadSixKeys(nvs, static_cast<uint8_t>(slot), signal)) {
+                        codes += signal.code;
+                    }
+                }
+                RfBenchKeep(codes);
+            };
+            list();
+            const RfHostNvsCounters listed = RfHost::NvsCounters();
+            const double list_ns = RfBenchBest(5, list);
+            printf("  %-6s N=%-4u %11u  %12u  %10u  %10u  %8.1fus\n", record ? "record" : "6 keys", stored, save.writes,
+                   save.commits, read.reads, listed.reads, list_ns / 1000);
+            nvs_close(nvs);
+        }
+    }
+    uint8_t record[RfSignalRecord::kMaxSize];
+    printf("  record size: %zu bytes for a code named \"lamp 1\"\n\n",
+           RfSignalRecord::Encode(Named(1), nullptr, 1, record, sizeof(record)));
+}
+
+// The last frame of a press only completes at the next edge, i.e. with the next press,
+// so earlier codes may still be queued
+static bool ReceiveCode(RFModule& rf, uint64_t code, int ms) {
+    RFSignal signal;
+    for (int i = 0; i < ms; i++) {
+        while (rf.Receive(signal)) {
+            if (signal.code == code) {
+                return true;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+static void Batching() {
+    static const RfChannelConfig kChannels[] = {
+        { RF_433MHZ, 0, GPIO_NUM_17, GPIO_NUM_NC },
+        { RF_433MHZ, 1, GPIO_NUM_NC, GPIO_NUM_18 },
+    };
+    static const uint16_t kSaves = 10;
+    RfHost::SetManualClock(true);  // Each transmit moves it by its airtime and takes no wall time
+    RfHost::Connect(17, 18);
+    printf("RFModule, %u codes received and saved (NVS)\n", kSaves);
+    printf("             writes  commits  ms between saves\n");
+    for (bool batched : { false, true }) {
+        RfHost::ClearNvs();
+        RFModule rf(kChannels, 2);
+        rf.Begin();
+        rf.EnableReceive(RF_433MHZ);
+        rf.EnableFlashStorage();
+        rf.LoadFromFlash();
+        rf.Flush();
+        RfHost::ResetNvsCounters();
+        const int64_t start = RfHost::Now();
+        uint16_t saved = 0;
+        for (uint16_t i = 0; i < kSaves; i++) {
+            const RFSignal signal = Named(static_cast<uint16_t>(i + (batched ? kSaves : 0)));
+            rf.Send(signal);
+            if (ReceiveCode(rf, signal.code, 2000) && rf.SaveToFlash()) {
+                saved++;
+            }
+            if (!batched) {
+                rf.Flush();
+            }
+        }
+        rf.Flush();
+        const RfHostNvsCounters counters = RfHost::NvsCounters();
+        printf("  %-9s %8u  %7u  %16.1f%s\n", batched ? "batched" : "per save", counters.writes, counters.commits,
+               (RfHost::Now() - start) / 1000.0 / kSaves, saved == kSaves ? "" : "  (some saves failed)");
+        rf.End();
+    }
+    RfHost::Disconnect(17);
+    RfHost::SetManualClock(false);
+}
+
+int main() {
+    RfHost::SetLogLevel(ESP_LOG_ERROR);
+    Layouts();
+    Batching();
+    return 0;
+}
@@ -0,0 +1,66 @@
+// Duplicate check cost with 10, 100 and 1000 stored signals: a linear scan of
+// the flash mirror (CheckDuplicateSignal() before RfSignalIndex) against the
+// hash index. 1024 lookups, 3 of 4 of them for a stored code; best of 5 runs.
+
+#include <stdio.h>
+#include <vector>
+#include "rf_bench.h"
+#include "rf_signal_index.h"
+
+static const int kLookups = 1024;
+
+static bool LinearFind(const std::vector<RFSignal>& mirror, const RFSignal& signal, uint16_t& slot) {
+    for (size_t i = 0; i < mirror.size(); i++) {
+        if (!mirror[i].Empty() && mirror[i].frequency == signal.frequency && mirror[i].code == signal.code &&
+            mirror[i].bit_length == signal.bit_length) {
+            slot = static_cast<uint16_t>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+int main() {
+    printf("ns per duplicate check (%d lookups, 3/4 hits)\n", kLookups);
+    printf("  stored    linear scan    hash index\n");
+    for (size_t stored : { 10, 100, 1000 }) {
+        RfBenchRandom random(stored);
+        std::vector<RFSignal> mirror(stored);
+        RfSignalIndex index;
+        index.Reset(stored);
+        for (size_t slot = 0; slot < stored; slot++) {
+            mirror[slot].code = random.Next() & 0xFFFFFF;
+            mirror[slot].bit_length = 24;
+            mirror[slot].frequency = (slot & 1) ? RF_315MHZ : RF_433MHZ;
+            index.Insert(mirror[slot], static_cast<uint16_t>(slot));
+        }
+        std::vector<RFSignal> lookups(kLookups);
+        for (int i = 0; i < kLookups; i++) {
+            if (i % 4 != 3) {
+                lookups[i] = mirror[random.Next() % stored];
+            } else {
+                lookups[i].code = random.Next() | 0x1000000;  // Above 24 bits: never stored
+                lookups[i].bit_length = 24;
+            }
+        }
+
+        const double linear = RfBenchBest(5, [&]() {
+            uint64_t found = 0;
+            for (const RFSignal& signal : lookups) {
+                uint16_t slot = 0;
+                found += LinearFind(mirror, signal, slot) ? slot + 1 : 0;
+            }
+            RfBenchKeep(found);
+        });
+        const double hashed = RfBenchBest(5, [&]() {
+            uint64_t found = 0;
+            for (const RFSignal& signal : lookups) {
+                uint16_t slot = 0;
+                found += index.Find(signal, slot) ? slot + 1 : 0;
+            }
+            RfBenchKeep(found);
+        });
+        printf("  %6zu    %11.1f    %10.1f\n", stored, linear / kLookups, hashed / kLookups);
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+#ifndef RF_FILE_MEDIUM_H
+#define RF_FILE_MEDIUM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "rf_signal_log.h"
+
+/**
+ * File-backed stand-in for the signal partition, for running RfSignalLog
+ * on a Linux host. Behaves like NOR flash: a new file is fully erased
+ * (0xFF), writes can only clear bits and EraseSector() sets a sector back
+ * to 0xFF. Write and erase counters make wear measurable.
+ */
+class RfFileMedium : public RfLogMedium {
+public:
+    RfFileMedium() : file_(nullptr), size_(0), sector_size_(4096), writes_(0), erases_(0) {}
+    ~RfFileMedium() { Close(); }
+    RfFileMedium(const RfFileMedium&) = delete;
+    RfFileMedium& operator=(const RfFileMedium&) = delete;
+
+    // Opens `path`, creating it erased with `size` bytes if it does not exist
+    bool Open(const char* path, size_t size, size_t sector_size = 4096) {
+        Close();
+        sector_size_ = sector_size;
+        size_ = size - size % sector_size;
+        file_ = fopen(path, "r+b");
+        if (file_ == nullptr) {
+            file_ = fopen(path, "w+b");
+            if (file_ == nullptr) {
+                return false;
+            }
+            for (size_t offset = 0; offset < size_; offset += sector_size_) {
+                EraseSector(offset);
+            }
+            erases_ = 0;
+        }
+        return true;
+    }
+
+    void Close() {
+        if (file_ != nullptr) {
+            fclose(file_);
+            file_ = nullptr;
+        }
+    }
+
+    size_t Size() const override { return size_; }
+    size_t SectorSize() const override { return sector_size_; }
+
+    bool Read(size_t offset, void* data, size_t size) const override {
+        return offset + size <= size_ && fseek(file_, static_cast<long>(offset), SEEK_SET) == 0 &&
+               fread(data, 1, size, file_) == size;
+    }
+
+    bool Write(size_t offset, const void* data, size_t size) override {
+        uint8_t current[256];
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t done = 0; done < size;) {
+            const size_t chunk = size - done < sizeof(current) ? size - done : sizeof(current);
+            if (!Read(offset + done, current, chunk)) {
+                return false;
+            }
+            for (size_t i = 0; i < chunk; i++) {
+                current[i] &= bytes[done + i];  // Programming only clears bits
+            }
+            if (fseek(file_, static_cast<long>(offset + done), SEEK_SET) != 0 ||
+                fwrite(current, 1, chunk, file_) != chunk) {
+                return false;
+            }
+            done += chunk;
+        }
+        writes_++;
+        return fflush(file_) == 0;
+    }
+
+    bool EraseSector(size_t offset) override {
+        uint8_t erased[256];
+        memset(erased, 0xFF, sizeof(erased));
+        offset -= offset % sector_size_;
+        if (fseek(file_, static_cast<long>(offset), SEEK_SET) != 0) {
+            return false;
+        }
+        for (size_t done = 0; done < sector_size_; done += sizeof(erased)) {
+            const size_t chunk = sector_size_ - done < sizeof(erased) ? sector_size_ - done : sizeof(erased);
+            if (fwrite(erased, 1, chunk, file_) != chunk) {
+                return false;
+            }
+        }
+        erases_++;
+        return fflush(file_) == 0;
+    }
+
+    uint32_t WriteCount() const { return writes_; }
+    uint32_t EraseCount() const { return erases_; }
+
+private:
+    FILE* file_;
+    size_t size_;
+    size_t sector_size_;
+    uint32_t writes_;
+    uint32_t erases_;
+};
+
+#endif // RF_FILE_MEDIUM_H
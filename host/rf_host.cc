@@ -0,0 +1,1102 @@
+#include "rf_host.h"
+#include <driver/gpio.h>
+#include <driver/rmt_tx.h>
+#include <esp_cpu.h>
+#include <esp_log.h>
+#include <esp_partition.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <nvs.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Clock
+
+namespace {
+
+std::atomic<bool> clock_manual(false);
+std::atomic<int64_t> clock_manual_time(0);
+std::atomic<int64_t> clock_offset(0);  // Real clock: added to the monotonic time since start
+
+int64_t MonotonicUs() {
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The scheduler: every FreeRTOS object is guarded by one lock and waits on one condition
+std::mutex& KernelLock() {
+    static std::mutex lock;
+    return lock;
+}
+
+std::condition_variable& KernelWake() {
+    static std::condition_variable wake;
+    return wake;
+}
+
+void WakeAll() {
+    std::lock_guard<std::mutex> lock(KernelLock());
+    KernelWake().notify_all();
+}
+
+// Real clock: sleeps through most of it, spins for the rest
+void SleepUntil(int64_t time) {
+    for (;;) {
+        const int64_t remaining = time - RfHost::Now();
+        if (remaining <= 0) {
+            return;
+        }
+        if (remaining > 200) {
+            std::this_thread::sleep_for(std::chrono::microseconds(remaining - 100));
+        }
+    }
+}
+
+// Manual clock: moves it to time; real clock: sleeps until then
+void ReachTime(int64_t time) {
+    if (clock_manual.load()) {
+        RfHost::SetTime(time);
+    } else {
+        SleepUntil(time);
+    }
+}
+
+}  // namespace
+
+int64_t RfHost::Now() {
+    return clock_manual.load() ? clock_manual_time.load() : clock_offset.load() + MonotonicUs();
+}
+
+void RfHost::SetManualClock(bool manual) {
+    if (manual == clock_manual.load()) {
+        return;
+    }
+    if (manual) {
+        clock_manual_time.store(Now());
+        clock_manual.store(true);
+    } else {
+        clock_offset.store(clock_manual_time.load() - MonotonicUs());
+        clock_manual.store(false);
+    }
+    WakeAll();  // Waits switch between the two kinds of timeout
+}
+
+void RfHost::SetTime(int64_t us) {
+    int64_t now = clock_manual_time.load();
+    while (us > now && !clock_manual_time.compare_exchange_weak(now, us)) {
+    }
+    WakeAll();
+}
+
+void RfHost::Advance(int64_t us) {
+    if (clock_manual.load()) {
+        clock_manual_time.fetch_add(us);
+        WakeAll();
+    } else {
+        SleepUntil(Now() + us);
+    }
+}
+
+int64_t esp_timer_get_time(void) {
+    return RfHost::Now();
+}
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void) {
+    return static_cast<esp_cpu_cycle_count_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// FreeRTOS
+
+struct RfHostTask {
+    TaskFunction_t function;
+    void* arg;
+    std::string name;
+    std::thread thread;
+    uint32_t notifications;
+    bool deleted;       // The task ends at its next blocking call
+    bool joined;        // vTaskDelete() from another thread joins and frees it
+
+    RfHostTask() : function(nullptr), arg(nullptr), notifications(0), deleted(false), joined(false) {}
+};
+
+struct RfHostQueue {
+    size_t length;
+    size_t item_size;                // 0 for semaphores
+    std::deque<std::string> items;
+};
+
+struct RfHostEventGroup {
+    EventBits_t bits;
+};
+
+namespace {
+
+// Unwinds a deleted task's thread from whichever blocking call it is in
+struct TaskExit {};
+
+thread_local RfHostTask* current_task = nullptr;
+
+RfHostTask* CurrentTask() {
+    // Threads the shim did not start (main, test runners) get a handle on first use
+    static thread_local std::unique_ptr<RfHostTask> foreign;
+    if (current_task == nullptr) {
+        foreign.reset(new RfHostTask());
+        foreign->name = "host";
+        current_task = foreign.get();
+    }
+    return current_task;
+}
+
+// Waits on the kernel lock until ready() or ticks have passed on the host clock
+template <typename Ready>
+bool WaitFor(std::unique_lock<std::mutex>& lock, TickType_t ticks, Ready ready) {
+    RfHostTask* self = CurrentTask();
+    const int64_t deadline = ticks == portMAX_DELAY ? INT64_MAX : RfHost::Now() + static_cast<int64_t>(ticks) * 1000;
+    for (;;) {
+        if (self->deleted) {
+            throw TaskExit();
+        }
+        if (ready()) {
+            return true;
+        }
+        const int64_t now = RfHost::Now();
+        if (now >= deadline) {
+            return false;
+        }
+        if (deadline == INT64_MAX || clock_manual.load()) {
+            KernelWake().wait(lock);
+        } else {
+            KernelWake().wait_for(lock, std::chrono::microseconds(deadline - now));
+        }
+    }
+}
+
+void RunTask(RfHostTask* task) {
+    current_task = task;
+    try {
+        task->function(task->arg);
+    } catch (const TaskExit&) {
+    }
+    bool joined;
+    {
+        std::lock_guard<std::mutex> lock(KernelLock());
+        joined = task->joined;
+        if (!joined) {
+            task->thread.detach();  // Deleted itself (or returned, which FreeRTOS does not allow)
+        }
+    }
+    if (!joined) {
+        delete task;
+    }
+}
+
+}  // namespace
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stack_depth, void* arg,
+                       UBaseType_t priority, TaskHandle_t* created_task) {
+    (void)stack_depth;
+    (void)priority;
+    RfHostTask* task = new RfHostTask();
+    task->function = function;
+    task->arg = arg;
+    task->name = name != nullptr ? name : "";
+    if (created_task != nullptr) {
+        *created_task = task;  // Before the task runs, as the task may read it
+    }
+    std::lock_guard<std::mutex> lock(KernelLock());  // RunTask() must see thread assigned
+    task->thread = std::thread(RunTask, task);
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stack_depth, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* created_task, BaseType_t core_id) {
+    (void)core_id;
+    return xTaskCreate(function, name, stack_depth, arg, priority, created_task);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    RfHostTask* self = CurrentTask();
+    if (task == nullptr || task == self) {
+        throw TaskExit();
+    }
+    {
+        std::lock_guard<std::mutex> lock(KernelLock());
+        task->deleted = true;
+        task->joined = task->thread.joinable();
+        KernelWake().notify_all();
+    }
+    if (task->joined) {
+        task->thread.join();
+        delete task;
+    }
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(KernelLock());
+    WaitFor(lock, ticks, [] { return false; });
+}
+
+void vTaskSuspend(TaskHandle_t task) {
+    (void)task;  // Only ever the calling task, see freertos/task.h
+    std::unique_lock<std::mutex> lock(KernelLock());
+    WaitFor(lock, portMAX_DELAY, [] { return false; });
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return static_cast<TickType_t>(RfHost::Now() / (1000000 / configTICK_RATE_HZ));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return CurrentTask();
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait) {
+    RfHostTask* self = CurrentTask();
+    std::unique_lock<std::mutex> lock(KernelLock());
+    WaitFor(lock, ticks_to_wait, [self] { return self->notifications > 0; });
+    const uint32_t count = self->notifications;
+    if (count > 0) {
+        self->notifications = clear_count_on_exit ? 0 : count - 1;
+    }
+    return count;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    std::lock_guard<std::mutex> lock(KernelLock());
+    task->notifications++;
+    KernelWake().notify_all();
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_task_woken) {
+    xTaskNotifyGive(task);
+    if (higher_priority_task_woken != nullptr) {
+        *higher_priority_task_woken = pdTRUE;
+    }
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    if (length == 0) {
+        return nullptr;
+    }
+    RfHostQueue* queue = new RfHostQueue();
+    queue->length = length;
+    queue->item_size = item_size;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait) {
+    std::unique_lock<std::mutex> lock(KernelLock());
+    if (!WaitFor(lock, ticks_to_wait, [queue] { return queue->items.size() < queue->length; })) {
+        return pdFALSE;
+    }
+    queue->items.emplace_back(static_cast<const char*>(item), queue->item_size);
+    KernelWake().notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait) {
+    return xQueueSend(queue, item, ticks_to_wait);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks_to_wait) {
+    std::unique_lock<std::mutex> lock(KernelLock());
+    if (!WaitFor(lock, ticks_to_wait, [queue] { return !queue->items.empty(); })) {
+        return pdFALSE;
+    }
+    if (queue->item_size > 0) {
+        memcpy(item, queue->items.front().data(), queue->item_size);
+    }
+    queue->items.pop_front();
+    KernelWake().notify_all();
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> lock(KernelLock());
+    return queue->items.size();
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return xQueueCreate(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count) {
+    SemaphoreHandle_t semaphore = xQueueCreate(max_count, 0);
+    if (semaphore != nullptr) {
+        semaphore->items.resize(std::min(initial_count, max_count));
+    }
+    return semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait) {
+    return xQueueReceive(semaphore, nullptr, ticks_to_wait);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    return xQueueSend(semaphore, nullptr, 0);
+}
+
+EventGroupHandle_t xEventGroupCreate(void) {
+    RfHostEventGroup* group = new RfHostEventGroup();
+    group->bits = 0;
+    return group;
+}
+
+void vEventGroupDelete(EventGroupHandle_t group) {
+    delete group;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    std::lock_guard<std::mutex> lock(KernelLock());
+    group->bits |= bits;
+    KernelWake().notify_all();
+    return group->bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    std::lock_guard<std::mutex> lock(KernelLock());
+    const EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+    std::lock_guard<std::mutex> lock(KernelLock());
+    return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits_to_wait_for, BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all_bits, TickType_t ticks_to_wait) {
+    std::unique_lock<std::mutex> lock(KernelLock());
+    const bool met = WaitFor(lock, ticks_to_wait, [=] {
+        const EventBits_t set = group->bits & bits_to_wait_for;
+        return wait_for_all_bits ? set == bits_to_wait_for : set != 0;
+    });
+    const EventBits_t bits = group->bits;
+    if (met && clear_on_exit) {
+        group->bits &= ~bits_to_wait_for;
+    }
+    return bits;
+}
+
+// GPIO and RMT
+
+namespace {
+
+struct HostPin {
+    std::atomic<uint8_t> level;
+    gpio_isr_t isr;                  // Guarded by IsrLock()
+    void* isr_arg;
+    int connected;                   // Input driven by this pin, -1 = none; guarded by GpioLock()
+    std::vector<RfHostEdge> output;  // Guarded by GpioLock()
+
+    HostPin() : level(0), isr(nullptr), isr_arg(nullptr), connected(-1) {}
+};
+
+HostPin pins[GPIO_NUM_MAX];
+bool isr_service_installed = false;
+
+bool ValidPin(int pin) {
+    return pin >= 0 && pin < GPIO_NUM_MAX;
+}
+
+std::mutex& GpioLock() {
+    static std::mutex lock;
+    return lock;
+}
+
+// Serialises ISRs like a single core does, and handler removal against a running ISR
+std::mutex& IsrLock() {
+    static std::mutex lock;
+    return lock;
+}
+
+// Holds each level of a Play() or RMT sequence, timed from the start of the sequence
+// so the durations never drift
+class LevelSequence {
+public:
+    explicit LevelSequence(int64_t start) : time_(start) {}
+    void Hold(uint32_t us) {
+        time_ += us;
+        ReachTime(time_);
+    }
+
+private:
+    int64_t time_;
+};
+
+}  // namespace
+
+struct rmt_channel_t {
+    gpio_num_t pin;
+    uint32_t resolution_hz;
+    bool enabled;
+};
+
+struct rmt_encoder_t {
+};
+
+int RfHost::Level(int pin) {
+    return ValidPin(pin) ? pins[pin].level.load() : 0;
+}
+
+void RfHost::Drive(int pin, int level) {
+    if (!ValidPin(pin)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(IsrLock());
+    if (pins[pin].level.exchange(level != 0 ? 1 : 0) == (level != 0 ? 1 : 0)) {
+        return;
+    }
+    if (pins[pin].isr != nullptr) {
+        pins[pin].isr(pins[pin].isr_arg);
+    }
+}
+
+void RfHost::Play(int pin, const uint32_t* durations, size_t count, int first_level) {
+    LevelSequence sequence(Now());
+    for (size_t i = 0; i < count; i++) {
+        Drive(pin, first_level ^ static_cast<int>(i & 1));
+        sequence.Hold(durations[i]);
+    }
+    Drive(pin, first_level ^ static_cast<int>(count & 1));
+}
+
+void RfHost::Connect(int output, int input) {
+    if (ValidPin(output) && ValidPin(input)) {
+        std::lock_guard<std::mutex> lock(GpioLock());
+        pins[output].connected = input;
+    }
+}
+
+void RfHost::Disconnect(int output) {
+    if (ValidPin(output)) {
+        std::lock_guard<std::mutex> lock(GpioLock());
+        pins[output].connected = -1;
+    }
+}
+
+std::vector<RfHostEdge> RfHost::TakeOutput(int pin) {
+    std::vector<RfHostEdge> edges;
+    if (ValidPin(pin)) {
+        std::lock_guard<std::mutex> lock(GpioLock());
+        edges.swap(pins[pin].output);
+    }
+    return edges;
+}
+
+esp_err_t gpio_config(const gpio_config_t* config) {
+    if (config == nullptr || config->pin_bit_mask >> GPIO_NUM_MAX != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode) {
+    (void)mode;
+    return ValidPin(gpio_num) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+// Recorded when the level changes; a connected input sees the edge as well
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+    if (!ValidPin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const uint8_t value = level != 0 ? 1 : 0;
+    int connected;
+    {
+        std::lock_guard<std::mutex> lock(GpioLock());
+        HostPin& pin = pins[gpio_num];
+        if (pin.level.exchange(value) != value) {
+            pin.output.push_back(RfHostEdge{RfHost::Now(), value});
+        }
+        connected = pin.connected;
+    }
+    if (connected >= 0) {
+        RfHost::Drive(connected, value);
+    }
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num) {
+    return RfHost::Level(gpio_num);
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags) {
+    (void)intr_alloc_flags;
+    std::lock_guard<std::mutex> lock(IsrLock());
+    if (isr_service_installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    isr_service_installed = true;
+    return ESP_OK;
+}
+
+void gpio_uninstall_isr_service(void) {
+    std::lock_guard<std::mutex> lock(IsrLock());
+    isr_service_installed = false;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void* args) {
+    if (!ValidPin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(IsrLock());
+    if (!isr_service_installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    pins[gpio_num].isr = isr_handler;
+    pins[gpio_num].isr_arg = args;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num) {
+    if (!ValidPin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(IsrLock());  // Returns once a running ISR is done
+    pins[gpio_num].isr = nullptr;
+    pins[gpio_num].isr_arg = nullptr;
+    return ESP_OK;
+}
+
+esp_err_t rmt_new_tx_channel(const rmt_tx_channel_config_t* config, rmt_channel_handle_t* ret_chan) {
+    if (config == nullptr || ret_chan == nullptr || !ValidPin(config->gpio_num) || config->resolution_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *ret_chan = new rmt_channel_t{config->gpio_num, config->resolution_hz, false};
+    return ESP_OK;
+}
+
+esp_err_t rmt_del_channel(rmt_channel_handle_t channel) {
+    if (channel == nullptr || channel->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    delete channel;
+    return ESP_OK;
+}
+
+esp_err_t rmt_enable(rmt_channel_handle_t channel) {
+    channel->enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t rmt_disable(rmt_channel_handle_t channel) {
+    channel->enabled = false;
+    return ESP_OK;
+}
+
+esp_err_t rmt_new_copy_encoder(const rmt_copy_encoder_config_t* config, rmt_encoder_handle_t* ret_encoder) {
+    (void)config;
+    *ret_encoder = new rmt_encoder_t();
+    return ESP_OK;
+}
+
+esp_err_t rmt_del_encoder(rmt_encoder_handle_t encoder) {
+    delete encoder;
+    return ESP_OK;
+}
+
+// Plays the symbols before returning; a zero duration ends the transmission, as on the chip
+esp_err_t rmt_transmit(rmt_channel_handle_t channel, rmt_encoder_handle_t encoder, const void* payload,
+                       size_t payload_bytes, const rmt_transmit_config_t* config) {
+    if (channel == nullptr || encoder == nullptr || config == nullptr || config->loop_count != 0) {
+        return ESP_ERR_INVALID_ARG;  // Loops are not needed by the component and not emulated
+    }
+    if (!channel->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    const rmt_symbol_word_t* symbols = static_cast<const rmt_symbol_word_t*>(payload);
+    const size_t count = payload_bytes / sizeof(rmt_symbol_word_t);
+    LevelSequence sequence(RfHost::Now());
+    for (size_t i = 0; i < count; i++) {
+        if (symbols[i].duration0 == 0) {
+            break;
+        }
+        gpio_set_level(channel->pin, symbols[i].level0);
+        sequence.Hold(static_cast<uint32_t>(uint64_t(symbols[i].duration0) * 1000000 / channel->resolution_hz));
+        if (symbols[i].duration1 == 0) {
+            break;
+        }
+        gpio_set_level(channel->pin, symbols[i].level1);
+        sequence.Hold(static_cast<uint32_t>(uint64_t(symbols[i].duration1) * 1000000 / channel->resolution_hz));
+    }
+    gpio_set_level(channel->pin, config->flags.eot_level);
+    return ESP_OK;
+}
+
+esp_err_t rmt_tx_wait_all_done(rmt_channel_handle_t channel, int timeout_ms) {
+    (void)channel;
+    (void)timeout_ms;
+    return ESP_OK;
+}
+
+// NVS
+
+namespace {
+
+enum NvsType : uint8_t { kNvsU8 = 0x01, kNvsU16 = 0x02, kNvsU32 = 0x04, kNvsStr = 0x21, kNvsBlob = 0x42 };
+
+struct NvsEntry {
+    uint8_t type;
+    std::string data;
+};
+
+struct NvsHandle {
+    std::string name_space;
+    bool read_only;
+};
+
+typedef std::map<std::string, std::map<std::string, NvsEntry>> NvsStore;
+
+std::mutex nvs_lock;
+NvsStore nvs_store;
+std::map<nvs_handle_t, NvsHandle> nvs_handles;
+nvs_handle_t nvs_next_handle = 1;
+std::string nvs_path;
+RfHostNvsCounters nvs_counters = {};
+
+// File: per entry, namespace and key (length byte + characters), type, size (4, little endian), data
+bool SaveNvs() {
+    if (nvs_path.empty()) {
+        return true;
+    }
+    std::string file;
+    for (const auto& name_space : nvs_store) {
+        for (const auto& entry : name_space.second) {
+            file += static_cast<char>(name_space.first.size());
+            file += name_space.first;
+            file += static_cast<char>(entry.first.size());
+            file += entry.first;
+            file += static_cast<char>(entry.second.type);
+            const uint32_t size = entry.second.data.size();
+            for (int i = 0; i < 4; i++) {
+                file += static_cast<char>(size >> (8 * i));
+            }
+            file += entry.second.data;
+        }
+    }
+    const std::string temp = nvs_path + ".tmp";
+    FILE* f = fopen(temp.c_str(), "wb");
+    if (f == nullptr) {
+        return false;
+    }
+    const bool written = fwrite(file.data(), 1, file.size(), f) == file.size();
+    if (fclose(f) != 0 || !written) {
+        return false;
+    }
+    return rename(temp.c_str(), nvs_path.c_str()) == 0;
+}
+
+bool LoadNvs(const std::string& file, NvsStore& store) {
+    size_t pos = 0;
+    auto take = [&](size_t size, std::string& out) {
+        if (file.size() - pos < size) {
+            return false;
+        }
+        out = file.substr(pos, size);
+        pos += size;
+        return true;
+    };
+    while (pos < file.size()) {
+        std::string name_space, key, type, size_bytes, data;
+        if (!take(1, size_bytes) || !take(static_cast<uint8_t>(size_bytes[0]), name_space) ||
+            !take(1, size_bytes) || !take(static_cast<uint8_t>(size_bytes[0]), key) ||
+            !take(1, type) || !take(4, size_bytes)) {
+            return false;
+        }
+        uint32_t size = 0;
+        for (int i = 0; i < 4; i++) {
+            size |= static_cast<uint32_t>(static_cast<uint8_t>(size_bytes[i])) << (8 * i);
+        }
+        if (!take(size, data)) {
+            return false;
+        }
+        store[name_space][key] = NvsEntry{static_cast<uint8_t>(type[0]), data};
+    }
+    return true;
+}
+
+esp_err_t NvsSet(nvs_handle_t handle, const char* key, uint8_t type, const void* data, size_t size) {
+    std::lock_guard<std::mutex> lock(nvs_lock);
+    nvs_counters.writes++;
+    auto it = nvs_handles.find(handle);
+    if (it == nvs_handles.end()) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (it->second.read_only) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    if (key == nullptr || key[0] == '\0') {
+        return ESP_ERR_NVS_INVALID_NAME;
+    }
+    if (strlen(key) >= NVS_KEY_NAME_MAX_SIZE) {
+        return ESP_ERR_NVS_KEY_TOO_LONG;
+    }
+    nvs_store[it->second.name_space][key] = NvsEntry{type, std::string(static_cast<const char*>(data), size)};
+    return ESP_OK;
+}
+
+// Fixed size: *size must match; variable size (out_size != nullptr): the ESP-IDF length rules
+esp_err_t NvsGet(nvs_handle_t handle, const char* key, uint8_t type, void* out, size_t size, size_t* out_size) {
+    std::lock_guard<std::mutex> lock(nvs_lock);
+    nvs_counters.reads++;
+    auto it = nvs_handles.find(handle);
+    if (it == nvs_handles.end()) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (key == nullptr || strlen(key) >= NVS_KEY_NAME_MAX_SIZE) {
+        return ESP_ERR_NVS_INVALID_NAME;
+    }
+    auto name_space = nvs_store.find(it->second.name_space);
+    if (name_space == nvs_store.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    auto entry = name_space->second.find(key);
+    if (entry == name_space->second.end() || entry->second.type != type) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    const std::string& data = entry->second.data;
+    if (out_size == nullptr) {
+        memcpy(out, data.data(), size);
+        return ESP_OK;
+    }
+    const size_t needed = data.size() + (type == kNvsStr ? 1 : 0);
+    if (out == nullptr) {
+        *out_size = needed;
+        return ESP_OK;
+    }
+    if (*out_size < needed) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(out, data.data(), data.size());
+    if (type == kNvsStr) {
+        static_cast<char*>(out)[data.size()] = '\0';
+    }
+    *out_size = needed;
+    return ESP_OK;
+}
+
+}  // namespace
+
+bool RfHost::UseNvsFile(const char* path) {
+    std::lock_guard<std::mutex> lock(nvs_lock);
+    nvs_path = path != nullptr ? path : "";
+    if (nvs_path.empty()) {
+        return true;
+    }
+    FILE* f = fopen(path, "rb");
+    if (f == nullptr) {
+        return true;  // Created by the first commit
+    }
+    std::string file;
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        file.append(buffer, read);
+    }
+    fclose(f);
+    NvsStore store;
+    if (!LoadNvs(file, store)) {
+        return false;
+    }
+    nvs_store.swap(store);
+    return true;
+}
+
+RfHostNvsCounters RfHost::NvsCounters() {
+    std::lock_guard<std::mutex> lock(nvs_lock);
+    return nvs_counters;
+}
+
+void RfHost::ResetNvsCounters() {
+    std::lock_guard<std::mutex> lock(nvs_lock);
+    nvs_counters = RfHostNvsCounters{};
+}
+
+void RfHost::ClearNvs() {
+    std::lock_guard<std::mutex> lock(nvs_lock);
+    nvs_store.clear();
+}
+
+esp_err_t nvs_open(const char* namespace_name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle) {
+    if (namespace_name == nullptr || namespace_name[0] == '\0' ||
+        strlen(namespace_name) >= NVS_KEY_NAME_MAX_SIZE) {
+        return ESP_ERR_NVS_INVALID_NAME;
+    }
+    std::lock_guard<std::mutex> lock(nvs_lock);
+    if (open_mode == NVS_READONLY && nvs_store.find(namespace_name) == nvs_store.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *out_handle = nvs_next_handle++;
+    nvs_handles[*out_handle] = NvsHandle{namespace_name, open_mode == NVS_READONLY};
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    std::lock_guard<std::mutex> lock(nvs_lock);
+    nvs_handles.erase(handle);
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    std::lock_guard<std::mutex> lock(nvs_lock);
+    nvs_counters.commits++;
+    if (nvs_handles.find(handle) == nvs_handles.end()) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    return SaveNvs() ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key) {
+    std::lock_guard<std::mutex> lock(nvs_lock);
+    nvs_counters.erases++;
+    auto it = nvs_handles.find(handle);
+    if (it == nvs_handles.end()) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (it->second.read_only) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    auto name_space = nvs_store.find(it->second.name_space);
+    if (name_space == nvs_store.end() || name_space->second.erase(key) == 0) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle) {
+    std::lock_guard<std::mutex> lock(nvs_lock);
+    nvs_counters.erases++;
+    auto it = nvs_handles.find(handle);
+    if (it == nvs_handles.end()) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (it->second.read_only) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    nvs_store.erase(it->second.name_space);
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char* key, uint8_t value) {
+    return NvsSet(handle, key, kNvsU8, &value, sizeof(value));
+}
+
+esp_err_t nvs_set_u16(nvs_handle_t handle, const char* key, uint16_t value) {
+    return NvsSet(handle, key, kNvsU16, &value, sizeof(value));
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char* key, uint32_t value) {
+    return NvsSet(handle, key, kNvsU32, &value, sizeof(value));
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char* key, const char* value) {
+    return NvsSet(handle, key, kNvsStr, value, strlen(value));
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length) {
+    return NvsSet(handle, key, kNvsBlob, value, length);
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char* key, uint8_t* out_value) {
+    return NvsGet(handle, key, kNvsU8, out_value, sizeof(*out_value), nullptr);
+}
+
+esp_err_t nvs_get_u16(nvs_handle_t handle, const char* key, uint16_t* out_value) {
+    return NvsGet(handle, key, kNvsU16, out_value, sizeof(*out_value), nullptr);
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char* key, uint32_t* out_value) {
+    return NvsGet(handle, key, kNvsU32, out_value, sizeof(*out_value), nullptr);
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char* key, char* out_value, size_t* length) {
+    return NvsGet(handle, key, kNvsStr, out_value, 0, length);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length) {
+    return NvsGet(handle, key, kNvsBlob, out_value, 0, length);
+}
+
+// Partitions
+
+namespace {
+
+struct HostPartition {
+    esp_partition_t info;
+    std::vector<uint8_t> data;
+};
+
+std::mutex partition_lock;
+std::vector<std::unique_ptr<HostPartition>> partitions;
+
+HostPartition* FindPartition(const esp_partition_t* partition) {
+    for (auto& candidate : partitions) {
+        if (&candidate->info == partition) {
+            return candidate.get();
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+bool RfHost::AddPartition(const char* label, size_t size, size_t sector_size) {
+    if (label == nullptr || strlen(label) >= sizeof(esp_partition_t::label) || sector_size == 0 ||
+        size < sector_size || size % sector_size != 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(partition_lock);
+    uint32_t address = 0x110000;  // After a typical app partition
+    for (const auto& partition : partitions) {
+        if (strcmp(partition->info.label, label) == 0) {
+            return false;
+        }
+        address = std::max<uint32_t>(address, partition->info.address + partition->info.size);
+    }
+    std::unique_ptr<HostPartition> partition(new HostPartition());
+    partition->info.type = ESP_PARTITION_TYPE_DATA;
+    partition->info.subtype = static_cast<esp_partition_subtype_t>(0x40);
+    partition->info.address = address;
+    partition->info.size = size;
+    partition->info.erase_size = sector_size;
+    strcpy(partition->info.label, label);
+    partition->data.assign(size, 0xFF);
+    partitions.push_back(std::move(partition));
+    return true;
+}
+
+void RfHost::RemovePartitions() {
+    std::lock_guard<std::mutex> lock(partition_lock);
+    partitions.clear();
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label) {
+    std::lock_guard<std::mutex> lock(partition_lock);
+    for (const auto& partition : partitions) {
+        if ((type == ESP_PARTITION_TYPE_ANY || type == partition->info.type) &&
+            (subtype == ESP_PARTITION_SUBTYPE_ANY || subtype == partition->info.subtype) &&
+            (label == nullptr || strcmp(label, partition->info.label) == 0)) {
+            return &partition->info;
+        }
+    }
+    return nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size) {
+    std::lock_guard<std::mutex> lock(partition_lock);
+    HostPartition* host = FindPartition(partition);
+    if (host == nullptr || dst == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (src_offset > host->data.size() || size > host->data.size() - src_offset) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(dst, host->data.data() + src_offset, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size) {
+    std::lock_guard<std::mutex> lock(partition_lock);
+    HostPartition* host = FindPartition(partition);
+    if (host == nullptr || src == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (dst_offset > host->data.size() || size > host->data.size() - dst_offset) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(src);
+    for (size_t i = 0; i < size; i++) {
+        host->data[dst_offset + i] &= bytes[i];  // NOR flash only clears bits
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+    std::lock_guard<std::mutex> lock(partition_lock);
+    HostPartition* host = FindPartition(partition);
+    if (host == nullptr || offset % partition->erase_size != 0 || size % partition->erase_size != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (offset > host->data.size() || size > host->data.size() - offset) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memset(host->data.data() + offset, 0xFF, size);
+    return ESP_OK;
+}
+
+// Log
+
+namespace {
+
+std::atomic<int> log_level(ESP_LOG_INFO);
+
+}  // namespace
+
+void RfHost::SetLogLevel(int level) {
+    log_level.store(level);
+}
+
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...) {
+    if (level > log_level.load()) {
+        return;
+    }
+    static const char kLetters[] = "NEWIDV";
+    char line[512];
+    int length = snprintf(line, sizeof(line), "%c (%lld) %s: ", kLetters[level],
+                          static_cast<long long>(RfHost::Now() / 1000), tag);
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line + length, sizeof(line) - length - 1, format, args);
+    va_end(args);
+    length = strlen(line);
+    line[length] = '\n';
+    fwrite(line, 1, length + 1, stderr);
+}
+
+const char* esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK: return "ESP_OK";
+        case ESP_FAIL: return "ESP_FAIL";
+        case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_NVS_NOT_FOUND: return "ESP_ERR_NVS_NOT_FOUND";
+        case ESP_ERR_NVS_READ_ONLY: return "ESP_ERR_NVS_READ_ONLY";
+        case ESP_ERR_NVS_INVALID_HANDLE: return "ESP_ERR_NVS_INVALID_HANDLE";
+        case ESP_ERR_NVS_INVALID_NAME: return "ESP_ERR_NVS_INVALID_NAME";
+        case ESP_ERR_NVS_KEY_TOO_LONG: return "ESP_ERR_NVS_KEY_TOO_LONG";
+        case ESP_ERR_NVS_INVALID_LENGTH: return "ESP_ERR_NVS_INVALID_LENGTH";
+        default: return "UNKNOWN ERROR";
+    }
+}
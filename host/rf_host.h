@@ -0,0 +1,75 @@
+#ifndef RF_HOST_H
+#define RF_HOST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// NVS calls since the last ResetNvsCounters(), failed ones included
+struct RfHostNvsCounters {
+    uint32_t reads;    // nvs_get_*, size probes included
+    uint32_t writes;   // nvs_set_*
+    uint32_t erases;   // nvs_erase_key() and nvs_erase_all()
+    uint32_t commits;
+};
+
+// One level change of a virtual GPIO pin
+struct RfHostEdge {
+    int64_t time;   // Host clock, microseconds
+    uint8_t level;
+};
+
+/**
+ * Control side of the host (Linux) shims in host/shim
+ *
+ * The host build compiles the component's sources unchanged against
+ * stand-ins for the ESP-IDF and FreeRTOS headers they include. A program
+ * linked against it drives them through this class:
+ *
+ *  - Clock: esp_timer_get_time() and the FreeRTOS tick follow the system's
+ *    monotonic clock, or a manual clock that only moves when told to.
+ *    Blocking FreeRTOS calls time out on this clock; code that busy-waits
+ *    (busy-wait transmit, scene gaps) spins until another thread advances
+ *    a manual clock.
+ *  - GPIO: Drive() and Play() change an input pin and run its ISR on the
+ *    calling thread, one ISR at a time as on a single core. Levels written
+ *    by the component are recorded per pin; Connect() also drives another
+ *    pin from them, e.g. to wire a transmitter to a receiver. The RMT shim
+ *    plays its symbols onto the pin with the same timing rules as Play().
+ *  - Storage: NVS lives in RAM, and in a file after UseNvsFile(); its calls
+ *    are counted. Data partitions exist once AddPartition() created them,
+ *    in RAM.
+ *
+ * Everything is process-wide, like the hardware it stands in for.
+ */
+class RfHost {
+public:
+    // Clock
+    static int64_t Now();                 // esp_timer_get_time()
+    static void SetManualClock(bool manual);  // The time carries on from where it is either way
+    static void SetTime(int64_t us);      // Manual clock only; never moves backwards
+    static void Advance(int64_t us);      // Manual clock: moves it; real clock: sleeps
+
+    // GPIO
+    static int Level(int pin);
+    static void Drive(int pin, int level);  // Runs the pin's ISR if the level changed
+    // Drives durations[i] microseconds of level first_level ^ (i & 1) each, then one more
+    // edge, so the last duration ends with an edge as a trailing sync gap does
+    static void Play(int pin, const uint32_t* durations, size_t count, int first_level);
+    static void Connect(int output, int input);  // Levels written to output drive input too
+    static void Disconnect(int output);
+    static std::vector<RfHostEdge> TakeOutput(int pin);  // Recorded levels of pin, oldest first; clears them
+
+    // Storage
+    static bool UseNvsFile(const char* path);  // Loads the file if it exists; every nvs_commit() saves it
+    static void ClearNvs();
+    static bool AddPartition(const char* label, size_t size, size_t sector_size = 4096);  // Erased (0xFF)
+    static void RemovePartitions();       // Only while nothing uses them
+    static RfHostNvsCounters NvsCounters();
+    static void ResetNvsCounters();
+
+    // Log
+    static void SetLogLevel(int level);   // esp_log_level_t; ESP_LOG_INFO by default
+};
+
+#endif // RF_HOST_H
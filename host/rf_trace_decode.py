@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""Turns an RF module trace dump into a timeline.
+
+Input is the binary dump of RFModule::DumpTrace(), its base64 text, or the
+JSON returned by the self.rf.dump_trace MCP tool, read from the file given
+on the command line or from stdin. The layout is described in
+include/rf_trace.h (RfTraceDump).
+
+    python3 host/rf_trace_decode.py trace.json
+"""
+
+import base64
+import binascii
+import json
+import struct
+import sys
+
+HEADER = struct.Struct("<4sBBHII")
+EVENT = struct.Struct("<IBBHI")
+NO_CHANNEL = 0xFF
+
+
+def edge_burst(arg16, arg32):
+    return "%u edges, then %u us gap" % (arg16, arg32)
+
+
+def frame(arg16, arg32):
+    protocol = arg16 & 0xFF
+    bits = (arg16 >> 8) & 0x7F
+    reported = "reported" if arg16 & 0x8000 else "repeat"
+    return "protocol %u, %u bits, code 0x%X (%s)" % (protocol, bits, arg32, reported)
+
+
+def decode_failed(arg16, arg32):
+    return "%u timings, trailing gap %u us" % (arg16, arg32)
+
+
+def overflow(arg16, arg32):
+    return "%u timings, restarted" % arg16
+
+
+def resync(arg16, arg32):
+    return "%u edges dropped so far" % arg32
+
+
+def tx_start(arg16, arg32):
+    return "planned %u us" % arg32
+
+
+def tx_end(arg16, arg32):
+    return "took %u us" % arg32
+
+
+def flash_commit(arg16, arg32):
+    return "%u changes in %u us" % (arg16, arg32)
+
+
+# RfTraceType
+TYPES = {
+    1: ("EDGE_BURST", edge_burst),
+    2: ("FRAME", frame),
+    3: ("DECODE_FAILED", decode_failed),
+    4: ("OVERFLOW", overflow),
+    5: ("RESYNC", resync),
+    6: ("TX_START", tx_start),
+    7: ("TX_END", tx_end),
+    8: ("FLASH_COMMIT", flash_commit),
+}
+
+
+def load(data):
+    """Returns the binary dump, whichever of the three forms data holds."""
+    if data.startswith(b"RFTR"):
+        return data
+    text = data.decode("ascii", errors="replace").strip()
+    if text.startswith("{"):
+        text = json.loads(text)["data"]
+    try:
+        return base64.b64decode(text, validate=True)
+    except binascii.Error as error:
+        raise ValueError("not a trace dump: %s" % error)
+
+
+def parse(dump):
+    """Returns (dump time, [(timestamp, type, channel, arg16, arg32)]), oldest first."""
+    magic, version, event_size, _, count, now = HEADER.unpack_from(dump)
+    if magic != b"RFTR" or version != 1:
+        raise ValueError("unsupported trace dump (magic %r, version %u)" % (magic, version))
+    if len(dump) < HEADER.size + count * event_size:
+        raise ValueError("truncated dump: %u events announced" % count)
+    events = [EVENT.unpack_from(dump, HEADER.size + i * event_size) for i in range(count)]
+    return now, events
+
+
+def timeline(now, events):
+    if not events:
+        return ["no events"]
+    lines = ["%u events, dumped %.3f ms after the last one"
+             % (len(events), ((now - events[-1][0]) & 0xFFFFFFFF) / 1000.0)]
+    first = previous = events[0][0]
+    for timestamp, kind, channel, arg16, arg32 in events:
+        name, describe = TYPES.get(kind, ("TYPE_%u" % kind, lambda a, b: "arg16=%u arg32=%u" % (a, b)))
+        lines.append("%12.3f ms  %+10u us  %-4s %-14s %s" % (
+            ((timestamp - first) & 0xFFFFFFFF) / 1000.0,
+            (timestamp - previous) & 0xFFFFFFFF,
+            "-" if channel == NO_CHANNEL else "ch%u" % channel,
+            name,
+            describe(arg16, arg32)))
+        previous = timestamp
+    return lines
+
+
+def main(argv):
+    if len(argv) > 2:
+        sys.stderr.write("usage: %s [dump | base64 | self.rf.dump_trace JSON]\n" % argv[0])
+        return 2
+    if len(argv) == 2:
+        with open(argv[1], "rb") as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+    try:
+        now, events = parse(load(data))
+    except (ValueError, KeyError, struct.error) as error:
+        sys.stderr.write("%s\n" % error)
+        return 1
+    print("\n".join(timeline(now, events)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,9 @@
+#ifndef RF_HOST_ESP_ATTR_H
+#define RF_HOST_ESP_ATTR_H
+
+// Host shim of the ESP-IDF header of the same name: no IRAM or DRAM placement on the host
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+#endif // RF_HOST_ESP_ATTR_H
@@ -0,0 +1,13 @@
+#ifndef RF_HOST_ESP_CPU_H
+#define RF_HOST_ESP_CPU_H
+
+// Host shim of the ESP-IDF header of the same name: "cycles" are nanoseconds of the
+// monotonic system clock, whatever the host clock mode
+
+#include <stdint.h>
+
+typedef uint32_t esp_cpu_cycle_count_t;
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void);
+
+#endif // RF_HOST_ESP_CPU_H
@@ -0,0 +1,22 @@
+#ifndef RF_HOST_ESP_ERR_H
+#define RF_HOST_ESP_ERR_H
+
+// Host shim of the ESP-IDF header of the same name (see host/rf_host.h)
+
+#include <stdint.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_INVALID_SIZE 0x104
+#define ESP_ERR_NOT_FOUND 0x105
+#define ESP_ERR_NOT_SUPPORTED 0x106
+#define ESP_ERR_TIMEOUT 0x107
+
+const char* esp_err_to_name(esp_err_t code);
+
+#endif // RF_HOST_ESP_ERR_H
@@ -0,0 +1,10 @@
+#ifndef RF_HOST_CACHE_UTILS_H
+#define RF_HOST_CACHE_UTILS_H
+
+// Host shim of the ESP-IDF header of the same name: the host has no flash cache to disable
+
+#include <stdbool.h>
+
+static inline bool spi_flash_cache_enabled(void) { return true; }
+
+#endif // RF_HOST_CACHE_UTILS_H
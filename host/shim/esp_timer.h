@@ -0,0 +1,11 @@
+#ifndef RF_HOST_ESP_TIMER_H
+#define RF_HOST_ESP_TIMER_H
+
+// Host shim of the ESP-IDF header of the same name: microseconds of the host clock,
+// real or manual (RfHost::SetManualClock())
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
+
+#endif // RF_HOST_ESP_TIMER_H
@@ -0,0 +1,33 @@
+#ifndef RF_HOST_FREERTOS_H
+#define RF_HOST_FREERTOS_H
+
+// Host shim of the FreeRTOS headers: tasks are threads, and queues, semaphores, event
+// groups and task notifications share one lock and condition variable. Blocking calls
+// time out on the host clock, so with a manual clock they wait for RfHost::Advance().
+// vTaskDelete() of another task makes its next (or current) blocking call end the
+// thread, then joins it.
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define configTICK_RATE_HZ 1000
+#define configMAX_TASK_NAME_LEN 16
+#define configMAX_PRIORITIES 25
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+
+// ISRs run on the thread that injected the edge; the woken task is scheduled by the host
+#define portYIELD_FROM_ISR(woken) ((void)(woken))
+
+#endif // RF_HOST_FREERTOS_H
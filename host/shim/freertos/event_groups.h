@@ -0,0 +1,19 @@
+#ifndef RF_HOST_FREERTOS_EVENT_GROUPS_H
+#define RF_HOST_FREERTOS_EVENT_GROUPS_H
+
+// Host shim of the FreeRTOS header of the same name (see freertos/FreeRTOS.h)
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct RfHostEventGroup* EventGroupHandle_t;
+typedef TickType_t EventBits_t;
+
+EventGroupHandle_t xEventGroupCreate(void);
+void vEventGroupDelete(EventGroupHandle_t group);
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits);  // Returns the bits before clearing
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group);
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits_to_wait_for, BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all_bits, TickType_t ticks_to_wait);
+
+#endif // RF_HOST_FREERTOS_EVENT_GROUPS_H
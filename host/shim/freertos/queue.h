@@ -0,0 +1,17 @@
+#ifndef RF_HOST_FREERTOS_QUEUE_H
+#define RF_HOST_FREERTOS_QUEUE_H
+
+// Host shim of the FreeRTOS header of the same name (see freertos/FreeRTOS.h)
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct RfHostQueue* QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait);
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks_to_wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+
+#endif // RF_HOST_FREERTOS_QUEUE_H
@@ -0,0 +1,19 @@
+#ifndef RF_HOST_FREERTOS_SEMPHR_H
+#define RF_HOST_FREERTOS_SEMPHR_H
+
+// Host shim of the FreeRTOS header of the same name: semaphores are queues of empty
+// items, as in FreeRTOS (mutexes without priority inheritance)
+
+#include "freertos/queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+
+#define vSemaphoreDelete(semaphore) vQueueDelete(semaphore)
+
+#endif // RF_HOST_FREERTOS_SEMPHR_H
@@ -0,0 +1,28 @@
+#ifndef RF_HOST_FREERTOS_TASK_H
+#define RF_HOST_FREERTOS_TASK_H
+
+// Host shim of the FreeRTOS header of the same name (see freertos/FreeRTOS.h)
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct RfHostTask* TaskHandle_t;
+typedef void (*TaskFunction_t)(void* arg);
+
+#define tskNO_AFFINITY ((BaseType_t)0x7fffffff)
+
+// Stack size, priority and core are ignored
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stack_depth, void* arg,
+                       UBaseType_t priority, TaskHandle_t* created_task);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stack_depth, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* created_task, BaseType_t core_id);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+void vTaskSuspend(TaskHandle_t task);  // The calling task only (nullptr); it stays blocked until deleted
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);  // Threads the shim did not start get a handle too
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_task_woken);
+
+#endif // RF_HOST_FREERTOS_TASK_H
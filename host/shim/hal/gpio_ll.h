@@ -0,0 +1,19 @@
+#ifndef RF_HOST_HAL_GPIO_LL_H
+#define RF_HOST_HAL_GPIO_LL_H
+
+// Host shim of the ESP-IDF header of the same name: reads the virtual GPIO level
+
+#include <stdint.h>
+#include "driver/gpio.h"
+
+typedef struct gpio_dev_t gpio_dev_t;
+
+#define GPIO_PORT_0 0
+#define GPIO_LL_GET_HW(num) ((gpio_dev_t*)0)
+
+static inline int gpio_ll_get_level(gpio_dev_t* hw, uint32_t gpio_num) {
+    (void)hw;
+    return gpio_get_level((gpio_num_t)gpio_num);
+}
+
+#endif // RF_HOST_HAL_GPIO_LL_H
@@ -0,0 +1,9 @@
+#ifndef RF_HOST_SOC_CAPS_H
+#define RF_HOST_SOC_CAPS_H
+
+// Host shim of the ESP-IDF header of the same name, with ESP32-S3 values
+
+#define SOC_GPIO_PIN_COUNT 49
+#define SOC_RMT_MEM_WORDS_PER_CHANNEL 48
+
+#endif // RF_HOST_SOC_CAPS_H
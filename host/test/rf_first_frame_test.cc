@@ -0,0 +1,119 @@
+// Press latency of the receive decoder, built once per value of
+// CONFIG_RF_MODULE_RX_CONFIRM_REPEAT (see CMakeLists.txt). The decoder is set
+// up as RfRadioChannel sets it up. Each press of 8 frames, with +-60 us of
+// jitter on every pulse, must be reported on its first frame without
+// confirmation and only at the end of the matching second frame with it,
+// then every other frame. Both frame styles are covered: remote style
+// (bits, then a sync) and this module's own (RfPulseEncoder: sync, bits, sync).
+// The latency from the press's first edge to its first report is measured on
+// the edge timestamps and must stay within that many frame times.
+
+#include <vector>
+#include "rf_decoder.h"
+#include "rf_module_config.h"
+#include "rf_pulse_encoder.h"
+#include "rf_test.h"
+
+static const int kRepeats = 8;
+
+// Edge stream of one press; frame_ends[i] is the edge that completes frame i + 1
+struct Press {
+    std::vector<RfEdge> edges;
+    std::vector<uint32_t> frame_ends;
+    uint32_t time = 0;
+    uint32_t jitter_state = 1;
+
+    void Pulse(bool level, uint32_t duration) {
+        jitter_state = jitter_state * 1103515245 + 12345;
+        edges.push_back({ time, static_cast<uint8_t>(level) });
+        time += duration + (jitter_state >> 16) % 121 - 60;
+    }
+    void HighLow(const RfHighLow& pulses, uint16_t pulse_length, bool inverted) {
+        Pulse(!inverted, pulses.high * pulse_length);
+        Pulse(inverted, pulses.low * pulse_length);
+    }
+    void EndFrame() { frame_ends.push_back(time); }
+};
+
+static Press MakePress(const RfProtocol& protocol, uint64_t code, unsigned int bits, bool remote_style) {
+    Press press;
+    press.time = 100000;  // Idle before the press
+    for (int repeat = 0; repeat < kRepeats; repeat++) {
+        if (!remote_style) {
+            press.HighLow(protocol.syncFactor, protocol.pulseLength, protocol.invertedSignal);
+        }
+        for (int i = static_cast<int>(bits) - 1; i >= 0; i--) {
+            press.HighLow((code >> i) & 1 ? protocol.one : protocol.zero, protocol.pulseLength, protocol.invertedSignal);
+        }
+        press.HighLow(protocol.syncFactor, protocol.pulseLength, protocol.invertedSignal);
+        press.EndFrame();
+    }
+    press.Pulse(!protocol.invertedSignal, 0);  // Next press or noise: completes the last frame
+    return press;
+}
+
+// Frame numbers (1-based) the press was reported on; latency_us is from its first edge to the first report
+static std::vector<int> ReportedFrames(RfDecoder& decoder, const Press& press, uint64_t code, unsigned int bits,
+                                       uint32_t& latency_us) {
+    std::vector<int> reported;
+    RfDecodedFrame frame;
+    for (const RfEdge& edge : press.edges) {
+        if (!decoder.ProcessEdge(edge.timestamp, edge.level, frame)) {
+            continue;
+        }
+        RF_CHECK(frame.value == code && frame.bitlength == bits);
+        int number = 0;
+        for (size_t i = 0; i < press.frame_ends.size(); i++) {
+            if (press.frame_ends[i] == edge.timestamp) {
+                number = static_cast<int>(i) + 1;
+            }
+        }
+        RF_CHECK(number != 0);  // Reported on the edge that completes a frame, not later
+        if (reported.empty()) {
+            latency_us = edge.timestamp - press.edges[0].timestamp;
+        }
+        reported.push_back(number);
+    }
+    return reported;
+}
+
+int main() {
+    RfDecoder decoder(RfProtocolRegistry::GetInstance());
+    decoder.SetConfirmRepeat(CONFIG_RF_MODULE_RX_CONFIRM_REPEAT);  // As RfRadioChannel does
+    const int first = CONFIG_RF_MODULE_RX_CONFIRM_REPEAT ? 2 : 1;
+    const std::vector<int> expected = { first, first + 2, first + 4, first + 6 };
+    uint32_t worst_latency_us = 0;
+    double worst_latency_frames = 0;
+
+    for (unsigned int number : { 1u, 2u, 3u, 5u }) {
+        RfProtocol protocol;
+        RF_CHECK(RfProtocolRegistry::GetInstance().Get(number, protocol));
+        for (unsigned int bits : { 24u, 32u }) {
+            for (bool remote_style : { true, false }) {
+                const uint64_t code = 0xA5C3F00DULL & ((1ULL << bits) - 1);
+                decoder.Reset();
+                const Press press = MakePress(protocol, code, bits, remote_style);
+                uint32_t latency_us = 0;
+                const std::vector<int> reported = ReportedFrames(decoder, press, code, bits, latency_us);
+                if (reported != expected) {
+                    printf("protocol %u, %u bits, %s frames: first report on frame %d, %zu reports\n", number, bits,
+                           remote_style ? "remote" : "module", reported.empty() ? 0 : reported[0], reported.size());
+                }
+                RF_CHECK(reported == expected);
+                
+                // Within `first` frame times, with half a frame to spare for the jitter
+                const double frame_us = static_cast<double>(press.frame_ends.back() - press.edges[0].timestamp) / kRepeats;
+                const double latency_frames = latency_us / frame_us;
+                RF_CHECK(latency_us > 0 && latency_frames < first + 0.5);
+                if (latency_us > worst_latency_us) {
+                    worst_latency_us = latency_us;
+                }
+                if (latency_frames > worst_latency_frames) {
+                    worst_latency_frames = latency_frames;
+                }
+            }
+        }
+    }
+    printf("first report after at most %.1f ms (%.2f frame times)\n", worst_latency_us / 1000.0, worst_latency_frames);
+    return RF_TEST_RESULT();
+}
@@ -0,0 +1,87 @@
+// RFModule end to end on the host shims: a code sent on one channel is
+// received on another wired to it, saved to flash and loaded back.
+// Runs on the manual clock, so the airtime is exact whatever the host load.
+
+#include <esp_log.h>
+#include <chrono>
+#include <thread>
+#include "rf_host.h"
+#include "rf_module.h"
+#include "rf_test.h"
+
+static const RfChannelConfig kChannels[] = {
+    { RF_433MHZ, 0, GPIO_NUM_17, GPIO_NUM_NC },
+    { RF_433MHZ, 1, GPIO_NUM_NC, GPIO_NUM_18 },
+};
+
+// Polls in real time: the decoder task runs on its own thread and the manual clock stands still
+static bool ReceiveWithin(RFModule& rf, RFSignal& signal, int ms) {
+    for (int i = 0; i < ms; i++) {
+        if (rf.Receive(signal)) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+int main() {
+    RfHost::SetLogLevel(ESP_LOG_ERROR);  // Capture mode warns about its own save; SaveToFlash() below is the one checked
+    RfHost::SetManualClock(true);
+    RfHost::Connect(17, 18);
+
+    RFSignal sent;
+    sent.code = 0x123456;
+    sent.bit_length = 24;
+    sent.protocol = 1;
+    sent.pulse_length = 350;
+    {
+        RFModule rf(kChannels, 2);
+        rf.Begin();
+        rf.EnableReceive(RF_433MHZ);
+        rf.EnableFlashStorage();
+        rf.EnableCaptureMode();
+        rf.Send(sent);
+        RF_CHECK(RfHost::TakeOutput(17).size() > 2 * 24);
+
+        RFSignal received;
+        RF_CHECK(ReceiveWithin(rf, received, 2000));
+        RF_CHECK(received.code == sent.code);
+        RF_CHECK(received.bit_length == sent.bit_length);
+        RF_CHECK(received.protocol == sent.protocol);
+        RF_CHECK(received.channel == 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        RF_CHECK(!rf.Receive(received));  // The next frame is only a repeat
+        
+        // The third frame's trailing sync gap only ends at the next edge, as a later press or
+        // noise would end it. Every other frame of a press is reported: frames 1 and 3 of
+        // the three sent here, or only frame 2 when a repeat has to confirm the first
+        RfHost::Drive(18, 1);
+        RfHost::Advance(350);
+        RfHost::Drive(18, 0);
+        if (!RF_TEST_CONFIRM_REPEAT) {
+            RF_CHECK(ReceiveWithin(rf, received, 2000));
+            RF_CHECK(received.code == sent.code && received.channel == 1);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        RF_CHECK(!rf.Receive(received));
+
+        RF_CHECK(rf.HasCapturedSignal());
+        RF_CHECK(rf.SaveToFlash());
+        RF_CHECK(rf.Flush());
+        rf.End();
+    }
+    {
+        RFModule rf(kChannels, 2);
+        rf.Begin();
+        rf.EnableFlashStorage();
+        RF_CHECK(rf.LoadFromFlash());
+        RF_CHECK(rf.GetFlashSignalCount() == 1);
+        RFSignal saved;
+        RF_CHECK(rf.GetFlashSignal(0, saved));
+        RF_CHECK(saved.code == sent.code && saved.bit_length == sent.bit_length);
+        rf.End();
+    }
+    RfHost::Disconnect(17);
+    return RF_TEST_RESULT();
+}
@@ -0,0 +1,119 @@
+// RfPulseEncoder against the protocol table: the symbols of a send (frames
+// of sync, MSB-first bits, sync) must hold exactly the levels and durations
+// RfProtocolRegistry gives for each half pulse, inverted protocols included.
+// Also: pulses longer than a symbol field are split, an odd last half gets
+// the zero-length end marker, and running out of room is reported.
+
+#include <vector>
+#include "rf_protocol.h"
+#include "rf_pulse_encoder.h"
+#include "rf_test.h"
+
+struct Half {
+    bool level;
+    uint32_t duration;
+    bool operator==(const Half& other) const { return level == other.level && duration == other.duration; }
+};
+
+// Straight from the table: high then low, levels swapped when inverted
+static void AddExpected(std::vector<Half>& halves, const RfHighLow& pulses, const RfProtocol& protocol) {
+    halves.push_back({ !protocol.invertedSignal, static_cast<uint32_t>(protocol.pulseLength) * pulses.high });
+    halves.push_back({ protocol.invertedSignal, static_cast<uint32_t>(protocol.pulseLength) * pulses.low });
+}
+
+static std::vector<Half> Expected(const RfProtocol& protocol, uint64_t code, unsigned int bits, int frames) {
+    std::vector<Half> halves;
+    for (int frame = 0; frame < frames; frame++) {
+        AddExpected(halves, protocol.syncFactor, protocol);
+        for (int i = static_cast<int>(bits) - 1; i >= 0; i--) {
+            AddExpected(halves, (code >> i) & 1 ? protocol.one : protocol.zero, protocol);
+        }
+        AddExpected(halves, protocol.syncFactor, protocol);
+    }
+    return halves;
+}
+
+// What the RMT peripheral would clock out; a zero-length half ends the transmission
+static std::vector<Half> Played(const RfPulseEncoder& encoder, bool merge_levels) {
+    std::vector<Half> halves;
+    for (size_t i = 0; i < encoder.Size(); i++) {
+        const RfSymbol& symbol = encoder.Data()[i];
+        const Half pair[2] = { { symbol.level0 != 0, symbol.duration0 }, { symbol.level1 != 0, symbol.duration1 } };
+        for (const Half& half : pair) {
+            RF_CHECK(half.duration <= RfPulseEncoder::kMaxDuration);
+            if (half.duration == 0) {
+                RF_CHECK(i + 1 == encoder.Size());
+                continue;
+            }
+            if (merge_levels && !halves.empty() && halves.back().level == half.level) {
+                halves.back().duration += half.duration;
+            } else {
+                halves.push_back(half);
+            }
+        }
+    }
+    return halves;
+}
+
+int main() {
+    const int kFrames = 3;  // As RfRadioChannel::send() repeats them
+    std::vector<RfSymbol> buffer(RfPulseEncoder::SymbolsPerFrame(64) * kFrames);
+
+    // Built-in protocols, 6 and 9 inverted; 3 and 8 have long syncs and uneven bits
+    for (unsigned int number : { 1u, 2u, 3u, 6u, 8u, 9u }) {
+        RfProtocol protocol;
+        RF_CHECK(RfProtocolRegistry::GetInstance().Get(number, protocol));
+        for (unsigned int bits : { 1u, 24u, 32u, 64u }) {
+            const uint64_t code = 0xF00DA5C3B0E11ULL & (bits == 64 ? ~0ULL : (1ULL << bits) - 1);
+            RfPulseEncoder encoder(buffer.data(), buffer.size());
+            for (int frame = 0; frame < kFrames; frame++) {
+                RF_CHECK(encoder.AddFrame(protocol, code, bits));
+            }
+            RF_CHECK(encoder.Finish());
+            // Levels alternate all the way through, so every symbol is one full high/low pair
+            RF_CHECK(encoder.Size() == RfPulseEncoder::SymbolsPerFrame(bits) * kFrames);
+            const bool same = Played(encoder, false) == Expected(protocol, code, bits, kFrames);
+            if (!same) {
+                printf("protocol %u, %u bits: symbols differ from the table\n", number, bits);
+            }
+            RF_CHECK(same);
+        }
+    }
+
+    // A sync longer than a 15-bit duration field is split over symbols of the same level
+    const RfProtocol slow = { 1000, { 1, 40 }, { 1, 3 }, { 3, 1 }, false };
+    {
+        RfPulseEncoder encoder(buffer.data(), buffer.size());
+        RF_CHECK(encoder.AddFrame(slow, 0x5A, 8));
+        RF_CHECK(encoder.Finish());
+        RF_CHECK(encoder.Size() > RfPulseEncoder::SymbolsPerFrame(8));
+        RF_CHECK(Played(encoder, true) == Expected(slow, 0x5A, 8, 1));
+    }
+
+    // An odd number of halves: the last symbol ends with the zero-length marker
+    {
+        RfPulseEncoder encoder(buffer.data(), buffer.size());
+        RF_CHECK(encoder.AddPulse(true, 500));
+        RF_CHECK(encoder.AddPulse(true, 200));  // Same level: merged
+        RF_CHECK(encoder.AddPulse(false, 300));
+        RF_CHECK(encoder.AddPulse(true, 400));
+        RF_CHECK(encoder.Finish());
+        RF_CHECK(encoder.Size() == 2);
+        RF_CHECK(buffer[0].duration0 == 700 && buffer[0].level0 == 1);
+        RF_CHECK(buffer[0].duration1 == 300 && buffer[0].level1 == 0);
+        RF_CHECK(buffer[1].duration0 == 400 && buffer[1].level0 == 1);
+        RF_CHECK(buffer[1].duration1 == 0 && buffer[1].level1 == 1);
+    }
+
+    // Too small a buffer is reported, not overrun
+    {
+        RfProtocol protocol;
+        RF_CHECK(RfProtocolRegistry::GetInstance().Get(1, protocol));
+        const size_t capacity = RfPulseEncoder::SymbolsPerFrame(24) - 1;
+        RfPulseEncoder encoder(buffer.data(), capacity);
+        encoder.AddFrame(protocol, 0x123456, 24);
+        RF_CHECK(!encoder.Finish());
+        RF_CHECK(encoder.Overflowed() && encoder.Size() == capacity);
+    }
+    return RF_TEST_RESULT();
+}
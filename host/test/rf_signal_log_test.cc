@@ -0,0 +1,142 @@
+// RfSignalLog on the file-backed medium against a model: a std::map of the
+// live payloads. Random writes, supersedes, erases and clears, background
+// style compaction, remounts from the file alone, and power cuts that tear
+// a record halfway through programming it.
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <map>
+#include <random>
+#include <vector>
+#include "rf_file_medium.h"
+#include "rf_signal_log.h"
+#include "rf_test.h"
+
+typedef std::map<uint16_t, std::vector<uint8_t>> Model;
+
+static const uint16_t kKeys = 48;
+static const size_t kSectors = 12;
+
+// Programs only the first `tear` bytes of the next write, then fails it, as a power cut would
+class TearingMedium : public RfFileMedium {
+public:
+    TearingMedium() : tear_(0) {}
+    void TearNextWrite(size_t bytes) { tear_ = bytes; }
+    bool Write(size_t offset, const void* data, size_t size) override {
+        if (tear_ == 0) {
+            return RfFileMedium::Write(offset, data, size);
+        }
+        const size_t bytes = tear_ < size ? tear_ : size - 1;
+        tear_ = 0;
+        if (bytes > 0) {
+            RfFileMedium::Write(offset, data, bytes);
+        }
+        return false;
+    }
+
+private:
+    size_t tear_;
+};
+
+static void CheckAgainst(const RfSignalLog& log, const Model& model) {
+    size_t live_bytes = 0;
+    for (const Model::value_type& entry : model) {
+        live_bytes += (entry.second.size() + RfSignalLog::kRecordOverhead + 3) & ~static_cast<size_t>(3);
+    }
+    RF_CHECK(log.LiveBytes() == live_bytes);  // What compaction decisions are based on
+    for (uint16_t key = 0; key < kKeys; key++) {
+        const Model::const_iterator it = model.find(key);
+        RF_CHECK(log.Contains(key) == (it != model.end()));
+        uint8_t payload[RfSignalLog::kMaxPayload];
+        size_t size = 0;
+        if (it != model.end()) {
+            RF_CHECK(log.Read(key, payload, sizeof(payload), size));
+            RF_CHECK(size == it->second.size() && memcmp(payload, it->second.data(), size) == 0);
+        } else {
+            RF_CHECK(!log.Read(key, payload, sizeof(payload), size));
+        }
+    }
+}
+
+// Power cycle: everything the log knows comes back from the file
+static void Remount(RfSignalLog& log, TearingMedium& medium, const char* path) {
+    log.Unmount();
+    medium.Close();
+    RF_CHECK(medium.Open(path, kSectors * 4096));
+    RF_CHECK(log.Mount(&medium, kKeys));
+}
+
+static std::vector<uint8_t> RandomPayload(std::mt19937& random) {
+    // Mostly signal-record sized, sometimes the largest a record can hold
+    const size_t size = random() % 8 == 0 ? RfSignalLog::kMaxPayload : 1 + random() % 80;
+    std::vector<uint8_t> payload(size);
+    for (uint8_t& byte : payload) {
+        byte = static_cast<uint8_t>(random());
+    }
+    return payload;
+}
+
+static void Run(const char* path, int operations, uint32_t seed) {
+    std::mt19937 random(seed);
+    unlink(path);
+    TearingMedium medium;
+    RF_CHECK(medium.Open(path, kSectors * 4096));
+    RfSignalLog log;
+    RF_CHECK(log.Mount(&medium, kKeys));
+    Model model;
+    int torn = 0;
+
+    for (int op = 0; op < operations; op++) {
+        const uint16_t key = static_cast<uint16_t>(random() % kKeys);
+        const uint32_t choice = random() % 100;
+        if (choice < 60) {
+            // New key or a supersede of an existing one
+            const std::vector<uint8_t> payload = RandomPayload(random);
+            RF_CHECK(log.Write(key, payload.data(), payload.size()));
+            model[key] = payload;
+        } else if (choice < 80) {
+            RF_CHECK(log.Erase(key));
+            model.erase(key);
+        } else if (choice < 81) {
+            RF_CHECK(log.Clear());
+            model.clear();
+        } else if (choice < 85) {
+            Remount(log, medium, path);
+        } else if (choice < 88) {
+            // Power cut while programming a supersede: the key keeps its previous payload
+            const std::vector<uint8_t> payload = RandomPayload(random);
+            medium.TearNextWrite(1 + random() % (payload.size() + 7));
+            RF_CHECK(!log.Write(key, payload.data(), payload.size()));
+            Remount(log, medium, path);
+            torn++;
+        } else {
+            // What the compaction task does when the log runs low
+            while (log.NeedsCompaction()) {
+                RF_CHECK(log.Compact());
+            }
+        }
+        CheckAgainst(log, model);
+        RF_CHECK(log.LiveBytes() <= log.Capacity());
+    }
+    Remount(log, medium, path);
+    CheckAgainst(log, model);
+    RF_CHECK(torn > 0);
+    RF_CHECK(medium.EraseCount() > 0);  // The log wrapped round and reclaimed sectors
+    log.Unmount();
+    medium.Close();
+    unlink(path);
+}
+
+int main() {
+    char path[] = "/tmp/rf_signal_log_test_XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd < 0) {
+        printf("no temporary file\n");
+        return 1;
+    }
+    close(fd);
+    for (uint32_t seed = 1; seed <= 20; seed++) {
+        Run(path, 3000, seed);
+    }
+    return RF_TEST_RESULT();
+}
@@ -0,0 +1,124 @@
+// RfSlotTable against a model: a std::deque of the used slots, oldest
+// first. Random Allocate/Free/SlotAt/IndexOf, and reboots rebuilt with
+// Restore() + FinishRestore() from the sequence numbers alone.
+
+#include <algorithm>
+#include <deque>
+#include <random>
+#include "rf_slot_table.h"
+#include "rf_test.h"
+
+static const uint16_t kNoSlot = RfSlotTable::kNoSlot;
+
+// Everything the table reports agrees with the model
+static void CheckAgainst(const RfSlotTable& table, const std::deque<uint16_t>& model) {
+    RF_CHECK(table.Count() == model.size());
+    for (uint16_t index = 0; index < model.size(); index++) {
+        const uint16_t slot = model[model.size() - 1 - index];
+        RF_CHECK(table.SlotAt(index) == slot);
+        RF_CHECK(table.IndexOf(slot) == index);
+    }
+    RF_CHECK(table.SlotAt(static_cast<uint16_t>(model.size())) == kNoSlot);
+    for (uint16_t slot = 0; slot < table.Capacity(); slot++) {
+        const bool used = std::find(model.begin(), model.end(), slot) != model.end();
+        RF_CHECK(table.Used(slot) == used);
+        RF_CHECK((table.IndexOf(slot) == kNoSlot) == !used);
+        RF_CHECK((table.Sequence(slot) == 0) == !used);
+    }
+}
+
+// Power cycle: a fresh table learns the used slots and their sequences, in any order
+static void Reboot(RfSlotTable& table, std::mt19937& random) {
+    std::vector<uint16_t> slots;
+    std::vector<uint32_t> sequences;
+    for (uint16_t slot = 0; slot < table.Capacity(); slot++) {
+        if (table.Used(slot)) {
+            slots.push_back(slot);
+            sequences.push_back(table.Sequence(slot));
+        }
+    }
+    std::vector<size_t> order(slots.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), random);
+    table.Reset(table.Capacity());
+    for (size_t i : order) {
+        RF_CHECK(table.Restore(slots[i], sequences[i]));
+        RF_CHECK(!table.Restore(slots[i], sequences[i]));  // Already restored
+    }
+    RF_CHECK(!table.Restore(table.Capacity(), 1));
+    table.FinishRestore();
+}
+
+static void Run(uint16_t capacity, int operations, uint32_t seed) {
+    std::mt19937 random(seed);
+    RfSlotTable table;
+    table.Reset(capacity);
+    std::deque<uint16_t> model;
+    uint32_t last_sequence = 0;
+    uint16_t last_freed = kNoSlot;
+
+    uint32_t sequence = 0;
+    RF_CHECK(table.Allocate(sequence) == 0);  // Lowest slot first
+    model.push_back(0);
+    last_sequence = sequence;
+
+    for (int op = 0; op < operations; op++) {
+        const unsigned int choice = random() % 100;
+        if (choice < 45) {
+            const uint16_t slot = table.Allocate(sequence);
+            if (model.size() == capacity) {
+                RF_CHECK(slot == kNoSlot);
+            } else {
+                RF_CHECK(slot < capacity);
+                RF_CHECK(std::find(model.begin(), model.end(), slot) == model.end());
+                RF_CHECK(last_freed == kNoSlot || slot == last_freed);  // Freed last, reused first
+                RF_CHECK(sequence > last_sequence);  // Newer than every live slot
+                RF_CHECK(table.Sequence(slot) == sequence);
+                model.push_back(slot);
+                last_sequence = sequence;
+            }
+            last_freed = kNoSlot;
+        } else if (choice < 85) {
+            const uint16_t slot = random() % (capacity + 1);  // Sometimes out of range
+            const auto found = std::find(model.begin(), model.end(), slot);
+            RF_CHECK(table.Free(slot) == (found != model.end()));
+            if (found != model.end()) {
+                model.erase(found);
+                last_freed = slot;
+            }
+        } else if (choice < 97) {
+            if (!model.empty()) {
+                const uint16_t index = random() % model.size();
+                const uint16_t slot = model[model.size() - 1 - index];
+                RF_CHECK(table.SlotAt(index) == slot);
+                RF_CHECK(table.IndexOf(slot) == index);
+            }
+        } else {
+            Reboot(table, random);
+            CheckAgainst(table, model);
+            last_freed = kNoSlot;
+            // Sequences only have to stay above the live ones, which is all a reboot knows
+            last_sequence = model.empty() ? 0 : table.Sequence(model.back());
+        }
+        if (op % 64 == 0) {
+            CheckAgainst(table, model);
+        }
+    }
+    CheckAgainst(table, model);
+
+    table.Clear();
+    model.clear();
+    CheckAgainst(table, model);
+    RF_CHECK(table.Allocate(sequence) == 0 && sequence == 1);
+}
+
+int main() {
+    Run(1, 2000, 1);
+    Run(2, 5000, 2);
+    Run(10, 50000, 3);
+    Run(100, 50000, 4);
+    Run(1000, 20000, 5);
+    return RF_TEST_RESULT();
+}
@@ -0,0 +1,35 @@
+#ifndef RF_TEST_H
+#define RF_TEST_H
+
+#include <stdio.h>
+#include "rf_host.h"
+
+/**
+ * Minimal checks for the host tests in this directory. A failed RF_CHECK
+ * prints where it failed and the test carries on; RF_TEST_RESULT() is the
+ * exit status, non-zero after any failure, as ctest expects.
+ */
+inline int& RfTestFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define RF_CHECK(condition)                                                       \
+    do {                                                                          \
+        if (!(condition)) {                                                       \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            RfTestFailures()++;                                                   \
+        }                                                                         \
+    } while (0)
+
+// Busy-wait transmit spins until the clock reaches the end of each pulse, which the
+// manual clock never does on its own. Tests that transmit take the manual clock only
+// when TX goes through the RMT shim (RF_TEST_BUSY_WAIT_TX is set by CMakeLists.txt)
+inline bool RfTestUseTxClock() {
+    RfHost::SetManualClock(!RF_TEST_BUSY_WAIT_TX);
+    return !RF_TEST_BUSY_WAIT_TX;
+}
+
+#define RF_TEST_RESULT() (printf(RfTestFailures() ? "FAILED (%d)\n" : "OK\n", RfTestFailures()), RfTestFailures() != 0)
+
+#endif // RF_TEST_H
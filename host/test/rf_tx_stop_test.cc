@@ -0,0 +1,56 @@
+// End() stops the TX task: jobs queued before it are all transmitted and
+// their callbacks have run by the time it returns, and it never hangs,
+// whether the task is idle, between jobs or in the middle of one.
+// GetSendCount() counts what went out, not what was asked for.
+
+#include <esp_log.h>
+#include <atomic>
+#include "rf_host.h"
+#include "rf_module.h"
+#include "rf_test.h"
+
+static const RfChannelConfig kChannels[] = {
+    { RF_433MHZ, 0, GPIO_NUM_17, GPIO_NUM_NC },
+};
+
+static void CountSent(RfTxHandle handle, const RfTxResult& result, void* context) {
+    (void)handle;
+    if (result.sent) {
+        static_cast<std::atomic<int>*>(context)->fetch_add(1);
+    }
+}
+
+int main() {
+    RfHost::SetLogLevel(ESP_LOG_ERROR);
+    // On the manual clock transmits take no wall time, so End() lands anywhere in the queue;
+    // on the real clock each takes its airtime, and fewer rounds still cover the same cases
+    const int rounds = RfTestUseTxClock() ? 200 : 10;
+    RFSignal signal;
+    signal.code = 0x5A5A5A;
+    signal.bit_length = 24;
+    signal.protocol = 1;
+    signal.pulse_length = 350;
+    for (int round = 0; round < rounds; round++) {
+        RFModule rf(kChannels, 1);
+        rf.Begin();
+        std::atomic<int> sent(0);
+        const int queued = round % 5;  // Fewer than the queue holds, so none is refused
+        for (int i = 0; i < queued; i++) {
+            RF_CHECK(rf.SendAsync(signal, 0, CountSent, &sent) != 0);
+        }
+        rf.End();
+        RF_CHECK(sent.load() == queued);
+        RF_CHECK(rf.GetSendCount() == static_cast<uint32_t>(queued));
+        RfHost::TakeOutput(17);
+    }
+    {
+        RFModule rf(kChannels, 1);
+        rf.Begin();
+        signal.frequency = RF_315MHZ;  // No channel transmits on it
+        rf.Send(signal);
+        RF_CHECK(rf.SendAsync(signal) == 0);
+        rf.End();
+        RF_CHECK(rf.GetSendCount() == 0);
+    }
+    return RF_TEST_RESULT();
+}
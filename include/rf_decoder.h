@@ -0,0 +1,147 @@
+#ifndef RF_DECODER_H
+#define RF_DECODER_H
+
+#include <stdint.h>
+#include "rf_metrics.h"
+#include "rf_protocol.h"
+#include "rf_raw_code.h"
+#include "rf_trace.h"
+
+// One GPIO edge as captured by the receive ISR
+struct RfEdge {
+    uint32_t timestamp;  // esp_timer time in microseconds (wraps, only differences are used)
+    uint8_t level;       // Pin level after the edge
+};
+
+struct RfDecodedFrame {
+    uint64_t value;
+    unsigned int bitlength;
+    unsigned int delay;
+    unsigned int protocol;
+    uint32_t timestamp;  // Edge that completed the frame
+};
+
+/**
+ * RC-switch style protocol decoder.
+ *
+ * Fed one edge timestamp at a time (from the decoder task, not the ISR).
+ * Streaming: a gap over kSeparationLimit is taken as the sync that leads a
+ * frame, every enabled protocol's bit timings are derived from it at once,
+ * and each bit pair is classified as soon as its second edge arrives, so
+ * protocols drop out at their first mismatch. The frame is accepted at its
+ * trailing sync. The first frame of a press is led by idle time rather
+ * than a sync, so it is decoded against its trailing sync instead.
+ *
+ * Repeats of one press are reported every other frame, starting with the
+ * first; with SetConfirmRepeat() the first report waits for the second
+ * frame to match (the rc-switch behaviour, one frame later).
+ *
+ * Pure C++ with no ESP-IDF dependency, so it can be driven with synthetic
+ * edge streams on the host.
+ */
+class RfDecoder {
+public:
+    // Protocols have no fixed length (it is read off the frame), so frames are decoded up to
+    // the longest code any protocol can carry: sync gap, two timings per bit, closing sync pulse
+    static constexpr unsigned int kMaxCodeBits = 64;
+    static constexpr unsigned int kMaxChanges = 2 * kMaxCodeBits + 2;
+    static constexpr unsigned int kSeparationLimit = 4300;  // us, gap that separates two frames
+    static constexpr unsigned int kRepeatGapTolerance = 200;  // us, sync gaps of one press differ by less
+    static constexpr unsigned int kMaxProtocols = RfProtocolRegistry::kMaxProtocols;
+    static constexpr unsigned int kMaxRawChanges = RfRawCode::kMaxTimings;  // Frame length limit in raw capture
+
+    // Only protocols in protocol_mask (bit n-1 = protocol n) are ever tried,
+    // on top of what the registry has enabled
+    explicit RfDecoder(const RfProtocolRegistry& registry, uint32_t protocol_mask = 0xFFFFFFFF);
+
+    void Reset();
+    void SetReceiveTolerance(int percent) { receive_tolerance_ = percent; }
+    void SetConfirmRepeat(bool enabled) { confirm_repeat_ = enabled; }
+    bool ConfirmRepeat() const { return confirm_repeat_; }
+    void SetMetrics(RfMetricsBlock* metrics) { metrics_ = metrics; }  // nullptr: not counted
+    void SetTrace(RfChannelTrace* trace) { trace_ = trace; }          // Records to trace->rx; nullptr: off
+
+    // Returns true when this edge completed a frame; the result is written to frame.
+    // level is the pin level after the edge.
+    bool ProcessEdge(uint32_t timestamp, uint8_t level, RfDecodedFrame& frame);
+
+    // Raw capture: frames no enabled protocol matches are kept as pulse timings
+    // once the same shape has been seen twice in a row
+    void SetRawCapture(bool enabled);
+    bool RawCapture() const { return raw_capture_; }
+    bool RawFrameReady() const { return raw_ready_; }
+    bool PopRawFrame(RfRawCode& raw);
+
+    // Enabled protocol numbers (1-based) in the order they are currently preferred
+    const uint8_t* ProtocolOrder() const { return order_; }
+    unsigned int ProtocolCount() const { return protocol_count_; }
+
+private:
+    // Frame shape of one protocol in pulse-length units, fixed at construction
+    struct Shape {
+        uint64_t sync_reciprocal;  // ceil(2^32 / sync_length), replaces the per-frame division
+        uint8_t sync_length;
+        uint8_t zero_high;
+        uint8_t zero_low;
+        uint8_t one_high;
+        uint8_t one_low;
+        uint8_t first_timing;
+    };
+
+    // Per-protocol expectations for the frame being decoded
+    struct Candidate {
+        unsigned int zero_high;
+        unsigned int zero_low;
+        unsigned int one_high;
+        unsigned int one_low;
+        unsigned int tolerance;
+        unsigned int delay;
+        unsigned int first_timing;
+        uint64_t code;
+    };
+
+    void Reload();
+    void BeginFrame(unsigned int gap, uint8_t level);
+    void ClassifyPair();
+    bool EndFrame(unsigned int gap, RfDecodedFrame& frame);
+    bool Decode(unsigned int change_count, RfDecodedFrame& frame);
+    void SetupCandidate(unsigned int rank);
+    bool Accept(unsigned int rank, unsigned int change_count, RfDecodedFrame& frame);
+    void CaptureRaw(unsigned int change_count, unsigned int gap);
+    bool FinishCandidate(Candidate& c, unsigned int k, unsigned int change_count) const;
+    bool ShiftBit(Candidate& c, unsigned int i) const;
+    void RecordHit(unsigned int rank);
+    void CountMisses(unsigned int winner);
+
+    const RfProtocolRegistry& registry_;
+    const uint32_t protocol_mask_;     // Compile-time protocol set of the owning channel
+    uint32_t generation_;              // Registry generation shapes_/order_ were built from
+    uint32_t enabled_mask_;
+    unsigned int protocol_count_;      // Enabled protocols, i.e. entries in order_
+    Shape shapes_[kMaxProtocols];      // Indexed by protocol number - 1
+    uint8_t order_[kMaxProtocols];     // Enabled protocol numbers sorted by recent hit rate
+    uint16_t hits_[kMaxProtocols];     // Decaying hit score per protocol (index p - 1)
+    uint8_t hits_since_decay_;
+    Candidate candidates_[kMaxProtocols];  // Indexed by rank in order_
+    int receive_tolerance_;
+    uint32_t last_time_;
+    unsigned int change_count_;
+    uint32_t alive_;                     // Ranks still matching the frame in timings_
+    bool confirm_repeat_;
+    RfMetricsBlock* metrics_;
+    RfChannelTrace* trace_;
+    // Press the last accepted frame belongs to
+    bool burst_open_;                    // The next frame may repeat it
+    uint64_t burst_value_;
+    unsigned int burst_bitlength_;
+    unsigned int burst_protocol_;
+    unsigned int burst_frames_;
+    uint8_t frame_level_;                // Level of the first pulse of the frame in timings_
+    bool raw_capture_;
+    bool raw_ready_;                     // raw_frame_ holds a confirmed frame
+    RfRawCode raw_frame_;                // Latest undecodable frame
+    RfRawCode raw_previous_;             // The one before, for repeat confirmation
+    unsigned int timings_[kMaxRawChanges > kMaxChanges ? kMaxRawChanges : kMaxChanges];  // Protocol decoding only uses the first kMaxChanges
+};
+
+#endif // RF_DECODER_H
@@ -0,0 +1,123 @@
+#ifndef RF_EDGE_CAPTURE_H
+#define RF_EDGE_CAPTURE_H
+
+#include <esp_attr.h>
+#include <esp_cpu.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <hal/gpio_ll.h>
+#include <esp_private/cache_utils.h>
+#include <new>
+#include "rf_decoder.h"
+#include "rf_metrics.h"
+#include "rf_spsc_ring.h"
+#include "rf_trace.h"
+
+// A Kconfig bool that is off is left undefined. The host build has no sdkconfig at all
+#if defined(ESP_PLATFORM) && !defined(CONFIG_ESP_TIMER_IN_IRAM)
+#warning "esp_timer_get_time() is not in IRAM: edges arriving during flash writes will fault the receive ISR"
+#endif
+
+/**
+ * Everything the receive GPIO ISR touches, kept cache-safe
+ *
+ * NVS and partition writes disable the flash cache. Only code in IRAM and
+ * data in internal RAM may run then, and only ISRs registered with
+ * ESP_INTR_FLAG_IRAM are serviced. Create() therefore places this state in
+ * internal RAM, even when the owning object ends up in PSRAM. OnEdge() is
+ * forced inline into the IRAM ISR and calls only IRAM-resident code:
+ * esp_timer_get_time(), the inline GPIO LL register read,
+ * spi_flash_cache_enabled(), the ring's producer side, the inline
+ * metric and trace updates and vTaskNotifyGiveFromISR().
+ *
+ * The channel's RfMetricsBlock and RfChannelTrace are allocated alongside,
+ * in internal RAM as well, only when metrics or tracing are compiled in.
+ */
+struct RfEdgeCapture {
+    static constexpr size_t kRingSize = 256;
+
+    RfSpscRing<RfEdge, kRingSize> ring;  // ISR -> decoder task
+    uint32_t pin;
+    uint32_t lastTime;                   // ISR only
+    TaskHandle_t decoderTask;
+    volatile uint32_t cacheOffEdges;     // Edges captured while the flash cache was disabled; ISR writes
+    RfMetricsBlock* metrics;             // Whole channel (ISR, decoder task, TX); nullptr when compiled out
+    RfChannelTrace* trace;               // Likewise
+    uint32_t burstEdges;                 // ISR only: edges since the last separation gap
+
+    RfEdgeCapture()
+        : pin(0), lastTime(0), decoderTask(nullptr), cacheOffEdges(0), metrics(nullptr), trace(nullptr),
+          burstEdges(0) {}
+
+    static RfEdgeCapture* Create() {
+        void* memory = heap_caps_malloc(sizeof(RfEdgeCapture), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (memory == nullptr) {
+            return nullptr;
+        }
+        RfEdgeCapture* capture = new (memory) RfEdgeCapture();
+#if CONFIG_RF_MODULE_ENABLE_METRICS
+        void* block = heap_caps_malloc(sizeof(RfMetricsBlock), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        capture->metrics = block != nullptr ? new (block) RfMetricsBlock() : nullptr;
+#endif
+#if CONFIG_RF_MODULE_ENABLE_TRACE
+        void* rings = heap_caps_malloc(sizeof(RfChannelTrace), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        capture->trace = rings != nullptr ? new (rings) RfChannelTrace() : nullptr;
+#endif
+        return capture;
+    }
+
+    static void Destroy(RfEdgeCapture* capture) {
+        if (capture != nullptr) {
+            if (capture->metrics != nullptr) {
+                capture->metrics->~RfMetricsBlock();
+                heap_caps_free(capture->metrics);
+            }
+            if (capture->trace != nullptr) {
+                capture->trace->~RfChannelTrace();
+                heap_caps_free(capture->trace);
+            }
+            capture->~RfEdgeCapture();
+            heap_caps_free(capture);
+        }
+    }
+
+    // Timestamps one edge; wakes the decoder at frame boundaries, or early if the ring is filling up
+    __attribute__((always_inline)) inline void OnEdge() {
+#if CONFIG_RF_MODULE_ENABLE_METRICS
+        const uint32_t start_cycles = esp_cpu_get_cycle_count();
+#endif
+        RfEdge edge;
+        edge.timestamp = static_cast<uint32_t>(esp_timer_get_time());
+        edge.level = static_cast<uint8_t>(gpio_ll_get_level(GPIO_LL_GET_HW(GPIO_PORT_0), pin));
+        ring.Push(edge);
+        if (!spi_flash_cache_enabled()) {
+            cacheOffEdges = cacheOffEdges + 1;
+        }
+
+        const uint32_t duration = edge.timestamp - lastTime;
+        lastTime = edge.timestamp;
+#if CONFIG_RF_MODULE_ENABLE_TRACE
+        burstEdges++;
+        if (duration > RfDecoder::kSeparationLimit && trace != nullptr) {
+            trace->isr.Record(edge.timestamp, RF_TRACE_EDGE_BURST, trace->channel,
+                              burstEdges < UINT16_MAX ? burstEdges : UINT16_MAX, duration);
+            burstEdges = 0;
+        }
+#endif
+        if (duration > RfDecoder::kSeparationLimit || ring.Size() >= kRingSize / 2) {
+            BaseType_t higher_priority_task_woken = pdFALSE;
+            vTaskNotifyGiveFromISR(decoderTask, &higher_priority_task_woken);
+            portYIELD_FROM_ISR(higher_priority_task_woken);
+        }
+#if CONFIG_RF_MODULE_ENABLE_METRICS
+        if (metrics != nullptr) {
+            metrics->edges.Add();
+            metrics->isr_cycles.Record(esp_cpu_get_cycle_count() - start_cycles);
+        }
+#endif
+    }
+};
+
+#endif // RF_EDGE_CAPTURE_H
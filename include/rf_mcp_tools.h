@@ -17,6 +17,98 @@
 
 #define TAG_RF_MCP "RF_MCP"
 
+// Keeps raw capture on while a tool waits for a remote, so remotes no
+// protocol decodes are recorded as raw timings instead of timing out
+struct RFRawCaptureScope {
+    explicit RFRawCaptureScope(RFModule* module) : module_(module) { module_->EnableRawCapture(); }
+    ~RFRawCaptureScope() { module_->DisableRawCapture(); }
+    RFModule* module_;
+};
+
+// Histogram as self.rf.get_metrics reports it: buckets trimmed after the last non-empty one
+inline cJSON* RfHistogramJson(const RfHistogram& histogram) {
+    cJSON* json = cJSON_CreateObject();
+    cJSON_AddNumberToObject(json, "count", histogram.count);
+    cJSON_AddNumberToObject(json, "max", histogram.max);
+    cJSON_AddNumberToObject(json, "p50", histogram.Percentile(50));
+    cJSON_AddNumberToObject(json, "p99", histogram.Percentile(99));
+    size_t used = RfHistogram::kBuckets;
+    while (used > 0 && histogram.buckets[used - 1] == 0) {
+        used--;
+    }
+    cJSON* buckets = cJSON_CreateArray();
+    for (size_t i = 0; i < used; i++) {
+        cJSON_AddItemToArray(buckets, cJSON_CreateNumber(histogram.buckets[i]));
+    }
+    cJSON_AddItemToObject(json, "buckets", buckets);
+    return json;
+}
+
+inline cJSON* RfMetricsJson(const RfMetrics& metrics) {
+    cJSON* json = cJSON_CreateObject();
+    cJSON_AddNumberToObject(json, "edges", metrics.edges);
+    cJSON_AddItemToObject(json, "isr_cycles", RfHistogramJson(metrics.isr_cycles));
+    cJSON_AddNumberToObject(json, "frames_decoded", metrics.frames_decoded);
+    cJSON_AddNumberToObject(json, "frames_reported", metrics.frames_reported);
+    cJSON_AddNumberToObject(json, "decode_failures", metrics.decode_failures);
+    cJSON_AddNumberToObject(json, "overflows", metrics.overflows);
+    cJSON_AddNumberToObject(json, "resyncs", metrics.resyncs);
+    cJSON* misses = cJSON_CreateObject();
+    for (size_t i = 0; i < RfProtocolRegistry::kMaxProtocols; i++) {
+        if (metrics.protocol_misses[i] != 0) {
+            cJSON_AddNumberToObject(misses, std::to_string(i + 1).c_str(), metrics.protocol_misses[i]);
+        }
+    }
+    cJSON_AddItemToObject(json, "protocol_misses", misses);
+    cJSON_AddItemToObject(json, "decode_latency_us", RfHistogramJson(metrics.decode_latency_us));
+    cJSON_AddNumberToObject(json, "transmissions", metrics.transmissions);
+    cJSON_AddItemToObject(json, "tx_jitter_us", RfHistogramJson(metrics.tx_jitter_us));
+    return json;
+}
+
+/**
+ * Saved signal for a spoken name, as self.rf.send_by_name resolves it: the best
+ * ranked candidate, unless another one with a different name ranks equally.
+ * Throws with a message for the agent when there is no unique match.
+ */
+inline RfNameMatch RfFindSignalByName(RFModule* rf_module, const std::string& name, RFSignal& found_signal) {
+    if (rf_module->GetFlashSignalCount() == 0) {
+        throw std::runtime_error("No signals saved. Use self.rf.copy to save signals first.");
+    }
+    
+    // Ranked lookup in the in-memory name index (no flash access)
+    RfNameMatch matches[4];
+    size_t match_count = rf_module->FindSignalsByName(name, matches, 4);
+    if (match_count == 0) {
+        throw std::runtime_error("No signal found with name: \"" + name + "\". Use self.rf.list_signals to see available signals.");
+    }
+    
+    if (!rf_module->GetFlashSignal(matches[0].index, found_signal)) {
+        throw std::runtime_error("Failed to retrieve signal named: \"" + name + "\"");
+    }
+    
+    // An inexact match is only sent when no other candidate ranks equally with a different name
+    if (matches[0].kind != RF_NAME_EXACT) {
+        std::string candidates;
+        bool ambiguous = false;
+        for (size_t i = 0; i < match_count; i++) {
+            RFSignal candidate;
+            if (!rf_module->GetFlashSignal(matches[i].index, candidate)) {
+                continue;
+            }
+            if (i > 0 && matches[i].kind == matches[0].kind && matches[i].distance == matches[0].distance &&
+                strcmp(candidate.name, found_signal.name) != 0) {
+                ambiguous = true;
+            }
+            candidates += std::string(candidates.empty() ? "" : ", ") + "\"" + candidate.name + "\"";
+        }
+        if (ambiguous) {
+            throw std::runtime_error("Name \"" + name + "\" is ambiguous, candidates: " + candidates + ". Ask the user which one to send.");
+        }
+    }
+    return matches[0];
+}
+
 /**
  * Register RF MCP tools for boards that have RF module configured.
  * This function should be called in board's RegisterMcpTools() method
@@ -34,9 +126,11 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
     mcp_server.AddTool("self.rf.send",
         "发送RF信号到指定频率（315MHz或433MHz）。"
         "信号默认发送3次（行业标准）。"
+        "信号进入发送队列后立即返回，不等待发送完成（发送队列见 self.rf.get_status 的 tx_queue_depth）。"
         "注意：此工具直接发送信号，不会保存信号。"
         "如需保存信号以便后续重播，请先使用 self.rf.copy 复制信号。"
-        "参数：address（6位十六进制，例如 \"1A2B3C\"）、key（2位十六进制，例如 \"01\"）、frequency（\"315\" 或 \"433\"）",
+        "参数：address（十六进制地址码，6位为24位编码，例如 \"1A2B3C\"；更长的编码每4位多1位，最多16位即64位，"
+        "与 self.rf.list_signals 返回的 address 相同）、key（2位十六进制，例如 \"01\"）、frequency（\"315\" 或 \"433\"）",
         PropertyList({
             Property("address", kPropertyTypeString),
             Property("key", kPropertyTypeString),
@@ -54,7 +148,9 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
                 throw std::runtime_error("Frequency must be \"315\" or \"433\"");
             }
             
-            rf_module->Send(address, key, freq);
+            if (rf_module->SendAsync(address, key, freq) == 0) {
+                throw std::runtime_error("发送队列已满，请稍后重试");
+            }
             return true;
         });
 
@@ -62,17 +158,18 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
         "复制/克隆RF信号（自动识别315MHz或433MHz频率）。"
         "调用此工具并等待用户按下遥控器，系统会自动接收并保存信号。"
         "RF模块同时监听两个频率并自动识别信号频率。"
-        "所有接收到的信号都会自动保存到闪存（最多10个信号，循环缓冲区）。"
+        "所有接收到的信号都会自动保存到闪存（循环缓冲区，容量见 self.rf.get_status 的 saved_signals_capacity）。"
         "这是一个阻塞调用，最多等待10秒接收信号。"
         "返回值说明："
-        "- 成功接收信号：返回JSON对象，包含address, key, frequency, protocol, pulse_length, name, is_duplicate=false。"
+        "- 成功接收信号：返回JSON对象，包含address, key, frequency, protocol, pulse_length, type, name, is_duplicate=false。"
+        "无法识别协议的遥控器（如吊扇、车库门）会以原始脉冲时序保存：type=\"raw\"，protocol=0，address为时序指纹，重播时按原始时序发送。"
         "- 检测到重复信号：工具会抛出异常（error响应），错误消息为'信号保存失败：检测到重复信号...'，此时信号不会被保存。这不是超时，而是重复信号错误。"
         "- 超时未接收到信号：返回null（不是error响应）。"
         "重要：如果工具返回error响应，说明检测到重复信号或存储已满，错误消息会详细说明原因。如果返回null，说明超时未接收到信号。"
         "重要：要完成复制/克隆信号，需要两个步骤：(1) 调用 self.rf.copy 复制信号，(2) 调用 self.rf.replay 重播/发送复制的信号。"
         "仅复制信号并不等于完成克隆，必须同时调用 self.rf.replay 才能完成克隆操作。"
         "使用 self.rf.get_status 可以非阻塞查询最新接收的信号。"
-        "使用 self.rf.list_signals 可以查看所有保存的信号（最多10个）及其索引。"
+        "使用 self.rf.list_signals 可以查看所有保存的信号及其索引。"
         "设备名称提取："
         "- 当用户说\"录制大门信号\"、\"复制大门信号\"、\"录制大门\"时，应提取\"大门\"作为name参数。"
         "- 当用户说\"复制卧室灯开关\"、\"录制卧室灯开关\"时，应提取\"卧室灯开关\"作为name参数。"
@@ -96,6 +193,7 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
             }
             
             int64_t start_time = esp_timer_get_time();
+            RFRawCaptureScope raw_capture(rf_module);
             
             ESP_LOGI(TAG_RF_MCP, "[复制] 开始等待RF信号，超时时间: %dms%s", 
                     timeout_ms, signal_name.empty() ? "" : (", 信号名称: " + signal_name).c_str());
@@ -114,16 +212,16 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
                     // Set signal name if provided
                     if (!signal_name.empty()) {
                         rf_module->SetCapturedSignalName(signal_name);
-                        signal.name = signal_name;
+                        signal.SetName(signal_name);
                     }
                     
                     // Explicitly save to flash storage for self.rf.copy tool
                     // Check if storage is full before saving
                     if (rf_module->IsFlashStorageEnabled()) {
-                        uint8_t current_count = rf_module->GetFlashSignalCount();
-                        if (current_count >= 10) {
-                            ESP_LOGW(TAG_RF_MCP, "[复制] ⚠️ 信号存储已满 (10/10)，无法保存新信号");
-                            throw std::runtime_error("Signal storage is full (10/10). Please use self.rf.list_signals to see saved signals, or clear some signals.");
+                        uint16_t current_count = rf_module->GetFlashSignalCount();
+                        if (current_count >= rf_module->GetFlashSignalCapacity()) {
+                            ESP_LOGW(TAG_RF_MCP, "[复制] ⚠️ 信号存储已满 (%d/%d)，无法保存新信号", current_count, rf_module->GetFlashSignalCapacity());
+                            throw std::runtime_error("Signal storage is full (" + std::to_string(current_count) + "/" + std::to_string(rf_module->GetFlashSignalCapacity()) + "). Please use self.rf.list_signals to see saved signals, or clear some signals.");
                         }
                         if (!rf_module->SaveToFlash()) {
                             ESP_LOGW(TAG_RF_MCP, "[复制] ⚠️ 保存信号到闪存失败");
@@ -131,27 +229,29 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
                     }
                     
                     // Check for duplicate signal
-                    uint8_t duplicate_index = 0;
+                    uint16_t duplicate_index = 0;
                     bool is_duplicate = rf_module->CheckDuplicateSignal(signal, duplicate_index);
                     
                     if (is_duplicate) {
                         ESP_LOGW(TAG_RF_MCP, "[复制] ⚠️ 接收到重复信号: %s%s (%sMHz) - 与闪存中索引%d的信号相同", 
-                                signal.address.c_str(), signal.key.c_str(),
+                                signal.AddressHex().c_str(), signal.KeyHex().c_str(),
                                 signal.frequency == RF_315MHZ ? "315" : "433", duplicate_index);
                     } else {
                         ESP_LOGI(TAG_RF_MCP, "[复制] 立即接收到信号: %s%s (%sMHz)%s", 
-                                signal.address.c_str(), signal.key.c_str(),
+                                signal.AddressHex().c_str(), signal.KeyHex().c_str(),
                                 signal.frequency == RF_315MHZ ? "315" : "433",
-                                signal.name.empty() ? "" : (", 名称: " + signal.name).c_str());
+                                signal.HasName() ? (", 名称: " + std::string(signal.name)).c_str() : "");
                     }
                     
                     cJSON* json = cJSON_CreateObject();
-                    cJSON_AddStringToObject(json, "address", signal.address.c_str());
-                    cJSON_AddStringToObject(json, "key", signal.key.c_str());
+                    cJSON_AddStringToObject(json, "address", signal.AddressHex().c_str());
+                    cJSON_AddStringToObject(json, "key", signal.KeyHex().c_str());
                     cJSON_AddStringToObject(json, "frequency", signal.frequency == RF_315MHZ ? "315" : "433");
                     cJSON_AddNumberToObject(json, "protocol", signal.protocol);
+                    cJSON_AddNumberToObject(json, "bit_length", signal.bit_length);
+                    cJSON_AddStringToObject(json, "type", signal.type == RF_SIGNAL_RAW ? "raw" : "code");
                     cJSON_AddNumberToObject(json, "pulse_length", signal.pulse_length);
-                    cJSON_AddStringToObject(json, "name", signal.name.empty() ? "" : signal.name.c_str());
+                    cJSON_AddStringToObject(json, "name", signal.name);
                     if (is_duplicate) {
                         cJSON_AddBoolToObject(json, "is_duplicate", true);
                         cJSON_AddNumberToObject(json, "duplicate_index", duplicate_index);
@@ -162,35 +262,38 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
                 }
             }
             
-            // 阻塞等待信号，每100ms检查一次
-            while ((esp_timer_get_time() - start_time) / 1000 < timeout_ms) {
-                if (rf_module->ReceiveAvailable()) {
+            // 阻塞等待信号，解码任务收到信号后立即唤醒
+            int64_t wait_ms = 0;
+            while ((wait_ms = (esp_timer_get_time() - start_time) / 1000) < timeout_ms) {
+                if (rf_module->WaitForSignal(timeout_ms - wait_ms)) {
             RFSignal signal;
             if (rf_module->Receive(signal)) {
                         // Set signal name if provided
                         if (!signal_name.empty()) {
                             rf_module->SetCapturedSignalName(signal_name);
-                            signal.name = signal_name;
+                            signal.SetName(signal_name);
                         }
                         
                         // Check for duplicate signal BEFORE saving
-                        uint8_t duplicate_index = 0;
+                        uint16_t duplicate_index = 0;
                         bool is_duplicate = rf_module->CheckDuplicateSignal(signal, duplicate_index);
                         
                         if (is_duplicate) {
                             ESP_LOGW(TAG_RF_MCP, "[复制] ⚠️ 接收到重复信号: %s%s (%sMHz) - 与闪存中索引%d的信号相同", 
-                                    signal.address.c_str(), signal.key.c_str(),
+                                    signal.AddressHex().c_str(), signal.KeyHex().c_str(),
                                     signal.frequency == RF_315MHZ ? "315" : "433", duplicate_index);
                             
                             // 返回信号信息，标记为重复（而不是抛出异常）
                             int64_t elapsed_ms = (esp_timer_get_time() - start_time) / 1000;
                             cJSON* json = cJSON_CreateObject();
-                            cJSON_AddStringToObject(json, "address", signal.address.c_str());
-                            cJSON_AddStringToObject(json, "key", signal.key.c_str());
+                            cJSON_AddStringToObject(json, "address", signal.AddressHex().c_str());
+                            cJSON_AddStringToObject(json, "key", signal.KeyHex().c_str());
                             cJSON_AddStringToObject(json, "frequency", signal.frequency == RF_315MHZ ? "315" : "433");
                             cJSON_AddNumberToObject(json, "protocol", signal.protocol);
+                            cJSON_AddNumberToObject(json, "bit_length", signal.bit_length);
+                            cJSON_AddStringToObject(json, "type", signal.type == RF_SIGNAL_RAW ? "raw" : "code");
                             cJSON_AddNumberToObject(json, "pulse_length", signal.pulse_length);
-                            cJSON_AddStringToObject(json, "name", signal.name.empty() ? "" : signal.name.c_str());
+                            cJSON_AddStringToObject(json, "name", signal.name);
                             cJSON_AddBoolToObject(json, "is_duplicate", true);
                             cJSON_AddNumberToObject(json, "duplicate_index", duplicate_index);
                             return json;
@@ -199,10 +302,10 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
                         // Explicitly save to flash storage for self.rf.copy tool
                         // Check if storage is full before saving
                         if (rf_module->IsFlashStorageEnabled()) {
-                            uint8_t current_count = rf_module->GetFlashSignalCount();
-                            if (current_count >= 10) {
-                                ESP_LOGW(TAG_RF_MCP, "[复制] ⚠️ 信号存储已满 (10/10)，无法保存新信号");
-                                throw std::runtime_error("Signal storage is full (10/10). Please use self.rf.list_signals to see saved signals, or clear some signals.");
+                            uint16_t current_count = rf_module->GetFlashSignalCount();
+                            if (current_count >= rf_module->GetFlashSignalCapacity()) {
+                                ESP_LOGW(TAG_RF_MCP, "[复制] ⚠️ 信号存储已满 (%d/%d)，无法保存新信号", current_count, rf_module->GetFlashSignalCapacity());
+                                throw std::runtime_error("Signal storage is full (" + std::to_string(current_count) + "/" + std::to_string(rf_module->GetFlashSignalCapacity()) + "). Please use self.rf.list_signals to see saved signals, or clear some signals.");
                             }
                             if (!rf_module->SaveToFlash()) {
                                 ESP_LOGE(TAG_RF_MCP, "[复制] ✗ 保存信号到闪存失败");
@@ -212,23 +315,24 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
                         
                         int64_t elapsed_ms = (esp_timer_get_time() - start_time) / 1000;
                         ESP_LOGI(TAG_RF_MCP, "[复制] ✓ 复制信号成功: %s%s (%sMHz, 协议:%d, 脉冲:%dμs, 等待时间:%ldms)%s", 
-                                signal.address.c_str(), signal.key.c_str(),
+                                signal.AddressHex().c_str(), signal.KeyHex().c_str(),
                                 signal.frequency == RF_315MHZ ? "315" : "433",
                                 signal.protocol, signal.pulse_length, (long)elapsed_ms,
-                                signal.name.empty() ? "" : (", 名称: " + signal.name).c_str());
+                                signal.HasName() ? (", 名称: " + std::string(signal.name)).c_str() : "");
                         
                 cJSON* json = cJSON_CreateObject();
-                cJSON_AddStringToObject(json, "address", signal.address.c_str());
-                cJSON_AddStringToObject(json, "key", signal.key.c_str());
+                cJSON_AddStringToObject(json, "address", signal.AddressHex().c_str());
+                cJSON_AddStringToObject(json, "key", signal.KeyHex().c_str());
                 cJSON_AddStringToObject(json, "frequency", signal.frequency == RF_315MHZ ? "315" : "433");
                 cJSON_AddNumberToObject(json, "protocol", signal.protocol);
+                cJSON_AddNumberToObject(json, "bit_length", signal.bit_length);
+                cJSON_AddStringToObject(json, "type", signal.type == RF_SIGNAL_RAW ? "raw" : "code");
                 cJSON_AddNumberToObject(json, "pulse_length", signal.pulse_length);
-                cJSON_AddStringToObject(json, "name", signal.name.empty() ? "" : signal.name.c_str());
+                cJSON_AddStringToObject(json, "name", signal.name);
                 cJSON_AddBoolToObject(json, "is_duplicate", false);  // 保存成功，不是重复
                 return json;
                     }
                 }
-                vTaskDelay(pdMS_TO_TICKS(100));  // 每100ms检查一次
             }
             
             // 超时
@@ -238,8 +342,11 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
 
     mcp_server.AddTool("self.rf.get_status",
         "获取RF模块实时状态和统计信息（非阻塞查询）。"
-        "返回：enabled状态、send_count、receive_count、last_signal（最近接收的信号）和saved_signals_count。"
-        "saved_signals_count字段显示闪存中实际保存的信号数量（最多10个，循环缓冲区）。"
+        "返回：enabled状态、send_count、receive_count、last_signal（最近接收的信号）、saved_signals_count和saved_signals_capacity。"
+        "saved_signals_count字段显示闪存中实际保存的信号数量，saved_signals_capacity为最大容量（已满时覆盖最旧的信号）。"
+        "tx_queue_depth 为等待发送的信号数，last_tx_airtime_ms 为最近一次发送的空中时间。"
+        "receive_stats 为接收统计：dropped_edges/dropped_frames（丢失的边沿/帧）、flash_busy_edges（闪存写入期间仍正常捕获的边沿）。"
+        "channels 列出每个收发通道（频率、天线编号、引脚）及其 sent/received/merged（被其他天线重复收到而合并的帧）计数。"
         "使用此工具可以快速检查模块状态和最新信号，无需阻塞。"
         "注意：要列出所有保存的信号及其索引，请使用 self.rf.list_signals。"
         "last_signal字段包含最新信号（address, key, frequency, protocol, pulse_length, name）。"
@@ -251,37 +358,146 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
             cJSON_AddBoolToObject(json, "enabled", rf_module->IsEnabled());
             cJSON_AddNumberToObject(json, "send_count", rf_module->GetSendCount());
             cJSON_AddNumberToObject(json, "receive_count", rf_module->GetReceiveCount());
+            cJSON_AddNumberToObject(json, "tx_queue_depth", rf_module->GetTxQueueDepth());
+            cJSON_AddNumberToObject(json, "last_tx_airtime_ms", rf_module->GetLastTxAirtime() / 1000);
+            
+            cJSON* stats = cJSON_CreateObject();
+            cJSON_AddNumberToObject(stats, "dropped_edges",
+                                    rf_module->GetDroppedEdgeCount(RF_433MHZ) + rf_module->GetDroppedEdgeCount(RF_315MHZ));
+            cJSON_AddNumberToObject(stats, "dropped_frames",
+                                    rf_module->GetDroppedFrameCount(RF_433MHZ) + rf_module->GetDroppedFrameCount(RF_315MHZ));
+            cJSON_AddNumberToObject(stats, "flash_busy_edges",
+                                    rf_module->GetFlashBusyEdgeCount(RF_433MHZ) + rf_module->GetFlashBusyEdgeCount(RF_315MHZ));
+            cJSON_AddItemToObject(json, "receive_stats", stats);
+            
+            cJSON* channels = cJSON_CreateArray();
+            for (uint8_t i = 0; i < rf_module->GetChannelCount(); i++) {
+                const RfChannelConfig* config = rf_module->GetChannelConfig(i);
+                RfChannelStats channel_stats;
+                if (config == nullptr || !rf_module->GetChannelStats(i, channel_stats)) {
+                    continue;
+                }
+                cJSON* channel = cJSON_CreateObject();
+                cJSON_AddNumberToObject(channel, "channel", i);
+                cJSON_AddStringToObject(channel, "frequency", config->band == RF_315MHZ ? "315" : "433");
+                cJSON_AddNumberToObject(channel, "antenna", config->antenna);
+                cJSON_AddNumberToObject(channel, "tx_pin", config->tx_pin);
+                cJSON_AddNumberToObject(channel, "rx_pin", config->rx_pin);
+                cJSON_AddBoolToObject(channel, "receiving", rf_module->IsChannelReceiving(i));
+                cJSON_AddNumberToObject(channel, "sent", channel_stats.sent);
+                cJSON_AddNumberToObject(channel, "received", channel_stats.received);
+                cJSON_AddNumberToObject(channel, "merged", channel_stats.merged);
+                cJSON_AddNumberToObject(channel, "dropped_frames", channel_stats.dropped_frames);
+                cJSON_AddItemToArray(channels, channel);
+            }
+            cJSON_AddItemToObject(json, "channels", channels);
             
             auto last_signal = rf_module->GetLastReceived();
-            if (!last_signal.address.empty()) {
+            if (!last_signal.Empty()) {
                 cJSON* last = cJSON_CreateObject();
-                cJSON_AddStringToObject(last, "address", last_signal.address.c_str());
-                cJSON_AddStringToObject(last, "key", last_signal.key.c_str());
+                cJSON_AddStringToObject(last, "address", last_signal.AddressHex().c_str());
+                cJSON_AddStringToObject(last, "key", last_signal.KeyHex().c_str());
                 cJSON_AddStringToObject(last, "frequency", last_signal.frequency == RF_315MHZ ? "315" : "433");
                 cJSON_AddNumberToObject(last, "protocol", last_signal.protocol);
+                cJSON_AddNumberToObject(last, "bit_length", last_signal.bit_length);
+                cJSON_AddStringToObject(last, "type", last_signal.type == RF_SIGNAL_RAW ? "raw" : "code");
                 cJSON_AddNumberToObject(last, "pulse_length", last_signal.pulse_length);
-                cJSON_AddStringToObject(last, "name", last_signal.name.empty() ? "" : last_signal.name.c_str());
+                cJSON_AddStringToObject(last, "name", last_signal.name);
                 cJSON_AddItemToObject(json, "last_signal", last);
             }
             
             // Add flash storage count only (not the full list to avoid confusion with list_signals)
             if (rf_module->IsFlashStorageEnabled()) {
-                uint8_t flash_count = rf_module->GetFlashSignalCount();
+                uint16_t flash_count = rf_module->GetFlashSignalCount();
                 cJSON_AddNumberToObject(json, "saved_signals_count", flash_count);
+                cJSON_AddNumberToObject(json, "saved_signals_capacity", rf_module->GetFlashSignalCapacity());
                 ESP_LOGI(TAG_RF_MCP, "[状态] 闪存中保存了 %d 个信号", flash_count);
             } else {
                 cJSON_AddNumberToObject(json, "saved_signals_count", 0);
+                cJSON_AddNumberToObject(json, "saved_signals_capacity", 0);
             }
             
             return json;
         });
 
+    mcp_server.AddTool("self.rf.get_metrics",
+        "获取接收/发送热路径指标（非阻塞，用于排查漏收、误码和发送时序问题）。"
+        "按频率返回（\"433\"、\"315\"，多个天线通道的计数相加）；参数 channel（可选，默认-1）指定单个通道时只返回该通道。"
+        "计数：edges（中断处理的边沿数）、frames_decoded（解码成功的帧，含未上报的重复帧）、frames_reported（上报的帧）、"
+        "decode_failures（没有协议匹配的帧）、overflows（超长帧被截断）、resyncs（边沿缓冲溢出后解码器重置）、"
+        "protocol_misses（按协议号：尝试该协议但未匹配的帧数）、transmissions（发送次数）。"
+        "直方图：isr_cycles（中断耗时，CPU周期）、decode_latency_us（帧结束到进入接收队列的微秒数）、"
+        "tx_jitter_us（实际与计划空中时间之差的微秒数）；每个直方图含 count、max、p50、p99（桶上界估计）"
+        "和 buckets（第0个桶为0，第i个桶统计 [2^(i-1), 2^i) 的值）。"
+        "指标未编译（RF_MODULE_ENABLE_METRICS=OFF）时返回错误。",
+        PropertyList({
+            Property("channel", kPropertyTypeInteger, -1, -1, RFModule::kMaxChannels - 1)
+        }),
+        [rf_module](const PropertyList& properties) -> ReturnValue {
+            int channel = properties["channel"].value<int>();
+            RfMetrics metrics;
+            cJSON* json = cJSON_CreateObject();
+            if (channel >= 0) {
+                if (!rf_module->GetChannelMetrics(channel, metrics)) {
+                    cJSON_Delete(json);
+                    throw std::runtime_error("通道" + std::to_string(channel) + "没有指标（通道不存在或指标未编译）");
+                }
+                cJSON_AddNumberToObject(json, "channel", channel);
+                cJSON_AddItemToObject(json, "metrics", RfMetricsJson(metrics));
+                return json;
+            }
+            
+            bool found = false;
+            if (rf_module->GetMetrics(RF_433MHZ, metrics)) {
+                cJSON_AddItemToObject(json, "433", RfMetricsJson(metrics));
+                found = true;
+            }
+            if (rf_module->GetMetrics(RF_315MHZ, metrics)) {
+                cJSON_AddItemToObject(json, "315", RfMetricsJson(metrics));
+                found = true;
+            }
+            if (!found) {
+                cJSON_Delete(json);
+                throw std::runtime_error("指标未编译（RF_MODULE_ENABLE_METRICS=OFF）");
+            }
+            return json;
+        });
+
+    mcp_server.AddTool("self.rf.dump_trace",
+        "导出最近的接收/发送事件跟踪（非阻塞，用于事后分析时序问题，例如漏收时边沿、解码和发送的先后顺序）。"
+        "事件包括：边沿突发（帧间隔）、解码成功/失败的帧、超长帧、边沿缓冲溢出、发送开始/结束和闪存提交，时间戳精确到微秒。"
+        "参数 max_events（可选，默认200）：最多返回的最新事件数。"
+        "返回 format=\"rftrace1\"、events（事件数）和 data（二进制跟踪的Base64编码）；"
+        "将返回的JSON保存为文件后用 host/rf_trace_decode.py 转换为时间线。"
+        "跟踪未编译（RF_MODULE_ENABLE_TRACE=OFF）时返回错误。",
+        PropertyList({
+            Property("max_events", kPropertyTypeInteger, 200, 1, 2000)
+        }),
+        [rf_module](const PropertyList& properties) -> ReturnValue {
+            const size_t max_size = rf_module->GetTraceDumpSize();
+            if (max_size == 0) {
+                throw std::runtime_error("跟踪未编译（RF_MODULE_ENABLE_TRACE=OFF）");
+            }
+            const size_t capacity = std::min(max_size, RfTraceDump::Size(properties["max_events"].value<int>()));
+            std::string dump(capacity, '\0');
+            const size_t size = rf_module->DumpTrace(reinterpret_cast<uint8_t*>(&dump[0]), capacity);
+            if (size == 0) {
+                throw std::runtime_error("跟踪导出失败（内存不足）");
+            }
+            cJSON* json = cJSON_CreateObject();
+            cJSON_AddStringToObject(json, "format", "rftrace1");
+            cJSON_AddNumberToObject(json, "events", (size - RfTraceDump::kHeaderSize) / RfTraceDump::kEventSize);
+            cJSON_AddStringToObject(json, "data",
+                                    RfTraceDump::Base64(reinterpret_cast<const uint8_t*>(dump.data()), size).c_str());
+            return json;
+        });
+
     mcp_server.AddTool("self.rf.capture",
         "启用捕捉模式并等待信号（阻塞，超时10秒）。"
         "这是捕捉信号的替代方式（不用于复制/克隆）。"
         "调用此工具并等待用户按下遥控器。"
         "RF模块自动检测315MHz和433MHz频率的信号。"
-        "捕捉到的信号会自动保存到闪存（最多10个信号，循环缓冲区）。"
+        "捕捉到的信号会自动保存到闪存（循环缓冲区，容量见 self.rf.get_status 的 saved_signals_capacity）。"
         "返回值说明："
         "- 成功捕捉信号：返回JSON对象，包含address, key, frequency, protocol, pulse_length, is_duplicate=false。"
         "- 检测到重复信号：工具会抛出异常（error响应），错误消息为'信号保存失败：检测到重复信号...'，此时信号不会被保存。这不是超时，而是重复信号错误。"
@@ -290,13 +506,14 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
         "重要：此工具仅捕捉信号，不会复制/克隆信号。"
         "要复制/克隆信号，请使用：self.rf.copy（步骤1）+ self.rf.replay（步骤2）。"
         "此捕捉工具主要用于显式捕捉工作流，不用于复制/克隆。"
-        "使用 self.rf.list_signals 可以查看所有保存的信号（最多10个）及其索引。"
+        "使用 self.rf.list_signals 可以查看所有保存的信号及其索引。"
         "参数：timeout_ms（可选，默认10000）",
         PropertyList({
             Property("timeout_ms", kPropertyTypeInteger, 10000)
         }),
         [rf_module](const PropertyList& properties) -> ReturnValue {
             rf_module->EnableCaptureMode();
+            RFRawCaptureScope raw_capture(rf_module);
             // timeout_ms 有默认值10000，如果用户提供了值会被覆盖
             int timeout_ms = properties["timeout_ms"].value<int>();
             int64_t start_time = esp_timer_get_time();
@@ -315,23 +532,25 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
                 auto signal = rf_module->GetCapturedSignal();
                 
                 // Check for duplicate signal BEFORE saving
-                uint8_t duplicate_index = 0;
+                uint16_t duplicate_index = 0;
                 bool is_duplicate = rf_module->CheckDuplicateSignal(signal, duplicate_index);
                 
                 if (is_duplicate) {
                     rf_module->DisableCaptureMode();
                     ESP_LOGW(TAG_RF_MCP, "[捕捉] ⚠️ 接收到重复信号: %s%s (%sMHz) - 与闪存中索引%d的信号相同", 
-                            signal.address.c_str(), signal.key.c_str(),
+                            signal.AddressHex().c_str(), signal.KeyHex().c_str(),
                             signal.frequency == RF_315MHZ ? "315" : "433", duplicate_index);
                     
                     // 返回信号信息，标记为重复（而不是抛出异常）
                     cJSON* json = cJSON_CreateObject();
-                    cJSON_AddStringToObject(json, "address", signal.address.c_str());
-                    cJSON_AddStringToObject(json, "key", signal.key.c_str());
+                    cJSON_AddStringToObject(json, "address", signal.AddressHex().c_str());
+                    cJSON_AddStringToObject(json, "key", signal.KeyHex().c_str());
                     cJSON_AddStringToObject(json, "frequency", signal.frequency == RF_315MHZ ? "315" : "433");
                     cJSON_AddNumberToObject(json, "protocol", signal.protocol);
+                    cJSON_AddNumberToObject(json, "bit_length", signal.bit_length);
+                    cJSON_AddStringToObject(json, "type", signal.type == RF_SIGNAL_RAW ? "raw" : "code");
                     cJSON_AddNumberToObject(json, "pulse_length", signal.pulse_length);
-                    cJSON_AddStringToObject(json, "name", signal.name.empty() ? "" : signal.name.c_str());
+                    cJSON_AddStringToObject(json, "name", signal.name);
                     cJSON_AddBoolToObject(json, "is_duplicate", true);
                     cJSON_AddNumberToObject(json, "duplicate_index", duplicate_index);
                     return json;
@@ -339,47 +558,50 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
                 
                 // Check if storage is full (capture mode saves via CheckCaptureMode, but we should verify)
                 if (rf_module->IsFlashStorageEnabled()) {
-                    uint8_t current_count = rf_module->GetFlashSignalCount();
-                    if (current_count >= 10) {
-                        ESP_LOGW(TAG_RF_MCP, "[捕捉] ⚠️ 信号存储已满 (10/10)，无法保存新信号");
+                    uint16_t current_count = rf_module->GetFlashSignalCount();
+                    if (current_count >= rf_module->GetFlashSignalCapacity()) {
+                        ESP_LOGW(TAG_RF_MCP, "[捕捉] ⚠️ 信号存储已满 (%d/%d)，无法保存新信号", current_count, rf_module->GetFlashSignalCapacity());
                         rf_module->DisableCaptureMode();
-                        throw std::runtime_error("Signal storage is full (10/10). Please use self.rf.list_signals to see saved signals, or clear some signals.");
+                        throw std::runtime_error("Signal storage is full (" + std::to_string(current_count) + "/" + std::to_string(rf_module->GetFlashSignalCapacity()) + "). Please use self.rf.list_signals to see saved signals, or clear some signals.");
                     }
                     
                     // Verify that SaveToFlash was successful (CheckCaptureMode should have called it)
                     // If SaveToFlash failed (e.g., due to duplicate), it would have returned false
                     // But since we already checked for duplicate above, this should succeed
                     // However, we can verify by checking if the signal count increased
-                    uint8_t count_before = current_count;
+                    uint16_t count_before = current_count;
                     // Re-check count after a small delay to ensure SaveToFlash completed
                     vTaskDelay(pdMS_TO_TICKS(10));
-                    uint8_t count_after = rf_module->GetFlashSignalCount();
+                    uint16_t count_after = rf_module->GetFlashSignalCount();
                     if (count_after <= count_before) {
                         ESP_LOGW(TAG_RF_MCP, "[捕捉] ⚠️ 信号可能未成功保存到闪存");
                     }
                 }
                 
                 ESP_LOGI(TAG_RF_MCP, "[捕捉] ✓ 立即捕捉到信号: %s%s (%sMHz)", 
-                        signal.address.c_str(), signal.key.c_str(),
+                        signal.AddressHex().c_str(), signal.KeyHex().c_str(),
                         signal.frequency == RF_315MHZ ? "315" : "433");
                 
                 rf_module->DisableCaptureMode();
                 
                 cJSON* json = cJSON_CreateObject();
-                cJSON_AddStringToObject(json, "address", signal.address.c_str());
-                cJSON_AddStringToObject(json, "key", signal.key.c_str());
+                cJSON_AddStringToObject(json, "address", signal.AddressHex().c_str());
+                cJSON_AddStringToObject(json, "key", signal.KeyHex().c_str());
                 cJSON_AddStringToObject(json, "frequency", signal.frequency == RF_315MHZ ? "315" : "433");
                 cJSON_AddNumberToObject(json, "protocol", signal.protocol);
+                cJSON_AddNumberToObject(json, "bit_length", signal.bit_length);
+                cJSON_AddStringToObject(json, "type", signal.type == RF_SIGNAL_RAW ? "raw" : "code");
                 cJSON_AddNumberToObject(json, "pulse_length", signal.pulse_length);
-                cJSON_AddStringToObject(json, "name", signal.name.empty() ? "" : signal.name.c_str());
+                cJSON_AddStringToObject(json, "name", signal.name);
                 cJSON_AddBoolToObject(json, "is_duplicate", false);  // 保存成功，不是重复
                 return json;
             }
             
-            // 阻塞等待捕捉信号，每100ms检查一次
-            while ((esp_timer_get_time() - start_time) / 1000 < timeout_ms) {
-                // 主动检查并处理新到达的信号（这会触发 CheckCaptureMode）
-                if (rf_module->ReceiveAvailable()) {
+            // 阻塞等待捕捉信号，解码任务收到信号后立即唤醒
+            int64_t wait_ms = 0;
+            while ((wait_ms = (esp_timer_get_time() - start_time) / 1000) < timeout_ms) {
+                // 等待并处理新到达的信号（这会触发 CheckCaptureMode）
+                if (rf_module->WaitForSignal(timeout_ms - wait_ms)) {
                     RFSignal temp_signal;
                     rf_module->Receive(temp_signal);  // 这会触发 CheckCaptureMode，设置 has_captured_signal_
                 }
@@ -390,21 +612,23 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
                     int64_t elapsed_ms = (esp_timer_get_time() - start_time) / 1000;
                     
                     // Check for duplicate signal BEFORE saving
-                    uint8_t duplicate_index = 0;
+                    uint16_t duplicate_index = 0;
                     bool is_duplicate = rf_module->CheckDuplicateSignal(signal, duplicate_index);
                     
                     if (is_duplicate) {
                         rf_module->DisableCaptureMode();
                         ESP_LOGW(TAG_RF_MCP, "[捕捉] ⚠️ 接收到重复信号: %s%s (%sMHz) - 与闪存中索引%d的信号相同", 
-                                signal.address.c_str(), signal.key.c_str(),
+                                signal.AddressHex().c_str(), signal.KeyHex().c_str(),
                                 signal.frequency == RF_315MHZ ? "315" : "433", duplicate_index);
                         
                         // 返回信号信息，标记为重复（而不是抛出异常）
                         cJSON* json = cJSON_CreateObject();
-                        cJSON_AddStringToObject(json, "address", signal.address.c_str());
-                        cJSON_AddStringToObject(json, "key", signal.key.c_str());
+                        cJSON_AddStringToObject(json, "address", signal.AddressHex().c_str());
+                        cJSON_AddStringToObject(json, "key", signal.KeyHex().c_str());
                         cJSON_AddStringToObject(json, "frequency", signal.frequency == RF_315MHZ ? "315" : "433");
                         cJSON_AddNumberToObject(json, "protocol", signal.protocol);
+                        cJSON_AddNumberToObject(json, "bit_length", signal.bit_length);
+                        cJSON_AddStringToObject(json, "type", signal.type == RF_SIGNAL_RAW ? "raw" : "code");
                         cJSON_AddNumberToObject(json, "pulse_length", signal.pulse_length);
                         cJSON_AddBoolToObject(json, "is_duplicate", true);
                         cJSON_AddNumberToObject(json, "duplicate_index", duplicate_index);
@@ -413,31 +637,32 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
                     
                     // Check if storage is full (capture mode saves via CheckCaptureMode, but we should verify)
                     if (rf_module->IsFlashStorageEnabled()) {
-                        uint8_t current_count = rf_module->GetFlashSignalCount();
-                        if (current_count >= 10) {
-                            ESP_LOGW(TAG_RF_MCP, "[捕捉] ⚠️ 信号存储已满 (10/10)，无法保存新信号");
+                        uint16_t current_count = rf_module->GetFlashSignalCount();
+                        if (current_count >= rf_module->GetFlashSignalCapacity()) {
+                            ESP_LOGW(TAG_RF_MCP, "[捕捉] ⚠️ 信号存储已满 (%d/%d)，无法保存新信号", current_count, rf_module->GetFlashSignalCapacity());
                             rf_module->DisableCaptureMode();
-                            throw std::runtime_error("Signal storage is full (10/10). Please use self.rf.list_signals to see saved signals, or clear some signals.");
+                            throw std::runtime_error("Signal storage is full (" + std::to_string(current_count) + "/" + std::to_string(rf_module->GetFlashSignalCapacity()) + "). Please use self.rf.list_signals to see saved signals, or clear some signals.");
                         }
                     }
                     
                     ESP_LOGI(TAG_RF_MCP, "[捕捉] ✓ 捕捉到信号: %s%s (%sMHz, 协议:%d, 脉冲:%dμs, 等待时间:%ldms)", 
-                            signal.address.c_str(), signal.key.c_str(),
+                            signal.AddressHex().c_str(), signal.KeyHex().c_str(),
                             signal.frequency == RF_315MHZ ? "315" : "433",
                             signal.protocol, signal.pulse_length, (long)elapsed_ms);
                     
                     rf_module->DisableCaptureMode();
                     
                     cJSON* json = cJSON_CreateObject();
-                    cJSON_AddStringToObject(json, "address", signal.address.c_str());
-                    cJSON_AddStringToObject(json, "key", signal.key.c_str());
+                    cJSON_AddStringToObject(json, "address", signal.AddressHex().c_str());
+                    cJSON_AddStringToObject(json, "key", signal.KeyHex().c_str());
                     cJSON_AddStringToObject(json, "frequency", signal.frequency == RF_315MHZ ? "315" : "433");
                     cJSON_AddNumberToObject(json, "protocol", signal.protocol);
+                    cJSON_AddNumberToObject(json, "bit_length", signal.bit_length);
+                    cJSON_AddStringToObject(json, "type", signal.type == RF_SIGNAL_RAW ? "raw" : "code");
                     cJSON_AddNumberToObject(json, "pulse_length", signal.pulse_length);
                     cJSON_AddBoolToObject(json, "is_duplicate", false);  // 保存成功，不是重复
                     return json;
                 }
-                vTaskDelay(pdMS_TO_TICKS(100));  // 每100ms检查一次
             }
             
             // 超时前最后检查一次，避免信号在超时检查后立即到达
@@ -449,21 +674,23 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
                     int64_t elapsed_ms = (esp_timer_get_time() - start_time) / 1000;
                     
                     // Check for duplicate signal BEFORE saving
-                    uint8_t duplicate_index = 0;
+                    uint16_t duplicate_index = 0;
                     bool is_duplicate = rf_module->CheckDuplicateSignal(signal, duplicate_index);
                     
                     if (is_duplicate) {
                         rf_module->DisableCaptureMode();
                         ESP_LOGW(TAG_RF_MCP, "[捕捉] ⚠️ 接收到重复信号: %s%s (%sMHz) - 与闪存中索引%d的信号相同", 
-                                signal.address.c_str(), signal.key.c_str(),
+                                signal.AddressHex().c_str(), signal.KeyHex().c_str(),
                                 signal.frequency == RF_315MHZ ? "315" : "433", duplicate_index);
                         
                         // 返回信号信息，标记为重复（而不是抛出异常）
                         cJSON* json = cJSON_CreateObject();
-                        cJSON_AddStringToObject(json, "address", signal.address.c_str());
-                        cJSON_AddStringToObject(json, "key", signal.key.c_str());
+                        cJSON_AddStringToObject(json, "address", signal.AddressHex().c_str());
+                        cJSON_AddStringToObject(json, "key", signal.KeyHex().c_str());
                         cJSON_AddStringToObject(json, "frequency", signal.frequency == RF_315MHZ ? "315" : "433");
                         cJSON_AddNumberToObject(json, "protocol", signal.protocol);
+                        cJSON_AddNumberToObject(json, "bit_length", signal.bit_length);
+                        cJSON_AddStringToObject(json, "type", signal.type == RF_SIGNAL_RAW ? "raw" : "code");
                         cJSON_AddNumberToObject(json, "pulse_length", signal.pulse_length);
                         cJSON_AddBoolToObject(json, "is_duplicate", true);
                         cJSON_AddNumberToObject(json, "duplicate_index", duplicate_index);
@@ -472,26 +699,28 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
                     
                     // Check if storage is full
                     if (rf_module->IsFlashStorageEnabled()) {
-                        uint8_t current_count = rf_module->GetFlashSignalCount();
-                        if (current_count >= 10) {
-                            ESP_LOGW(TAG_RF_MCP, "[捕捉] ⚠️ 信号存储已满 (10/10)，无法保存新信号");
+                        uint16_t current_count = rf_module->GetFlashSignalCount();
+                        if (current_count >= rf_module->GetFlashSignalCapacity()) {
+                            ESP_LOGW(TAG_RF_MCP, "[捕捉] ⚠️ 信号存储已满 (%d/%d)，无法保存新信号", current_count, rf_module->GetFlashSignalCapacity());
                             rf_module->DisableCaptureMode();
-                            throw std::runtime_error("Signal storage is full (10/10). Please use self.rf.list_signals to see saved signals, or clear some signals.");
+                            throw std::runtime_error("Signal storage is full (" + std::to_string(current_count) + "/" + std::to_string(rf_module->GetFlashSignalCapacity()) + "). Please use self.rf.list_signals to see saved signals, or clear some signals.");
                         }
                     }
                     
                     ESP_LOGI(TAG_RF_MCP, "[捕捉] ✓ 捕捉到信号: %s%s (%sMHz, 协议:%d, 脉冲:%dμs, 等待时间:%ldms)", 
-                            signal.address.c_str(), signal.key.c_str(),
+                            signal.AddressHex().c_str(), signal.KeyHex().c_str(),
                             signal.frequency == RF_315MHZ ? "315" : "433",
                             signal.protocol, signal.pulse_length, (long)elapsed_ms);
                     
                     rf_module->DisableCaptureMode();
                     
                     cJSON* json = cJSON_CreateObject();
-                    cJSON_AddStringToObject(json, "address", signal.address.c_str());
-                    cJSON_AddStringToObject(json, "key", signal.key.c_str());
+                    cJSON_AddStringToObject(json, "address", signal.AddressHex().c_str());
+                    cJSON_AddStringToObject(json, "key", signal.KeyHex().c_str());
                     cJSON_AddStringToObject(json, "frequency", signal.frequency == RF_315MHZ ? "315" : "433");
                     cJSON_AddNumberToObject(json, "protocol", signal.protocol);
+                    cJSON_AddNumberToObject(json, "bit_length", signal.bit_length);
+                    cJSON_AddStringToObject(json, "type", signal.type == RF_SIGNAL_RAW ? "raw" : "code");
                     cJSON_AddNumberToObject(json, "pulse_length", signal.pulse_length);
                     cJSON_AddBoolToObject(json, "is_duplicate", false);  // 保存成功，不是重复
                     return json;
@@ -508,7 +737,7 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
         "重播/发送最后接收的信号（复制/克隆的第二步）。"
         "这是完成复制/克隆信号的第二步：在调用 self.rf.copy（步骤1）复制信号后，"
         "调用此工具重播/发送该信号，完成复制/克隆操作。"
-        "所有通过 self.rf.copy 复制的信号都会自动保存到闪存（最多10个信号，循环缓冲区）。"
+        "所有通过 self.rf.copy 复制的信号都会自动保存到闪存（循环缓冲区，容量见 self.rf.get_status 的 saved_signals_capacity）。"
         "此工具重播/发送最近复制的信号。"
         "重要：复制/克隆信号需要两个步骤：(1) self.rf.copy - 复制信号，(2) self.rf.replay - 发送/重播信号。"
         "只有完成这两个步骤后，信号才被复制/克隆。"
@@ -526,16 +755,16 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
                 signal = rf_module->GetCapturedSignal();
                 has_signal = true;
                 ESP_LOGI(TAG_RF_MCP, "[重播] 使用捕捉的信号: %s%s (%sMHz)", 
-                        signal.address.c_str(), signal.key.c_str(),
+                        signal.AddressHex().c_str(), signal.KeyHex().c_str(),
                         signal.frequency == RF_315MHZ ? "315" : "433");
             } else {
                 // 如果没有捕捉信号，使用最后接收的信号
                 auto last_signal = rf_module->GetLastReceived();
-                if (!last_signal.address.empty()) {
+                if (!last_signal.Empty()) {
                     signal = last_signal;
                     has_signal = true;
                     ESP_LOGI(TAG_RF_MCP, "[重播] 使用最后接收的信号: %s%s (%sMHz)", 
-                            signal.address.c_str(), signal.key.c_str(),
+                            signal.AddressHex().c_str(), signal.KeyHex().c_str(),
                             signal.frequency == RF_315MHZ ? "315" : "433");
                 }
             }
@@ -547,21 +776,27 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
             // 按原始频率发送，不支持修改频率
             ESP_LOGI(TAG_RF_MCP, "[重播] 使用原始频率: %sMHz", 
                     signal.frequency == RF_315MHZ ? "315" : "433");
-            rf_module->Send(signal);
+            if (rf_module->SendAsync(signal) == 0) {
+                throw std::runtime_error("发送队列已满，请稍后重试");
+            }
             return true;
         });
 
     mcp_server.AddTool("self.rf.list_signals",
         "列出闪存中所有保存的RF信号及其索引（1-based）。"
-        "返回：total_count（实际保存的信号数量，最多10个）和signals数组。"
-        "闪存使用循环缓冲区，最大容量为10个信号。"
+        "返回：total_count（实际保存的信号数量）、offset和signals数组。"
+        "闪存使用循环缓冲区，容量见 self.rf.get_status 的 saved_signals_capacity。"
         "当缓冲区满时，新信号会覆盖最旧的信号。"
         "信号索引按录入顺序递增：第一个录入的信号索引为1，最新录入的信号索引最大。"
         "重复信号（地址+按键+频率相同）在接收时会被检测并警告，但仍会保存。"
         "使用此工具查看所有保存的信号，然后通过 self.rf.send_by_index 按索引发送特定信号。"
         "数组中的每个信号包括：index（1-based）、address、key、frequency、protocol、pulse_length和name（设备名称，如果未设置则为空字符串）。"
-        "参数：无",
-        PropertyList(),
+        "信号较多时分页返回：signals从最新信号开始，跳过offset个，最多limit个；offset+limit小于total_count时可继续查询下一页。"
+        "参数：offset（可选，默认0）、limit（可选，默认50，最多200）",
+        PropertyList({
+            Property("offset", kPropertyTypeInteger, 0, 0, 65535),
+            Property("limit", kPropertyTypeInteger, 50, 1, 200)
+        }),
         [rf_module](const PropertyList& properties) -> ReturnValue {
             // Check if flash storage is enabled
             if (!rf_module->IsFlashStorageEnabled()) {
@@ -573,37 +808,46 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
                 return json;
             }
             
-            uint8_t flash_count = rf_module->GetFlashSignalCount();
+            uint16_t flash_count = rf_module->GetFlashSignalCount();
+            // Page through newest-first internal indices so thousands of signals never build one huge reply
+            int offset = properties["offset"].value<int>();
+            int end = offset + properties["limit"].value<int>();
+            if (end > flash_count) {
+                end = flash_count;
+            }
             
-            ESP_LOGI(TAG_RF_MCP, "[列表] 闪存中保存了 %d 个信号", flash_count);
+            ESP_LOGI(TAG_RF_MCP, "[列表] 闪存中保存了 %d 个信号，返回第%d-%d个", flash_count, offset + 1, end);
             
             cJSON* json = cJSON_CreateObject();
             cJSON_AddNumberToObject(json, "total_count", flash_count);
+            cJSON_AddNumberToObject(json, "offset", offset);
             
-            if (flash_count > 0) {
+            if (offset < end) {
                 cJSON* signals = cJSON_CreateArray();
-                for (uint8_t i = 0; i < flash_count; i++) {
+                for (uint16_t i = offset; i < end; i++) {
                     RFSignal signal;
                     if (rf_module->GetFlashSignal(i, signal)) {
                         // 用户看到的索引是从1开始的（1-based），按录入顺序递增
                         // GetFlashSignal(i=0) 返回最新的信号，所以 user_index = flash_count - i
                         // 例如：如果有7个信号，最新的(i=0)索引为7，最旧的(i=6)索引为1
-                        uint8_t user_index = flash_count - i;  // 最新信号索引最大，按录入顺序递增
+                        uint16_t user_index = flash_count - i;  // 最新信号索引最大，按录入顺序递增
                         
                         ESP_LOGI(TAG_RF_MCP, "[列表] 信号[%d]: %s%s (%sMHz, 协议:%d, 脉冲:%dμs%s)", 
-                                user_index, signal.address.c_str(), signal.key.c_str(),
+                                user_index, signal.AddressHex().c_str(), signal.KeyHex().c_str(),
                                 signal.frequency == RF_315MHZ ? "315" : "433",
                                 signal.protocol, signal.pulse_length,
-                                signal.name.empty() ? " (未命名)" : (", 名称: " + signal.name).c_str());
+                                signal.HasName() ? (", 名称: " + std::string(signal.name)).c_str() : " (未命名)");
                         
                         cJSON* sig_obj = cJSON_CreateObject();
                         cJSON_AddNumberToObject(sig_obj, "index", user_index);  // 1-based index for user
-                        cJSON_AddStringToObject(sig_obj, "address", signal.address.c_str());
-                        cJSON_AddStringToObject(sig_obj, "key", signal.key.c_str());
+                        cJSON_AddStringToObject(sig_obj, "address", signal.AddressHex().c_str());
+                        cJSON_AddStringToObject(sig_obj, "key", signal.KeyHex().c_str());
                         cJSON_AddStringToObject(sig_obj, "frequency", signal.frequency == RF_315MHZ ? "315" : "433");
                         cJSON_AddNumberToObject(sig_obj, "protocol", signal.protocol);
+                        cJSON_AddNumberToObject(sig_obj, "bit_length", signal.bit_length);
+                        cJSON_AddStringToObject(sig_obj, "type", signal.type == RF_SIGNAL_RAW ? "raw" : "code");
                         cJSON_AddNumberToObject(sig_obj, "pulse_length", signal.pulse_length);
-                        cJSON_AddStringToObject(sig_obj, "name", signal.name.empty() ? "" : signal.name.c_str());
+                        cJSON_AddStringToObject(sig_obj, "name", signal.name);
                         cJSON_AddItemToArray(signals, sig_obj);
                     }
                 }
@@ -619,10 +863,10 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
     mcp_server.AddTool("self.rf.send_by_index",
         "按索引发送已保存的RF信号（1-based）。"
         "最新信号位于索引1，较旧的信号索引更大。"
-        "使用 self.rf.list_signals 查看所有可用信号（最多10个）及其索引。"
+        "使用 self.rf.list_signals 查看所有可用信号及其索引。"
         "信号默认发送3次（行业标准）。"
         "信号按原始频率发送，不支持修改频率。"
-        "注意：闪存最多可保存10个信号（循环缓冲区）。"
+        "注意：闪存使用循环缓冲区，容量见 self.rf.get_status 的 saved_signals_capacity。"
         "如果尝试发送不存在的索引，会抛出错误。"
         "参数：index（整数，1-based，必需，范围：1到saved_signals_count）",
         PropertyList({
@@ -640,7 +884,7 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
                 throw std::runtime_error("Index must be >= 1 (1-based indexing)");
             }
             
-            uint8_t flash_count = rf_module->GetFlashSignalCount();
+            uint16_t flash_count = rf_module->GetFlashSignalCount();
             if (user_index > flash_count) {
                 throw std::runtime_error("Index " + std::to_string(user_index) + " exceeds available signals count (" + std::to_string(flash_count) + ")");
             }
@@ -651,7 +895,7 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
             // GetFlashSignal(i=flash_count-1) 返回最旧的信号，对应用户索引 1
             // user_index = flash_count -> internal_index = 0 (latest)
             // user_index = 1 -> internal_index = flash_count - 1 (oldest)
-            uint8_t internal_index = flash_count - user_index;
+            uint16_t internal_index = flash_count - user_index;
             
             RFSignal signal;
             if (!rf_module->GetFlashSignal(internal_index, signal)) {
@@ -659,30 +903,34 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
             }
             
             ESP_LOGI(TAG_RF_MCP, "[按索引发送] 发送信号[%d]: %s%s (%sMHz, 协议:%d, 脉冲:%dμs%s)", 
-                    user_index, signal.address.c_str(), signal.key.c_str(),
+                    user_index, signal.AddressHex().c_str(), signal.KeyHex().c_str(),
                     signal.frequency == RF_315MHZ ? "315" : "433",
                     signal.protocol, signal.pulse_length,
-                    signal.name.empty() ? "" : (", 名称: " + signal.name).c_str());
+                    signal.HasName() ? (", 名称: " + std::string(signal.name)).c_str() : "");
             
             // 按原始频率发送，不支持修改频率
-            rf_module->Send(signal);
+            if (rf_module->SendAsync(signal) == 0) {
+                throw std::runtime_error("发送队列已满，请稍后重试");
+            }
             
             // 返回信号详细信息，而不是只返回 true
             cJSON* json = cJSON_CreateObject();
             cJSON_AddNumberToObject(json, "index", user_index);
-            cJSON_AddStringToObject(json, "address", signal.address.c_str());
-            cJSON_AddStringToObject(json, "key", signal.key.c_str());
+            cJSON_AddStringToObject(json, "address", signal.AddressHex().c_str());
+            cJSON_AddStringToObject(json, "key", signal.KeyHex().c_str());
             cJSON_AddStringToObject(json, "frequency", signal.frequency == RF_315MHZ ? "315" : "433");
             cJSON_AddNumberToObject(json, "protocol", signal.protocol);
+            cJSON_AddNumberToObject(json, "bit_length", signal.bit_length);
+            cJSON_AddStringToObject(json, "type", signal.type == RF_SIGNAL_RAW ? "raw" : "code");
             cJSON_AddNumberToObject(json, "pulse_length", signal.pulse_length);
-            cJSON_AddStringToObject(json, "name", signal.name.empty() ? "" : signal.name.c_str());
+            cJSON_AddStringToObject(json, "name", signal.name);
             cJSON_AddBoolToObject(json, "sent", true);
             return json;
         });
 
     mcp_server.AddTool("self.rf.set_signal_name",
         "按索引设置已保存信号的名称/主题（1-based）。"
-        "使用 self.rf.list_signals 查看所有可用信号（最多10个）及其索引。"
+        "使用 self.rf.list_signals 查看所有可用信号及其索引。"
         "设置名称后，可以通过 self.rf.send_by_name 按名称发送信号。"
         "如果 name 为空字符串，将清除信号名称。"
         "如果尝试设置不存在的索引，会抛出错误。"
@@ -710,7 +958,7 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
             
             // Allow empty string to clear name
             
-            uint8_t flash_count = rf_module->GetFlashSignalCount();
+            uint16_t flash_count = rf_module->GetFlashSignalCount();
             if (user_index > flash_count) {
                 throw std::runtime_error("Index " + std::to_string(user_index) + " exceeds available signals count (" + std::to_string(flash_count) + ")");
             }
@@ -721,7 +969,7 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
             // GetFlashSignal(i=flash_count-1) 返回最旧的信号，对应用户索引 1
             // user_index = flash_count -> internal_index = 0 (latest)
             // user_index = 1 -> internal_index = flash_count - 1 (oldest)
-            uint8_t internal_index = flash_count - user_index;
+            uint16_t internal_index = flash_count - user_index;
             
             // Get signal info before updating (for logging)
             RFSignal signal;
@@ -734,17 +982,19 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
             }
             
             ESP_LOGI(TAG_RF_MCP, "[设置名称] 信号[%d]: %s%s (%sMHz) -> 名称: %s", 
-                    user_index, signal.address.c_str(), signal.key.c_str(),
+                    user_index, signal.AddressHex().c_str(), signal.KeyHex().c_str(),
                     signal.frequency == RF_315MHZ ? "315" : "433", 
                     name.empty() ? "(已清除)" : name.c_str());
             
             // Return updated signal info
             cJSON* json = cJSON_CreateObject();
             cJSON_AddNumberToObject(json, "index", user_index);
-            cJSON_AddStringToObject(json, "address", signal.address.c_str());
-            cJSON_AddStringToObject(json, "key", signal.key.c_str());
+            cJSON_AddStringToObject(json, "address", signal.AddressHex().c_str());
+            cJSON_AddStringToObject(json, "key", signal.KeyHex().c_str());
             cJSON_AddStringToObject(json, "frequency", signal.frequency == RF_315MHZ ? "315" : "433");
             cJSON_AddNumberToObject(json, "protocol", signal.protocol);
+            cJSON_AddNumberToObject(json, "bit_length", signal.bit_length);
+            cJSON_AddStringToObject(json, "type", signal.type == RF_SIGNAL_RAW ? "raw" : "code");
             cJSON_AddNumberToObject(json, "pulse_length", signal.pulse_length);
             cJSON_AddStringToObject(json, "name", name.c_str());
             cJSON_AddBoolToObject(json, "updated", true);
@@ -754,7 +1004,10 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
     mcp_server.AddTool("self.rf.send_by_name",
         "按名称发送已保存的RF信号。"
         "使用 self.rf.list_signals 查看所有可用信号及其名称。"
-        "如果多个信号具有相同的名称，将发送第一个匹配的信号。"
+        "如果多个信号具有相同的名称，将发送最新保存的信号。"
+        "名称匹配忽略空格、标点和英文大小写；没有完全相同的名称时，依次尝试前缀匹配（\"卧室灯\"→\"卧室灯开关\"）、"
+        "名称包含在输入开头（\"大门开关\"→\"大门\"）和近似匹配（相差1-2个字）。只有唯一的最佳候选时才会发送，"
+        "否则抛出错误并列出候选名称，请让用户确认。"
         "信号默认发送3次（行业标准）。"
         "信号按原始频率发送，不支持修改频率。"
         "如果找不到匹配的名称，会抛出错误。"
@@ -779,60 +1032,199 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
                 throw std::runtime_error("Name cannot be empty.");
             }
             
-            uint8_t flash_count = rf_module->GetFlashSignalCount();
-            if (flash_count == 0) {
-                throw std::runtime_error("No signals saved. Use self.rf.copy to save signals first.");
-            }
-            
-            // Search for signal with matching name
+            uint16_t flash_count = rf_module->GetFlashSignalCount();
             RFSignal found_signal;
-            uint8_t found_index = 0;
-            bool found = false;
-            
-            // Search from oldest to newest (index 1 to flash_count)
-            for (uint8_t i = 0; i < flash_count; i++) {
-                RFSignal signal;
-                if (rf_module->GetFlashSignal(i, signal)) {
-                    if (signal.name == name) {
-                        found_signal = signal;
-                        found_index = flash_count - i;  // Convert to 1-based user index
-                        found = true;
-                        break;  // Found first match
-                    }
-                }
-            }
+            RfNameMatch match = RfFindSignalByName(rf_module, name, found_signal);
+            uint16_t found_index = flash_count - match.index;  // Convert to 1-based user index
             
-            if (!found) {
-                throw std::runtime_error("No signal found with name: \"" + name + "\". Use self.rf.list_signals to see available signals.");
-            }
-            
-            ESP_LOGI(TAG_RF_MCP, "[按名称发送] 发送信号[%d]: %s%s (%sMHz, 协议:%d, 脉冲:%dμs, 名称: %s)", 
-                    found_index, found_signal.address.c_str(), found_signal.key.c_str(),
+            ESP_LOGI(TAG_RF_MCP, "[按名称发送] 发送信号[%d]: %s%s (%sMHz, 协议:%d, 脉冲:%dμs, 名称: %s, 输入: %s)", 
+                    found_index, found_signal.AddressHex().c_str(), found_signal.KeyHex().c_str(),
                     found_signal.frequency == RF_315MHZ ? "315" : "433",
-                    found_signal.protocol, found_signal.pulse_length, name.c_str());
+                    found_signal.protocol, found_signal.pulse_length, found_signal.name, name.c_str());
             
             // 按原始频率发送，不支持修改频率
-            rf_module->Send(found_signal);
+            if (rf_module->SendAsync(found_signal) == 0) {
+                throw std::runtime_error("发送队列已满，请稍后重试");
+            }
             
             // 返回信号详细信息
             cJSON* json = cJSON_CreateObject();
             cJSON_AddNumberToObject(json, "index", found_index);
-            cJSON_AddStringToObject(json, "address", found_signal.address.c_str());
-            cJSON_AddStringToObject(json, "key", found_signal.key.c_str());
+            cJSON_AddStringToObject(json, "address", found_signal.AddressHex().c_str());
+            cJSON_AddStringToObject(json, "key", found_signal.KeyHex().c_str());
             cJSON_AddStringToObject(json, "frequency", found_signal.frequency == RF_315MHZ ? "315" : "433");
             cJSON_AddNumberToObject(json, "protocol", found_signal.protocol);
+            cJSON_AddNumberToObject(json, "bit_length", found_signal.bit_length);
+            cJSON_AddStringToObject(json, "type", found_signal.type == RF_SIGNAL_RAW ? "raw" : "code");
             cJSON_AddNumberToObject(json, "pulse_length", found_signal.pulse_length);
-            cJSON_AddStringToObject(json, "name", found_signal.name.c_str());
+            cJSON_AddStringToObject(json, "name", found_signal.name);
+            static const char* const kMatchKinds[] = { "exact", "prefix", "contained", "fuzzy" };
+            cJSON_AddStringToObject(json, "match", kMatchKinds[match.kind]);
             cJSON_AddBoolToObject(json, "sent", true);
             return json;
         });
 
+    mcp_server.AddTool("self.rf.send_scene",
+        "按顺序批量发送多个已保存的信号（场景），例如\"回家模式\"：打开大门、打开客厅灯、关闭窗帘。"
+        "所有信号预先编译成一个发送计划，作为一个任务连续发送，步骤之间的间隔精确到微秒，其他发送请求不会插在中间。"
+        "比多次调用 self.rf.send_by_name 更快、更准确。信号名称的匹配方式与 self.rf.send_by_name 相同。"
+        "参数：signals（字符串，必需）- 用英文逗号分隔的步骤，每一步为\"名称[:重复次数[:间隔毫秒]]\"，"
+        "如\"大门,客厅灯:5,窗帘:3:500\"；重复次数省略或为0时使用当前配置的重复次数，间隔省略时使用gap_ms；"
+        "gap_ms（整数，可选，默认200）- 每一步发送完成后到下一步开始的间隔（毫秒）；"
+        "save_as（字符串，可选）- 如果提供，同时把场景按此名称保存，之后可用 self.rf.play_scene 重播。"
+        "最多16步。信号进入发送队列后立即返回。",
+        PropertyList({
+            Property("signals", kPropertyTypeString),
+            Property("gap_ms", kPropertyTypeInteger, 200, 0, 60000),
+            Property("save_as", kPropertyTypeString, "")
+        }),
+        [rf_module](const PropertyList& properties) -> ReturnValue {
+            if (!rf_module->IsFlashStorageEnabled()) {
+                throw std::runtime_error("Flash storage not enabled. Cannot send signals by name.");
+            }
+            
+            std::string signals = properties["signals"].value<std::string>();
+            int gap_ms = properties["gap_ms"].value<int>();
+            std::string save_as = properties["save_as"].value<std::string>();
+            
+            RfSceneStep steps[RfSceneBuilder::kMaxSteps];
+            size_t count = 0;
+            cJSON* step_list = cJSON_CreateArray();
+            size_t start = 0;
+            try {
+                while (start <= signals.size()) {
+                    size_t end = signals.find(',', start);
+                    if (end == std::string::npos) {
+                        end = signals.size();
+                    }
+                    std::string item = signals.substr(start, end - start);
+                    start = end + 1;
+                    if (item.find_first_not_of(' ') == std::string::npos) {
+                        continue;
+                    }
+                    if (count >= RfSceneBuilder::kMaxSteps) {
+                        throw std::runtime_error("A scene has at most " + std::to_string(RfSceneBuilder::kMaxSteps) + " steps");
+                    }
+                    
+                    // 名称[:重复次数[:间隔毫秒]]
+                    int repeat = 0;
+                    int step_gap_ms = gap_ms;
+                    size_t colon = item.find(':');
+                    std::string name = item.substr(0, colon);
+                    if (colon != std::string::npos) {
+                        std::string options = item.substr(colon + 1);
+                        size_t second = options.find(':');
+                        repeat = atoi(options.substr(0, second).c_str());
+                        if (second != std::string::npos) {
+                            step_gap_ms = atoi(options.substr(second + 1).c_str());
+                        }
+                    }
+                    if (repeat < 0 || repeat > 255 || step_gap_ms < 0 || step_gap_ms > 60000) {
+                        throw std::runtime_error("Invalid repeat count or gap in step \"" + item + "\"");
+                    }
+                    
+                    RfSceneStep& step = steps[count++];
+                    RfFindSignalByName(rf_module, name, step.signal);
+                    step.repeat = static_cast<uint8_t>(repeat);
+                    step.gap_us = static_cast<uint32_t>(step_gap_ms) * 1000;
+                    
+                    cJSON* step_json = cJSON_CreateObject();
+                    cJSON_AddStringToObject(step_json, "name", step.signal.name);
+                    cJSON_AddStringToObject(step_json, "frequency", step.signal.frequency == RF_315MHZ ? "315" : "433");
+                    cJSON_AddNumberToObject(step_json, "repeat", repeat);
+                    cJSON_AddNumberToObject(step_json, "gap_ms", step_gap_ms);
+                    cJSON_AddItemToArray(step_list, step_json);
+                }
+            } catch (...) {
+                cJSON_Delete(step_list);
+                throw;
+            }
+            if (count == 0) {
+                cJSON_Delete(step_list);
+                throw std::runtime_error("No signals given. Use self.rf.list_signals to see available signals.");
+            }
+            
+            bool saved = false;
+            if (!save_as.empty()) {
+                saved = rf_module->SaveScene(save_as, steps, count);
+            }
+            ESP_LOGI(TAG_RF_MCP, "[场景] 发送%d步%s%s", (int)count,
+                     save_as.empty() ? "" : ", 保存为: ", save_as.c_str());
+            if (rf_module->SendScene(steps, count) == 0) {
+                cJSON_Delete(step_list);
+                throw std::runtime_error("发送队列已满或场景无法编译，请稍后重试");
+            }
+            
+            cJSON* json = cJSON_CreateObject();
+            cJSON_AddNumberToObject(json, "step_count", count);
+            cJSON_AddItemToObject(json, "steps", step_list);
+            if (!save_as.empty()) {
+                cJSON_AddStringToObject(json, "saved_as", save_as.c_str());
+                cJSON_AddBoolToObject(json, "saved", saved);
+            }
+            cJSON_AddBoolToObject(json, "sent", true);
+            return json;
+        });
+
+    mcp_server.AddTool("self.rf.play_scene",
+        "重播用 self.rf.send_scene 的 save_as 保存的场景，步骤、重复次数和间隔与保存时相同。"
+        "场景保存了完整的信号，删除或重命名原信号不影响场景。"
+        "使用 self.rf.list_scenes 查看已保存的场景。"
+        "参数：name（字符串，必需）- 场景名称，需与保存时完全一致",
+        PropertyList({
+            Property("name", kPropertyTypeString)
+        }),
+        [rf_module](const PropertyList& properties) -> ReturnValue {
+            std::string name = properties["name"].value<std::string>();
+            if (rf_module->PlayScene(name) == 0) {
+                throw std::runtime_error("Scene \"" + name + "\" not found or could not be queued. Use self.rf.list_scenes to see saved scenes.");
+            }
+            cJSON* json = cJSON_CreateObject();
+            cJSON_AddStringToObject(json, "name", name.c_str());
+            cJSON_AddBoolToObject(json, "sent", true);
+            return json;
+        });
+
+    mcp_server.AddTool("self.rf.list_scenes",
+        "列出已保存的场景名称（最多16个）。",
+        PropertyList(),
+        [rf_module](const PropertyList& properties) -> ReturnValue {
+            std::string names[RFModule::kMaxScenes];
+            size_t count = rf_module->ListScenes(names, RFModule::kMaxScenes);
+            cJSON* json = cJSON_CreateObject();
+            cJSON* scenes = cJSON_CreateArray();
+            for (size_t i = 0; i < count; i++) {
+                cJSON_AddItemToArray(scenes, cJSON_CreateString(names[i].c_str()));
+            }
+            cJSON_AddItemToObject(json, "scenes", scenes);
+            cJSON_AddNumberToObject(json, "count", count);
+            cJSON_AddNumberToObject(json, "capacity", RFModule::kMaxScenes);
+            return json;
+        });
+
+    mcp_server.AddTool("self.rf.delete_scene",
+        "删除已保存的场景（不影响场景中使用的信号）。"
+        "参数：name（字符串，必需）- 场景名称",
+        PropertyList({
+            Property("name", kPropertyTypeString)
+        }),
+        [rf_module](const PropertyList& properties) -> ReturnValue {
+            std::string name = properties["name"].value<std::string>();
+            if (!rf_module->DeleteScene(name)) {
+                throw std::runtime_error("Scene \"" + name + "\" not found. Use self.rf.list_scenes to see saved scenes.");
+            }
+            cJSON* json = cJSON_CreateObject();
+            cJSON_AddStringToObject(json, "name", name.c_str());
+            cJSON_AddBoolToObject(json, "deleted", true);
+            return json;
+        });
+
     mcp_server.AddTool("self.rf.clear_signals",
         "清理闪存中保存的RF信号。"
         "可以清理所有信号，或按索引清理特定信号。"
         "清理后，使用 self.rf.list_signals 验证剩余信号。"
         "参数：clear_all（布尔值，可选，默认false）- 如果为true，清理所有信号；"
-        "index（整数，可选，1-based）- 如果提供，清理此索引的信号（需要clear_all=false或省略）。"
+        "index（整数，可选，1-based，与 list_signals 返回的 index 一致）- 如果提供，清理此索引的信号（需要clear_all=false或省略），之后录入的信号索引依次减1。"
         "如果同时提供clear_all和index，clear_all优先。"
         "返回：cleared_count（清理的信号数量）、remaining_count（剩余的信号数量）",
         PropertyList({
@@ -844,7 +1236,7 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
                 throw std::runtime_error("Flash storage not enabled. Cannot clear signals.");
             }
             
-            uint8_t initial_count = rf_module->GetFlashSignalCount();
+            uint16_t initial_count = rf_module->GetFlashSignalCount();
             
             // Check if clear_all is requested
             bool clear_all = false;
@@ -886,14 +1278,15 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
                     throw std::runtime_error("Index " + std::to_string(user_index) + " exceeds available signals count (" + std::to_string(initial_count) + ")");
                 }
                 
-                // Convert 1-based user index to 0-based internal index
-                uint8_t internal_index = user_index - 1;
+                // Same numbering as list_signals (oldest = 1, latest = count):
+                // user_index = count -> internal_index = 0 (latest)
+                uint16_t internal_index = initial_count - user_index;
                 
                 // Get signal info before clearing (for logging)
                 RFSignal signal;
                 std::string signal_info = "";
                 if (rf_module->GetFlashSignal(internal_index, signal)) {
-                    signal_info = signal.address + signal.key + " (" + 
+                    signal_info = signal.AddressHex() + signal.KeyHex() + " (" + 
                                  (signal.frequency == RF_315MHZ ? "315" : "433") + "MHz)";
                 }
                 
@@ -901,7 +1294,7 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
                     throw std::runtime_error("Failed to clear signal at index " + std::to_string(user_index));
                 }
                 
-                uint8_t remaining_count = rf_module->GetFlashSignalCount();
+                uint16_t remaining_count = rf_module->GetFlashSignalCount();
                 ESP_LOGI(TAG_RF_MCP, "[清理] 已清除信号索引 %d%s (剩余%d个信号)", 
                         user_index, 
                         signal_info.empty() ? "" : (" " + signal_info).c_str(),
@@ -941,6 +1334,67 @@ inline void RegisterRFMcpTools(RFModule* rf_module) {
             
             return true;
         });
+
+    mcp_server.AddTool("self.rf.register_protocol",
+        "注册自定义RF协议（内置协议1-12为rc-switch标准协议）。"
+        "时序以脉冲长度为单位：例如 sync_high=1, sync_low=31 表示同步位为1个脉冲高电平加31个脉冲低电平。"
+        "注册后的协议默认启用接收解码，并可在 self.rf.set_config 中用于发送。"
+        "返回新协议编号（13-32）。",
+        PropertyList({
+            Property("pulse_length", kPropertyTypeInteger, 350, 1, 65535),
+            Property("sync_high", kPropertyTypeInteger, 1, 0, 255),
+            Property("sync_low", kPropertyTypeInteger, 31, 0, 255),
+            Property("zero_high", kPropertyTypeInteger, 1, 0, 255),
+            Property("zero_low", kPropertyTypeInteger, 3, 0, 255),
+            Property("one_high", kPropertyTypeInteger, 3, 0, 255),
+            Property("one_low", kPropertyTypeInteger, 1, 0, 255),
+            Property("inverted", kPropertyTypeBoolean, false)
+        }),
+        [rf_module](const PropertyList& properties) -> ReturnValue {
+            RfProtocol protocol;
+            protocol.pulseLength = properties["pulse_length"].value<int>();
+            protocol.syncFactor.high = properties["sync_high"].value<int>();
+            protocol.syncFactor.low = properties["sync_low"].value<int>();
+            protocol.zero.high = properties["zero_high"].value<int>();
+            protocol.zero.low = properties["zero_low"].value<int>();
+            protocol.one.high = properties["one_high"].value<int>();
+            protocol.one.low = properties["one_low"].value<int>();
+            protocol.invertedSignal = properties["inverted"].value<bool>();
+            
+            uint8_t number = rf_module->RegisterProtocol(protocol);
+            if (number == 0) {
+                throw std::runtime_error("Failed to register protocol (invalid timing or no free slot)");
+            }
+            
+            cJSON* json = cJSON_CreateObject();
+            cJSON_AddNumberToObject(json, "protocol", number);
+            cJSON_AddBoolToObject(json, "enabled", true);
+            return json;
+        });
+
+    mcp_server.AddTool("self.rf.set_protocol_enabled",
+        "启用或禁用某个协议的接收解码（1-12为内置协议，13-32为自定义协议）。"
+        "只解码实际使用的协议可以减少误识别和解码开销。"
+        "设置 remove=true 可删除自定义协议。",
+        PropertyList({
+            Property("protocol", kPropertyTypeInteger, 1, 1, 32),
+            Property("enabled", kPropertyTypeBoolean, true),
+            Property("remove", kPropertyTypeBoolean, false)
+        }),
+        [rf_module](const PropertyList& properties) -> ReturnValue {
+            int protocol = properties["protocol"].value<int>();
+            if (properties["remove"].value<bool>()) {
+                if (!rf_module->RemoveProtocol(protocol)) {
+                    throw std::runtime_error("Only registered custom protocols (13-32) can be removed");
+                }
+            } else if (!rf_module->SetProtocolEnabled(protocol, properties["enabled"].value<bool>())) {
+                throw std::runtime_error("Protocol " + std::to_string(protocol) + " is not defined");
+            }
+            
+            cJSON* json = cJSON_CreateObject();
+            cJSON_AddNumberToObject(json, "enabled_mask", rf_module->GetEnabledProtocols());
+            return json;
+        });
 }
 
 #endif // RF_MCP_TOOLS_H
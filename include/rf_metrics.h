@@ -0,0 +1,186 @@
+#ifndef RF_METRICS_H
+#define RF_METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include "rf_module_config.h"
+#include "rf_protocol.h"
+
+// Updates one metric of a channel's RfMetricsBlock, e.g. RF_METRIC(metrics_, overflows.Add());
+// compiles to nothing when CONFIG_RF_MODULE_ENABLE_METRICS is 0
+#if CONFIG_RF_MODULE_ENABLE_METRICS
+#define RF_METRIC(block, update) do { if ((block) != nullptr) { (block)->update; } } while (0)
+#else
+#define RF_METRIC(block, update) do { } while (0)
+#endif
+
+// Log2 histogram as returned by RFModule::GetMetrics(): bucket 0 counts zeros, bucket i
+// values in [2^(i-1), 2^i), the last bucket everything from 2^(kBuckets-2) up
+struct RfHistogram {
+    static constexpr size_t kBuckets = 20;
+
+    uint32_t buckets[kBuckets];
+    uint32_t count;
+    uint32_t max;
+
+    // Shifts instead of a count-leading-zeros builtin, which is a library call on some targets
+    __attribute__((always_inline)) static inline size_t Bucket(uint32_t value) {
+        size_t bucket = 0;
+        while (value != 0 && bucket < kBuckets - 1) {
+            value >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+
+    // Largest value the bucket can hold (the last bucket is open-ended)
+    static uint32_t UpperBound(size_t bucket) {
+        return bucket == 0 ? 0 : (bucket < kBuckets - 1 ? (1UL << bucket) - 1 : UINT32_MAX);
+    }
+
+    // Upper bound of the bucket the given share of samples falls into, capped at max; 0 without samples
+    uint32_t Percentile(unsigned int percent) const {
+        if (count == 0) {
+            return 0;
+        }
+        const uint64_t target = (static_cast<uint64_t>(count) * percent + 99) / 100;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; i++) {
+            seen += buckets[i];
+            if (seen >= target && seen > 0) {
+                const uint32_t bound = UpperBound(i);
+                return bound < max ? bound : max;
+            }
+        }
+        return max;
+    }
+
+    void Merge(const RfHistogram& other) {
+        for (size_t i = 0; i < kBuckets; i++) {
+            buckets[i] += other.buckets[i];
+        }
+        count += other.count;
+        if (other.max > max) {
+            max = other.max;
+        }
+    }
+};
+
+// Snapshot of one channel's (or, summed, one band's) hot-path metrics
+struct RfMetrics {
+    // Receive ISR
+    uint32_t edges;
+    RfHistogram isr_cycles;          // CPU cycles spent in the edge interrupt
+    // Decoder task
+    uint32_t frames_decoded;         // Frames a protocol matched, unreported repeats included
+    uint32_t frames_reported;        // Frames handed to the receive queue
+    uint32_t decode_failures;        // Frames no enabled protocol matched
+    uint32_t overflows;              // Frames longer than the timing buffer, restarted midway
+    uint32_t resyncs;                // Decoder resets after the edge ring overflowed
+    uint32_t protocol_misses[RfProtocolRegistry::kMaxProtocols];  // Index p - 1: frames protocol p was tried on and lost
+    RfHistogram decode_latency_us;   // Edge that completed a frame until the frame was queued
+    // Transmit
+    uint32_t transmissions;
+    RfHistogram tx_jitter_us;        // |measured - planned airtime| per transmission
+
+    void Merge(const RfMetrics& other) {
+        edges += other.edges;
+        isr_cycles.Merge(other.isr_cycles);
+        frames_decoded += other.frames_decoded;
+        frames_reported += other.frames_reported;
+        decode_failures += other.decode_failures;
+        overflows += other.overflows;
+        resyncs += other.resyncs;
+        for (size_t i = 0; i < RfProtocolRegistry::kMaxProtocols; i++) {
+            protocol_misses[i] += other.protocol_misses[i];
+        }
+        decode_latency_us.Merge(other.decode_latency_us);
+        transmissions += other.transmissions;
+        tx_jitter_us.Merge(other.tx_jitter_us);
+    }
+};
+
+/**
+ * Live metrics of one channel
+ *
+ * Every field has a single writer: the receive ISR, the decoder task or
+ * whichever thread transmits on the channel. Updates are therefore plain
+ * relaxed loads and stores (no atomic read-modify-write, which some
+ * targets implement as library calls) and are forced inline, so the IRAM
+ * ISR can update them while the flash cache is off. Read() may see one
+ * field updated and the next not yet, never a torn value.
+ *
+ * Pure C++ with no ESP-IDF dependency, like RfRawCode.
+ */
+class RfMetricsBlock {
+public:
+    class Counter {
+    public:
+        Counter() : value_(0) {}
+        __attribute__((always_inline)) inline void Add(uint32_t n = 1) {
+            value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+        __attribute__((always_inline)) inline void Raise(uint32_t value) {  // Keeps the maximum
+            if (value > value_.load(std::memory_order_relaxed)) {
+                value_.store(value, std::memory_order_relaxed);
+            }
+        }
+        uint32_t Load() const { return value_.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint32_t> value_;
+    };
+
+    class Histogram {
+    public:
+        __attribute__((always_inline)) inline void Record(uint32_t value) {
+            buckets_[RfHistogram::Bucket(value)].Add();
+            count_.Add();
+            max_.Raise(value);
+        }
+
+        void Read(RfHistogram& histogram) const {
+            for (size_t i = 0; i < RfHistogram::kBuckets; i++) {
+                histogram.buckets[i] = buckets_[i].Load();
+            }
+            histogram.count = count_.Load();
+            histogram.max = max_.Load();
+        }
+
+    private:
+        Counter buckets_[RfHistogram::kBuckets];
+        Counter count_;
+        Counter max_;
+    };
+
+    Counter edges;
+    Histogram isr_cycles;
+    Counter frames_decoded;
+    Counter frames_reported;
+    Counter decode_failures;
+    Counter overflows;
+    Counter resyncs;
+    Counter protocol_misses[RfProtocolRegistry::kMaxProtocols];
+    Histogram decode_latency_us;
+    Counter transmissions;
+    Histogram tx_jitter_us;
+
+    void Read(RfMetrics& metrics) const {
+        metrics.edges = edges.Load();
+        isr_cycles.Read(metrics.isr_cycles);
+        metrics.frames_decoded = frames_decoded.Load();
+        metrics.frames_reported = frames_reported.Load();
+        metrics.decode_failures = decode_failures.Load();
+        metrics.overflows = overflows.Load();
+        metrics.resyncs = resyncs.Load();
+        for (size_t i = 0; i < RfProtocolRegistry::kMaxProtocols; i++) {
+            metrics.protocol_misses[i] = protocol_misses[i].Load();
+        }
+        decode_latency_us.Read(metrics.decode_latency_us);
+        metrics.transmissions = transmissions.Load();
+        tx_jitter_us.Read(metrics.tx_jitter_us);
+    }
+};
+
+#endif // RF_METRICS_H
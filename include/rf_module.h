@@ -2,51 +2,141 @@
 #define RF_MODULE_H
 
 #include <driver/gpio.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 #include <string>
 #include <cstdint>
+#include <atomic>
 #include "rf_module_config.h"
+#include "rf_metrics.h"
+#include "rf_protocol.h"
+#include "rf_raw_code.h"
+#include "rf_scene.h"
+#include "rf_signal.h"
+#include "rf_signal_index.h"
+#include "rf_name_index.h"
+#include "rf_slot_table.h"
+#include "rf_signal_log.h"
+#include "rf_trace.h"
+#include "rf_tx_queue.h"
 
-#if CONFIG_RF_MODULE_ENABLE_FLASH_STORAGE
-#include <nvs.h>  // NVS available on all ESP32 series chips
-#endif
+#include <nvs.h>  // NVS available on all ESP32 series chips; nvs_handle_ exists either way
 
 // Forward declarations
-class RCSwitch;
-class TCSwitch;
+class RfRadioChannel;
+struct RfDecodedFrame;
 
-enum RFFrequency {
-    RF_433MHZ = 0,
-    RF_315MHZ = 1
+// One transmitter and/or receiver managed by RFModule
+struct RfChannelConfig {
+    RFFrequency band;
+    uint8_t antenna;      // Antenna ID, free for the application (e.g. which room)
+    gpio_num_t tx_pin;    // GPIO_NUM_NC for a receive-only channel
+    gpio_num_t rx_pin;    // GPIO_NUM_NC for a transmit-only channel
 };
 
-struct RFSignal {
-    std::string address;      // 6位十六进制地址码
-    std::string key;          // 2位十六进制按键值
-    RFFrequency frequency;    // 频率类型
-    uint8_t protocol;        // 协议编号
-    uint16_t pulse_length;    // 脉冲长度（微秒）
-    std::string name;         // 信号主题/名称（如"卧室灯开关"、"空调开关"）
-    
-    RFSignal() : frequency(RF_433MHZ), protocol(1), pulse_length(320) {}
+// Per-channel counters, see RFModule::GetChannelStats()
+struct RfChannelStats {
+    uint32_t sent;              // Signals transmitted on this channel
+    uint32_t received;          // Frames Receive() returned from this channel
+    uint32_t merged;            // Frames dropped because another channel already returned the same one
+    uint32_t dropped_frames;
+    uint32_t dropped_edges;
+    uint32_t flash_busy_edges;
 };
 
+// Transmit jobs, see RFModule::SendAsync()
+typedef uint32_t RfTxHandle;  // 0 = not queued
+
+struct RfTxResult {
+    bool sent;              // At least one channel transmitted the signal
+    uint32_t airtime_us;    // First pulse until every channel finished
+    uint32_t wait_us;       // Time spent in the queue
+};
+
+// Runs on the TX task once the job is done; keep it short
+typedef void (*RfTxCallback)(RfTxHandle handle, const RfTxResult& result, void* context);
+
 class RFModule {
 public:
+    static constexpr size_t kMaxChannels = 32;  // Channel sets are 32-bit masks (bit n = channel n)
+    
+    // One 433MHz and one 315MHz transceiver: channel 0 = 433MHz, 1 = 315MHz (bands disabled in Kconfig are left out)
     RFModule(gpio_num_t tx433_pin, gpio_num_t rx433_pin,
              gpio_num_t tx315_pin, gpio_num_t rx315_pin);
+    // Any number of transceivers (up to kMaxChannels), e.g. several receivers per band for coverage.
+    // The array is copied; channel n is channels[n].
+    RFModule(const RfChannelConfig* channels, size_t count);
     ~RFModule();
     
     // Initialization
     void Begin();
     void End();
     
-    // Send functions
+    // Send functions (first transmit channel of the band)
+    // All sends go through one TX task, so concurrent callers never interleave on a pin.
+    // The synchronous forms queue the job and block until it has been transmitted.
     void Send(const std::string& address, const std::string& key, RFFrequency freq = RF_433MHZ);
     void Send(const RFSignal& signal);
+    // Sends on every channel in channel_mask whose band matches the signal; false if none could
+    bool SendOnChannels(const RFSignal& signal, uint32_t channel_mask);
+    bool SendOnChannel(const RFSignal& signal, uint8_t channel) {
+        return channel < kMaxChannels && SendOnChannels(signal, 1UL << channel);
+    }
+    // Queues the job and returns at once; higher priority jobs go first, equal ones in order.
+    // callback (optional) runs on the TX task with the airtime. Returns 0 when the queue is full.
+    RfTxHandle SendAsync(const RFSignal& signal, uint8_t priority = 0,
+                         RfTxCallback callback = nullptr, void* context = nullptr);
+    RfTxHandle SendAsync(const RFSignal& signal, uint32_t channel_mask, uint8_t priority,
+                         RfTxCallback callback = nullptr, void* context = nullptr);
+    RfTxHandle SendAsync(const std::string& address, const std::string& key, RFFrequency freq = RF_433MHZ,
+                         uint8_t priority = 0);
+    // Scenes: up to RfSceneBuilder::kMaxSteps signals compiled into one transmit schedule and sent
+    // back to back as one job, each on the first transmit channel of its band. Gaps between steps on
+    // the same transmitter are clocked by the RMT peripheral; a change of transmitter is timed by the CPU.
+    RfTxHandle SendScene(const RfSceneStep* steps, size_t count, uint8_t priority = 0,
+                         RfTxCallback callback = nullptr, void* context = nullptr);
+    // Named scenes are kept in NVS (flash storage must be enabled); saving an existing name replaces it
+    static constexpr size_t kMaxScenes = 16;
+    bool SaveScene(const std::string& name, const RfSceneStep* steps, size_t count);
+    RfTxHandle PlayScene(const std::string& name, uint8_t priority = 0,
+                         RfTxCallback callback = nullptr, void* context = nullptr);
+    bool DeleteScene(const std::string& name);
+    size_t ListScenes(std::string* names, size_t max_count) const;  // Returns count
+    size_t GetTxQueueDepth() const;  // Jobs waiting for the TX task
+    uint32_t GetLastTxAirtime() const { return last_tx_airtime_us_; }  // Microseconds, most recent job
     
     // Receive functions
+    // Frames from all receiving channels are merged oldest first; a frame another channel of the
+    // same band delivered within CONFIG_RF_MODULE_RX_MERGE_WINDOW_MS is dropped (RfChannelStats::merged).
+    // RFSignal::channel tells which channel heard it.
     bool ReceiveAvailable();
     bool Receive(RFSignal& signal);
+    bool WaitForSignal(uint32_t timeout_ms);  // Blocks until a decoded frame is queued on any band or timeout
+    size_t ReceiveBatch(RFSignal* signals, size_t max_count);  // Drains up to max_count queued frames, returns count
+    // Summed over the band's channels
+    uint32_t GetDroppedFrameCount(RFFrequency freq = RF_433MHZ) const;  // Frames lost because the receive queue was full
+    uint32_t GetDroppedEdgeCount(RFFrequency freq = RF_433MHZ) const;   // Edges lost because the decoder fell behind
+    uint32_t GetFlashBusyEdgeCount(RFFrequency freq = RF_433MHZ) const; // Edges captured while a flash write had the cache off
+    
+    // Channels
+    size_t GetChannelCount() const { return channel_count_; }
+    const RfChannelConfig* GetChannelConfig(uint8_t channel) const;  // nullptr past the end
+    bool GetChannelStats(uint8_t channel, RfChannelStats& stats) const;
+    // Hot-path metrics (see RfMetrics) of one channel or summed over a band's channels;
+    // false when metrics are compiled out (CONFIG_RF_MODULE_ENABLE_METRICS) or nothing matched
+    bool GetChannelMetrics(uint8_t channel, RfMetrics& metrics) const;
+    bool GetMetrics(RFFrequency freq, RfMetrics& metrics) const;
+    // Trace of recent RX, TX and flash events (see RfTraceType) as a binary dump for
+    // host/rf_trace_decode.py; the newest events that fit in capacity are kept.
+    // Both return 0 when tracing is compiled out (CONFIG_RF_MODULE_ENABLE_TRACE).
+    size_t GetTraceDumpSize() const;  // Buffer size that holds every event
+    size_t DumpTrace(uint8_t* out, size_t capacity) const;
+    uint32_t GetChannelMask(RFFrequency freq, bool transmit) const;  // Channels of a band with a TX (or RX) pin
+    void SetChannelReceive(uint8_t channel, bool enabled);  // Per channel, on top of EnableReceive(band)
+    bool IsChannelReceiving(uint8_t channel) const;
     
     // Configuration
     // Note: When freq is not specified (0xFF), sets both frequencies (433MHz and 315MHz)
@@ -54,6 +144,14 @@ public:
     void SetProtocol(uint8_t protocol, RFFrequency freq = RF_433MHZ);
     void SetPulseLength(uint16_t pulse_length, RFFrequency freq = RF_433MHZ);
     
+    // Protocol registry (shared by both bands; 1-12 are the built-in rc-switch protocols)
+    // Changes are kept in flash when flash storage is enabled
+    uint8_t RegisterProtocol(const RfProtocol& protocol);  // Returns the new protocol number (13-32), 0 when full
+    bool RemoveProtocol(uint8_t protocol);                 // Custom protocols only
+    bool SetProtocolEnabled(uint8_t protocol, bool enabled);  // Enabled protocols are tried by the receive decoder
+    bool GetProtocol(uint8_t protocol, RfProtocol& timing) const;
+    uint32_t GetEnabledProtocols() const;  // Bit n-1 = protocol n
+    
     // Frequency selection
     void SetFrequency(RFFrequency freq);
     RFFrequency GetFrequency() const { return current_frequency_; }
@@ -67,12 +165,20 @@ public:
     void SetCapturedSignalName(const std::string& name);  // Set name for captured signal
     void ClearCapturedSignal();
     
+    // Raw capture: remotes no enabled protocol decodes are received as RF_SIGNAL_RAW
+    // (seen twice with the same timing before it is reported)
+    void EnableRawCapture();
+    void DisableRawCapture();
+    bool IsRawCapture() const { return raw_capture_; }
+    // Timings of a RF_SIGNAL_RAW signal; nullptr once kRawPoolSize newer raw frames have been seen
+    const RfRawCode* GetRawTimings(const RFSignal& signal) const { return raw_pool_.Get(signal.raw_handle); }
+    
     // Statistics
     uint32_t GetSendCount() const { return send_count_; }
     uint32_t GetReceiveCount() const { return receive_count_; }
     void ResetCounters();
     
-    // Receive control
+    // Receive control (all channels of the band)
     void EnableReceive(RFFrequency freq = RF_433MHZ);
     void DisableReceive(RFFrequency freq = RF_433MHZ);
     bool IsReceiving(RFFrequency freq = RF_433MHZ) const;
@@ -89,46 +195,87 @@ public:
     RFSignal GetLastReceived() const { return last_received_; }
     void ClearReplayBuffer();
     
-    // Flash persistence functions (NVS available on all ESP32 series chips)
+    // Flash persistence functions
+    // Signals go to an append-only log on the CONFIG_RF_MODULE_SIGNAL_PARTITION data partition when
+    // the partition table has one (thousands of signals), otherwise to NVS (tens of signals).
+    // Saves, renames and deletes update RAM at once; a background task writes them to flash,
+    // batching what arrives within CONFIG_RF_MODULE_FLASH_COMMIT_WINDOW_MS into one commit.
     void EnableFlashStorage(const char* namespace_name = "rf_replay");
     void DisableFlashStorage();
     bool SaveToFlash();
     bool LoadFromFlash();
     void ClearFlash();
-    bool ClearFlashSignal(uint8_t index);  // Clear a single signal by index (0-based, internal index)
-    uint8_t GetFlashSignalCount() const { return flash_signal_count_; }
-    bool GetFlashSignal(uint8_t index, RFSignal& signal) const;
-    bool UpdateFlashSignalName(uint8_t index, const std::string& name);  // Update name for a signal by index (0-based, internal index)
+    bool ClearFlashSignal(uint16_t index);  // Clear a single signal by index (0-based, internal index)
+    uint16_t GetFlashSignalCount() const { return flash_slots_.Count(); }
+    uint16_t GetFlashSignalCapacity() const;  // As the component was built (CONFIG_RF_MODULE_MAX_FLASH_SIGNALS)
+    bool GetFlashSignal(uint16_t index, RFSignal& signal) const;
+    bool UpdateFlashSignalName(uint16_t index, const std::string& name);  // Update name for a signal by index (0-based, internal index)
     bool IsFlashStorageEnabled() const { return flash_storage_enabled_; }
-    bool CheckDuplicateSignal(const RFSignal& signal, uint8_t& duplicate_index) const;  // Check if signal already exists in flash storage
+    bool IsSignalLogActive() const { return flash_log_active_; }  // Signals are on the data partition, not in NVS
+    bool CheckDuplicateSignal(const RFSignal& signal, uint16_t& duplicate_index) const;  // Check if signal already exists in flash storage
+    bool Flush();  // Blocks until earlier flash changes are written; false if any of them failed
+    // Ranked name candidates (exact, prefix, contained, fuzzy; newest first on ties), index = internal index
+    size_t FindSignalsByName(const std::string& name, RfNameMatch* matches, size_t max_matches) const;
     
     // Status
     bool IsEnabled() const { return enabled_; }
 
 private:
-    // Hardware pins
-    gpio_num_t tx433_pin_;
-    gpio_num_t rx433_pin_;
-    gpio_num_t tx315_pin_;
-    gpio_num_t rx315_pin_;
-    
-    // Switch instances
-    RCSwitch* rc_switch_;  // 433MHz
-    TCSwitch* tc_switch_;  // 315MHz
+    // Transceivers
+    struct Channel {
+        RfChannelConfig config;
+        RfRadioChannel* radio;    // Created by Begin(); nullptr when the band is disabled
+        bool receive_enabled;     // SetChannelReceive()
+        uint32_t sent;
+        uint32_t received;
+        uint32_t merged;
+    };
+    Channel* channels_;           // channel_count_ entries
+    uint8_t channel_count_;
     
     // Current frequency
     RFFrequency current_frequency_;
     
-    // Configuration
-    uint8_t repeat_count_433_;
-    uint8_t repeat_count_315_;
-    uint8_t protocol_433_;
-    uint8_t protocol_315_;
-    uint16_t pulse_length_433_;
-    uint16_t pulse_length_315_;
+    // Configuration, shared by all channels of a band (index: BandIndex())
+    struct BandSettings {
+        uint8_t repeat_count;
+        uint8_t protocol;
+        uint16_t pulse_length;
+        bool receive_enabled;     // EnableReceive()
+    };
+    static constexpr size_t kBandCount = 2;
+    BandSettings bands_[kBandCount];
+    
+    // Transmit task: one job per Send()/SendAsync()/SendScene(), highest priority first
+    struct SceneSchedule {
+        RfSymbol* symbols;            // Internal RAM, read by the RMT peripheral
+        RfSceneSegment segments[RfSceneBuilder::kMaxSteps];
+        size_t segment_count;
+        size_t step_count;
+    };
+    struct TxJob {
+        RfTxHandle handle;
+        RFSignal signal;
+        RfRawCode raw;                // Timings of a raw signal, copied so the pool may reuse its slot
+        uint32_t channel_mask;
+        int64_t queued_at;            // esp_timer_get_time()
+        RfTxCallback callback;
+        void* context;
+        SemaphoreHandle_t done;       // Synchronous sends: given once the job is finished
+        RfTxResult* result;           // Synchronous sends: filled before done is given
+        SceneSchedule* scene;         // SendScene(): owned by the job, freed once it ran
+    };
+    RfTxQueue<TxJob> tx_queue_;       // CONFIG_RF_MODULE_TX_QUEUE_LENGTH entries, guarded by tx_lock_
+    SemaphoreHandle_t tx_lock_;
+    SemaphoreHandle_t tx_slots_;      // Counts free queue entries; synchronous sends wait on it
+    TaskHandle_t tx_task_;
+    std::atomic<bool> tx_stopping_;   // Set by StopTxTask(): the task stops once the queue is empty
+    SemaphoreHandle_t tx_stopped_;    // Given by the task when it has stopped and holds nothing
+    std::atomic<uint32_t> tx_next_handle_;
+    volatile uint32_t last_tx_airtime_us_;
     
     // Statistics
-    uint32_t send_count_;
+    uint32_t send_count_;             // Transmissions that went out, counted by RunTxJob()
     uint32_t receive_count_;
     
     // Callback
@@ -143,33 +290,130 @@ private:
     
     // Capture mode
     bool capture_mode_;
+    bool raw_capture_;
+    static constexpr size_t kRawPoolSize = 16;
+    mutable RfRawPool<kRawPoolSize> raw_pool_;  // Timings referenced by RFSignal::raw_handle
     RFSignal captured_signal_;
     bool has_captured_signal_;
     
     // Receive control
-    bool receive_enabled_433_;
-    bool receive_enabled_315_;
+    EventGroupHandle_t rx_event_group_;  // Set by the decoder tasks, see WaitForSignal()
+    static constexpr EventBits_t RX_FRAME_BIT = 1 << 0;
+    // Last frame Receive() returned, to merge the copies other channels heard
+    bool merge_valid_;
+    uint8_t merge_channel_;
+    RFFrequency merge_band_;
+    uint16_t merge_bit_length_;
+    uint64_t merge_code_;
+    uint32_t merge_timestamp_;
     
     // Flash storage (NVS available on all ESP32 series chips)
-    static constexpr uint8_t MAX_FLASH_SIGNALS = CONFIG_RF_MODULE_MAX_FLASH_SIGNALS;  // Maximum number of signals to store in flash (configurable via CMake/Kconfig)
+    // Maximum number of signals to store in flash (configurable via CMake/Kconfig). The option is
+    // only defined for the component's own sources: use it in rf_module.cc, not inline in this header.
+    static constexpr uint16_t MAX_FLASH_SIGNALS = CONFIG_RF_MODULE_MAX_FLASH_SIGNALS;
+    static constexpr size_t kMaxNameCandidates = 32;  // FindSignalsByName() ranks at most this many
     bool flash_storage_enabled_;
     nvs_handle_t nvs_handle_;
     std::string flash_namespace_;
-    uint8_t flash_signal_count_;  // Number of signals currently stored in flash
-    uint8_t flash_signal_index_;  // Current write index (circular buffer)
+    RfSlotTable flash_slots_;      // Free slots and save order (internal index -> slot)
+    // Write-through mirror of the flash slots, filled once by LoadFromFlash(); all reads are served from it.
+    // A slot is empty when its entry is Empty() (saved signals never are).
+    RFSignal* flash_mirror_;      // MAX_FLASH_SIGNALS entries, allocated with the NVS handle
+    RfSignalIndex flash_code_index_;  // (band, code, bit length) -> slot, for CheckDuplicateSignal()
+    RfNameIndex flash_name_index_;    // Normalised name -> slot, for FindSignalsByName()
+    uint16_t flash_code_copies_;      // Mirror slots whose key flash_code_index_ holds for another slot
+    // Signal log on the data partition: key 0 marks an initialised log, key slot + 1 holds a signal
+    static constexpr uint16_t kFlashFormatKey = 0;
+    RfLogMedium* log_medium_;
+    RfSignalLog signal_log_;
+    bool flash_log_active_;           // Records and metadata go to signal_log_ instead of NVS
+    SemaphoreHandle_t flash_lock_;    // Serialises signal_log_ with the compaction task
+    TaskHandle_t compaction_task_;
+    std::atomic<bool> compaction_stopping_;  // Set by StopCompactionTask(): the task stops after the sector it is on
+    SemaphoreHandle_t compaction_stopped_;   // Given by the task when it has stopped and holds nothing
+    // Persistence task: one record write, erase or clear per queue entry, applied in order.
+    // kFlashStop is the last entry StopPersistTask() queues: the task stops after applying the rest
+    enum FlashOp : uint8_t { kFlashWrite, kFlashErase, kFlashClear, kFlashBarrier, kFlashStop };
+    struct FlashMutation {
+        FlashOp op;
+        uint16_t slot;
+        uint16_t size;                // Encoded record bytes (kFlashWrite)
+        SemaphoreHandle_t done;       // Given once a kFlashBarrier is reached, or when the task stops
+        bool* result;                 // kFlashBarrier: set to false if a write since the last barrier failed
+        uint8_t record[RfSignalRecord::kMaxSize];
+    };
+    QueueHandle_t persist_queue_;
+    TaskHandle_t persist_task_;
+    FlashMutation* persist_batch_;    // CONFIG_RF_MODULE_PERSIST_QUEUE_LENGTH entries, owned by the task
+    bool persist_failed_;             // Only touched by the persistence task
+    static constexpr size_t kFlashTraceEvents = 32;
+    RfTraceRing<kFlashTraceEvents>* flash_trace_;  // Written where batches are applied; nullptr when compiled out
+    bool flash_loading_;              // LoadFromFlash() runs: format conversions write directly
     
     // Status
     bool enabled_;
     RFSignal last_received_;
     
     // Internal functions
-    uint8_t HexToNum(char c);
-    void SendSignalRCSwitch(const std::string& address, const std::string& key, uint16_t pulse_length, uint8_t protocol);
-    void SendSignalTCSwitch(const std::string& address, const std::string& key, uint16_t pulse_length, uint8_t protocol);
+    static uint8_t HexToNum(char c);
+    static uint64_t HexToUint64(const char* hex, size_t max_digits = 16);
+    static size_t BandIndex(RFFrequency freq) { return freq == RF_315MHZ ? 1 : 0; }
+    static const char* BandName(RFFrequency freq) { return freq == RF_315MHZ ? "315" : "433"; }
+    void SetChannels(const RfChannelConfig* channels, size_t count);
+    static RfRadioChannel* CreateRadio(RFFrequency band);
+    RFSignal ManualSignal(const std::string& address, RFFrequency freq) const;  // Band defaults, see Send(address, ...)
+    int FindTransmitChannel(RFFrequency freq) const;  // First channel of the band with a TX pin, -1 if none
+    bool IsReceivingChannel(const Channel& channel) const;
+    bool SendSignalCode(uint8_t channel, const RFSignal& signal);
+    bool SendRawSignal(uint8_t channel, const RFSignal& signal, const RfRawCode& raw);
+    RfTxHandle SubmitTx(const RFSignal& signal, uint32_t channel_mask, uint8_t priority,
+                        RfTxCallback callback, void* context, RfTxResult* wait_result);
+    RfTxHandle EnqueueTx(TxJob& job, uint8_t priority, RfTxResult* wait_result);
+    RfTxHandle SubmitScene(const RfSceneStep* steps, const RfRawCode* const* raws, size_t count,
+                           uint8_t priority, RfTxCallback callback, void* context);
+    static void FreeScene(SceneSchedule* scene);
+    bool TxQueued() const;  // False before Begin() and on the TX task itself: transmit on the caller's thread
+    bool TransmitOnChannels(const RFSignal& signal, const RfRawCode& raw, uint32_t channel_mask);
+    bool TransmitScene(const SceneSchedule& scene);
+    void RunTxJob(const TxJob& job);
+    void StartTxTask();
+    void StopTxTask();
+    static void TxTask(void* arg);
+    int PopOldestFrame(RfDecodedFrame& frame);  // Channel the frame came from, -1 when all queues are empty
+    bool IsMergedFrame(uint8_t channel, const RfDecodedFrame& frame) const;
+    bool ReceiveRaw(RFSignal& signal);
+    bool ReadFlashSignal(uint16_t index, RFSignal& signal, bool load_raw) const;  // By internal index
+    static void FlashRecordKey(uint16_t slot, char* key, size_t size);
+    bool WriteFlashRecord(uint16_t slot, const RFSignal& signal, uint32_t sequence);
+    bool ReadFlashRecord(uint16_t slot, RFSignal& signal, bool load_raw, uint32_t* sequence = nullptr) const;
+    void EraseFlashRecord(uint16_t slot);
+    bool CommitFlash();  // NVS commit of direct writes; no-op for the log and for queued changes
+    bool PersistQueued() const { return persist_task_ != nullptr && !flash_loading_; }
+    // Anything DisableFlashStorage() has to release, the background tasks included
+    bool FlashStorageActive() const {
+        return flash_storage_enabled_ || persist_task_ != nullptr || compaction_task_ != nullptr;
+    }
+    bool SubmitFlashMutation(const FlashMutation& mutation);  // Queued, or applied at once without the task
+    bool ApplyFlashMutation(const FlashMutation& mutation);
+    void ApplyFlashBatch(FlashMutation* batch, size_t count);
+    bool PersistBarrier() const;
+    void StartPersistTask();
+    void StopPersistTask();
+    static void PersistTask(void* arg);
+    void MigrateLegacyFlash();
+    void MountSignalLog();
+    void ImportNvsSignals();
+    void KickCompaction();  // Wakes the compaction task when the log runs low on free sectors
+    void StopCompactionTask();
+    static void CompactionTask(void* arg);
+    void LoadFlashMirror();
+    void SetFlashMirrorSlot(uint16_t slot, const RFSignal* signal);  // nullptr empties the slot
     void AddToReplayBuffer(const RFSignal& signal);
     void CheckCaptureMode(const RFSignal& signal);
-    std::string Uint32ToHex(uint32_t value, int length);
-    uint32_t HexToUint32(const std::string& hex);
+    static void SceneKey(size_t slot, char* key, size_t size);
+    int FindSceneSlot(const std::string& name, bool free_slot) const;  // -1 if none
+    bool SaveProtocolsToFlash();
+    void LoadProtocolsFromFlash();
 };
 
 #endif // RF_MODULE_H
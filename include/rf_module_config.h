@@ -22,6 +22,39 @@
 #define CONFIG_RF_MODULE_MAX_FLASH_SIGNALS 10
 #endif
 
+// Data partition for the append-only signal log (thousands of signals); without it
+// signals are kept in NVS, which suits a few dozen
+#ifndef CONFIG_RF_MODULE_SIGNAL_PARTITION
+#define CONFIG_RF_MODULE_SIGNAL_PARTITION "rf_signals"
+#endif
+
+// Background task that reclaims log sectors
+#ifndef CONFIG_RF_MODULE_COMPACTION_TASK_PRIORITY
+#define CONFIG_RF_MODULE_COMPACTION_TASK_PRIORITY 1
+#endif
+
+#ifndef CONFIG_RF_MODULE_COMPACTION_TASK_STACK
+#define CONFIG_RF_MODULE_COMPACTION_TASK_STACK 3072
+#endif
+
+// Saves, renames and deletes are written by a background task; changes that arrive
+// within this window share one commit (RFModule::Flush() waits for them)
+#ifndef CONFIG_RF_MODULE_FLASH_COMMIT_WINDOW_MS
+#define CONFIG_RF_MODULE_FLASH_COMMIT_WINDOW_MS 200
+#endif
+
+#ifndef CONFIG_RF_MODULE_PERSIST_QUEUE_LENGTH
+#define CONFIG_RF_MODULE_PERSIST_QUEUE_LENGTH 8
+#endif
+
+#ifndef CONFIG_RF_MODULE_PERSIST_TASK_PRIORITY
+#define CONFIG_RF_MODULE_PERSIST_TASK_PRIORITY 2
+#endif
+
+#ifndef CONFIG_RF_MODULE_PERSIST_TASK_STACK
+#define CONFIG_RF_MODULE_PERSIST_TASK_STACK 3072
+#endif
+
 // Frequency Support Configuration
 #ifndef CONFIG_RF_MODULE_ENABLE_433MHZ
 #define CONFIG_RF_MODULE_ENABLE_433MHZ 1
@@ -36,6 +69,81 @@
 #define CONFIG_RF_MODULE_ENABLE_MCP_TOOLS 1
 #endif
 
+// Transmit Configuration
+// 1 = RMT peripheral clocks out pre-encoded symbols, 0 = busy-wait bit-banging
+#ifndef CONFIG_RF_MODULE_ENABLE_RMT_TX
+#define CONFIG_RF_MODULE_ENABLE_RMT_TX 1
+#endif
+
+// Send() and SendAsync() queue jobs for one TX task, highest priority first
+#ifndef CONFIG_RF_MODULE_TX_QUEUE_LENGTH
+#define CONFIG_RF_MODULE_TX_QUEUE_LENGTH 8
+#endif
+
+#ifndef CONFIG_RF_MODULE_TX_TASK_PRIORITY
+#define CONFIG_RF_MODULE_TX_TASK_PRIORITY 5
+#endif
+
+#ifndef CONFIG_RF_MODULE_TX_TASK_STACK
+#define CONFIG_RF_MODULE_TX_TASK_STACK 4096
+#endif
+
+// Core the TX task is pinned to; -1 lets the scheduler pick
+#ifndef CONFIG_RF_MODULE_TX_TASK_CORE
+#define CONFIG_RF_MODULE_TX_TASK_CORE -1
+#endif
+
+// Receive Configuration
+// The GPIO ISR only timestamps edges; a decoder task per band runs protocol matching
+#ifndef CONFIG_RF_MODULE_DECODER_TASK_PRIORITY
+#define CONFIG_RF_MODULE_DECODER_TASK_PRIORITY 10
+#endif
+
+#ifndef CONFIG_RF_MODULE_DECODER_TASK_STACK
+#define CONFIG_RF_MODULE_DECODER_TASK_STACK 3072
+#endif
+
+// With several receivers per band, a frame that another channel of the same band already
+// delivered within this window is treated as the same transmission and dropped
+#ifndef CONFIG_RF_MODULE_RX_MERGE_WINDOW_MS
+#define CONFIG_RF_MODULE_RX_MERGE_WINDOW_MS 100
+#endif
+
+// 0 = a press is reported on its first frame, 1 = only once the next repeat matches it
+// (one frame later, but noise that happens to decode as a single frame is never reported)
+#ifndef CONFIG_RF_MODULE_RX_CONFIRM_REPEAT
+#define CONFIG_RF_MODULE_RX_CONFIRM_REPEAT 0
+#endif
+
+// Metrics Configuration
+// ISR, decoder and TX counters and histograms (RFModule::GetMetrics()); 0 compiles every update out
+#ifndef CONFIG_RF_MODULE_ENABLE_METRICS
+#define CONFIG_RF_MODULE_ENABLE_METRICS 1
+#endif
+
+// Trace Configuration
+// Rings of recent RX, TX and flash events (RFModule::DumpTrace()); 0 compiles every record out
+#ifndef CONFIG_RF_MODULE_ENABLE_TRACE
+#define CONFIG_RF_MODULE_ENABLE_TRACE 1
+#endif
+
+// Protocol Configuration
+// Protocols tried by the receive decoder at boot (bit n-1 = protocol n, 1-12 built in).
+// Protocols enabled at runtime via RFModule::SetProtocolEnabled() are kept in NVS.
+#ifndef CONFIG_RF_MODULE_DEFAULT_PROTOCOL_MASK
+#define CONFIG_RF_MODULE_DEFAULT_PROTOCOL_MASK 0x1F
+#endif
+
+// Protocols each band's radio can ever decode, fixed at compile time. A protocol
+// outside this set stays off on that band even if enabled at runtime.
+#ifndef CONFIG_RF_MODULE_PROTOCOLS_433
+#define CONFIG_RF_MODULE_PROTOCOLS_433 0xFFFFFFFF
+#endif
+
+#ifndef CONFIG_RF_MODULE_PROTOCOLS_315
+#define CONFIG_RF_MODULE_PROTOCOLS_315 0xFFFFFFFF
+#endif
+
 // Log Level Configuration
 // 0 = None, 1 = Error, 2 = Warning, 3 = Info, 4 = Debug, 5 = Verbose
 #ifndef CONFIG_RF_MODULE_LOG_LEVEL
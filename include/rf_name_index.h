@@ -0,0 +1,264 @@
+#ifndef RF_NAME_INDEX_H
+#define RF_NAME_INDEX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+enum RfNameMatchKind : uint8_t {
+    RF_NAME_EXACT = 0,      // Same name after normalisation
+    RF_NAME_PREFIX = 1,     // Query is the start of the name ("卧室灯" -> "卧室灯开关")
+    RF_NAME_CONTAINED = 2,  // Name is the start of the query ("大门开关" -> "大门")
+    RF_NAME_FUZZY = 3       // Within the edit-distance bound ("客厅等" -> "客厅灯")
+};
+
+struct RfNameMatch {
+    uint16_t index;         // Value given to Insert() (RFModule: 0-based internal signal index)
+    RfNameMatchKind kind;
+    uint8_t distance;       // Edit distance (fuzzy) or number of extra characters (prefix/contained)
+};
+
+/**
+ * Name lookup for stored signals
+ *
+ * Names are normalised before indexing and querying: UTF-8 is decoded to
+ * code points, full-width ASCII is folded to ASCII, ASCII is lowercased,
+ * and whitespace and punctuation (ASCII, CJK and full-width) are dropped.
+ * "卧室 灯！" and "卧室灯" are therefore the same name.
+ *
+ * Entries are kept sorted by normalised name, so exact and prefix
+ * lookups are binary searches. Fuzzy lookups (only when there is no
+ * exact hit) walk all entries with a Levenshtein distance that stops as
+ * soon as the bound is exceeded.
+ *
+ * Pure C++ with no ESP-IDF dependency, like RfRawCode.
+ */
+class RfNameIndex {
+public:
+    static constexpr size_t kMaxChars = 31;   // RFSignal::kMaxNameLength bytes never decode to more
+    static constexpr uint8_t kMaxDistance = 2;
+
+    RfNameIndex() : entries_(nullptr), capacity_(0), size_(0) {}
+    ~RfNameIndex() { delete[] entries_; }
+    RfNameIndex(const RfNameIndex&) = delete;
+    RfNameIndex& operator=(const RfNameIndex&) = delete;
+
+    void Reset(size_t capacity) {
+        delete[] entries_;
+        entries_ = new Entry[capacity];
+        capacity_ = capacity;
+        size_ = 0;
+    }
+
+    void Clear() { size_ = 0; }
+    size_t Size() const { return size_; }
+
+    // Empty names (also after normalisation) are not indexed
+    bool Insert(const char* name, uint16_t index) {
+        Entry entry;
+        entry.index = index;
+        entry.length = Normalise(name, entry.chars);
+        if (entry.length == 0 || size_ >= capacity_) {
+            return false;
+        }
+        size_t pos = LowerBound(entry.chars, entry.length);
+        memmove(&entries_[pos + 1], &entries_[pos], (size_ - pos) * sizeof(Entry));
+        entries_[pos] = entry;
+        size_++;
+        return true;
+    }
+
+    bool Remove(uint16_t index) {
+        for (size_t i = 0; i < size_; i++) {
+            if (entries_[i].index == index) {
+                memmove(&entries_[i], &entries_[i + 1], (size_ - i - 1) * sizeof(Entry));
+                size_--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Fills up to max_matches candidates, best first: exact, then prefix and
+    // contained (fewest extra characters first), then fuzzy (smallest distance).
+    // Returns the number of candidates written.
+    size_t Lookup(const char* query, RfNameMatch* matches, size_t max_matches) const {
+        uint16_t chars[kMaxChars];
+        const uint8_t length = Normalise(query, chars);
+        size_t count = 0;
+        if (length == 0) {
+            return 0;
+        }
+
+        // Exact and prefix: one contiguous run in sorted order
+        for (size_t i = LowerBound(chars, length); i < size_ && StartsWith(entries_[i], chars, length); i++) {
+            const uint8_t extra = entries_[i].length - length;
+            Add(matches, max_matches, count, entries_[i].index, extra ? RF_NAME_PREFIX : RF_NAME_EXACT, extra);
+        }
+        // Contained: every shorter prefix of the query that is itself a stored name
+        for (uint8_t prefix = length - 1; prefix > 0; prefix--) {
+            for (size_t i = LowerBound(chars, prefix); i < size_ && entries_[i].length == prefix &&
+                 StartsWith(entries_[i], chars, prefix); i++) {
+                Add(matches, max_matches, count, entries_[i].index, RF_NAME_CONTAINED, length - prefix);
+            }
+        }
+        // Fuzzy, only when nothing matched exactly: the bound scales with the
+        // query so names of one or two characters need an exact hit
+        const bool exact = count > 0 && matches[0].kind == RF_NAME_EXACT;
+        const uint8_t bound = (exact || length < 3) ? 0 : (length < 6 ? 1 : kMaxDistance);
+        for (size_t i = 0; bound > 0 && i < size_; i++) {
+            const Entry& entry = entries_[i];
+            if (StartsWith(entry, chars, length) || (entry.length < length && StartsWith(chars, length, entry))) {
+                continue;  // Already reported above
+            }
+            const uint8_t distance = Distance(entry.chars, entry.length, chars, length, bound);
+            if (distance <= bound) {
+                Add(matches, max_matches, count, entry.index, RF_NAME_FUZZY, distance);
+            }
+        }
+        return count;
+    }
+
+    // Decodes, folds and filters `name` into at most kMaxChars BMP code points
+    static uint8_t Normalise(const char* name, uint16_t* out) {
+        uint8_t length = 0;
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(name);
+        while (*p != 0 && length < kMaxChars) {
+            uint32_t cp = *p++;
+            int follow = 0;
+            if (cp >= 0xF0) {
+                cp &= 0x07;
+                follow = 3;
+            } else if (cp >= 0xE0) {
+                cp &= 0x0F;
+                follow = 2;
+            } else if (cp >= 0xC0) {
+                cp &= 0x1F;
+                follow = 1;
+            } else if (cp >= 0x80) {
+                continue;  // Stray continuation byte
+            }
+            for (; follow > 0 && (*p & 0xC0) == 0x80; follow--) {
+                cp = (cp << 6) | (*p++ & 0x3F);
+            }
+            if (follow > 0) {
+                continue;  // Truncated sequence
+            }
+            if (cp >= 0xFF01 && cp <= 0xFF5E) {
+                cp -= 0xFEE0;  // Full-width ASCII
+            }
+            if (cp >= 'A' && cp <= 'Z') {
+                cp += 'a' - 'A';
+            }
+            const bool ascii_separator = cp <= 0x7F && !((cp >= '0' && cp <= '9') || (cp >= 'a' && cp <= 'z'));
+            const bool cjk_separator = (cp >= 0x3000 && cp <= 0x303F) || (cp >= 0x2000 && cp <= 0x206F) ||
+                                       cp == 0xFF5F || cp == 0xFF60 || (cp >= 0xFF61 && cp <= 0xFF65);
+            if (ascii_separator || cjk_separator) {
+                continue;
+            }
+            out[length++] = cp > 0xFFFF ? 0xFFFD : static_cast<uint16_t>(cp);
+        }
+        return length;
+    }
+
+private:
+    struct Entry {
+        uint16_t index;
+        uint8_t length;
+        uint16_t chars[kMaxChars];
+    };
+
+    static int Compare(const uint16_t* a, uint8_t a_length, const uint16_t* b, uint8_t b_length) {
+        const uint8_t n = a_length < b_length ? a_length : b_length;
+        for (uint8_t i = 0; i < n; i++) {
+            if (a[i] != b[i]) {
+                return a[i] < b[i] ? -1 : 1;
+            }
+        }
+        return (a_length > b_length) - (a_length < b_length);
+    }
+
+    size_t LowerBound(const uint16_t* chars, uint8_t length) const {
+        size_t low = 0;
+        size_t high = size_;
+        while (low < high) {
+            const size_t mid = (low + high) / 2;
+            if (Compare(entries_[mid].chars, entries_[mid].length, chars, length) < 0) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    static bool StartsWith(const Entry& entry, const uint16_t* chars, uint8_t length) {
+        return entry.length >= length && memcmp(entry.chars, chars, length * sizeof(uint16_t)) == 0;
+    }
+
+    static bool StartsWith(const uint16_t* chars, uint8_t length, const Entry& entry) {
+        return length >= entry.length && memcmp(chars, entry.chars, entry.length * sizeof(uint16_t)) == 0;
+    }
+
+    // Levenshtein distance, or bound + 1 once it is certain to exceed bound
+    static uint8_t Distance(const uint16_t* a, uint8_t a_length, const uint16_t* b, uint8_t b_length, uint8_t bound) {
+        const int length_gap = a_length > b_length ? a_length - b_length : b_length - a_length;
+        if (length_gap > bound) {
+            return bound + 1;
+        }
+        uint8_t previous[kMaxChars + 1];
+        uint8_t current[kMaxChars + 1];
+        for (uint8_t j = 0; j <= b_length; j++) {
+            previous[j] = j;
+        }
+        for (uint8_t i = 1; i <= a_length; i++) {
+            current[0] = i;
+            uint8_t row_min = current[0];
+            for (uint8_t j = 1; j <= b_length; j++) {
+                uint8_t best = previous[j - 1] + (a[i - 1] != b[j - 1]);
+                if (previous[j] + 1 < best) {
+                    best = previous[j] + 1;
+                }
+                if (current[j - 1] + 1 < best) {
+                    best = current[j - 1] + 1;
+                }
+                current[j] = best;
+                if (best < row_min) {
+                    row_min = best;
+                }
+            }
+            if (row_min > bound) {
+                return bound + 1;
+            }
+            memcpy(previous, current, b_length + 1);
+        }
+        return previous[b_length];
+    }
+
+    // Insertion into the ranked output; ties keep the order they were found in
+    static void Add(RfNameMatch* matches, size_t max_matches, size_t& count,
+                    uint16_t index, RfNameMatchKind kind, uint8_t distance) {
+        size_t pos = count;
+        while (pos > 0 && (matches[pos - 1].kind > kind ||
+                           (matches[pos - 1].kind == kind && matches[pos - 1].distance > distance))) {
+            pos--;
+        }
+        if (pos >= max_matches) {
+            return;
+        }
+        const size_t last = count < max_matches ? count : max_matches - 1;
+        memmove(&matches[pos + 1], &matches[pos], (last - pos) * sizeof(RfNameMatch));
+        matches[pos].index = index;
+        matches[pos].kind = kind;
+        matches[pos].distance = distance;
+        if (count < max_matches) {
+            count++;
+        }
+    }
+
+    Entry* entries_;
+    size_t capacity_;
+    size_t size_;
+};
+
+#endif // RF_NAME_INDEX_H
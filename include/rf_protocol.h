@@ -0,0 +1,83 @@
+#ifndef RF_PROTOCOL_H
+#define RF_PROTOCOL_H
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+
+// Pulse timing shared by every RfRadioChannel, whatever its band
+struct RfHighLow {
+    uint8_t high;
+    uint8_t low;
+};
+
+struct RfProtocol {
+    uint16_t pulseLength;
+    RfHighLow syncFactor;
+    RfHighLow zero;
+    RfHighLow one;
+    bool invertedSignal;
+};
+
+/**
+ * Protocol registry shared by both bands.
+ *
+ * Protocols are numbered from 1. Numbers 1..kBuiltinCount are the upstream
+ * rc-switch set and cannot be changed; the remaining slots take custom
+ * timings registered at runtime. Only enabled protocols are tried by the
+ * decoder, every defined protocol can be used for transmit.
+ *
+ * Writers (application tasks) are serialised by a mutex. The decoder task
+ * does not take it: it copies the table with TrySnapshot() when
+ * Generation() has moved and keeps its previous copy if a write was in
+ * progress.
+ */
+class RfProtocolRegistry {
+public:
+    static constexpr unsigned int kMaxProtocols = 32;
+    static constexpr unsigned int kBuiltinCount = 12;
+
+    static RfProtocolRegistry& GetInstance();
+
+    // Copy of protocol `number`; false if the slot is empty
+    bool Get(unsigned int number, RfProtocol& protocol);
+
+    // Store a custom protocol in the first free slot, returns its number or 0 when full
+    unsigned int Register(const RfProtocol& protocol, bool enabled = true);
+    // Store a custom protocol in a given slot (used when restoring from flash)
+    bool Register(unsigned int number, const RfProtocol& protocol, bool enabled);
+    bool Remove(unsigned int number);  // Custom protocols only
+
+    bool SetEnabled(unsigned int number, bool enabled);
+    void SetEnabledMask(uint32_t mask);  // Bit n-1 = protocol n, undefined slots are ignored
+
+    bool IsDefined(unsigned int number) const;
+    bool IsEnabled(unsigned int number) const;
+    static bool IsCustom(unsigned int number) { return number > kBuiltinCount && number <= kMaxProtocols; }
+
+    uint32_t DefinedMask() const { return defined_mask_.load(std::memory_order_acquire); }
+    uint32_t EnabledMask() const { return enabled_mask_.load(std::memory_order_acquire); }
+    uint32_t CustomMask() const { return DefinedMask() & ~((1UL << kBuiltinCount) - 1); }
+
+    // Bumped by every change; odd while a writer is in the middle of one
+    uint32_t Generation() const { return generation_.load(std::memory_order_acquire); }
+
+    // Copy of all slots (indexed by number - 1); false if it raced with a writer
+    bool TrySnapshot(RfProtocol* table, uint32_t& enabled_mask, uint32_t& generation) const;
+
+private:
+    RfProtocolRegistry();
+    RfProtocolRegistry(const RfProtocolRegistry&) = delete;
+    RfProtocolRegistry& operator=(const RfProtocolRegistry&) = delete;
+
+    void BeginWrite();
+    void EndWrite();
+
+    RfProtocol protocols_[kMaxProtocols];
+    std::atomic<uint32_t> defined_mask_;
+    std::atomic<uint32_t> enabled_mask_;
+    std::atomic<uint32_t> generation_;
+    std::mutex write_mutex_;
+};
+
+#endif // RF_PROTOCOL_H
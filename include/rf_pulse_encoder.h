@@ -0,0 +1,166 @@
+#ifndef RF_PULSE_ENCODER_H
+#define RF_PULSE_ENCODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * RF pulse encoder
+ *
+ * Compiles a protocol's sync/zero/one HighLow pulses into RMT symbol words
+ * so the RMT peripheral can clock the frame out on its own.
+ * Pure C++ with no ESP-IDF dependency, so the generated symbols can be
+ * checked against the protocol table on the host.
+ */
+
+// Same bit layout as rmt_symbol_word_t (1 tick = 1us at RF_PULSE_RESOLUTION_HZ)
+typedef union {
+    struct {
+        uint16_t duration0 : 15;
+        uint16_t level0 : 1;
+        uint16_t duration1 : 15;
+        uint16_t level1 : 1;
+    };
+    uint32_t val;
+} RfSymbol;
+
+static_assert(sizeof(RfSymbol) == 4, "RfSymbol must match rmt_symbol_word_t");
+
+#define RF_PULSE_RESOLUTION_HZ 1000000
+
+class RfPulseEncoder {
+public:
+    static constexpr uint32_t kMaxDuration = 0x7FFF;  // 15-bit duration field
+
+    RfPulseEncoder(RfSymbol* buffer, size_t capacity)
+        : symbols_(buffer), capacity_(capacity) {
+        Reset();
+    }
+
+    void Reset() {
+        count_ = 0;
+        half_open_ = false;
+        has_pending_ = false;
+        pending_level_ = false;
+        pending_us_ = 0;
+        overflow_ = false;
+    }
+
+    // Append one level for duration_us. Adjacent pulses of the same level are
+    // merged and durations longer than kMaxDuration are split across symbols.
+    bool AddPulse(bool level, uint32_t duration_us) {
+        if (duration_us == 0) {
+            return !overflow_;
+        }
+        if (has_pending_ && pending_level_ == level) {
+            pending_us_ += duration_us;
+            return !overflow_;
+        }
+        FlushPending();
+        pending_level_ = level;
+        pending_us_ = duration_us;
+        has_pending_ = true;
+        return !overflow_;
+    }
+
+    // Same as RfRadioChannel::transmit(): high then low, swapped for inverted protocols
+    template <typename HighLowT>
+    bool AddHighLow(const HighLowT& pulses, uint32_t pulse_length, bool inverted) {
+        AddPulse(!inverted, pulse_length * pulses.high);
+        return AddPulse(inverted, pulse_length * pulses.low);
+    }
+
+    // One frame exactly as RfRadioChannel::send() emits it: sync, MSB-first bits, sync
+    template <typename ProtocolT>
+    bool AddFrame(const ProtocolT& protocol, uint64_t code, unsigned int length) {
+        if (length > 64) {
+            length = 64;  // Codes are at most 64 bits
+        }
+        const bool inverted = protocol.invertedSignal;
+        AddHighLow(protocol.syncFactor, protocol.pulseLength, inverted);
+        for (int i = static_cast<int>(length) - 1; i >= 0; i--) {
+            if (code & (1ULL << i)) {
+                AddHighLow(protocol.one, protocol.pulseLength, inverted);
+            } else {
+                AddHighLow(protocol.zero, protocol.pulseLength, inverted);
+            }
+        }
+        return AddHighLow(protocol.syncFactor, protocol.pulseLength, inverted);
+    }
+
+    // One raw frame (see RfRawCode): alternating levels, trailing gap included
+    template <typename RawT>
+    bool AddRaw(const RawT& raw) {
+        for (size_t i = 0; i < raw.TimingCount(); i++) {
+            AddPulse(raw.Level(i), raw.Duration(i));
+        }
+        return !overflow_;
+    }
+
+    // Flush the trailing pulse. An unpaired last half gets a zero-length
+    // partner, which the RMT peripheral treats as end of transmission.
+    bool Finish() {
+        FlushPending();
+        if (half_open_) {
+            symbols_[count_ - 1].duration1 = 0;
+            symbols_[count_ - 1].level1 = symbols_[count_ - 1].level0;
+            half_open_ = false;
+        }
+        return !overflow_;
+    }
+
+    const RfSymbol* Data() const { return symbols_; }
+    size_t Size() const { return count_; }
+    bool Overflowed() const { return overflow_; }
+
+    // Upper bound of symbols for a frame whose pulses all fit in kMaxDuration
+    static size_t SymbolsPerFrame(unsigned int length) {
+        return length + 2;
+    }
+
+    static size_t SymbolsPerRawFrame(size_t timing_count) {
+        return (timing_count + 1) / 2 + 1;
+    }
+
+private:
+    void FlushPending() {
+        if (!has_pending_) {
+            return;
+        }
+        while (pending_us_ > 0) {
+            uint32_t chunk = pending_us_ > kMaxDuration ? kMaxDuration : pending_us_;
+            EmitHalf(pending_level_, chunk);
+            pending_us_ -= chunk;
+        }
+        has_pending_ = false;
+    }
+
+    void EmitHalf(bool level, uint32_t duration) {
+        if (half_open_) {
+            symbols_[count_ - 1].duration1 = duration;
+            symbols_[count_ - 1].level1 = level;
+            half_open_ = false;
+            return;
+        }
+        if (count_ >= capacity_) {
+            overflow_ = true;
+            return;
+        }
+        symbols_[count_].val = 0;
+        symbols_[count_].duration0 = duration;
+        symbols_[count_].level0 = level;
+        count_++;
+        half_open_ = true;
+    }
+
+    RfSymbol* symbols_;
+    size_t capacity_;
+    size_t count_;
+    bool half_open_;
+    bool has_pending_;
+    bool pending_level_;
+    uint32_t pending_us_;
+    bool overflow_;
+};
+
+#endif // RF_PULSE_ENCODER_H
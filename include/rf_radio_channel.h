@@ -0,0 +1,151 @@
+#ifndef RF_RADIO_CHANNEL_H
+#define RF_RADIO_CHANNEL_H
+
+#include <driver/gpio.h>
+#include <driver/rmt_tx.h>
+#include <esp_attr.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <freertos/event_groups.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <atomic>
+#include "rf_protocol.h"
+#include "rf_decoder.h"
+#include "rf_edge_capture.h"
+#include "rf_metrics.h"
+#include "rf_pulse_encoder.h"
+#include "rf_raw_code.h"
+#include "rf_signal.h"
+#include "rf_spsc_ring.h"
+#include "rf_trace.h"
+
+/**
+ * One radio: a transmitter pin and/or a receiver pin on one band
+ *
+ * Every piece of state (edge capture, decoder task, frame queues, TX
+ * buffers) lives in the instance, so any number of channels can run side
+ * by side, e.g. two 433MHz receivers on different antennas. The receive
+ * decoder only tries the protocols in protocolMask; use RadioChannel<> to
+ * fix band and protocol set at compile time.
+ */
+class RfRadioChannel {
+public:
+    RfRadioChannel(RFFrequency band, uint32_t protocolMask);
+    virtual ~RfRadioChannel();
+    RfRadioChannel(const RfRadioChannel&) = delete;
+    RfRadioChannel& operator=(const RfRadioChannel&) = delete;
+    
+    RFFrequency band() const { return channelBand; }
+    uint32_t protocolMask() const { return decoderMask; }
+    
+    void enableTransmit(int nTransmitterPin);
+    void disableTransmit();
+    void setPulseLength(int nPulseLength);
+    void setRepeatTransmit(int nRepeatTransmit);
+    void setProtocol(int nProtocol);
+    void send(uint64_t code, unsigned int length);  // MSB first, up to 64 bits; returns once queued when RMT TX is active
+    void sendRaw(const RfRawCode& raw);  // Replays captured pulse timings nRepeatTransmit times
+    // Clocks out pre-encoded symbols once (e.g. a compiled scene); the buffer must stay
+    // valid and in internal RAM until waitTransmitDone() returns
+    bool sendSymbols(const RfSymbol* symbols, size_t count, uint8_t idleLevel);
+    void waitTransmitDone();
+    
+    void enableReceive(int interrupt);
+    void disableReceive();
+    bool available();
+    void resetAvailable();  // Drops the oldest decoded frame
+    
+    // Oldest decoded frame still queued
+    uint64_t getReceivedValue();
+    unsigned int getReceivedBitlength();
+    unsigned int getReceivedDelay();
+    unsigned int getReceivedProtocol();
+    bool popReceived(RfDecodedFrame& frame);
+    const RfDecodedFrame* peekReceived() const { return frameQueue.Peek(); }
+    void setFrameNotify(EventGroupHandle_t group, EventBits_t bits);  // Set bits each time a frame is queued
+    
+    // Raw capture: frames no enabled protocol decodes are queued as pulse timings
+    void setRawCapture(bool enabled) { rawCaptureEnabled.store(enabled, std::memory_order_relaxed); }
+    bool rawAvailable() { return !rawQueue.Empty(); }
+    bool popRawReceived(RfRawCode& raw) { return rawQueue.Pop(raw); }
+
+    typedef RfHighLow HighLow;
+    typedef RfProtocol Protocol;
+    
+    // Edges buffered between the ISR and the decoder task
+    static constexpr size_t kEdgeRingSize = RfEdgeCapture::kRingSize;
+    uint32_t getDroppedEdges() const { return edgeCapture != nullptr ? edgeCapture->ring.Dropped() : 0; }
+    uint32_t getCacheOffEdges() const { return edgeCapture != nullptr ? edgeCapture->cacheOffEdges : 0; }  // Captured during flash writes
+    
+    // Decoded frames waiting for the application, oldest first
+    static constexpr size_t kFrameQueueSize = 16;
+    uint32_t getDroppedFrames() const { return frameQueue.Dropped(); }
+    static constexpr size_t kRawQueueSize = 2;
+    
+    // ISR, decoder and TX metrics; false when compiled out (CONFIG_RF_MODULE_ENABLE_METRICS)
+    bool getMetrics(RfMetrics& metrics) const;
+    // Trace rings (see RfChannelTrace); events carry the channel number set here
+    void setTraceChannel(uint8_t channel);
+    size_t snapshotTrace(RfTraceEvent* events) const;  // Room for RfChannelTrace::kEvents; 0 when compiled out
+    
+private:
+    void transmit(HighLow pulses);
+    bool enableRmtTransmit();
+    void disableRmtTransmit();
+    bool sendRmt(uint64_t code, unsigned int length);
+    bool sendRawRmt(const RfRawCode& raw);
+    bool reserveTxSymbols(size_t needed);
+    void startTxTiming(uint32_t plannedUs);
+    void finishTxTiming();
+    static uint32_t symbolsDuration(const RfSymbol* symbols, size_t count);
+    static void delayMicroseconds(uint32_t us);
+    static void IRAM_ATTR handleInterrupt(void* arg);
+    static void decoderTask(void* arg);
+    
+    const RFFrequency channelBand;
+    const uint32_t decoderMask;
+    gpio_num_t nTransmitterPin;
+    int nRepeatTransmit;
+    Protocol protocol;
+    
+    // RMT transmit backend (nullptr when falling back to busy-wait transmit)
+    rmt_channel_handle_t txChannel;
+    rmt_encoder_handle_t txEncoder;
+    RfSymbol* txSymbols;
+    size_t txSymbolCapacity;
+    int64_t txStartedAt;                          // TX jitter metric and trace, 0 = no transmission being timed
+    uint32_t txPlannedUs;
+    
+    int nReceiverInterrupt;
+    RfEdgeCapture* edgeCapture;                   // ISR state, internal RAM
+    RfDecoder decoder;                            // Decoder task only
+    TaskHandle_t decoderTaskHandle;
+    std::atomic<bool> decoderStopping;            // Set by disableReceive(): the task stops once the ring is drained
+    SemaphoreHandle_t decoderStopped;             // Given by the task when it has stopped
+    RfSpscRing<RfDecodedFrame, kFrameQueueSize> frameQueue;  // Decoder task -> application
+    RfSpscRing<RfRawCode, kRawQueueSize> rawQueue;           // Decoder task -> application
+    std::atomic<bool> rawCaptureEnabled;
+    EventGroupHandle_t frameEventGroup;
+    EventBits_t frameEventBits;
+};
+
+/**
+ * Radio channel with band and protocol set fixed at compile time
+ *
+ * Protocols outside Protocols (bit n-1 = protocol n) are never tried by
+ * this channel's decoder, whatever is enabled in the registry.
+ */
+template <RFFrequency Band, uint32_t Protocols = 0xFFFFFFFF>
+class RadioChannel : public RfRadioChannel {
+public:
+    static constexpr RFFrequency kBand = Band;
+    static constexpr uint32_t kProtocols = Protocols;
+    static_assert(Protocols != 0, "RadioChannel needs at least one protocol");
+    
+    RadioChannel() : RfRadioChannel(Band, Protocols) {}
+};
+
+#endif // RF_RADIO_CHANNEL_H
+
@@ -0,0 +1,287 @@
+#ifndef RF_RAW_CODE_H
+#define RF_RAW_CODE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * Raw pulse-timing frame
+ *
+ * Used for remotes none of the registered protocols can decode. The edge
+ * durations of one frame are clustered into at most kMaxBins timing bins;
+ * each duration is then stored as a 4-bit bin index. Levels alternate, so
+ * only the level of the first pulse is kept. The trailing gap is the last
+ * entry and doubles as the spacing between repeats on replay.
+ *
+ * Pure C++ with no ESP-IDF dependency, like RfPulseEncoder.
+ */
+class RfRawCode {
+public:
+    static constexpr size_t kMaxBins = 16;          // 4-bit symbols
+    static constexpr size_t kMaxTimings = 192;      // Pulses + trailing gap
+    static constexpr size_t kMinTimings = 17;       // Shorter bursts are treated as noise
+    static constexpr unsigned int kMinTolerance = 60;  // us, added to the 25% relative tolerance
+    static constexpr size_t kHeaderSize = 4;
+
+    RfRawCode() { Clear(); }
+
+    void Clear() {
+        timing_count_ = 0;
+        first_level_ = 1;
+        bin_count_ = 0;
+    }
+
+    // Cluster pulses[0..count) plus the trailing gap into bins; false if the
+    // frame is too short, too long or has more than kMaxBins distinct widths
+    bool Quantise(const unsigned int* pulses, size_t count, unsigned int gap, uint8_t first_level) {
+        Clear();
+        if (count + 1 < kMinTimings || count + 1 > kMaxTimings) {
+            return false;
+        }
+        uint32_t sums[kMaxBins];
+        uint16_t counts[kMaxBins];
+        for (size_t i = 0; i <= count; i++) {
+            unsigned int d = (i < count) ? pulses[i] : gap;
+            if (d > 0xFFFF) {
+                d = 0xFFFF;
+            }
+            int bin = -1;
+            unsigned int best = 0;
+            for (size_t b = 0; b < bin_count_; b++) {
+                const unsigned int mean = sums[b] / counts[b];
+                const unsigned int delta = (d > mean) ? (d - mean) : (mean - d);
+                if (delta <= Tolerance(mean) && (bin < 0 || delta < best)) {
+                    bin = static_cast<int>(b);
+                    best = delta;
+                }
+            }
+            if (bin < 0) {
+                if (bin_count_ >= kMaxBins) {
+                    Clear();
+                    return false;
+                }
+                bin = bin_count_++;
+                sums[bin] = 0;
+                counts[bin] = 0;
+            }
+            sums[bin] += d;
+            counts[bin]++;
+            SetSymbol(i, static_cast<uint8_t>(bin));
+        }
+        for (size_t b = 0; b < bin_count_; b++) {
+            bins_[b] = static_cast<uint16_t>((sums[b] + counts[b] / 2) / counts[b]);
+        }
+        timing_count_ = static_cast<uint16_t>(count + 1);
+        first_level_ = first_level ? 1 : 0;
+        return true;
+    }
+
+    bool Empty() const { return timing_count_ == 0; }
+    size_t TimingCount() const { return timing_count_; }
+    size_t BinCount() const { return bin_count_; }
+    uint8_t FirstLevel() const { return first_level_; }
+
+    unsigned int Duration(size_t i) const { return bins_[Symbol(i)]; }
+    uint8_t Level(size_t i) const { return (i & 1) ? !first_level_ : first_level_; }
+    uint8_t IdleLevel() const { return timing_count_ ? Level(timing_count_ - 1) : 0; }
+
+    // Shortest bin, reported as the pulse length of a raw signal
+    unsigned int ShortestPulse() const {
+        unsigned int shortest = 0;
+        for (size_t b = 0; b < bin_count_; b++) {
+            if (shortest == 0 || bins_[b] < shortest) {
+                shortest = bins_[b];
+            }
+        }
+        return shortest;
+    }
+
+    // Total airtime of one frame including the trailing gap
+    uint32_t DurationUs() const {
+        uint32_t total = 0;
+        for (size_t i = 0; i < timing_count_; i++) {
+            total += Duration(i);
+        }
+        return total;
+    }
+
+    // Same shape within tolerance, e.g. two repeats of one key press
+    bool Matches(const RfRawCode& other) const {
+        if (timing_count_ != other.timing_count_ || first_level_ != other.first_level_) {
+            return false;
+        }
+        for (size_t i = 0; i < timing_count_; i++) {
+            const unsigned int a = Duration(i);
+            const unsigned int b = other.Duration(i);
+            const unsigned int delta = (a > b) ? (a - b) : (b - a);
+            if (delta > Tolerance(a > b ? a : b)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 24-bit FNV-1a of the symbol sequence, stable across small timing drift
+    uint32_t Fingerprint() const {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i + 1 < timing_count_; i++) {
+            // Rank of the bin by width, so bin numbering order does not matter
+            uint8_t rank = 0;
+            const uint16_t width = bins_[Symbol(i)];
+            for (size_t b = 0; b < bin_count_; b++) {
+                if (bins_[b] < width) {
+                    rank++;
+                }
+            }
+            hash = (hash ^ rank) * 16777619u;
+        }
+        return (hash ^ (hash >> 24)) & 0xFFFFFF;
+    }
+
+    // Storage form: count (2 bytes LE), first level, bin count, bins (2 bytes LE each), packed symbols
+    size_t SerializedSize() const {
+        return kHeaderSize + bin_count_ * 2 + (timing_count_ + 1) / 2;
+    }
+
+    size_t Serialize(uint8_t* out, size_t capacity) const {
+        const size_t size = SerializedSize();
+        if (capacity < size) {
+            return 0;
+        }
+        out[0] = timing_count_ & 0xFF;
+        out[1] = timing_count_ >> 8;
+        out[2] = first_level_;
+        out[3] = bin_count_;
+        uint8_t* p = out + kHeaderSize;
+        for (size_t b = 0; b < bin_count_; b++) {
+            *p++ = bins_[b] & 0xFF;
+            *p++ = bins_[b] >> 8;
+        }
+        memcpy(p, symbols_, (timing_count_ + 1) / 2);
+        return size;
+    }
+
+    bool Deserialize(const uint8_t* in, size_t size) {
+        Clear();
+        if (size < kHeaderSize) {
+            return false;
+        }
+        const uint16_t count = in[0] | (in[1] << 8);
+        const uint8_t bin_count = in[3];
+        if (count > kMaxTimings || bin_count > kMaxBins ||
+            size < kHeaderSize + bin_count * 2 + (count + 1) / 2) {
+            return false;
+        }
+        const uint8_t* p = in + kHeaderSize;
+        for (size_t b = 0; b < bin_count; b++) {
+            bins_[b] = p[0] | (p[1] << 8);
+            p += 2;
+        }
+        memcpy(symbols_, p, (count + 1) / 2);
+        for (size_t i = 0; i < count; i++) {
+            if (((symbols_[i >> 1] >> ((i & 1) * 4)) & 0x0F) >= bin_count) {
+                return false;
+            }
+        }
+        timing_count_ = count;
+        first_level_ = in[2] ? 1 : 0;
+        bin_count_ = bin_count;
+        return true;
+    }
+
+private:
+    static unsigned int Tolerance(unsigned int width) {
+        return width / 4 + kMinTolerance;
+    }
+
+    uint8_t Symbol(size_t i) const {
+        return (symbols_[i >> 1] >> ((i & 1) * 4)) & 0x0F;
+    }
+
+    void SetSymbol(size_t i, uint8_t bin) {
+        uint8_t& byte = symbols_[i >> 1];
+        if (i & 1) {
+            byte = (byte & 0x0F) | (bin << 4);
+        } else {
+            byte = (byte & 0xF0) | bin;
+        }
+    }
+
+    uint16_t timing_count_;
+    uint8_t first_level_;
+    uint8_t bin_count_;
+    uint16_t bins_[kMaxBins];              // Mean width of each bin in us
+    uint8_t symbols_[kMaxTimings / 2];     // Two 4-bit bin indices per byte, low nibble first
+};
+
+/**
+ * Fixed pool of raw frames referenced by 16-bit handles
+ *
+ * Keeps RFSignal a plain fixed-size record: a raw signal stores a handle
+ * instead of owning its timings. Identical frames share a slot. When the
+ * pool is full the least recently used slot is reused; its generation
+ * changes so stale handles resolve to nullptr instead of other timings.
+ */
+template <size_t N>
+class RfRawPool {
+public:
+    static_assert(N > 0 && N < 256, "slot index must fit in the low byte of a handle");
+
+    RfRawPool() : clock_(0) {
+        for (size_t i = 0; i < N; i++) {
+            generation_[i] = 1;
+            last_used_[i] = 0;
+            used_[i] = false;
+        }
+    }
+
+    // Handle of a slot holding `raw`, 0 if raw is empty
+    uint16_t Intern(const RfRawCode& raw) {
+        if (raw.Empty()) {
+            return 0;
+        }
+        size_t victim = 0;
+        for (size_t i = 0; i < N; i++) {
+            if (used_[i] && codes_[i].Matches(raw)) {
+                last_used_[i] = ++clock_;
+                return Handle(i);
+            }
+            if (!used_[i]) {
+                if (used_[victim]) {
+                    victim = i;
+                }
+            } else if (used_[victim] && last_used_[i] < last_used_[victim]) {
+                victim = i;
+            }
+        }
+        if (used_[victim]) {
+            generation_[victim] = generation_[victim] == 0xFF ? 1 : generation_[victim] + 1;
+        }
+        codes_[victim] = raw;
+        used_[victim] = true;
+        last_used_[victim] = ++clock_;
+        return Handle(victim);
+    }
+
+    const RfRawCode* Get(uint16_t handle) const {
+        const size_t slot = (handle & 0xFF);
+        if (slot == 0 || slot > N || !used_[slot - 1] || generation_[slot - 1] != (handle >> 8)) {
+            return nullptr;
+        }
+        return &codes_[slot - 1];
+    }
+
+private:
+    uint16_t Handle(size_t slot) const {
+        return static_cast<uint16_t>((generation_[slot] << 8) | (slot + 1));
+    }
+
+    RfRawCode codes_[N];
+    uint32_t last_used_[N];
+    uint32_t clock_;
+    uint8_t generation_[N];
+    bool used_[N];
+};
+
+#endif // RF_RAW_CODE_H
@@ -0,0 +1,272 @@
+#ifndef RF_SCENE_H
+#define RF_SCENE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "rf_protocol.h"
+#include "rf_pulse_encoder.h"
+#include "rf_raw_code.h"
+#include "rf_signal.h"
+
+// One entry of a scene: a signal, how often its frame is repeated and the pause before the next entry
+struct RfSceneStep {
+    RFSignal signal;
+    uint8_t repeat;      // Frame repetitions, 0 = the band's repeat count
+    uint32_t gap_us;     // Silence after this step (ignored for the last one)
+};
+
+// Consecutive steps on one transmitter, clocked out as a single RMT transfer
+struct RfSceneSegment {
+    uint8_t channel;
+    uint8_t steps;           // Scene steps in this segment
+    uint8_t idle_level;      // Line level between frames and after the last one
+    size_t offset;           // First symbol in the schedule buffer
+    size_t count;
+    uint32_t gap_after_us;   // Pause before the next segment (timed by the CPU, not the RMT)
+};
+
+/**
+ * Compiles a scene into one transmit schedule
+ *
+ * Every step is encoded up front into RMT symbols, gaps included, so the
+ * steps on one transmitter go out back to back as a single transfer with
+ * microsecond-exact spacing and no per-step reconfiguration. A change of
+ * transmitter starts a new segment; only those boundaries are timed by
+ * the CPU. The caller owns the symbol buffer (it must be DMA/ISR-safe).
+ *
+ * Pure C++ with no ESP-IDF dependency, like RfRawCode.
+ */
+class RfSceneBuilder {
+public:
+    static constexpr size_t kMaxSteps = 16;
+
+    RfSceneBuilder(RfSymbol* buffer, size_t capacity)
+        : buffer_(buffer), capacity_(capacity), encoder_(buffer, capacity),
+          used_(0), segment_count_(0), open_(false), overflow_(false) {}
+
+    // Upper bound of symbols for one step; Finish() reports overflow if pulses had to be split
+    static size_t EstimateSymbols(const RFSignal& signal, const RfRawCode* raw, uint8_t repeat, uint32_t gap_us) {
+        const size_t frame = signal.type == RF_SIGNAL_RAW && raw != nullptr
+            ? RfPulseEncoder::SymbolsPerRawFrame(raw->TimingCount())
+            : RfPulseEncoder::SymbolsPerFrame(signal.bit_length ? signal.bit_length : 24);
+        return frame * repeat + gap_us / RfPulseEncoder::kMaxDuration + 2;
+    }
+
+    bool AddCode(uint8_t channel, const RfProtocol& protocol, uint64_t code, unsigned int length,
+                 uint8_t repeat, uint32_t gap_us) {
+        if (!Open(channel, protocol.invertedSignal ? 1 : 0)) {
+            return false;
+        }
+        for (uint8_t i = 0; i < repeat; i++) {
+            encoder_.AddFrame(protocol, code, length);
+        }
+        return Gap(gap_us);
+    }
+
+    bool AddRaw(uint8_t channel, const RfRawCode& raw, uint8_t repeat, uint32_t gap_us) {
+        if (!Open(channel, raw.IdleLevel())) {
+            return false;
+        }
+        for (uint8_t i = 0; i < repeat; i++) {
+            encoder_.AddRaw(raw);
+        }
+        return Gap(gap_us);
+    }
+
+    // Closes the last segment; false if the buffer was too small or there were too many segments
+    bool Finish() {
+        Close();
+        if (segment_count_ > 0) {
+            segments_[segment_count_ - 1].gap_after_us = 0;  // Nothing follows the last step
+        }
+        return !overflow_;
+    }
+
+    bool Overflowed() const { return overflow_; }
+    size_t SymbolCount() const { return used_; }
+    size_t SegmentCount() const { return segment_count_; }
+    const RfSceneSegment& Segment(size_t index) const { return segments_[index]; }
+
+    // Planned airtime: all symbols plus the pauses between segments
+    uint32_t DurationUs() const {
+        uint32_t total = 0;
+        for (size_t i = 0; i < used_; i++) {
+            total += buffer_[i].duration0 + buffer_[i].duration1;
+        }
+        for (size_t i = 0; i < segment_count_; i++) {
+            total += segments_[i].gap_after_us;
+        }
+        return total;
+    }
+
+private:
+    bool Open(uint8_t channel, uint8_t idle_level) {
+        if (overflow_) {
+            return false;
+        }
+        if (open_ && segments_[segment_count_ - 1].channel == channel) {
+            // Same transmitter: the previous step's gap becomes idle line time
+            RfSceneSegment& segment = segments_[segment_count_ - 1];
+            encoder_.AddPulse(segment.idle_level != 0, segment.gap_after_us);
+            segment.idle_level = idle_level;
+            segment.gap_after_us = 0;
+            segment.steps++;
+            return true;
+        }
+        Close();
+        if (segment_count_ >= kMaxSteps) {
+            overflow_ = true;
+            return false;
+        }
+        RfSceneSegment& segment = segments_[segment_count_++];
+        segment.channel = channel;
+        segment.steps = 1;
+        segment.idle_level = idle_level;
+        segment.offset = used_;
+        segment.count = 0;
+        segment.gap_after_us = 0;
+        encoder_ = RfPulseEncoder(buffer_ + used_, capacity_ - used_);
+        open_ = true;
+        return true;
+    }
+
+    // The gap is only encoded once the next step turns out to use the same
+    // transmitter; until then it is the segment's trailing pause
+    bool Gap(uint32_t gap_us) {
+        segments_[segment_count_ - 1].gap_after_us = gap_us;
+        return !encoder_.Overflowed();
+    }
+
+    void Close() {
+        if (!open_) {
+            return;
+        }
+        open_ = false;
+        if (!encoder_.Finish()) {
+            overflow_ = true;
+        }
+        RfSceneSegment& segment = segments_[segment_count_ - 1];
+        segment.count = encoder_.Size();
+        used_ += segment.count;
+    }
+
+    RfSymbol* buffer_;
+    size_t capacity_;
+    RfPulseEncoder encoder_;  // Writes the open segment
+    size_t used_;             // Symbols in closed segments
+    RfSceneSegment segments_[kMaxSteps];
+    size_t segment_count_;
+    bool open_;
+    bool overflow_;
+};
+
+/**
+ * Flash form of a named scene (one NVS blob per scene)
+ *
+ * Layout, little endian:
+ *   version, name length, name bytes, step count,
+ *   per step: repeat, gap_us (4), record length (2), RfSignalRecord,
+ *   CRC-32 of everything before it (4)
+ *
+ * Steps embed full signal records, raw timings included, so a scene keeps
+ * working after the signals it was built from are deleted or renamed.
+ */
+class RfSceneRecord {
+public:
+    static constexpr uint8_t kVersion = 1;
+    static constexpr size_t kMaxNameLength = RFSignal::kMaxNameLength;
+    static constexpr size_t kMaxSize = 3 + kMaxNameLength + RfSceneBuilder::kMaxSteps * (7 + RfSignalRecord::kMaxSize) + 4;
+
+    // raws[i] holds the timings of a raw step (nullptr otherwise); returns the size, 0 if invalid
+    static size_t Encode(const char* name, const RfSceneStep* steps, const RfRawCode* const* raws, size_t count,
+                         uint8_t* out, size_t capacity) {
+        const size_t name_length = strlen(name);
+        if (capacity < kMaxSize || name_length > kMaxNameLength || count == 0 || count > RfSceneBuilder::kMaxSteps) {
+            return 0;
+        }
+        uint8_t* p = out;
+        *p++ = kVersion;
+        *p++ = static_cast<uint8_t>(name_length);
+        memcpy(p, name, name_length);
+        p += name_length;
+        *p++ = static_cast<uint8_t>(count);
+        for (size_t i = 0; i < count; i++) {
+            *p++ = steps[i].repeat;
+            p = Put(p, steps[i].gap_us, 4);
+            const size_t size = RfSignalRecord::Encode(steps[i].signal, raws[i], 0, p + 2, RfSignalRecord::kMaxSize);
+            if (size == 0) {
+                return 0;
+            }
+            p = Put(p, size, 2);
+            p += size;
+        }
+        p = Put(p, RfSignalRecord::Crc32(out, p - out), 4);
+        return p - out;
+    }
+
+    // Name only, e.g. to list or find stored scenes; name needs kMaxNameLength + 1 bytes
+    static bool DecodeName(const uint8_t* in, size_t size, char* name) {
+        if (size < 3 + 4 || in[0] != kVersion || in[1] > kMaxNameLength || 3u + in[1] > size - 4 ||
+            Get(in + size - 4, 4) != RfSignalRecord::Crc32(in, size - 4)) {
+            return false;
+        }
+        memcpy(name, in + 2, in[1]);
+        name[in[1]] = '\0';
+        return true;
+    }
+
+    // name needs kMaxNameLength + 1 bytes; steps and raws need RfSceneBuilder::kMaxSteps entries
+    static bool Decode(const uint8_t* in, size_t size, char* name, RfSceneStep* steps, RfRawCode* raws, size_t& count) {
+        if (size < 3 + 4 || in[0] != kVersion ||
+            Get(in + size - 4, 4) != RfSignalRecord::Crc32(in, size - 4)) {
+            return false;
+        }
+        const uint8_t* p = in + 1;
+        const uint8_t* end = in + size - 4;
+        const size_t name_length = *p++;
+        if (name_length > kMaxNameLength || p + name_length + 1 > end) {
+            return false;
+        }
+        memcpy(name, p, name_length);
+        name[name_length] = '\0';
+        p += name_length;
+        count = *p++;
+        if (count == 0 || count > RfSceneBuilder::kMaxSteps) {
+            return false;
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (p + 7 > end) {
+                return false;
+            }
+            steps[i].repeat = *p++;
+            steps[i].gap_us = static_cast<uint32_t>(Get(p, 4));
+            const size_t record_size = static_cast<size_t>(Get(p + 4, 2));
+            p += 6;
+            if (p + record_size > end ||
+                !RfSignalRecord::Decode(p, record_size, steps[i].signal, &raws[i])) {
+                return false;
+            }
+            p += record_size;
+        }
+        return p == end;
+    }
+
+private:
+    static uint8_t* Put(uint8_t* p, uint64_t value, size_t bytes) {
+        for (size_t i = 0; i < bytes; i++) {
+            *p++ = static_cast<uint8_t>(value >> (8 * i));
+        }
+        return p;
+    }
+
+    static uint64_t Get(const uint8_t* p, size_t bytes) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < bytes; i++) {
+            value |= static_cast<uint64_t>(p[i]) << (8 * i);
+        }
+        return value;
+    }
+};
+
+#endif // RF_SCENE_H
@@ -0,0 +1,191 @@
+#ifndef RF_SIGNAL_H
+#define RF_SIGNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include "rf_raw_code.h"
+
+enum RFFrequency : uint8_t {
+    RF_433MHZ = 0,
+    RF_315MHZ = 1
+};
+
+enum RFSignalType : uint8_t {
+    RF_SIGNAL_CODE = 0,  // 协议解码得到的编码
+    RF_SIGNAL_RAW = 1    // 无法解码的原始脉冲时序（protocol为0）
+};
+
+// Fixed-size signal record: no heap allocation to receive, copy or send one.
+// The hex address/key strings are only built for logs and the MCP tools.
+struct RFSignal {
+    static constexpr size_t kMaxNameLength = 31;  // UTF-8 bytes, without the terminator
+
+    uint64_t code;            // 解码值（原始信号为时序指纹）
+    uint16_t bit_length;      // 位长（原始信号为0）
+    uint16_t pulse_length;    // 脉冲长度（微秒）
+    uint16_t raw_handle;      // 原始时序在 RFModule 时序池中的句柄（0 = 无）
+    uint8_t protocol;         // 协议编号（原始信号为0）
+    RFFrequency frequency;    // 频率类型
+    RFSignalType type;        // 编码或原始时序
+    uint8_t channel;          // 接收通道（RFModule 通道编号，不保存到闪存）
+    char name[kMaxNameLength + 1];  // 信号主题/名称（如"卧室灯开关"、"空调开关"）
+
+    RFSignal() : code(0), bit_length(0), pulse_length(320), raw_handle(0), protocol(1),
+                 frequency(RF_433MHZ), type(RF_SIGNAL_CODE), channel(0) {
+        name[0] = '\0';
+    }
+
+    bool Empty() const { return bit_length == 0 && type == RF_SIGNAL_CODE; }
+    bool HasName() const { return name[0] != '\0'; }
+
+    // Truncates on a UTF-8 character boundary
+    void SetName(const char* value) {
+        size_t length = strlen(value);
+        if (length > kMaxNameLength) {
+            length = kMaxNameLength;
+            // Do not cut a multi-byte character (e.g. 卧室灯) in half
+            while (length > 0 && (static_cast<uint8_t>(value[length]) & 0xC0) == 0x80) {
+                length--;
+            }
+        }
+        memcpy(name, value, length);
+        name[length] = '\0';
+    }
+    void SetName(const std::string& value) { SetName(value.c_str()); }
+
+    // 十六进制地址码 / 2位按键值, the form used by self.rf.send: 6 digits for codes of
+    // up to 24 bits, one more digit per 4 bits beyond that (16 for a 64-bit code)
+    static constexpr unsigned int kMaxCodeBits = 64;
+    static constexpr size_t kAddressHexSize = kMaxCodeBits / 4 + 1;
+    void FormatAddress(char* out, size_t size) const {
+        const unsigned int bits = bit_length > 24 ? (bit_length < kMaxCodeBits ? bit_length : kMaxCodeBits) : 24;
+        const uint64_t value = bits < kMaxCodeBits ? code & ((1ULL << bits) - 1) : code;
+        snprintf(out, size, "%0*llX", (int)((bits + 3) / 4), (unsigned long long)value);
+    }
+    std::string AddressHex() const {
+        char hex[kAddressHexSize];
+        FormatAddress(hex, sizeof(hex));
+        return hex;
+    }
+    std::string KeyHex() const { return "00"; }
+};
+
+/**
+ * Flash form of one stored signal (one NVS blob per signal)
+ *
+ * Layout, little endian:
+ *   version, type, frequency, protocol, bit_length (2), pulse_length (2),
+ *   code (8), sequence (4), name length, name bytes, raw length, raw bytes
+ *   (RfRawCode::Serialize), CRC-32 of everything before it (4)
+ *
+ * The sequence number orders the stored signals (RfSlotTable).
+ *
+ * Readers reject unknown versions and CRC mismatches, so a torn write
+ * shows up as a missing signal rather than a garbled one.
+ */
+class RfSignalRecord {
+public:
+    static constexpr uint8_t kVersion = 2;
+    static constexpr size_t kFixedSize = 21;
+    static constexpr size_t kMaxRawSize = RfRawCode::kHeaderSize + RfRawCode::kMaxBins * 2 + RfRawCode::kMaxTimings / 2;
+    static constexpr size_t kMaxSize = kFixedSize + RFSignal::kMaxNameLength + 1 + kMaxRawSize + 4;
+
+    // `raw` is only written for RF_SIGNAL_RAW; returns the record size, 0 if it does not fit
+    static size_t Encode(const RFSignal& signal, const RfRawCode* raw, uint32_t sequence, uint8_t* out, size_t capacity) {
+        if (capacity < kMaxSize || (signal.type == RF_SIGNAL_RAW && raw == nullptr)) {
+            return 0;
+        }
+        uint8_t* p = out;
+        *p++ = kVersion;
+        *p++ = signal.type;
+        *p++ = signal.frequency;
+        *p++ = signal.protocol;
+        p = Put(p, signal.bit_length, 2);
+        p = Put(p, signal.pulse_length, 2);
+        p = Put(p, signal.code, 8);
+        p = Put(p, sequence, 4);
+        const size_t name_length = strlen(signal.name);
+        *p++ = static_cast<uint8_t>(name_length);
+        memcpy(p, signal.name, name_length);
+        p += name_length;
+        size_t raw_size = 0;
+        if (signal.type == RF_SIGNAL_RAW) {
+            raw_size = raw->Serialize(p + 1, kMaxRawSize);
+        }
+        *p++ = static_cast<uint8_t>(raw_size);
+        p += raw_size;
+        p = Put(p, Crc32(out, p - out), 4);
+        return p - out;
+    }
+
+    // `raw` and `sequence` may be nullptr when only the metadata is wanted
+    static bool Decode(const uint8_t* in, size_t size, RFSignal& signal, RfRawCode* raw, uint32_t* sequence = nullptr) {
+        if (size < kFixedSize + 1 + 4 || in[0] != kVersion || in[1] > RF_SIGNAL_RAW || in[2] > RF_315MHZ ||
+            Get(in + size - 4, 4) != Crc32(in, size - 4)) {
+            return false;
+        }
+        const uint8_t* p = in + 1;
+        const uint8_t* end = in + size - 4;
+        RFSignal decoded;
+        decoded.type = static_cast<RFSignalType>(*p++);
+        decoded.frequency = static_cast<RFFrequency>(*p++);
+        decoded.protocol = *p++;
+        decoded.bit_length = static_cast<uint16_t>(Get(p, 2));
+        decoded.pulse_length = static_cast<uint16_t>(Get(p + 2, 2));
+        decoded.code = Get(p + 4, 8);
+        const uint32_t decoded_sequence = static_cast<uint32_t>(Get(p + 12, 4));
+        p += 16;
+        const size_t name_length = *p++;
+        if (name_length > RFSignal::kMaxNameLength || p + name_length + 1 > end) {
+            return false;
+        }
+        memcpy(decoded.name, p, name_length);
+        decoded.name[name_length] = '\0';
+        p += name_length;
+        const size_t raw_size = *p++;
+        if (p + raw_size != end) {
+            return false;
+        }
+        if (decoded.type == RF_SIGNAL_RAW && raw != nullptr && !raw->Deserialize(p, raw_size)) {
+            return false;
+        }
+        signal = decoded;
+        if (sequence != nullptr) {
+            *sequence = decoded_sequence;
+        }
+        return true;
+    }
+
+    // CRC-32 (IEEE, reflected), bitwise: records are small and written rarely
+    static uint32_t Crc32(const uint8_t* data, size_t size) {
+        uint32_t crc = 0xFFFFFFFF;
+        for (size_t i = 0; i < size; i++) {
+            crc ^= data[i];
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+            }
+        }
+        return ~crc;
+    }
+
+private:
+    static uint8_t* Put(uint8_t* p, uint64_t value, size_t bytes) {
+        for (size_t i = 0; i < bytes; i++) {
+            *p++ = static_cast<uint8_t>(value >> (8 * i));
+        }
+        return p;
+    }
+
+    static uint64_t Get(const uint8_t* p, size_t bytes) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < bytes; i++) {
+            value |= static_cast<uint64_t>(p[i]) << (8 * i);
+        }
+        return value;
+    }
+};
+
+#endif // RF_SIGNAL_H
@@ -0,0 +1,153 @@
+#ifndef RF_SIGNAL_INDEX_H
+#define RF_SIGNAL_INDEX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "rf_signal.h"
+
+/**
+ * Hash index from (band, code, bit length) to a flash slot
+ *
+ * Open addressing with linear probing. Deletes shift the following
+ * entries back, so there are no tombstones and lookups never degrade.
+ * The table is sized to at least twice the number of slots, keeping the
+ * load factor at or below 0.5.
+ *
+ * Raw signals are keyed on their timing fingerprint with bit length 0,
+ * so they never collide with decoded codes.
+ *
+ * Pure C++ with no ESP-IDF dependency, like RfRawCode.
+ */
+class RfSignalIndex {
+public:
+    RfSignalIndex() : entries_(nullptr), mask_(0), size_(0) {}
+    ~RfSignalIndex() { delete[] entries_; }
+    RfSignalIndex(const RfSignalIndex&) = delete;
+    RfSignalIndex& operator=(const RfSignalIndex&) = delete;
+
+    // Drops all entries and sizes the table for up to max_entries keys
+    void Reset(size_t max_entries) {
+        size_t capacity = 4;
+        while (capacity < max_entries * 2) {
+            capacity <<= 1;
+        }
+        delete[] entries_;
+        entries_ = new Entry[capacity];
+        mask_ = capacity - 1;
+        Clear();
+    }
+
+    void Clear() {
+        for (size_t i = 0; entries_ != nullptr && i <= mask_; i++) {
+            entries_[i].used = 0;
+        }
+        size_ = 0;
+    }
+
+    size_t Size() const { return size_; }
+
+    // False if the key is already present (the existing slot is kept) or the table is full
+    bool Insert(const RFSignal& signal, uint16_t slot) {
+        if (entries_ == nullptr || size_ >= mask_) {
+            return false;
+        }
+        const Entry key = KeyOf(signal, slot);
+        for (size_t i = Hash(key) & mask_;; i = (i + 1) & mask_) {
+            Entry& entry = entries_[i];
+            if (!entry.used) {
+                entry = key;
+                size_++;
+                return true;
+            }
+            if (SameKey(entry, key)) {
+                return false;
+            }
+        }
+    }
+
+    bool Find(const RFSignal& signal, uint16_t& slot) const {
+        if (entries_ == nullptr) {
+            return false;
+        }
+        const Entry key = KeyOf(signal, 0);
+        for (size_t i = Hash(key) & mask_; entries_[i].used; i = (i + 1) & mask_) {
+            if (SameKey(entries_[i], key)) {
+                slot = entries_[i].slot;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Only removes the entry if it points at `slot`
+    bool Remove(const RFSignal& signal, uint16_t slot) {
+        if (entries_ == nullptr) {
+            return false;
+        }
+        const Entry key = KeyOf(signal, slot);
+        size_t i = Hash(key) & mask_;
+        for (; entries_[i].used; i = (i + 1) & mask_) {
+            if (SameKey(entries_[i], key)) {
+                break;
+            }
+        }
+        if (!entries_[i].used || entries_[i].slot != slot) {
+            return false;
+        }
+        // Backward-shift: move later entries of the probe run into the hole when
+        // their home position is not between the hole and their current position
+        size_t hole = i;
+        for (size_t j = (i + 1) & mask_; entries_[j].used; j = (j + 1) & mask_) {
+            const size_t home = Hash(entries_[j]) & mask_;
+            const bool stays = (hole <= j) ? (hole < home && home <= j) : (hole < home || home <= j);
+            if (!stays) {
+                entries_[hole] = entries_[j];
+                hole = j;
+            }
+        }
+        entries_[hole].used = 0;
+        size_--;
+        return true;
+    }
+
+private:
+    struct Entry {
+        uint64_t code;
+        uint16_t bit_length;
+        uint16_t slot;
+        uint8_t band;
+        uint8_t used;
+    };
+
+    static Entry KeyOf(const RFSignal& signal, uint16_t slot) {
+        Entry entry;
+        entry.code = signal.code;
+        entry.bit_length = signal.type == RF_SIGNAL_RAW ? 0 : signal.bit_length;
+        entry.slot = slot;
+        entry.band = signal.frequency;
+        entry.used = 1;
+        return entry;
+    }
+
+    static bool SameKey(const Entry& a, const Entry& b) {
+        return a.code == b.code && a.bit_length == b.bit_length && a.band == b.band;
+    }
+
+    // 64-bit finaliser from MurmurHash3
+    static size_t Hash(const Entry& entry) {
+        uint64_t h = entry.code ^ (static_cast<uint64_t>(entry.bit_length) << 48) ^
+                     (static_cast<uint64_t>(entry.band) << 40);
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ULL;
+        h ^= h >> 33;
+        return static_cast<size_t>(h);
+    }
+
+    Entry* entries_;
+    size_t mask_;
+    size_t size_;
+};
+
+#endif // RF_SIGNAL_INDEX_H
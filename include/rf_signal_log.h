@@ -0,0 +1,424 @@
+#ifndef RF_SIGNAL_LOG_H
+#define RF_SIGNAL_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "rf_signal.h"
+
+/**
+ * Erasable storage under RfSignalLog (a flash partition on the ESP32, a
+ * file on the host). Writes follow NOR rules: they only go into bytes
+ * that are erased (0xFF) and erasing works on whole sectors.
+ */
+class RfLogMedium {
+public:
+    virtual ~RfLogMedium() {}
+    virtual size_t Size() const = 0;        // Bytes, a multiple of SectorSize()
+    virtual size_t SectorSize() const = 0;  // Erase unit
+    virtual bool Read(size_t offset, void* data, size_t size) const = 0;
+    virtual bool Write(size_t offset, const void* data, size_t size) = 0;
+    virtual bool EraseSector(size_t offset) = 0;
+};
+
+/**
+ * Append-only key/value log for stored signals
+ *
+ * Every write appends a record to the head sector; the newest record of a
+ * key wins. Sectors carry a sequence number so the log can be replayed in
+ * order at mount, which rebuilds the only state kept in RAM: one 32-bit
+ * offset per key and a live byte count per sector.
+ *
+ * Sector:  magic (4), sequence (4), ~sequence (4), reserved (4), records
+ * Record:  key (2), size (2), payload, CRC-32 of key..payload (4), padded to 4
+ *
+ * A record with size 0 deletes its key; a kClearKey record deletes every
+ * key before it. Compact() reclaims the oldest sector: live records are
+ * copied to the head and the sector is erased. Deletes and clears found
+ * there are dropped, as there is nothing older left for them to hide.
+ * One erased sector is held back so compaction always has room.
+ *
+ * Not thread-safe; RFModule serialises callers with its compaction task.
+ * Pure C++ with no ESP-IDF dependency, like RfRawCode.
+ */
+class RfSignalLog {
+public:
+    static constexpr uint32_t kMagic = 0x474C4652;  // "RFLG"
+    static constexpr size_t kSectorHeaderSize = 16;
+    static constexpr size_t kRecordOverhead = 8;
+    static constexpr size_t kMaxPayload = 256;
+    static constexpr size_t kMaxRecordSize = kMaxPayload + kRecordOverhead;
+    static constexpr uint16_t kMaxKeys = 0xFFF0;
+    static constexpr size_t kReserveSectors = 1;
+
+    RfSignalLog() : medium_(nullptr), offsets_(nullptr), sequences_(nullptr), live_(nullptr),
+                    key_count_(0), sector_count_(0), sector_size_(0), head_(0), head_sector_(0),
+                    next_sequence_(1), free_sectors_(0), live_bytes_(0), erase_count_(0), bytes_written_(0) {}
+    ~RfSignalLog() { Unmount(); }
+    RfSignalLog(const RfSignalLog&) = delete;
+    RfSignalLog& operator=(const RfSignalLog&) = delete;
+
+    // Replays the log; sectors that are neither erased nor ours are erased.
+    // False if the medium is too small (fewer than three sectors).
+    bool Mount(RfLogMedium* medium, uint16_t key_count) {
+        Unmount();
+        const size_t sector_size = medium->SectorSize();
+        if (key_count == 0 || key_count > kMaxKeys || sector_size < kSectorHeaderSize + kMaxRecordSize ||
+            sector_size - kSectorHeaderSize > 0xFFFF || medium->Size() / sector_size < kReserveSectors + 2) {
+            return false;
+        }
+        medium_ = medium;
+        key_count_ = key_count;
+        sector_size_ = sector_size;
+        sector_count_ = medium->Size() / sector_size;
+        offsets_ = new uint32_t[key_count_];
+        sequences_ = new uint32_t[sector_count_];
+        live_ = new uint16_t[sector_count_];
+        ResetIndex();
+
+        size_t* order = new size_t[sector_count_];
+        size_t used = 0;
+        for (size_t sector = 0; sector < sector_count_; sector++) {
+            uint32_t header[4];
+            sequences_[sector] = kErased;
+            if (!medium_->Read(SectorBase(sector), header, sizeof(header))) {
+                continue;
+            }
+            if (header[0] == kMagic && header[2] == ~header[1] && header[1] != kErased) {
+                sequences_[sector] = header[1];
+                // Replay order: insertion sort on sequence, sector counts are small
+                size_t pos = used++;
+                while (pos > 0 && sequences_[order[pos - 1]] > header[1]) {
+                    order[pos] = order[pos - 1];
+                    pos--;
+                }
+                order[pos] = sector;
+                if (header[1] >= next_sequence_) {
+                    next_sequence_ = header[1] + 1;
+                }
+            } else if (!IsBlank(sector)) {
+                EraseSectorAt(sector);
+            }
+        }
+        for (size_t i = 0; i < used; i++) {
+            const size_t end = Replay(order[i]);
+            if (i + 1 == used) {
+                head_sector_ = order[i];
+                head_ = end;  // A torn record leaves end at the sector end: writes move on
+            }
+        }
+        delete[] order;
+
+        free_sectors_ = sector_count_ - used;
+        if (used == 0 && !OpenSector()) {
+            Unmount();
+            return false;
+        }
+        return true;
+    }
+
+    void Unmount() {
+        delete[] offsets_;
+        delete[] sequences_;
+        delete[] live_;
+        offsets_ = nullptr;
+        sequences_ = nullptr;
+        live_ = nullptr;
+        medium_ = nullptr;
+    }
+
+    bool Mounted() const { return medium_ != nullptr; }
+    uint16_t KeyCount() const { return key_count_; }
+    bool Contains(uint16_t key) const { return Mounted() && key < key_count_ && offsets_[key] != kNone; }
+
+    // Copies the newest payload of `key`; false if absent or the record fails its CRC
+    bool Read(uint16_t key, uint8_t* data, size_t capacity, size_t& size) const {
+        if (!Contains(key)) {
+            return false;
+        }
+        uint8_t record[kMaxRecordSize];
+        uint16_t payload_size = 0;
+        if (!ReadRecord(offsets_[key], record, nullptr, &payload_size) || payload_size > capacity) {
+            return false;
+        }
+        memcpy(data, record + 4, payload_size);
+        size = payload_size;
+        return true;
+    }
+
+    // Compacts in the foreground only when the reserve sector would be needed
+    bool Write(uint16_t key, const uint8_t* data, size_t size) {
+        if (!Mounted() || key >= key_count_ || size == 0 || size > kMaxPayload) {
+            return false;
+        }
+        return Append(key, data, size, false);
+    }
+
+    bool Erase(uint16_t key) {
+        if (!Contains(key)) {
+            return true;
+        }
+        return Append(key, nullptr, 0, false);
+    }
+
+    // O(1): one marker record instead of a tombstone per key
+    bool Clear() {
+        if (!Mounted()) {
+            return false;
+        }
+        return Append(kClearKey, nullptr, 0, false);
+    }
+
+    // True while free sectors are down to a quarter of the log and reclaiming would free at
+    // least one sector (compacting a log that is all live data only wears the flash)
+    bool NeedsCompaction() const {
+        return Mounted() && free_sectors_ <= CompactionThreshold() &&
+               UsedBytes() - live_bytes_ >= sector_size_ - kSectorHeaderSize;
+    }
+
+    // Reclaims the oldest sector other than the head; false if there is none
+    bool Compact() {
+        const size_t oldest = Mounted() ? OldestSector() : kNoSector;
+        if (oldest == kNoSector) {
+            return false;
+        }
+        const size_t base = SectorBase(oldest);
+        uint8_t record[kMaxRecordSize];
+        for (size_t offset = base + kSectorHeaderSize; offset + kRecordOverhead <= base + sector_size_;) {
+            uint16_t key = 0;
+            uint16_t size = 0;
+            if (!ReadRecord(offset, record, &key, &size)) {
+                break;
+            }
+            if (key < key_count_ && size > 0 && offsets_[key] == offset && !Append(key, record + 4, size, true)) {
+                return false;
+            }
+            offset += RecordSize(size);
+        }
+        if (!EraseSectorAt(oldest)) {
+            return false;
+        }
+        sequences_[oldest] = kErased;
+        live_bytes_ -= live_[oldest];
+        live_[oldest] = 0;
+        free_sectors_++;
+        return true;
+    }
+
+    size_t SectorCount() const { return sector_count_; }
+    size_t FreeSectors() const { return free_sectors_; }
+    size_t LiveBytes() const { return live_bytes_; }
+    // Payload room left before writes fail, leaving slack for one record per sector
+    size_t Capacity() const {
+        return Mounted() ? (sector_count_ - kReserveSectors - 1) * (sector_size_ - kSectorHeaderSize - kMaxRecordSize) : 0;
+    }
+    uint32_t EraseCount() const { return erase_count_; }
+    uint32_t BytesWritten() const { return bytes_written_; }
+
+private:
+    static constexpr uint32_t kErased = 0xFFFFFFFF;
+    static constexpr uint32_t kNone = 0xFFFFFFFF;
+    static constexpr uint16_t kClearKey = 0xFFFE;
+    static constexpr size_t kNoSector = static_cast<size_t>(-1);
+
+    static size_t RecordSize(size_t payload_size) { return (payload_size + kRecordOverhead + 3) & ~static_cast<size_t>(3); }
+    size_t SectorBase(size_t sector) const { return sector * sector_size_; }
+    size_t SectorOf(size_t offset) const { return offset / sector_size_; }
+    // Written bytes in all sectors but the free ones; stale records and sector tails count
+    size_t UsedBytes() const {
+        const size_t used_sectors = sector_count_ - free_sectors_;
+        return used_sectors * (sector_size_ - kSectorHeaderSize) - (SectorBase(head_sector_) + sector_size_ - head_);
+    }
+    size_t CompactionThreshold() const {
+        const size_t quarter = sector_count_ / 4;
+        return quarter > kReserveSectors + 1 ? quarter : kReserveSectors + 1;
+    }
+
+    void ResetIndex() {
+        for (uint16_t key = 0; key < key_count_; key++) {
+            offsets_[key] = kNone;
+        }
+        for (size_t sector = 0; sector < sector_count_; sector++) {
+            live_[sector] = 0;
+        }
+        live_bytes_ = 0;
+    }
+
+    bool IsBlank(size_t sector) const {
+        uint32_t words[32];
+        for (size_t offset = 0; offset < sector_size_; offset += sizeof(words)) {
+            const size_t chunk = sector_size_ - offset < sizeof(words) ? sector_size_ - offset : sizeof(words);
+            if (!medium_->Read(SectorBase(sector) + offset, words, chunk)) {
+                return false;
+            }
+            for (size_t i = 0; i < chunk / 4; i++) {
+                if (words[i] != kErased) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool EraseSectorAt(size_t sector) {
+        erase_count_++;
+        return medium_->EraseSector(SectorBase(sector));
+    }
+
+    size_t OldestSector() const {
+        size_t oldest = kNoSector;
+        for (size_t sector = 0; sector < sector_count_; sector++) {
+            if (sector != head_sector_ && sequences_[sector] != kErased &&
+                (oldest == kNoSector || sequences_[sector] < sequences_[oldest])) {
+                oldest = sector;
+            }
+        }
+        return oldest;
+    }
+
+    // Reads and checks one record into `record` (header, payload, CRC); false at the
+    // end of the written area or on a torn/corrupt record
+    bool ReadRecord(size_t offset, uint8_t* record, uint16_t* key, uint16_t* size) const {
+        if (!medium_->Read(offset, record, 4)) {
+            return false;
+        }
+        const uint16_t record_key = record[0] | (record[1] << 8);
+        const uint16_t record_size = record[2] | (record[3] << 8);
+        if (record_key == 0xFFFF || record_size > kMaxPayload ||
+            offset + RecordSize(record_size) > SectorBase(SectorOf(offset)) + sector_size_ ||
+            !medium_->Read(offset + 4, record + 4, record_size + 4)) {
+            return false;
+        }
+        const uint8_t* crc = record + 4 + record_size;
+        const uint32_t stored = crc[0] | (crc[1] << 8) | (crc[2] << 16) | (static_cast<uint32_t>(crc[3]) << 24);
+        if (stored != RfSignalRecord::Crc32(record, 4 + record_size)) {
+            return false;
+        }
+        if (key != nullptr) {
+            *key = record_key;
+        }
+        if (size != nullptr) {
+            *size = record_size;
+        }
+        return true;
+    }
+
+    // Applies one sector's records to the index; returns the offset after the last good one,
+    // or the sector end if a torn record means the rest of the sector cannot be trusted
+    size_t Replay(size_t sector) {
+        const size_t end = SectorBase(sector) + sector_size_;
+        size_t offset = SectorBase(sector) + kSectorHeaderSize;
+        uint8_t record[kMaxRecordSize];
+        while (offset + kRecordOverhead <= end) {
+            uint16_t key = 0;
+            uint16_t size = 0;
+            if (!ReadRecord(offset, record, &key, &size)) {
+                return (record[0] == 0xFF && record[1] == 0xFF) ? offset : end;
+            }
+            Apply(key, size, offset);
+            offset += RecordSize(size);
+        }
+        return end;
+    }
+
+    void Apply(uint16_t key, uint16_t size, size_t offset) {
+        if (key == kClearKey) {
+            ResetIndex();
+            return;
+        }
+        if (key >= key_count_) {
+            return;  // Written with a larger key count; ignored, reclaimed by compaction
+        }
+        if (offsets_[key] != kNone) {
+            uint8_t header[4];
+            if (medium_->Read(offsets_[key], header, sizeof(header))) {
+                const size_t old_size = RecordSize(header[2] | (header[3] << 8));
+                live_[SectorOf(offsets_[key])] -= old_size;
+                live_bytes_ -= old_size;
+            }
+            offsets_[key] = kNone;
+        }
+        if (size > 0) {
+            offsets_[key] = static_cast<uint32_t>(offset);
+            live_[SectorOf(offset)] += RecordSize(size);
+            live_bytes_ += RecordSize(size);
+        }
+    }
+
+    // Takes the next erased sector after the head and stamps it with a new sequence
+    bool OpenSector() {
+        for (size_t step = 1; step <= sector_count_; step++) {
+            const size_t sector = (head_sector_ + step) % sector_count_;
+            if (sequences_[sector] != kErased) {
+                continue;
+            }
+            const uint32_t header[4] = { kMagic, next_sequence_, ~next_sequence_, kErased };
+            if (!medium_->Write(SectorBase(sector), header, sizeof(header))) {
+                return false;
+            }
+            bytes_written_ += sizeof(header);
+            sequences_[sector] = next_sequence_++;
+            free_sectors_--;
+            head_sector_ = sector;
+            head_ = SectorBase(sector) + kSectorHeaderSize;
+            return true;
+        }
+        return false;
+    }
+
+    bool Append(uint16_t key, const uint8_t* data, size_t size, bool from_compaction) {
+        const size_t length = RecordSize(size);
+        for (size_t attempts = 0; head_ + length > SectorBase(head_sector_) + sector_size_; attempts++) {
+            if (free_sectors_ > (from_compaction ? 0 : kReserveSectors)) {
+                if (!OpenSector()) {
+                    return false;
+                }
+                break;
+            }
+            // Out of free sectors: reclaim in the foreground, but only if that can make room
+            if (from_compaction || attempts >= sector_count_ || live_bytes_ + length > Capacity() || !Compact()) {
+                return false;
+            }
+        }
+
+        uint8_t record[kMaxRecordSize];
+        memset(record, 0xFF, length);
+        record[0] = static_cast<uint8_t>(key);
+        record[1] = static_cast<uint8_t>(key >> 8);
+        record[2] = static_cast<uint8_t>(size);
+        record[3] = static_cast<uint8_t>(size >> 8);
+        if (size > 0) {
+            memcpy(record + 4, data, size);
+        }
+        const uint32_t crc = RfSignalRecord::Crc32(record, 4 + size);
+        for (int i = 0; i < 4; i++) {
+            record[4 + size + i] = static_cast<uint8_t>(crc >> (8 * i));
+        }
+        const size_t offset = head_;
+        if (!medium_->Write(offset, record, length)) {
+            head_ = SectorBase(head_sector_) + sector_size_;  // Do not write over a half-programmed record
+            return false;
+        }
+        head_ += length;
+        bytes_written_ += length;
+        Apply(key, static_cast<uint16_t>(size), offset);
+        return true;
+    }
+
+    RfLogMedium* medium_;
+    uint32_t* offsets_;    // Per key: offset of the newest record, kNone if absent
+    uint32_t* sequences_;  // Per sector: sequence number, kErased if free
+    uint16_t* live_;       // Per sector: bytes of records that are still the newest for their key
+    uint16_t key_count_;
+    size_t sector_count_;
+    size_t sector_size_;
+    size_t head_;          // Next write offset
+    size_t head_sector_;
+    uint32_t next_sequence_;
+    size_t free_sectors_;
+    size_t live_bytes_;
+    uint32_t erase_count_;
+    uint32_t bytes_written_;
+};
+
+#endif // RF_SIGNAL_LOG_H
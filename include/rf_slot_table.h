@@ -0,0 +1,196 @@
+#ifndef RF_SLOT_TABLE_H
+#define RF_SLOT_TABLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+
+/**
+ * Slot allocator for stored signals
+ *
+ * Storage slots (NVS keys / log keys) are handed out from a free list and
+ * never move. The save order lives in a separate array of slots, oldest
+ * first, so deleting any signal is O(1): the slot goes back on the free
+ * list and its place in the order becomes a hole. Holes are squeezed out
+ * by Compact(), which runs before the next index lookup, so a burst of
+ * deletes costs one O(n) pass and every index resolves to a live slot.
+ *
+ * Each slot also carries a save sequence number that is stored with the
+ * record; at boot Restore() + FinishRestore() rebuild the order from it.
+ *
+ * Indices follow RFModule: 0 is the most recently saved signal.
+ *
+ * Pure C++ with no ESP-IDF dependency, like RfRawCode.
+ */
+class RfSlotTable {
+public:
+    static constexpr uint16_t kNoSlot = 0xFFFF;
+
+    RfSlotTable() : order_(nullptr), position_(nullptr), free_(nullptr), sequence_(nullptr),
+                    capacity_(0), count_(0), free_count_(0), length_(0), holes_(0), next_sequence_(1) {}
+    ~RfSlotTable() { Release(); }
+    RfSlotTable(const RfSlotTable&) = delete;
+    RfSlotTable& operator=(const RfSlotTable&) = delete;
+
+    void Reset(uint16_t capacity) {
+        Release();
+        order_ = new uint16_t[capacity];
+        position_ = new uint16_t[capacity];
+        free_ = new uint16_t[capacity];
+        sequence_ = new uint32_t[capacity];
+        capacity_ = capacity;
+        Clear();
+    }
+
+    // Everything free; the lowest slot is handed out first
+    void Clear() {
+        for (uint16_t slot = 0; slot < capacity_; slot++) {
+            position_[slot] = kNoSlot;
+            sequence_[slot] = 0;
+            free_[slot] = capacity_ - 1 - slot;
+        }
+        count_ = 0;
+        free_count_ = capacity_;
+        length_ = 0;
+        holes_ = 0;
+        next_sequence_ = 1;
+    }
+
+    uint16_t Capacity() const { return capacity_; }
+    uint16_t Count() const { return count_; }
+    bool Used(uint16_t slot) const { return slot < capacity_ && position_[slot] != kNoSlot; }
+    uint32_t Sequence(uint16_t slot) const { return Used(slot) ? sequence_[slot] : 0; }
+
+    // Takes a free slot as the newest signal; kNoSlot when full
+    uint16_t Allocate(uint32_t& sequence) {
+        if (free_count_ == 0) {
+            return kNoSlot;
+        }
+        if (length_ == capacity_) {
+            Compact();  // Only holes can fill the order array while a slot is free
+        }
+        const uint16_t slot = free_[--free_count_];
+        position_[slot] = length_;
+        order_[length_++] = slot;
+        sequence = next_sequence_++;
+        sequence_[slot] = sequence;
+        count_++;
+        return slot;
+    }
+
+    // O(1): the slot is free again and leaves a hole in the order
+    bool Free(uint16_t slot) {
+        if (!Used(slot)) {
+            return false;
+        }
+        order_[position_[slot]] = kNoSlot;
+        position_[slot] = kNoSlot;
+        sequence_[slot] = 0;
+        free_[free_count_++] = slot;
+        count_--;
+        holes_++;
+        if (count_ == 0) {
+            length_ = 0;
+            holes_ = 0;
+        }
+        return true;
+    }
+
+    // Boot: marks a slot found in flash as used. Call FinishRestore() once all are in.
+    bool Restore(uint16_t slot, uint32_t sequence) {
+        if (slot >= capacity_ || position_[slot] != kNoSlot || sequence == 0) {
+            return false;
+        }
+        position_[slot] = 0;
+        sequence_[slot] = sequence;
+        return true;
+    }
+
+    // Orders the restored slots by sequence and rebuilds the free list
+    void FinishRestore() {
+        count_ = 0;
+        free_count_ = 0;
+        for (uint16_t slot = capacity_; slot-- > 0;) {
+            if (position_[slot] != kNoSlot) {
+                order_[count_++] = slot;
+            } else {
+                free_[free_count_++] = slot;
+            }
+        }
+        const uint32_t* sequence = sequence_;
+        std::sort(order_, order_ + count_, [sequence](uint16_t a, uint16_t b) {
+            return sequence[a] != sequence[b] ? sequence[a] < sequence[b] : a < b;
+        });
+        next_sequence_ = 1;
+        for (uint16_t position = 0; position < count_; position++) {
+            position_[order_[position]] = position;
+            if (sequence_[order_[position]] >= next_sequence_) {
+                next_sequence_ = sequence_[order_[position]] + 1;
+            }
+        }
+        length_ = count_;
+        holes_ = 0;
+    }
+
+    // 0 = newest; kNoSlot past the end
+    uint16_t SlotAt(uint16_t index) const {
+        if (index >= count_) {
+            return kNoSlot;
+        }
+        Compact();
+        return order_[count_ - 1 - index];
+    }
+
+    // Inverse of SlotAt(); kNoSlot for a free slot
+    uint16_t IndexOf(uint16_t slot) const {
+        if (!Used(slot)) {
+            return kNoSlot;
+        }
+        Compact();
+        return count_ - 1 - position_[slot];
+    }
+
+    // Removes the holes left by Free(), keeping the order
+    void Compact() const {
+        if (holes_ == 0) {
+            return;
+        }
+        uint16_t live = 0;
+        for (uint16_t position = 0; position < length_; position++) {
+            const uint16_t slot = order_[position];
+            if (slot != kNoSlot) {
+                order_[live] = slot;
+                position_[slot] = live++;
+            }
+        }
+        length_ = live;
+        holes_ = 0;
+    }
+
+private:
+    void Release() {
+        delete[] order_;
+        delete[] position_;
+        delete[] free_;
+        delete[] sequence_;
+        order_ = nullptr;
+        position_ = nullptr;
+        free_ = nullptr;
+        sequence_ = nullptr;
+        capacity_ = 0;
+    }
+
+    uint16_t* order_;      // Slots oldest first, kNoSlot for a hole; length_ entries
+    uint16_t* position_;   // Slot -> position in order_, kNoSlot when free
+    uint16_t* free_;       // Stack of free slots
+    uint32_t* sequence_;   // Slot -> save sequence, 0 when free
+    uint16_t capacity_;
+    uint16_t count_;
+    uint16_t free_count_;
+    mutable uint16_t length_;
+    mutable uint16_t holes_;
+    uint32_t next_sequence_;
+};
+
+#endif // RF_SLOT_TABLE_H
@@ -0,0 +1,78 @@
+#ifndef RF_SPSC_RING_H
+#define RF_SPSC_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * Fixed-size single-producer/single-consumer ring.
+ *
+ * Push() is called from exactly one context (e.g. the GPIO ISR) and Pop()
+ * from exactly one other (e.g. the decoder task). No locks, no allocation;
+ * a full ring drops the new item and counts it in Dropped().
+ *
+ * The producer side is forced inline and uses plain atomic loads and
+ * stores only (no read-modify-write helpers, which some targets implement
+ * as library calls), so an IRAM ISR can push while the flash cache is off.
+ */
+template <typename T, size_t N>
+class RfSpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "RfSpscRing size must be a power of two");
+
+public:
+    RfSpscRing() : head_(0), tail_(0), dropped_(0) {}
+
+    // Producer side
+    __attribute__((always_inline)) inline bool Push(const T& item) {
+        const uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= N) {
+            // Only the producer writes dropped_
+            dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        items_[head & (N - 1)] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    inline bool Pop(T& item) {
+        const uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = items_[tail & (N - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: look at the oldest item without removing it
+    inline const T* Peek() const {
+        const uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &items_[tail & (N - 1)];
+    }
+
+    // Consumer side: discard everything currently queued
+    void Clear() {
+        tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    __attribute__((always_inline)) inline size_t Size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+    bool Empty() const { return Size() == 0; }
+    static constexpr size_t Capacity() { return N; }
+    uint32_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint32_t> head_;
+    std::atomic<uint32_t> tail_;
+    std::atomic<uint32_t> dropped_;
+    T items_[N];
+};
+
+#endif // RF_SPSC_RING_H
@@ -0,0 +1,188 @@
+#ifndef RF_TRACE_H
+#define RF_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include "rf_module_config.h"
+
+// Records one event through a trace that may be nullptr, e.g. RF_TRACE(trace_, rx.Record(...));
+// compiles to nothing when CONFIG_RF_MODULE_ENABLE_TRACE is 0
+#if CONFIG_RF_MODULE_ENABLE_TRACE
+#define RF_TRACE(trace, record) do { if ((trace) != nullptr) { (trace)->record; } } while (0)
+#else
+#define RF_TRACE(trace, record) do { } while (0)
+#endif
+
+// Event types; the argument layout is what host/rf_trace_decode.py prints
+enum RfTraceType : uint8_t {
+    RF_TRACE_EDGE_BURST = 1,     // ISR: a gap over the separation limit ended. arg16 = edges since the previous one, arg32 = gap us
+    RF_TRACE_FRAME = 2,          // Decoder: frame accepted. arg16 = protocol | bits << 8 | reported << 15, arg32 = code (low 32 bits)
+    RF_TRACE_DECODE_FAILED = 3,  // Decoder: no protocol matched. arg16 = timings, arg32 = trailing gap us
+    RF_TRACE_OVERFLOW = 4,       // Decoder: frame longer than the timing buffer, restarted. arg16 = timings
+    RF_TRACE_RESYNC = 5,         // Decoder task: the edge ring overflowed. arg32 = edges dropped so far
+    RF_TRACE_TX_START = 6,       // arg32 = planned airtime us
+    RF_TRACE_TX_END = 7,         // arg32 = measured airtime us
+    RF_TRACE_FLASH_COMMIT = 8,   // arg16 = changes written, arg32 = duration us
+};
+
+struct RfTraceEvent {
+    uint32_t timestamp;  // esp_timer microseconds (wraps, only differences are used)
+    uint8_t type;        // RfTraceType
+    uint8_t channel;     // RFModule channel, kNoChannel for module-wide events
+    uint16_t arg16;
+    uint32_t arg32;
+
+    static constexpr uint8_t kNoChannel = 0xFF;
+};
+
+/**
+ * Flight recorder: the last N events of one producer
+ *
+ * Record() is called from one context only (the receive ISR, a decoder
+ * task, the TX path, ...) and overwrites the oldest event; it uses plain
+ * atomic loads and stores and is forced inline, so the IRAM ISR can record
+ * while the flash cache is off. Snapshot() may run on any thread at any
+ * time and drops events the producer overwrote while they were copied.
+ */
+template <size_t N>
+class RfTraceRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "RfTraceRing size must be a power of two");
+
+public:
+    static constexpr size_t kCapacity = N;
+
+    RfTraceRing() : head_(0) {}
+
+    __attribute__((always_inline)) inline void Record(uint32_t timestamp, uint8_t type, uint8_t channel,
+                                                      uint16_t arg16, uint32_t arg32) {
+        const uint32_t head = head_.load(std::memory_order_relaxed);
+        RfTraceEvent& event = events_[head & (N - 1)];
+        event.timestamp = timestamp;
+        event.type = type;
+        event.channel = channel;
+        event.arg16 = arg16;
+        event.arg32 = arg32;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    // Copies the events still held, oldest first, to out (room for N); returns the count
+    size_t Snapshot(RfTraceEvent* out) const {
+        const uint32_t end = head_.load(std::memory_order_acquire);
+        uint32_t begin = end - std::min<uint32_t>(end, N);
+        for (uint32_t i = begin; i != end; i++) {
+            out[i - begin] = events_[i & (N - 1)];
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // Event i is overwritten by event i + N; the producer may be writing event `after` now
+        const uint32_t after = head_.load(std::memory_order_relaxed);
+        size_t skip = 0;
+        if (after - begin >= N) {
+            skip = std::min<uint32_t>(after - begin - N + 1, end - begin);
+            memmove(out, out + skip, (end - begin - skip) * sizeof(RfTraceEvent));
+        }
+        return end - begin - skip;
+    }
+
+private:
+    std::atomic<uint32_t> head_;
+    RfTraceEvent events_[N];
+};
+
+// One channel's rings, one per producer; allocated in internal RAM next to its RfEdgeCapture
+struct RfChannelTrace {
+    static constexpr size_t kIsrEvents = 64;
+    static constexpr size_t kRxEvents = 64;
+    static constexpr size_t kTxEvents = 32;
+    static constexpr size_t kEvents = kIsrEvents + kRxEvents + kTxEvents;
+
+    uint8_t channel;                  // Set by RFModule, recorded with every event
+    RfTraceRing<kIsrEvents> isr;      // Receive ISR
+    RfTraceRing<kRxEvents> rx;        // Decoder task
+    RfTraceRing<kTxEvents> tx;        // Whichever thread transmits on the channel
+
+    RfChannelTrace() : channel(RfTraceEvent::kNoChannel) {}
+
+    size_t Snapshot(RfTraceEvent* out) const {
+        size_t count = isr.Snapshot(out);
+        count += rx.Snapshot(out + count);
+        return count + tx.Snapshot(out + count);
+    }
+};
+
+/**
+ * Binary trace dump, as returned by RFModule::DumpTrace()
+ *
+ * Layout, little endian:
+ *   "RFTR", version, event size, reserved (2), event count (4), esp_timer time of the dump (4),
+ *   per event, oldest first: timestamp (4), type, channel, arg16 (2), arg32 (4)
+ *
+ * Pure C++ with no ESP-IDF dependency, like RfRawCode.
+ */
+class RfTraceDump {
+public:
+    static constexpr uint8_t kVersion = 1;
+    static constexpr size_t kHeaderSize = 16;
+    static constexpr size_t kEventSize = 12;
+
+    static size_t Size(size_t event_count) { return kHeaderSize + event_count * kEventSize; }
+
+    // Sorts events (gathered from several rings) by age; keeps the newest that fit in capacity.
+    // Returns the dump size, 0 if not even the header fits.
+    static size_t Write(RfTraceEvent* events, size_t count, uint32_t now, uint8_t* out, size_t capacity) {
+        if (capacity < kHeaderSize) {
+            return 0;
+        }
+        std::sort(events, events + count, [now](const RfTraceEvent& a, const RfTraceEvent& b) {
+            return now - a.timestamp > now - b.timestamp;
+        });
+        const size_t fit = std::min(count, (capacity - kHeaderSize) / kEventSize);
+        const RfTraceEvent* first = events + (count - fit);
+
+        uint8_t* p = out;
+        memcpy(p, "RFTR", 4);
+        p += 4;
+        *p++ = kVersion;
+        *p++ = kEventSize;
+        p = Put(p, 0, 2);
+        p = Put(p, fit, 4);
+        p = Put(p, now, 4);
+        for (size_t i = 0; i < fit; i++) {
+            p = Put(p, first[i].timestamp, 4);
+            *p++ = first[i].type;
+            *p++ = first[i].channel;
+            p = Put(p, first[i].arg16, 2);
+            p = Put(p, first[i].arg32, 4);
+        }
+        return p - out;
+    }
+
+    // For transports that carry text, e.g. the self.rf.dump_trace MCP tool
+    static std::string Base64(const uint8_t* data, size_t size) {
+        static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string text;
+        text.reserve((size + 2) / 3 * 4);
+        for (size_t i = 0; i < size; i += 3) {
+            const uint32_t chunk = (data[i] << 16) | (i + 1 < size ? data[i + 1] << 8 : 0) |
+                                   (i + 2 < size ? data[i + 2] : 0);
+            text += kAlphabet[(chunk >> 18) & 0x3F];
+            text += kAlphabet[(chunk >> 12) & 0x3F];
+            text += i + 1 < size ? kAlphabet[(chunk >> 6) & 0x3F] : '=';
+            text += i + 2 < size ? kAlphabet[chunk & 0x3F] : '=';
+        }
+        return text;
+    }
+
+private:
+    static uint8_t* Put(uint8_t* p, uint32_t value, size_t bytes) {
+        for (size_t i = 0; i < bytes; i++) {
+            *p++ = static_cast<uint8_t>(value >> (8 * i));
+        }
+        return p;
+    }
+};
+
+#endif // RF_TRACE_H
@@ -0,0 +1,107 @@
+#ifndef RF_TX_QUEUE_H
+#define RF_TX_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <utility>
+
+/**
+ * Bounded priority queue for transmit jobs
+ *
+ * A binary heap over a fixed array: the highest priority comes out first,
+ * and jobs of equal priority keep their submission order (a push counter
+ * breaks ties). Push() fails when full instead of evicting anything, so
+ * the submitter knows its job was not taken. No locking; the owner
+ * serialises access.
+ *
+ * Pure C++ with no ESP-IDF dependency, like RfRawCode.
+ */
+template <typename T>
+class RfTxQueue {
+public:
+    RfTxQueue() : entries_(nullptr), capacity_(0), size_(0), next_sequence_(0) {}
+    ~RfTxQueue() { delete[] entries_; }
+    RfTxQueue(const RfTxQueue&) = delete;
+    RfTxQueue& operator=(const RfTxQueue&) = delete;
+
+    void Reset(size_t capacity) {
+        delete[] entries_;
+        entries_ = capacity > 0 ? new Entry[capacity] : nullptr;
+        capacity_ = capacity;
+        size_ = 0;
+    }
+
+    size_t Size() const { return size_; }
+    size_t Capacity() const { return capacity_; }
+    bool Empty() const { return size_ == 0; }
+    bool Full() const { return size_ >= capacity_; }
+
+    bool Push(const T& item, uint8_t priority) {
+        if (Full()) {
+            return false;
+        }
+        size_t position = size_++;
+        entries_[position].item = item;
+        entries_[position].priority = priority;
+        entries_[position].sequence = next_sequence_++;
+        while (position > 0) {
+            const size_t parent = (position - 1) / 2;
+            if (!Before(entries_[position], entries_[parent])) {
+                break;
+            }
+            std::swap(entries_[position], entries_[parent]);
+            position = parent;
+        }
+        return true;
+    }
+
+    bool Pop(T& item) {
+        if (size_ == 0) {
+            return false;
+        }
+        item = entries_[0].item;
+        if (--size_ == 0) {
+            return true;
+        }
+        entries_[0] = entries_[size_];
+        size_t position = 0;
+        for (;;) {
+            const size_t left = position * 2 + 1;
+            const size_t right = left + 1;
+            size_t first = position;
+            if (left < size_ && Before(entries_[left], entries_[first])) {
+                first = left;
+            }
+            if (right < size_ && Before(entries_[right], entries_[first])) {
+                first = right;
+            }
+            if (first == position) {
+                break;
+            }
+            std::swap(entries_[position], entries_[first]);
+            position = first;
+        }
+        return true;
+    }
+
+private:
+    struct Entry {
+        T item;
+        uint8_t priority;
+        uint32_t sequence;  // Submission order, wraps
+    };
+
+    static bool Before(const Entry& a, const Entry& b) {
+        if (a.priority != b.priority) {
+            return a.priority > b.priority;
+        }
+        return static_cast<int32_t>(a.sequence - b.sequence) < 0;
+    }
+
+    Entry* entries_;
+    size_t capacity_;
+    size_t size_;
+    uint32_t next_sequence_;
+};
+
+#endif // RF_TX_QUEUE_H
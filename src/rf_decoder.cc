@@ -0,0 +1,403 @@
+#include "rf_decoder.h"
+#include <string.h>
+
+// Helper function for ReceiveProtocol
+static inline unsigned int diff(int A, int B) {
+    return (A > B) ? (A - B) : (B - A);
+}
+
+RfDecoder::RfDecoder(const RfProtocolRegistry& registry, uint32_t protocol_mask)
+    : registry_(registry),
+      protocol_mask_(protocol_mask),
+      generation_(0),
+      enabled_mask_(0),
+      protocol_count_(0),
+      hits_since_decay_(0),
+      receive_tolerance_(60),
+      confirm_repeat_(false),
+      metrics_(nullptr),
+      trace_(nullptr),
+      frame_level_(1),
+      raw_capture_(false),
+      raw_ready_(false) {
+    memset(hits_, 0, sizeof(hits_));
+    Reload();
+    Reset();
+}
+
+// Rebuild the per-protocol shapes after the registry changed. Protocols that
+// stay enabled keep their place in order_, new ones are appended.
+void RfDecoder::Reload() {
+    RfProtocol table[kMaxProtocols];
+    uint32_t enabled;
+    uint32_t generation;
+    if (!registry_.TrySnapshot(table, enabled, generation)) {
+        return;  // Writer busy, keep the current set and retry on the next frame
+    }
+    generation_ = generation;
+    enabled &= protocol_mask_;
+    
+    for (unsigned int i = 0; i < kMaxProtocols; i++) {
+        if (!(enabled & (1UL << i))) {
+            hits_[i] = 0;
+            continue;
+        }
+        const RfProtocol& pro = table[i];
+        Shape& shape = shapes_[i];
+        shape.sync_length = ((pro.syncFactor.low) > (pro.syncFactor.high)) ? (pro.syncFactor.low) : (pro.syncFactor.high);
+        if (shape.sync_length == 0) {
+            shape.sync_length = 1;
+        }
+        // floor(t / n) == (t * ceil(2^32 / n)) >> 32 for every t < 2^24 and n < 256
+        shape.sync_reciprocal = ((0xFFFFFFFFULL / shape.sync_length) + 1);
+        shape.zero_high = pro.zero.high;
+        shape.zero_low = pro.zero.low;
+        shape.one_high = pro.one.high;
+        shape.one_low = pro.one.low;
+        shape.first_timing = (pro.invertedSignal) ? (2) : (1);
+    }
+    
+    unsigned int count = 0;
+    for (unsigned int rank = 0; rank < protocol_count_; rank++) {
+        if (enabled & (1UL << (order_[rank] - 1))) {
+            order_[count++] = order_[rank];
+        }
+    }
+    const uint32_t added = enabled & ~enabled_mask_;
+    for (unsigned int i = 0; i < kMaxProtocols; i++) {
+        if (added & (1UL << i)) {
+            order_[count++] = i + 1;
+        }
+    }
+    protocol_count_ = count;
+    enabled_mask_ = enabled;
+}
+
+void RfDecoder::Reset() {
+    last_time_ = 0;
+    change_count_ = 0;
+    alive_ = 0;
+    burst_open_ = false;
+    burst_value_ = 0;
+    burst_bitlength_ = 0;
+    burst_protocol_ = 0;
+    burst_frames_ = 0;
+    memset(timings_, 0, sizeof(timings_));
+    raw_ready_ = false;
+    raw_frame_.Clear();
+    raw_previous_.Clear();
+}
+
+void RfDecoder::SetRawCapture(bool enabled) {
+    if (raw_capture_ == enabled) {
+        return;
+    }
+    raw_capture_ = enabled;
+    raw_ready_ = false;
+    raw_previous_.Clear();
+}
+
+bool RfDecoder::PopRawFrame(RfRawCode& raw) {
+    if (!raw_ready_) {
+        return false;
+    }
+    raw = raw_frame_;
+    raw_ready_ = false;
+    return true;
+}
+
+bool RfDecoder::ProcessEdge(uint32_t timestamp, uint8_t level, RfDecodedFrame& frame) {
+    // Unsigned subtraction keeps durations correct across timestamp wrap-around
+    unsigned int duration = timestamp - last_time_;
+    last_time_ = timestamp;
+    
+    if (duration > kSeparationLimit) {
+        // The gap ends the frame in timings_ and leads the next one
+        const bool decoded = EndFrame(duration, frame);
+        if (decoded) {
+            frame.timestamp = timestamp;
+        }
+        BeginFrame(duration, level);
+        return decoded;
+    }
+    
+    // Detect overflow
+    if (change_count_ >= (raw_capture_ ? kMaxRawChanges : kMaxChanges)) {
+        RF_METRIC(metrics_, overflows.Add());
+        RF_TRACE(trace_, rx.Record(timestamp, RF_TRACE_OVERFLOW, trace_->channel, change_count_, 0));
+        change_count_ = 0;
+        alive_ = 0;
+        burst_open_ = false;
+    }
+    
+    timings_[change_count_++] = duration;
+    if (alive_ != 0) {
+        if (change_count_ > kMaxChanges) {
+            alive_ = 0;  // Longer than any code, only raw capture still wants it
+        } else {
+            ClassifyPair();
+        }
+    }
+    return false;
+}
+
+// Sets up every enabled protocol against the sync that leads the frame
+void RfDecoder::BeginFrame(unsigned int gap, uint8_t level) {
+    change_count_ = 0;
+    frame_level_ = level;
+    timings_[change_count_++] = gap;
+    
+    if (registry_.Generation() != generation_) {
+        Reload();
+    }
+    alive_ = 0;
+    for (unsigned int rank = 0; rank < protocol_count_; rank++) {
+        SetupCandidate(rank);
+        alive_ |= 1UL << rank;
+    }
+}
+
+// Called once per edge: the timing just stored may complete a bit pair. Bit pair
+// k sits at timings_[first_timing + 2k]; inverted protocols start one timing later.
+void RfDecoder::ClassifyPair() {
+    const unsigned int last = change_count_ - 1;
+    uint32_t pending = alive_;
+    while (pending != 0) {
+        const unsigned int rank = __builtin_ctz(pending);
+        pending &= pending - 1;
+        Candidate& c = candidates_[rank];
+        if (last <= c.first_timing || ((last - c.first_timing) & 1) == 0) {
+            continue;  // First half of a pair (or the sync before the first one)
+        }
+        if (!ShiftBit(c, last - 1)) {
+            alive_ &= ~(1UL << rank);
+        }
+    }
+}
+
+// The gap that just ended is the frame's trailing sync. Returns true when the
+// frame is to be reported (see SetConfirmRepeat()).
+bool RfDecoder::EndFrame(unsigned int gap, RfDecodedFrame& frame) {
+    const unsigned int change_count = change_count_;
+    const unsigned int lead = timings_[0];
+    bool decoded = false;
+    bool calibrated_on_trailing = false;
+    if (change_count > 7 && change_count <= kMaxChanges) {
+        if (alive_ != 0) {
+            // Lowest rank = most frequently seen protocol among the survivors
+            decoded = Accept(__builtin_ctz(alive_), change_count, frame);
+        } else if (diff(gap, lead) >= kRepeatGapTolerance) {
+            // Led by idle time or noise instead of a sync: time the bits against the trailing one
+            timings_[0] = gap;
+            decoded = Decode(change_count, frame);
+            calibrated_on_trailing = decoded;
+        }
+    }
+    alive_ = 0;
+    
+    if (change_count > 7) {
+        CountMisses(decoded ? frame.protocol : 0);
+    }
+    if (!decoded) {
+        if (change_count > 7) {
+            RF_TRACE(trace_, rx.Record(last_time_, RF_TRACE_DECODE_FAILED, trace_->channel, change_count, gap));
+        }
+        if (raw_capture_ && change_count <= kMaxRawChanges) {
+            CaptureRaw(change_count, gap);
+        }
+        if (change_count > 7) {
+            burst_open_ = false;
+        }
+        return false;  // Shorter runs, like the lone sync pulse between two sync gaps, leave the press open
+    }
+    
+    const bool repeat = burst_open_ && frame.value == burst_value_ &&
+                        frame.bitlength == burst_bitlength_ && frame.protocol == burst_protocol_;
+    RF_METRIC(metrics_, frames_decoded.Add());
+    if (!repeat) {
+        burst_value_ = frame.value;
+        burst_bitlength_ = frame.bitlength;
+        burst_protocol_ = frame.protocol;
+        burst_frames_ = 0;
+    }
+    burst_frames_++;
+    // A trailing gap much longer than the leading sync is idle time: the press is over
+    burst_open_ = calibrated_on_trailing || diff(gap, lead) < kRepeatGapTolerance;
+    const bool report = confirm_repeat_ ? (burst_frames_ % 2) == 0 : (burst_frames_ % 2) == 1;
+    if (report) {
+        RF_METRIC(metrics_, frames_reported.Add());
+    }
+    RF_TRACE(trace_, rx.Record(last_time_, RF_TRACE_FRAME, trace_->channel,
+                               (frame.protocol & 0xFF) | (frame.bitlength & 0x7F) << 8 | (report ? 0x8000 : 0),
+                               static_cast<uint32_t>(frame.value)));
+    return report;
+}
+
+// Metrics for a frame long enough to be one: every enabled protocol but the winner (0 = none) lost it
+void RfDecoder::CountMisses(unsigned int winner) {
+#if CONFIG_RF_MODULE_ENABLE_METRICS
+    if (metrics_ == nullptr) {
+        return;
+    }
+    if (winner == 0) {
+        metrics_->decode_failures.Add();
+    }
+    for (unsigned int rank = 0; rank < protocol_count_; rank++) {
+        if (order_[rank] != winner) {
+            metrics_->protocol_misses[order_[rank] - 1].Add();
+        }
+    }
+#else
+    (void)winner;
+#endif
+}
+
+bool RfDecoder::Decode(unsigned int change_count, RfDecodedFrame& frame) {
+    // ignore very short transmissions: no device sends them, so this must be noise
+    if (change_count <= 7) return false;
+    
+    if (registry_.Generation() != generation_) {
+        Reload();
+    }
+    if (protocol_count_ == 0) return false;
+    
+    // The protocol with the best recent hit rate usually matches, so walk it on
+    // its own first; if it wins nothing else needs to be looked at
+    SetupCandidate(0);
+    if (FinishCandidate(candidates_[0], 0, change_count)) {
+        return Accept(0, change_count, frame);
+    }
+    
+    // Otherwise set up the remaining protocols and walk timings_[] a single
+    // time, dropping candidates at their first mismatching bit pair
+    uint32_t alive = 0;
+    for (unsigned int rank = 1; rank < protocol_count_; rank++) {
+        SetupCandidate(rank);
+        alive |= 1UL << rank;
+    }
+    
+    // Bit pair k sits at timings_[first_timing + 2k]; inverted protocols start
+    // one timing later and run out of pairs first
+    for (unsigned int k = 0; alive != 0; k++) {
+        uint32_t pending = alive;
+        while (pending != 0) {
+            const unsigned int rank = __builtin_ctz(pending);
+            pending &= pending - 1;
+            Candidate& c = candidates_[rank];
+            const unsigned int i = c.first_timing + 2 * k;
+            if (i >= change_count - 1) {
+                continue;  // Finished without a mismatch
+            }
+            if (!ShiftBit(c, i)) {
+                alive &= ~(1UL << rank);
+            }
+        }
+        if (2 * k + 1 >= change_count - 1) {
+            break;
+        }
+        // Usually a single protocol survives the first pair; finish it without the mask walk
+        if (alive != 0 && (alive & (alive - 1)) == 0) {
+            const unsigned int rank = __builtin_ctz(alive);
+            if (!FinishCandidate(candidates_[rank], k + 1, change_count)) {
+                alive = 0;
+            }
+            break;
+        }
+    }
+    
+    if (alive == 0) {
+        return false;
+    }
+    
+    // Lowest rank = most frequently seen protocol among the survivors
+    return Accept(__builtin_ctz(alive), change_count, frame);
+}
+
+void RfDecoder::SetupCandidate(unsigned int rank) {
+    const Shape& shape = shapes_[order_[rank] - 1];
+    Candidate& c = candidates_[rank];
+    // Assuming the longer pulse length is the pulse captured in timings[0]
+    const unsigned int sync = timings_[0];
+    c.delay = (sync < (1U << 24)) ? (unsigned int)((sync * shape.sync_reciprocal) >> 32)
+                                  : sync / shape.sync_length;
+    c.tolerance = c.delay * receive_tolerance_ / 100;
+    c.zero_high = c.delay * shape.zero_high;
+    c.zero_low = c.delay * shape.zero_low;
+    c.one_high = c.delay * shape.one_high;
+    c.one_low = c.delay * shape.one_low;
+    c.first_timing = shape.first_timing;
+    c.code = 0;
+}
+
+bool RfDecoder::Accept(unsigned int rank, unsigned int change_count, RfDecodedFrame& frame) {
+    const Candidate& c = candidates_[rank];
+    frame.value = c.code;
+    frame.bitlength = (change_count - 1) / 2;
+    frame.delay = c.delay;
+    frame.protocol = order_[rank];
+    RecordHit(rank);
+    return true;
+}
+
+// timings_[0] is the gap before the frame; the gap that just ended it is
+// stored as the trailing entry so replay keeps the original spacing
+void RfDecoder::CaptureRaw(unsigned int change_count, unsigned int gap) {
+    if (change_count < 2) {
+        return;
+    }
+    raw_previous_ = raw_frame_;
+    if (!raw_frame_.Quantise(&timings_[1], change_count - 1, gap, frame_level_)) {
+        return;
+    }
+    if (!raw_previous_.Empty() && raw_frame_.Matches(raw_previous_)) {
+        raw_ready_ = true;
+    }
+}
+
+bool RfDecoder::FinishCandidate(Candidate& c, unsigned int k, unsigned int change_count) const {
+    for (unsigned int i = c.first_timing + 2 * k; i < change_count - 1; i += 2) {
+        if (!ShiftBit(c, i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Appends the bit whose pair starts at timings_[i]; false if the pair is neither a zero nor a one
+bool RfDecoder::ShiftBit(Candidate& c, unsigned int i) const {
+    c.code <<= 1;
+    if (diff(timings_[i], c.zero_high) < c.tolerance &&
+        diff(timings_[i + 1], c.zero_low) < c.tolerance) {
+        // zero bit
+        return true;
+    }
+    if (diff(timings_[i], c.one_high) < c.tolerance &&
+        diff(timings_[i + 1], c.one_low) < c.tolerance) {
+        // one bit
+        c.code |= 1;
+        return true;
+    }
+    return false;
+}
+
+void RfDecoder::RecordHit(unsigned int rank) {
+    const unsigned int p = order_[rank];
+    if (hits_[p - 1] < UINT16_MAX - 16) {
+        hits_[p - 1] += 16;
+    }
+    
+    // Age the scores so the order follows what is on the air now
+    if (++hits_since_decay_ >= 64) {
+        hits_since_decay_ = 0;
+        for (unsigned int i = 0; i < protocol_count_; i++) {
+            hits_[order_[i] - 1] >>= 1;
+        }
+    }
+    
+    // Move the winner up past protocols with a lower score
+    while (rank > 0 && hits_[order_[rank - 1] - 1] < hits_[p - 1]) {
+        order_[rank] = order_[rank - 1];
+        rank--;
+    }
+    order_[rank] = p;
+}
@@ -1,27 +1,81 @@
 #include "rf_module.h"
-#include "rcswitch.h"
-#include "tcswitch.h"
+#include "rf_radio_channel.h"
 #include <esp_log.h>
 #include <driver/gpio.h>
 #include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <esp_partition.h>
 #include <cstring>
-#include <sstream>
-#include <iomanip>
 #include <algorithm>
 
 #include <nvs.h>  // NVS available on all ESP32 series chips
 
 #define TAG "RFModule"
 
+static_assert(RfDecoder::kMaxCodeBits == RFSignal::kMaxCodeBits, "Decoded codes must fit RFSignal");
+
+// RfSignalLog on a flash data partition
+class RfPartitionMedium : public RfLogMedium {
+public:
+    explicit RfPartitionMedium(const esp_partition_t* partition) : partition_(partition) {}
+    size_t Size() const override { return partition_->size; }
+    size_t SectorSize() const override { return partition_->erase_size; }
+    bool Read(size_t offset, void* data, size_t size) const override {
+        return esp_partition_read(partition_, offset, data, size) == ESP_OK;
+    }
+    bool Write(size_t offset, const void* data, size_t size) override {
+        return esp_partition_write(partition_, offset, data, size) == ESP_OK;
+    }
+    bool EraseSector(size_t offset) override {
+        return esp_partition_erase_range(partition_, offset, partition_->erase_size) == ESP_OK;
+    }
+
+private:
+    const esp_partition_t* partition_;
+};
+
+// Holds RFModule::flash_lock_ for a scope
+class FlashLockGuard {
+public:
+    explicit FlashLockGuard(SemaphoreHandle_t lock) : lock_(lock) { xSemaphoreTake(lock_, portMAX_DELAY); }
+    ~FlashLockGuard() { xSemaphoreGive(lock_); }
+    FlashLockGuard(const FlashLockGuard&) = delete;
+    FlashLockGuard& operator=(const FlashLockGuard&) = delete;
+
+private:
+    SemaphoreHandle_t lock_;
+};
+
 RFModule::RFModule(gpio_num_t tx433_pin, gpio_num_t rx433_pin,
                    gpio_num_t tx315_pin, gpio_num_t rx315_pin)
-    : tx433_pin_(tx433_pin), rx433_pin_(rx433_pin),
-      tx315_pin_(tx315_pin), rx315_pin_(rx315_pin),
-      rc_switch_(nullptr), tc_switch_(nullptr),
+    : RFModule(nullptr, 0) {
+    RfChannelConfig channels[kBandCount];
+    size_t count = 0;
+#if CONFIG_RF_MODULE_ENABLE_433MHZ
+    channels[count++] = { RF_433MHZ, 0, tx433_pin, rx433_pin };
+#else
+    (void)tx433_pin;
+    (void)rx433_pin;
+#endif // CONFIG_RF_MODULE_ENABLE_433MHZ
+#if CONFIG_RF_MODULE_ENABLE_315MHZ
+    channels[count++] = { RF_315MHZ, 0, tx315_pin, rx315_pin };
+#else
+    (void)tx315_pin;
+    (void)rx315_pin;
+#endif // CONFIG_RF_MODULE_ENABLE_315MHZ
+    SetChannels(channels, count);
+}
+
+RFModule::RFModule(const RfChannelConfig* channels, size_t count)
+    : channels_(nullptr), channel_count_(0),
       current_frequency_(RF_433MHZ),
-      repeat_count_433_(3), repeat_count_315_(3),
-      protocol_433_(1), protocol_315_(1),
-      pulse_length_433_(320), pulse_length_315_(320),
+      tx_lock_(nullptr),
+      tx_slots_(nullptr),
+      tx_task_(nullptr),
+      tx_stopping_(false),
+      tx_stopped_(nullptr),
+      tx_next_handle_(1),
+      last_tx_airtime_us_(0),
       send_count_(0), receive_count_(0),
       receive_callback_(nullptr),
       replay_buffer_enabled_(false),
@@ -29,18 +83,80 @@ RFModule::RFModule(gpio_num_t tx433_pin, gpio_num_t rx433_pin,
       replay_buffer_size_(0),
       replay_buffer_index_(0),
       replay_buffer_count_(0),
-      capture_mode_(false), has_captured_signal_(false),
-      receive_enabled_433_(true), receive_enabled_315_(true),
+      capture_mode_(false), raw_capture_(false), has_captured_signal_(false),
+      rx_event_group_(nullptr),
+      merge_valid_(false), merge_channel_(0), merge_band_(RF_433MHZ),
+      merge_bit_length_(0), merge_code_(0), merge_timestamp_(0),
       flash_storage_enabled_(false),
       nvs_handle_(0),
       flash_namespace_("rf_replay"),
-      flash_signal_count_(0),
-      flash_signal_index_(0),
+      flash_mirror_(nullptr),
+      flash_code_copies_(0),
+      log_medium_(nullptr),
+      flash_log_active_(false),
+      flash_lock_(nullptr),
+      compaction_task_(nullptr),
+      compaction_stopping_(false),
+      compaction_stopped_(nullptr),
+      persist_queue_(nullptr),
+      persist_task_(nullptr),
+      persist_batch_(nullptr),
+      persist_failed_(false),
+      flash_trace_(nullptr),
+      flash_loading_(false),
       enabled_(false) {
+    for (size_t band = 0; band < kBandCount; band++) {
+        bands_[band].repeat_count = 3;
+        bands_[band].protocol = 1;
+        bands_[band].pulse_length = 320;
+        bands_[band].receive_enabled = true;
+    }
+    SetChannels(channels, count);
+#if CONFIG_RF_MODULE_ENABLE_TRACE
+    flash_trace_ = new RfTraceRing<kFlashTraceEvents>();
+#endif
 }
 
 RFModule::~RFModule() {
     End();
+    delete[] channels_;
+    delete flash_trace_;
+}
+
+void RFModule::SetChannels(const RfChannelConfig* channels, size_t count) {
+    if (count > kMaxChannels) {
+        ESP_LOGW(TAG, "Only the first %d of %d channels are used", (int)kMaxChannels, (int)count);
+        count = kMaxChannels;
+    }
+    delete[] channels_;
+    channels_ = count > 0 ? new Channel[count] : nullptr;
+    channel_count_ = count;
+    for (size_t i = 0; i < count; i++) {
+        channels_[i].config = channels[i];
+        channels_[i].radio = nullptr;
+        channels_[i].receive_enabled = true;
+        channels_[i].sent = 0;
+        channels_[i].received = 0;
+        channels_[i].merged = 0;
+    }
+}
+
+// Bands disabled in Kconfig have no RadioChannel instantiation at all
+RfRadioChannel* RFModule::CreateRadio(RFFrequency band) {
+    if (band == RF_315MHZ) {
+#if CONFIG_RF_MODULE_ENABLE_315MHZ
+        return new RadioChannel<RF_315MHZ, CONFIG_RF_MODULE_PROTOCOLS_315>();
+#else
+        ESP_LOGW(TAG, "315MHz frequency support is disabled");
+        return nullptr;
+#endif // CONFIG_RF_MODULE_ENABLE_315MHZ
+    }
+#if CONFIG_RF_MODULE_ENABLE_433MHZ
+    return new RadioChannel<RF_433MHZ, CONFIG_RF_MODULE_PROTOCOLS_433>();
+#else
+    ESP_LOGW(TAG, "433MHz frequency support is disabled");
+    return nullptr;
+#endif // CONFIG_RF_MODULE_ENABLE_433MHZ
 }
 
 void RFModule::Begin() {
@@ -49,902 +165,2090 @@ void RFModule::Begin() {
         return;
     }
     
-#if CONFIG_RF_MODULE_ENABLE_433MHZ
-    // Initialize 433MHz TX pin
-    gpio_set_direction(tx433_pin_, GPIO_MODE_OUTPUT);
-    gpio_set_level(tx433_pin_, 0);
-    
-    // Initialize RCSwitch (433MHz)
-    if (rc_switch_ == nullptr) {
-        rc_switch_ = new RCSwitch();
-        rc_switch_->enableTransmit(static_cast<int>(tx433_pin_));
-        rc_switch_->setProtocol(protocol_433_);
-        rc_switch_->setPulseLength(pulse_length_433_);
-        rc_switch_->setRepeatTransmit(repeat_count_433_);
-        
-        if (receive_enabled_433_) {
-            rc_switch_->enableReceive(static_cast<int>(rx433_pin_));
-        }
+    if (rx_event_group_ == nullptr) {
+        rx_event_group_ = xEventGroupCreate();
     }
-#endif // CONFIG_RF_MODULE_ENABLE_433MHZ
     
-#if CONFIG_RF_MODULE_ENABLE_315MHZ
-    // Initialize 315MHz TX pin
-    gpio_set_direction(tx315_pin_, GPIO_MODE_OUTPUT);
-    gpio_set_level(tx315_pin_, 0);
-    
-    // Initialize TCSwitch (315MHz)
-    if (tc_switch_ == nullptr) {
-        tc_switch_ = new TCSwitch();
-        tc_switch_->enableTransmit(static_cast<int>(tx315_pin_));
-        tc_switch_->setProtocol(protocol_315_);
-        tc_switch_->setPulseLength(pulse_length_315_);
-        tc_switch_->setRepeatTransmit(repeat_count_315_);
+    for (uint8_t i = 0; i < channel_count_; i++) {
+        Channel& channel = channels_[i];
+        if (channel.radio != nullptr) {
+            continue;
+        }
+        channel.radio = CreateRadio(channel.config.band);
+        if (channel.radio == nullptr) {
+            continue;
+        }
+        channel.radio->setTraceChannel(i);
+        
+        const BandSettings& settings = bands_[BandIndex(channel.config.band)];
+        if (channel.config.tx_pin != GPIO_NUM_NC) {
+            channel.radio->enableTransmit(static_cast<int>(channel.config.tx_pin));
+        }
+        channel.radio->setProtocol(settings.protocol);
+        channel.radio->setPulseLength(settings.pulse_length);
+        channel.radio->setRepeatTransmit(settings.repeat_count);
+        channel.radio->setFrameNotify(rx_event_group_, RX_FRAME_BIT);
+        channel.radio->setRawCapture(raw_capture_);
         
-        if (receive_enabled_315_) {
-            tc_switch_->enableReceive(static_cast<int>(rx315_pin_));
+        if (IsReceivingChannel(channel)) {
+            channel.radio->enableReceive(static_cast<int>(channel.config.rx_pin));
         }
+        ESP_LOGI(TAG, "Channel %d: %sMHz, antenna %d, TX=%d, RX=%d", i, BandName(channel.config.band),
+                 channel.config.antenna, channel.config.tx_pin, channel.config.rx_pin);
     }
-#endif // CONFIG_RF_MODULE_ENABLE_315MHZ
     
     enabled_ = true;
     ResetCounters();
+    merge_valid_ = false;
+    StartTxTask();
     
 #if CONFIG_RF_MODULE_ENABLE_FLASH_STORAGE
     // Enable flash storage and load saved signal
     EnableFlashStorage("rf_replay");
     ESP_LOGI(TAG, "[闪存] Flash storage enabled: enabled=%d, handle=%lu", 
             flash_storage_enabled_, (unsigned long)nvs_handle_);
+    LoadProtocolsFromFlash();
     LoadFromFlash();  // Load the last saved signal
     ESP_LOGI(TAG, "[闪存] After LoadFromFlash: count=%d, has_signal=%d", 
-            flash_signal_count_, has_captured_signal_);
+            GetFlashSignalCount(), has_captured_signal_);
 #endif // CONFIG_RF_MODULE_ENABLE_FLASH_STORAGE
     
-    ESP_LOGI(TAG, "RF module initialized: TX433=%d, RX433=%d, TX315=%d, RX315=%d",
-             tx433_pin_, rx433_pin_, tx315_pin_, rx315_pin_);
+    ESP_LOGI(TAG, "RF module initialized: %d channels", channel_count_);
 }
 
 void RFModule::End() {
     if (!enabled_) {
+        if (FlashStorageActive()) {
+            DisableFlashStorage();  // Enabled by hand without Begin()
+        }
         return;
     }
     
-#if CONFIG_RF_MODULE_ENABLE_433MHZ
-    if (rc_switch_ != nullptr) {
-        rc_switch_->disableReceive();
-        delete rc_switch_;
-        rc_switch_ = nullptr;
+    StopTxTask();
+    
+    for (uint8_t i = 0; i < channel_count_; i++) {
+        Channel& channel = channels_[i];
+        if (channel.radio != nullptr) {
+            channel.radio->disableReceive();
+            delete channel.radio;
+            channel.radio = nullptr;
+        }
     }
-#endif // CONFIG_RF_MODULE_ENABLE_433MHZ
     
-#if CONFIG_RF_MODULE_ENABLE_315MHZ
-    if (tc_switch_ != nullptr) {
-        tc_switch_->disableReceive();
-        delete tc_switch_;
-        tc_switch_ = nullptr;
+    if (rx_event_group_ != nullptr) {
+        vEventGroupDelete(rx_event_group_);
+        rx_event_group_ = nullptr;
     }
-#endif // CONFIG_RF_MODULE_ENABLE_315MHZ
     
     // Cleanup replay buffer
     DisableReplayBuffer();
     
-#if CONFIG_RF_MODULE_ENABLE_FLASH_STORAGE
-    DisableFlashStorage();
-#endif // CONFIG_RF_MODULE_ENABLE_FLASH_STORAGE
+    // Begin() enables storage only when the option is on, but a caller may enable it by hand
+    if (FlashStorageActive()) {
+        DisableFlashStorage();
+    }
     
     enabled_ = false;
     ESP_LOGI(TAG, "RF module disabled");
 }
 
 void RFModule::Send(const std::string& address, const std::string& key, RFFrequency freq) {
+    // 十六进制地址码 = 编码：6位为24位，每多1位多4位，最多16位（64位编码）
+    // 按键值不参与编码，与接收时的格式一致
+    (void)key;
+    Send(ManualSignal(address, freq));
+}
+
+RfTxHandle RFModule::SendAsync(const std::string& address, const std::string& key, RFFrequency freq,
+                               uint8_t priority) {
+    (void)key;
+    return SendAsync(ManualSignal(address, freq), priority);
+}
+
+RFSignal RFModule::ManualSignal(const std::string& address, RFFrequency freq) const {
+    // Use global default configuration for manual send
+    const BandSettings& settings = bands_[BandIndex(freq)];
+    RFSignal signal;
+    const size_t digits = std::min(address.size(), static_cast<size_t>(RFSignal::kMaxCodeBits / 4));
+    signal.code = HexToUint64(address.c_str(), digits);
+    signal.bit_length = std::max(static_cast<uint16_t>(digits * 4), static_cast<uint16_t>(24));
+    signal.frequency = freq;
+    signal.protocol = settings.protocol;
+    signal.pulse_length = settings.pulse_length;
+    return signal;
+}
+
+void RFModule::Send(const RFSignal& signal) {
     if (!enabled_) {
         ESP_LOGW(TAG, "RF module not enabled");
         return;
     }
     
-    send_count_++;
-    
-    if (freq == RF_315MHZ) {
-#if CONFIG_RF_MODULE_ENABLE_315MHZ
-        // Use global default configuration for manual send
-        SendSignalTCSwitch(address, key, pulse_length_315_, protocol_315_);
-#else
-        ESP_LOGE(TAG, "315MHz frequency support is disabled");
-#endif // CONFIG_RF_MODULE_ENABLE_315MHZ
-    } else {
-#if CONFIG_RF_MODULE_ENABLE_433MHZ
-        // Use global default configuration for manual send
-        SendSignalRCSwitch(address, key, pulse_length_433_, protocol_433_);
-#else
-        ESP_LOGE(TAG, "433MHz frequency support is disabled");
-#endif // CONFIG_RF_MODULE_ENABLE_433MHZ
+    const int channel = FindTransmitChannel(signal.frequency);
+    if (channel < 0) {
+        ESP_LOGE(TAG, "[%sMHz发送] 没有可用的发送通道", BandName(signal.frequency));
+        return;
     }
+    SendOnChannels(signal, 1UL << channel);
 }
 
-void RFModule::Send(const RFSignal& signal) {
+bool RFModule::SendOnChannels(const RFSignal& signal, uint32_t channel_mask) {
+    RfTxResult result = {};
+    return SubmitTx(signal, channel_mask, 0, nullptr, nullptr, &result) != 0 && result.sent;
+}
+
+RfTxHandle RFModule::SendAsync(const RFSignal& signal, uint8_t priority, RfTxCallback callback, void* context) {
+    const int channel = FindTransmitChannel(signal.frequency);
+    if (channel < 0) {
+        ESP_LOGE(TAG, "[%sMHz发送] 没有可用的发送通道", BandName(signal.frequency));
+        return 0;
+    }
+    return SubmitTx(signal, 1UL << channel, priority, callback, context, nullptr);
+}
+
+RfTxHandle RFModule::SendAsync(const RFSignal& signal, uint32_t channel_mask, uint8_t priority,
+                               RfTxCallback callback, void* context) {
+    return SubmitTx(signal, channel_mask, priority, callback, context, nullptr);
+}
+
+size_t RFModule::GetTxQueueDepth() const {
+    if (tx_lock_ == nullptr) {
+        return 0;
+    }
+    xSemaphoreTake(tx_lock_, portMAX_DELAY);
+    const size_t depth = tx_queue_.Size();
+    xSemaphoreGive(tx_lock_);
+    return depth;
+}
+
+bool RFModule::TxQueued() const {
+    return tx_task_ != nullptr && xTaskGetCurrentTaskHandle() != tx_task_;
+}
+
+// wait_result != nullptr: block until the job is done (synchronous send)
+RfTxHandle RFModule::SubmitTx(const RFSignal& signal, uint32_t channel_mask, uint8_t priority,
+                              RfTxCallback callback, void* context, RfTxResult* wait_result) {
     if (!enabled_) {
         ESP_LOGW(TAG, "RF module not enabled");
-        return;
+        return 0;
     }
     
-    send_count_++;
-    
-    // 直接使用信号中保存的参数发送，确保脉冲长度和协议正确
-    if (signal.frequency == RF_315MHZ) {
-#if CONFIG_RF_MODULE_ENABLE_315MHZ
-        SendSignalTCSwitch(signal.address, signal.key, signal.pulse_length, signal.protocol);
-#else
-        ESP_LOGE(TAG, "315MHz frequency support is disabled");
-#endif // CONFIG_RF_MODULE_ENABLE_315MHZ
-    } else {
-#if CONFIG_RF_MODULE_ENABLE_433MHZ
-        SendSignalRCSwitch(signal.address, signal.key, signal.pulse_length, signal.protocol);
-#else
-        ESP_LOGE(TAG, "433MHz frequency support is disabled");
-#endif // CONFIG_RF_MODULE_ENABLE_433MHZ
+    TxJob job;
+    job.signal = signal;
+    if (signal.type == RF_SIGNAL_RAW) {
+        const RfRawCode* raw = raw_pool_.Get(signal.raw_handle);
+        if (raw == nullptr) {
+            ESP_LOGE(TAG, "Raw signal has no timings");
+            return 0;
+        }
+        job.raw = *raw;
     }
+    job.channel_mask = channel_mask;
+    job.callback = callback;
+    job.context = context;
+    job.scene = nullptr;
+    return EnqueueTx(job, priority, wait_result);
 }
 
-bool RFModule::ReceiveAvailable() {
-    if (!enabled_) {
-        return false;
+// Runs the job at once without a TX task, otherwise queues it. A job that is not taken
+// (0 returned) has its scene freed here.
+RfTxHandle RFModule::EnqueueTx(TxJob& job, uint8_t priority, RfTxResult* wait_result) {
+    job.queued_at = esp_timer_get_time();
+    job.done = nullptr;
+    job.result = wait_result;
+    job.handle = tx_next_handle_.fetch_add(1, std::memory_order_relaxed);
+    if (job.handle == 0) {
+        job.handle = tx_next_handle_.fetch_add(1, std::memory_order_relaxed);  // 0 means "not queued"
     }
     
-#if CONFIG_RF_MODULE_ENABLE_433MHZ
-    // Check 433MHz interrupt receive
-    if (rc_switch_ != nullptr && receive_enabled_433_ && rc_switch_->available()) {
-        ESP_LOGI(TAG, "[433MHz接收] 检测到可用信号");
-        return true;
+    if (!TxQueued()) {
+        RunTxJob(job);
+        return job.handle;
     }
-#endif // CONFIG_RF_MODULE_ENABLE_433MHZ
     
-#if CONFIG_RF_MODULE_ENABLE_315MHZ
-    // Check 315MHz interrupt receive
-    if (tc_switch_ != nullptr && receive_enabled_315_ && tc_switch_->available()) {
-        ESP_LOGI(TAG, "[315MHz接收] 检测到可用信号");
-        return true;
+    // Asynchronous sends never wait for room, synchronous ones wait for the task
+    if (xSemaphoreTake(tx_slots_, wait_result != nullptr ? portMAX_DELAY : 0) != pdTRUE) {
+        ESP_LOGW(TAG, "[发送] 发送队列已满 (%d个任务)", (int)CONFIG_RF_MODULE_TX_QUEUE_LENGTH);
+        FreeScene(job.scene);
+        return 0;
+    }
+    if (wait_result != nullptr) {
+        job.done = xSemaphoreCreateBinary();
+        if (job.done == nullptr) {
+            xSemaphoreGive(tx_slots_);
+            FreeScene(job.scene);
+            return 0;
+        }
+    }
+    xSemaphoreTake(tx_lock_, portMAX_DELAY);
+    tx_queue_.Push(job, priority);  // Has room: tx_slots_ was taken
+    xSemaphoreGive(tx_lock_);
+    xTaskNotifyGive(tx_task_);
+    
+    if (job.done != nullptr) {
+        xSemaphoreTake(job.done, portMAX_DELAY);
+        vSemaphoreDelete(job.done);
+    }
+    return job.handle;
+}
+
+void RFModule::RunTxJob(const TxJob& job) {
+    const int64_t start = esp_timer_get_time();
+    RfTxResult result;
+    result.wait_us = static_cast<uint32_t>(start - job.queued_at);
+    if (job.scene != nullptr) {
+        result.sent = TransmitScene(*job.scene);
+    } else {
+        result.sent = job.channel_mask != 0 && TransmitOnChannels(job.signal, job.raw, job.channel_mask);
+    }
+    result.airtime_us = static_cast<uint32_t>(esp_timer_get_time() - start);
+    
+    // Only what was transmitted counts: a scene as its steps
+    if (result.sent && job.scene != nullptr) {
+        send_count_ += job.scene->step_count;
+        last_tx_airtime_us_ = result.airtime_us;
+        ESP_LOGI(TAG, "[场景] ✓ 发送完成: %d步 (通道:0x%lX, 空中时间:%lums, 排队:%lums)",
+                 (int)job.scene->step_count, (unsigned long)job.channel_mask,
+                 (unsigned long)(result.airtime_us / 1000), (unsigned long)(result.wait_us / 1000));
+    } else if (result.sent) {
+        send_count_++;
+        last_tx_airtime_us_ = result.airtime_us;
+        char address[RFSignal::kAddressHexSize];
+        job.signal.FormatAddress(address, sizeof(address));
+        ESP_LOGI(TAG, "[%sMHz发送] ✓ 发送完成: %s00 (通道:0x%lX, 空中时间:%lums, 排队:%lums)",
+                 BandName(job.signal.frequency), address,
+                 (unsigned long)job.channel_mask, (unsigned long)(result.airtime_us / 1000),
+                 (unsigned long)(result.wait_us / 1000));
     }
-#endif // CONFIG_RF_MODULE_ENABLE_315MHZ
     
-    return false;
+    if (job.result != nullptr) {
+        *job.result = result;
+    }
+    if (job.callback != nullptr) {
+        job.callback(job.handle, result, job.context);
+    }
+    FreeScene(job.scene);
+    if (job.done != nullptr) {
+        xSemaphoreGive(job.done);
+    }
 }
 
-bool RFModule::Receive(RFSignal& signal) {
+RfTxHandle RFModule::SendScene(const RfSceneStep* steps, size_t count, uint8_t priority,
+                               RfTxCallback callback, void* context) {
+    const RfRawCode* raws[RfSceneBuilder::kMaxSteps] = {};
+    for (size_t i = 0; i < count && i < RfSceneBuilder::kMaxSteps; i++) {
+        if (steps[i].signal.type == RF_SIGNAL_RAW) {
+            raws[i] = raw_pool_.Get(steps[i].signal.raw_handle);
+        }
+    }
+    return SubmitScene(steps, raws, count, priority, callback, context);
+}
+
+// Compiles the whole scene on the caller's thread, so the TX task only clocks out symbols
+RfTxHandle RFModule::SubmitScene(const RfSceneStep* steps, const RfRawCode* const* raws, size_t count,
+                                 uint8_t priority, RfTxCallback callback, void* context) {
     if (!enabled_) {
-        return false;
+        ESP_LOGW(TAG, "RF module not enabled");
+        return 0;
+    }
+    if (count == 0 || count > RfSceneBuilder::kMaxSteps) {
+        ESP_LOGE(TAG, "[场景] 步骤数无效: %d (1-%d)", (int)count, (int)RfSceneBuilder::kMaxSteps);
+        return 0;
     }
     
-#if CONFIG_RF_MODULE_ENABLE_433MHZ
-    // Check 433MHz interrupt receive
-    if (rc_switch_ != nullptr && receive_enabled_433_ && rc_switch_->available()) {
-        unsigned long value = rc_switch_->getReceivedValue();
-        unsigned int bitlength = rc_switch_->getReceivedBitlength();
-        unsigned int protocol = rc_switch_->getReceivedProtocol();
-        unsigned int delay = rc_switch_->getReceivedDelay();
-        
-        ESP_LOGI(TAG, "[433MHz接收] 原始值:0x%lX, 位长:%d, 协议:%d, 脉冲:%dμs", value, bitlength, protocol, delay);
+    uint8_t channels[RfSceneBuilder::kMaxSteps];
+    uint8_t repeats[RfSceneBuilder::kMaxSteps];
+    uint32_t channel_mask = 0;
+    size_t needed = 0;
+    for (size_t i = 0; i < count; i++) {
+        const RFSignal& signal = steps[i].signal;
+        const int channel = FindTransmitChannel(signal.frequency);
+        if (channel < 0) {
+            ESP_LOGE(TAG, "[场景] 第%d步: 没有可用的%sMHz发送通道", (int)i + 1, BandName(signal.frequency));
+            return 0;
+        }
+        if (signal.type == RF_SIGNAL_RAW && (raws[i] == nullptr || raws[i]->Empty())) {
+            ESP_LOGE(TAG, "[场景] 第%d步: 原始信号没有时序", (int)i + 1);
+            return 0;
+        }
+        if (signal.bit_length > RFSignal::kMaxCodeBits) {
+            ESP_LOGE(TAG, "[场景] 第%d步: 位长无效: %d", (int)i + 1, signal.bit_length);
+            return 0;
+        }
+        channels[i] = static_cast<uint8_t>(channel);
+        repeats[i] = steps[i].repeat ? steps[i].repeat : bands_[BandIndex(signal.frequency)].repeat_count;
+        channel_mask |= 1UL << channel;
+        needed += RfSceneBuilder::EstimateSymbols(signal, raws[i], repeats[i], steps[i].gap_us);
+    }
+    
+    SceneSchedule* scene = new SceneSchedule();
+    RfProtocolRegistry& registry = RfProtocolRegistry::GetInstance();
+    for (;;) {
+        scene->symbols = static_cast<RfSymbol*>(
+            heap_caps_malloc(needed * sizeof(RfSymbol), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+        if (scene->symbols == nullptr) {
+            ESP_LOGE(TAG, "[场景] 内存不足: 需要%d个符号", (int)needed);
+            FreeScene(scene);
+            return 0;
+        }
         
-        if (value > 0 && bitlength > 0) {
-            // Convert to hex string (based on actual bit length)
-            char hex_str[9];
-            if (bitlength >= 24) {
-                // 24位数据：只取低24位，格式化为6位十六进制
-                uint32_t value24bit = value & 0xFFFFFF;
-                snprintf(hex_str, sizeof(hex_str), "%06lX", value24bit);
-                std::string hex_value = hex_str;
-                // 24位数据：全部6位都是地址码，按键值设为00
-                signal.address = hex_value;  // 完整的6位十六进制作为地址码
-                signal.key = "00";  // 24位数据没有按键值，设为00
-            } else {
-                // 位长度不足24位
-                int hex_len = (bitlength + 3) / 4;  // 转换为十六进制长度
-                snprintf(hex_str, sizeof(hex_str), "%0*lX", hex_len, value);
-                std::string hex_value = hex_str;
-                signal.address = hex_value.substr(0, std::min(6, hex_len));
-                signal.key = hex_value.substr(std::min(6, hex_len), std::min(2, hex_len + 2 - std::min(6, hex_len)));
-                // 如果key为空（不足24位时可能发生），设置为默认值"00"
-                if (signal.key.empty()) {
-                    signal.key = "00";
-                }
+        RfSceneBuilder builder(scene->symbols, needed);
+        for (size_t i = 0; i < count; i++) {
+            const RFSignal& signal = steps[i].signal;
+            if (signal.type == RF_SIGNAL_RAW) {
+                builder.AddRaw(channels[i], *raws[i], repeats[i], steps[i].gap_us);
+                continue;
             }
-            
-            signal.frequency = RF_433MHZ;
-            signal.protocol = protocol;
-            signal.pulse_length = delay;
-            
-            receive_count_++;
-            last_received_ = signal;
-            
-            // Check for duplicate signal
-            uint8_t duplicate_index = 0;
-            bool is_duplicate = CheckDuplicateSignal(signal, duplicate_index);
-            
-            // Print receive log
-            if (is_duplicate) {
-                ESP_LOGW(TAG, "[433MHz接收] ⚠️ 信号重复: %s%s (24位:0x%06lX, 协议:%d, 脉冲:%dμs, 位长:%d) - 与闪存中索引%d的信号相同",
-                        signal.address.c_str(), signal.key.c_str(), value & 0xFFFFFF, protocol, delay, bitlength, duplicate_index);
-            } else {
-                ESP_LOGI(TAG, "[433MHz接收] ✓ 信号接收成功: %s%s (24位:0x%06lX, 协议:%d, 脉冲:%dμs, 位长:%d)",
-                        signal.address.c_str(), signal.key.c_str(), value & 0xFFFFFF, protocol, delay, bitlength);
+            // Same timing as SendSignalCode(): the protocol with the signal's own pulse length
+            RfProtocol protocol;
+            if (!registry.Get(signal.protocol, protocol)) {
+                registry.Get(1, protocol);
             }
-            
-            // Add to replay buffer
-            AddToReplayBuffer(signal);
-            
-            // Check capture mode (will save to captured_signal_ if in capture mode)
-            CheckCaptureMode(signal);
-            
-            // Always save to captured_signal_ for replay functionality
-            // This allows self.rf.replay to work even if capture mode was not enabled
-            captured_signal_ = signal;
-            has_captured_signal_ = true;
-            
-            // Save to flash storage only in capture mode (handled by CheckCaptureMode)
-            // For explicit save via MCP tools (self.rf.receive), save is handled in the tool callback
-            // Removed unconditional SaveToFlash() here to avoid saving on every automatic receive
-            
-            // Call callback if set
-            if (receive_callback_ != nullptr) {
-                receive_callback_(signal);
+            protocol.pulseLength = signal.pulse_length;
+            builder.AddCode(channels[i], protocol, signal.code, signal.bit_length ? signal.bit_length : 24,
+                            repeats[i], steps[i].gap_us);
+        }
+        if (builder.Finish()) {
+            scene->segment_count = builder.SegmentCount();
+            for (size_t i = 0; i < scene->segment_count; i++) {
+                scene->segments[i] = builder.Segment(i);
             }
-            
-            rc_switch_->resetAvailable();
-            return true;
+            ESP_LOGI(TAG, "[场景] 已编译: %d步, %d段, %d个符号, 预计%lums",
+                     (int)count, (int)scene->segment_count, (int)builder.SymbolCount(),
+                     (unsigned long)(builder.DurationUs() / 1000));
+            break;
         }
-        rc_switch_->resetAvailable();
+        // Pulses longer than one symbol were split, retry with room for it
+        heap_caps_free(scene->symbols);
+        needed *= 2;
     }
-#endif // CONFIG_RF_MODULE_ENABLE_433MHZ
-    
-#if CONFIG_RF_MODULE_ENABLE_315MHZ
-    // Check 315MHz interrupt receive
-    if (tc_switch_ != nullptr && receive_enabled_315_ && tc_switch_->available()) {
-        unsigned long value = tc_switch_->getReceivedValue();
-        unsigned int bitlength = tc_switch_->getReceivedBitlength();
-        unsigned int protocol = tc_switch_->getReceivedProtocol();
-        unsigned int delay = tc_switch_->getReceivedDelay();
-        
-        ESP_LOGI(TAG, "[315MHz接收] 原始值:0x%lX, 位长:%d, 协议:%d, 脉冲:%dμs", value, bitlength, protocol, delay);
+    scene->step_count = count;
+    
+    TxJob job;
+    job.signal = steps[0].signal;
+    job.channel_mask = channel_mask;
+    job.callback = callback;
+    job.context = context;
+    job.scene = scene;
+    return EnqueueTx(job, priority, nullptr);
+}
+
+void RFModule::FreeScene(SceneSchedule* scene) {
+    if (scene != nullptr) {
+        heap_caps_free(scene->symbols);
+        delete scene;
+    }
+}
+
+// Plays the segments in order; the pause before a change of transmitter starts once
+// the previous one has finished
+bool RFModule::TransmitScene(const SceneSchedule& scene) {
+    bool sent = false;
+    for (size_t i = 0; i < scene.segment_count; i++) {
+        const RfSceneSegment& segment = scene.segments[i];
+        Channel& channel = channels_[segment.channel];
+        if (channel.radio == nullptr ||
+            !channel.radio->sendSymbols(scene.symbols + segment.offset, segment.count, segment.idle_level)) {
+            ESP_LOGW(TAG, "[场景] 通道%d发送失败，跳过%d步", segment.channel, segment.steps);
+            continue;
+        }
+        channel.radio->waitTransmitDone();
+        channel.sent += segment.steps;
+        sent = true;
         
-        if (value > 0 && bitlength > 0) {
-            // Convert to hex string (based on actual bit length)
-            char hex_str[9];
-            if (bitlength >= 24) {
-                // 24位数据：只取低24位，格式化为6位十六进制
-                uint32_t value24bit = value & 0xFFFFFF;
-                snprintf(hex_str, sizeof(hex_str), "%06lX", value24bit);
-                std::string hex_value = hex_str;
-                // 24位数据：全部6位都是地址码，按键值设为00
-                signal.address = hex_value;  // 完整的6位十六进制作为地址码
-                signal.key = "00";  // 24位数据没有按键值，设为00
-            } else {
-                // 位长度不足24位
-                int hex_len = (bitlength + 3) / 4;  // 转换为十六进制长度
-                snprintf(hex_str, sizeof(hex_str), "%0*lX", hex_len, value);
-                std::string hex_value = hex_str;
-                signal.address = hex_value.substr(0, std::min(6, hex_len));
-                signal.key = hex_value.substr(std::min(6, hex_len), std::min(2, hex_len + 2 - std::min(6, hex_len)));
-                // 如果key为空（不足24位时可能发生），设置为默认值"00"
-                if (signal.key.empty()) {
-                    signal.key = "00";
-                }
+        if (segment.gap_after_us > 0) {
+            const int64_t until = esp_timer_get_time() + segment.gap_after_us;
+            // Sleep through most of a long pause, spin for the rest
+            const TickType_t ticks = pdMS_TO_TICKS(segment.gap_after_us / 1000);
+            if (ticks > 1) {
+                vTaskDelay(ticks - 1);
             }
-            
-            signal.frequency = RF_315MHZ;
-            signal.protocol = protocol;
-            signal.pulse_length = delay;
-            
-            receive_count_++;
-            last_received_ = signal;
-            
-            // Print receive log
-            ESP_LOGI(TAG, "[315MHz接收] ✓ 信号接收成功: %s%s (24位:0x%06lX, 协议:%d, 脉冲:%dμs, 位长:%d)",
-                    signal.address.c_str(), signal.key.c_str(), value & 0xFFFFFF, protocol, delay, bitlength);
-            
-            // Add to replay buffer
-            AddToReplayBuffer(signal);
-            
-            // Check capture mode (will save to captured_signal_ if in capture mode)
-            CheckCaptureMode(signal);
-            
-            // Always save to captured_signal_ for replay functionality
-            // This allows self.rf.replay to work even if capture mode was not enabled
-            captured_signal_ = signal;
-            has_captured_signal_ = true;
-            
-            // Save to flash storage only in capture mode (handled by CheckCaptureMode)
-            // For explicit save via MCP tools (self.rf.receive), save is handled in the tool callback
-            // Removed unconditional SaveToFlash() here to avoid saving on every automatic receive
-            
-            // Call callback if set
-            if (receive_callback_ != nullptr) {
-                receive_callback_(signal);
+            while (esp_timer_get_time() < until) {
+                // Busy wait
             }
-            
-            tc_switch_->resetAvailable();
-            return true;
         }
-        tc_switch_->resetAvailable();
     }
-#endif // CONFIG_RF_MODULE_ENABLE_315MHZ
-    
-    return false;
+    return sent;
 }
 
-void RFModule::SetRepeatCount(uint8_t count, RFFrequency freq) {
-    // If freq is 0xFF (not specified), set both frequencies
-    if (freq == (RFFrequency)0xFF) {
-#if CONFIG_RF_MODULE_ENABLE_433MHZ
-        repeat_count_433_ = count;
-        if (rc_switch_ != nullptr) {
-            rc_switch_->setRepeatTransmit(count);
+// Starts every channel, then waits for all of them: with RMT TX the channels transmit side by side
+bool RFModule::TransmitOnChannels(const RFSignal& signal, const RfRawCode& raw, uint32_t channel_mask) {
+    uint32_t started = 0;
+    for (uint8_t i = 0; i < channel_count_; i++) {
+        if (!(channel_mask & (1UL << i))) {
+            continue;
         }
-#endif // CONFIG_RF_MODULE_ENABLE_433MHZ
-#if CONFIG_RF_MODULE_ENABLE_315MHZ
-        repeat_count_315_ = count;
-        if (tc_switch_ != nullptr) {
-            tc_switch_->setRepeatTransmit(count);
+        Channel& channel = channels_[i];
+        if (channel.radio == nullptr || channel.config.tx_pin == GPIO_NUM_NC) {
+            continue;
         }
-#endif // CONFIG_RF_MODULE_ENABLE_315MHZ
-    } else if (freq == RF_315MHZ) {
-#if CONFIG_RF_MODULE_ENABLE_315MHZ
-        repeat_count_315_ = count;
-        if (tc_switch_ != nullptr) {
-            tc_switch_->setRepeatTransmit(count);
+        if (BandIndex(channel.config.band) != BandIndex(signal.frequency)) {
+            ESP_LOGW(TAG, "[发送] 通道%d为%sMHz，跳过%sMHz信号", i, BandName(channel.config.band),
+                     BandName(signal.frequency));
+            continue;
         }
-#endif // CONFIG_RF_MODULE_ENABLE_315MHZ
-    } else {
-#if CONFIG_RF_MODULE_ENABLE_433MHZ
-        repeat_count_433_ = count;
-        if (rc_switch_ != nullptr) {
-            rc_switch_->setRepeatTransmit(count);
+        
+        bool ok;
+        if (signal.type == RF_SIGNAL_RAW) {
+            ok = SendRawSignal(i, signal, raw);
+        } else {
+            ok = SendSignalCode(i, signal);
+        }
+        if (ok) {
+            channel.sent++;
+            started |= 1UL << i;
+        }
+    }
+    
+    for (uint8_t i = 0; i < channel_count_; i++) {
+        if (started & (1UL << i)) {
+            channels_[i].radio->waitTransmitDone();
         }
-#endif // CONFIG_RF_MODULE_ENABLE_433MHZ
     }
+    return started != 0;
 }
 
-void RFModule::SetProtocol(uint8_t protocol, RFFrequency freq) {
-    // If freq is 0xFF (not specified), set both frequencies
-    if (freq == (RFFrequency)0xFF) {
-#if CONFIG_RF_MODULE_ENABLE_433MHZ
-        protocol_433_ = protocol;
-        if (rc_switch_ != nullptr) {
-            rc_switch_->setProtocol(protocol);
+void RFModule::StartTxTask() {
+    if (tx_task_ != nullptr) {
+        return;
+    }
+    tx_queue_.Reset(CONFIG_RF_MODULE_TX_QUEUE_LENGTH);
+    tx_lock_ = xSemaphoreCreateMutex();
+    tx_slots_ = xSemaphoreCreateCounting(CONFIG_RF_MODULE_TX_QUEUE_LENGTH, CONFIG_RF_MODULE_TX_QUEUE_LENGTH);
+    tx_stopped_ = xSemaphoreCreateBinary();
+    tx_stopping_.store(false);
+    const BaseType_t core = CONFIG_RF_MODULE_TX_TASK_CORE < 0 ? tskNO_AFFINITY : CONFIG_RF_MODULE_TX_TASK_CORE;
+    if (tx_lock_ == nullptr || tx_slots_ == nullptr || tx_stopped_ == nullptr ||
+        xTaskCreatePinnedToCore(TxTask, "rf_tx", CONFIG_RF_MODULE_TX_TASK_STACK, this,
+                                CONFIG_RF_MODULE_TX_TASK_PRIORITY, &tx_task_, core) != pdPASS) {
+        tx_task_ = nullptr;  // Signals are sent on the caller's thread
+        StopTxTask();
+        ESP_LOGW(TAG, "[发送] 无法创建发送任务，改为同步发送");
+    }
+}
+
+// Deleting the task while it holds tx_lock_ or runs a job would leave the lock taken or the
+// job half sent, so the task is asked to stop and deleted only once it says it has
+void RFModule::StopTxTask() {
+    if (tx_task_ != nullptr) {
+        tx_stopping_.store(true);
+        xTaskNotifyGive(tx_task_);
+        xSemaphoreTake(tx_stopped_, portMAX_DELAY);  // Everything queued before has been sent
+        vTaskDelete(tx_task_);
+        tx_task_ = nullptr;
+    }
+    if (tx_stopped_ != nullptr) {
+        vSemaphoreDelete(tx_stopped_);
+        tx_stopped_ = nullptr;
+    }
+    if (tx_slots_ != nullptr) {
+        vSemaphoreDelete(tx_slots_);
+        tx_slots_ = nullptr;
+    }
+    if (tx_lock_ != nullptr) {
+        vSemaphoreDelete(tx_lock_);
+        tx_lock_ = nullptr;
+    }
+    tx_queue_.Reset(0);
+}
+
+void RFModule::TxTask(void* arg) {
+    RFModule* self = static_cast<RFModule*>(arg);
+    TxJob job;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        for (;;) {
+            xSemaphoreTake(self->tx_lock_, portMAX_DELAY);
+            const bool popped = self->tx_queue_.Pop(job);
+            xSemaphoreGive(self->tx_lock_);
+            if (!popped) {
+                break;
+            }
+            xSemaphoreGive(self->tx_slots_);
+            self->RunTxJob(job);
         }
-#endif // CONFIG_RF_MODULE_ENABLE_433MHZ
-#if CONFIG_RF_MODULE_ENABLE_315MHZ
-        protocol_315_ = protocol;
-        if (tc_switch_ != nullptr) {
-            tc_switch_->setProtocol(protocol);
+        if (self->tx_stopping_.load()) {
+            // Queue empty, no lock held and no job running: StopTxTask() deletes the task
+            xSemaphoreGive(self->tx_stopped_);
+            vTaskSuspend(nullptr);
         }
-#endif // CONFIG_RF_MODULE_ENABLE_315MHZ
-    } else if (freq == RF_315MHZ) {
-#if CONFIG_RF_MODULE_ENABLE_315MHZ
-        protocol_315_ = protocol;
-        if (tc_switch_ != nullptr) {
-            tc_switch_->setProtocol(protocol);
+    }
+}
+
+int RFModule::FindTransmitChannel(RFFrequency freq) const {
+    for (uint8_t i = 0; i < channel_count_; i++) {
+        const Channel& channel = channels_[i];
+        if (channel.radio != nullptr && channel.config.tx_pin != GPIO_NUM_NC &&
+            BandIndex(channel.config.band) == BandIndex(freq)) {
+            return i;
         }
-#endif // CONFIG_RF_MODULE_ENABLE_315MHZ
-    } else {
-#if CONFIG_RF_MODULE_ENABLE_433MHZ
-        protocol_433_ = protocol;
-        if (rc_switch_ != nullptr) {
-            rc_switch_->setProtocol(protocol);
+    }
+    return -1;
+}
+
+bool RFModule::IsReceivingChannel(const Channel& channel) const {
+    return channel.config.rx_pin != GPIO_NUM_NC && channel.receive_enabled &&
+           bands_[BandIndex(channel.config.band)].receive_enabled;
+}
+
+bool RFModule::ReceiveAvailable() {
+    if (!enabled_) {
+        return false;
+    }
+    
+    for (uint8_t i = 0; i < channel_count_; i++) {
+        const Channel& channel = channels_[i];
+        if (channel.radio != nullptr && IsReceivingChannel(channel) &&
+            (channel.radio->available() || channel.radio->rawAvailable())) {
+            ESP_LOGI(TAG, "[%sMHz接收] 通道%d检测到可用信号", BandName(channel.config.band), i);
+            return true;
         }
-#endif // CONFIG_RF_MODULE_ENABLE_433MHZ
     }
+    
+    return false;
 }
 
-void RFModule::SetPulseLength(uint16_t pulse_length, RFFrequency freq) {
-    // If freq is 0xFF (not specified), set both frequencies
-    if (freq == (RFFrequency)0xFF) {
-#if CONFIG_RF_MODULE_ENABLE_433MHZ
-        pulse_length_433_ = pulse_length;
-        if (rc_switch_ != nullptr) {
-            rc_switch_->setPulseLength(pulse_length);
+// Oldest queued frame over all receiving channels
+int RFModule::PopOldestFrame(RfDecodedFrame& frame) {
+    int oldest = -1;
+    uint32_t oldest_time = 0;
+    for (uint8_t i = 0; i < channel_count_; i++) {
+        const Channel& channel = channels_[i];
+        if (channel.radio == nullptr || !IsReceivingChannel(channel)) {
+            continue;
         }
-#endif // CONFIG_RF_MODULE_ENABLE_433MHZ
-#if CONFIG_RF_MODULE_ENABLE_315MHZ
-        pulse_length_315_ = pulse_length;
-        if (tc_switch_ != nullptr) {
-            tc_switch_->setPulseLength(pulse_length);
+        const RfDecodedFrame* head = channel.radio->peekReceived();
+        if (head != nullptr && (oldest < 0 || static_cast<int32_t>(head->timestamp - oldest_time) < 0)) {
+            oldest = i;
+            oldest_time = head->timestamp;
         }
-#endif // CONFIG_RF_MODULE_ENABLE_315MHZ
-    } else if (freq == RF_315MHZ) {
-#if CONFIG_RF_MODULE_ENABLE_315MHZ
-        pulse_length_315_ = pulse_length;
-        if (tc_switch_ != nullptr) {
-            tc_switch_->setPulseLength(pulse_length);
+    }
+    if (oldest >= 0) {
+        channels_[oldest].radio->popReceived(frame);
+    }
+    return oldest;
+}
+
+// The same transmission heard by another antenna of the same band
+bool RFModule::IsMergedFrame(uint8_t channel, const RfDecodedFrame& frame) const {
+    if (!merge_valid_ || merge_channel_ == channel ||
+        BandIndex(merge_band_) != BandIndex(channels_[channel].config.band) ||
+        merge_code_ != frame.value || merge_bit_length_ != frame.bitlength) {
+        return false;
+    }
+    int32_t age = static_cast<int32_t>(frame.timestamp - merge_timestamp_);
+    if (age < 0) {
+        age = -age;
+    }
+    return age <= static_cast<int32_t>(CONFIG_RF_MODULE_RX_MERGE_WINDOW_MS) * 1000;
+}
+
+bool RFModule::Receive(RFSignal& signal) {
+    if (!enabled_) {
+        return false;
+    }
+    
+    RfDecodedFrame frame;
+    int index;
+    while ((index = PopOldestFrame(frame)) >= 0) {
+        Channel& channel = channels_[index];
+        const RFFrequency freq = channel.config.band;
+        const char* band = BandName(freq);
+        uint64_t value = frame.value;
+        unsigned int bitlength = frame.bitlength;
+        unsigned int protocol = frame.protocol;
+        unsigned int delay = frame.delay;
+        
+        ESP_LOGI(TAG, "[%sMHz接收] 原始值:0x%llX, 位长:%d, 协议:%d, 脉冲:%dμs, 通道:%d",
+                 band, (unsigned long long)value, bitlength, protocol, delay, index);
+        
+        if (value == 0 || bitlength == 0) {
+            continue;
+        }
+        if (IsMergedFrame(index, frame)) {
+            channel.merged++;
+            ESP_LOGD(TAG, "[%sMHz接收] 通道%d的信号与通道%d相同，已合并", band, index, merge_channel_);
+            continue;
+        }
+        merge_valid_ = true;
+        merge_channel_ = index;
+        merge_band_ = freq;
+        merge_code_ = value;
+        merge_bit_length_ = bitlength;
+        merge_timestamp_ = frame.timestamp;
+        
+        // 完整编码和位长（最多64位）；十六进制地址码 + 按键值00 只在日志/MCP输出时格式化
+        signal.code = value;
+        signal.bit_length = bitlength;
+        signal.frequency = freq;
+        signal.protocol = protocol;
+        signal.pulse_length = delay;
+        signal.type = RF_SIGNAL_CODE;
+        signal.channel = index;
+        signal.raw_handle = 0;
+        signal.name[0] = '\0';
+        
+        receive_count_++;
+        channel.received++;
+        last_received_ = signal;
+        
+        // Check for duplicate signal
+        uint16_t duplicate_index = 0;
+        bool is_duplicate = CheckDuplicateSignal(signal, duplicate_index);
+        
+        // Print receive log
+        char address[RFSignal::kAddressHexSize];
+        signal.FormatAddress(address, sizeof(address));
+        if (is_duplicate) {
+            ESP_LOGW(TAG, "[%sMHz接收] ⚠️ 信号重复: %s00 (%d位:0x%llX, 协议:%d, 脉冲:%dμs) - 与闪存中索引%d的信号相同",
+                    band, address, bitlength, (unsigned long long)value, protocol, delay, duplicate_index);
+        } else {
+            ESP_LOGI(TAG, "[%sMHz接收] ✓ 信号接收成功: %s00 (%d位:0x%llX, 协议:%d, 脉冲:%dμs)",
+                    band, address, bitlength, (unsigned long long)value, protocol, delay);
+        }
+        
+        // Add to replay buffer
+        AddToReplayBuffer(signal);
+        
+        // Check capture mode (will save to captured_signal_ if in capture mode)
+        CheckCaptureMode(signal);
+        
+        // Always save to captured_signal_ for replay functionality
+        // This allows self.rf.replay to work even if capture mode was not enabled
+        captured_signal_ = signal;
+        has_captured_signal_ = true;
+        
+        // Save to flash storage only in capture mode (handled by CheckCaptureMode)
+        // For explicit save via MCP tools (self.rf.receive), save is handled in the tool callback
+        // Removed unconditional SaveToFlash() here to avoid saving on every automatic receive
+        
+        // Call callback if set
+        if (receive_callback_ != nullptr) {
+            receive_callback_(signal);
+        }
+        return true;
+    }
+    
+    return ReceiveRaw(signal);
+}
+
+bool RFModule::ReceiveRaw(RFSignal& signal) {
+    RfRawCode raw;
+    int index = -1;
+    for (uint8_t i = 0; i < channel_count_ && index < 0; i++) {
+        const Channel& channel = channels_[i];
+        if (channel.radio != nullptr && IsReceivingChannel(channel) && channel.radio->popRawReceived(raw)) {
+            index = i;
+        }
+    }
+    if (index < 0) {
+        return false;
+    }
+    const RFFrequency freq = channels_[index].config.band;
+    
+    // 原始信号没有地址码，用时序指纹代替，便于查重和显示
+    signal.code = raw.Fingerprint();
+    signal.bit_length = 0;
+    signal.frequency = freq;
+    signal.protocol = 0;
+    signal.pulse_length = raw.ShortestPulse();
+    signal.name[0] = '\0';
+    signal.type = RF_SIGNAL_RAW;
+    signal.channel = index;
+    signal.raw_handle = raw_pool_.Intern(raw);
+    
+    receive_count_++;
+    channels_[index].received++;
+    last_received_ = signal;
+    
+    ESP_LOGI(TAG, "[%sMHz接收] ✓ 原始信号: %016llX (%d个时序, %d种脉宽, 帧长:%luμs)",
+             BandName(freq), (unsigned long long)signal.code,
+             (int)raw.TimingCount(), (int)raw.BinCount(), (unsigned long)raw.DurationUs());
+    
+    AddToReplayBuffer(signal);
+    CheckCaptureMode(signal);
+    captured_signal_ = signal;
+    has_captured_signal_ = true;
+    
+    if (receive_callback_ != nullptr) {
+        receive_callback_(signal);
+    }
+    return true;
+}
+
+bool RFModule::WaitForSignal(uint32_t timeout_ms) {
+    if (!enabled_ || rx_event_group_ == nullptr) {
+        return false;
+    }
+    
+    int64_t deadline = esp_timer_get_time() + static_cast<int64_t>(timeout_ms) * 1000;
+    for (;;) {
+        // Clear before checking so a frame queued in between still wakes the wait below
+        xEventGroupClearBits(rx_event_group_, RX_FRAME_BIT);
+        if (ReceiveAvailable()) {
+            return true;
+        }
+        
+        int64_t remaining_us = deadline - esp_timer_get_time();
+        if (remaining_us <= 0) {
+            return false;
+        }
+        TickType_t ticks = pdMS_TO_TICKS((remaining_us + 999) / 1000);
+        EventBits_t bits = xEventGroupWaitBits(rx_event_group_, RX_FRAME_BIT, pdFALSE, pdFALSE,
+                                               ticks > 0 ? ticks : 1);
+        if ((bits & RX_FRAME_BIT) == 0) {
+            return ReceiveAvailable();
+        }
+    }
+}
+
+size_t RFModule::ReceiveBatch(RFSignal* signals, size_t max_count) {
+    size_t count = 0;
+    while (count < max_count && ReceiveAvailable()) {
+        if (Receive(signals[count])) {
+            count++;
+        }
+    }
+    return count;
+}
+
+uint32_t RFModule::GetDroppedFrameCount(RFFrequency freq) const {
+    uint32_t dropped = 0;
+    for (uint8_t i = 0; i < channel_count_; i++) {
+        const Channel& channel = channels_[i];
+        if (channel.radio != nullptr && BandIndex(channel.config.band) == BandIndex(freq)) {
+            dropped += channel.radio->getDroppedFrames();
+        }
+    }
+    return dropped;
+}
+
+uint32_t RFModule::GetDroppedEdgeCount(RFFrequency freq) const {
+    uint32_t dropped = 0;
+    for (uint8_t i = 0; i < channel_count_; i++) {
+        const Channel& channel = channels_[i];
+        if (channel.radio != nullptr && BandIndex(channel.config.band) == BandIndex(freq)) {
+            dropped += channel.radio->getDroppedEdges();
+        }
+    }
+    return dropped;
+}
+
+uint32_t RFModule::GetFlashBusyEdgeCount(RFFrequency freq) const {
+    uint32_t edges = 0;
+    for (uint8_t i = 0; i < channel_count_; i++) {
+        const Channel& channel = channels_[i];
+        if (channel.radio != nullptr && BandIndex(channel.config.band) == BandIndex(freq)) {
+            edges += channel.radio->getCacheOffEdges();
+        }
+    }
+    return edges;
+}
+
+const RfChannelConfig* RFModule::GetChannelConfig(uint8_t channel) const {
+    return channel < channel_count_ ? &channels_[channel].config : nullptr;
+}
+
+bool RFModule::GetChannelStats(uint8_t channel, RfChannelStats& stats) const {
+    if (channel >= channel_count_) {
+        return false;
+    }
+    const Channel& entry = channels_[channel];
+    stats.sent = entry.sent;
+    stats.received = entry.received;
+    stats.merged = entry.merged;
+    stats.dropped_frames = entry.radio != nullptr ? entry.radio->getDroppedFrames() : 0;
+    stats.dropped_edges = entry.radio != nullptr ? entry.radio->getDroppedEdges() : 0;
+    stats.flash_busy_edges = entry.radio != nullptr ? entry.radio->getCacheOffEdges() : 0;
+    return true;
+}
+
+bool RFModule::GetChannelMetrics(uint8_t channel, RfMetrics& metrics) const {
+    if (channel >= channel_count_ || channels_[channel].radio == nullptr) {
+        return false;
+    }
+    return channels_[channel].radio->getMetrics(metrics);
+}
+
+bool RFModule::GetMetrics(RFFrequency freq, RfMetrics& metrics) const {
+    memset(&metrics, 0, sizeof(metrics));
+    bool found = false;
+    RfMetrics channel_metrics;
+    for (uint8_t i = 0; i < channel_count_; i++) {
+        const Channel& channel = channels_[i];
+        if (channel.radio != nullptr && BandIndex(channel.config.band) == BandIndex(freq) &&
+            channel.radio->getMetrics(channel_metrics)) {
+            metrics.Merge(channel_metrics);
+            found = true;
+        }
+    }
+    return found;
+}
+
+size_t RFModule::GetTraceDumpSize() const {
+#if CONFIG_RF_MODULE_ENABLE_TRACE
+    return RfTraceDump::Size(channel_count_ * RfChannelTrace::kEvents + kFlashTraceEvents);
+#else
+    return 0;
+#endif
+}
+
+// Gathers every ring, then sorts by age: events of different producers interleave in time
+size_t RFModule::DumpTrace(uint8_t* out, size_t capacity) const {
+#if CONFIG_RF_MODULE_ENABLE_TRACE
+    const size_t max_events = channel_count_ * RfChannelTrace::kEvents + kFlashTraceEvents;
+    RfTraceEvent* events = static_cast<RfTraceEvent*>(
+        heap_caps_malloc(max_events * sizeof(RfTraceEvent), MALLOC_CAP_8BIT));  // PSRAM will do
+    if (events == nullptr) {
+        return 0;
+    }
+    size_t count = 0;
+    for (uint8_t i = 0; i < channel_count_; i++) {
+        if (channels_[i].radio != nullptr) {
+            count += channels_[i].radio->snapshotTrace(events + count);
+        }
+    }
+    if (flash_trace_ != nullptr) {
+        count += flash_trace_->Snapshot(events + count);
+    }
+    const size_t size = RfTraceDump::Write(events, count, static_cast<uint32_t>(esp_timer_get_time()), out, capacity);
+    heap_caps_free(events);
+    return size;
+#else
+    (void)out;
+    (void)capacity;
+    return 0;
+#endif
+}
+
+uint32_t RFModule::GetChannelMask(RFFrequency freq, bool transmit) const {
+    uint32_t mask = 0;
+    for (uint8_t i = 0; i < channel_count_; i++) {
+        const RfChannelConfig& config = channels_[i].config;
+        const gpio_num_t pin = transmit ? config.tx_pin : config.rx_pin;
+        if (pin != GPIO_NUM_NC && BandIndex(config.band) == BandIndex(freq)) {
+            mask |= 1UL << i;
+        }
+    }
+    return mask;
+}
+
+void RFModule::SetChannelReceive(uint8_t channel, bool enabled) {
+    if (channel >= channel_count_) {
+        return;
+    }
+    Channel& entry = channels_[channel];
+    entry.receive_enabled = enabled;
+    if (entry.radio == nullptr) {
+        return;
+    }
+    if (IsReceivingChannel(entry)) {
+        if (enabled_) {
+            entry.radio->enableReceive(static_cast<int>(entry.config.rx_pin));
+        }
+    } else {
+        entry.radio->disableReceive();
+    }
+}
+
+bool RFModule::IsChannelReceiving(uint8_t channel) const {
+    return channel < channel_count_ && IsReceivingChannel(channels_[channel]);
+}
+
+void RFModule::SetRepeatCount(uint8_t count, RFFrequency freq) {
+    // If freq is 0xFF (not specified), set both frequencies
+    for (size_t band = 0; band < kBandCount; band++) {
+        if (freq == (RFFrequency)0xFF || BandIndex(freq) == band) {
+            bands_[band].repeat_count = count;
+        }
+    }
+    for (uint8_t i = 0; i < channel_count_; i++) {
+        Channel& channel = channels_[i];
+        if (channel.radio != nullptr && (freq == (RFFrequency)0xFF || BandIndex(freq) == BandIndex(channel.config.band))) {
+            channel.radio->setRepeatTransmit(count);
+        }
+    }
+}
+
+void RFModule::SetProtocol(uint8_t protocol, RFFrequency freq) {
+    // If freq is 0xFF (not specified), set both frequencies
+    for (size_t band = 0; band < kBandCount; band++) {
+        if (freq == (RFFrequency)0xFF || BandIndex(freq) == band) {
+            bands_[band].protocol = protocol;
+        }
+    }
+    for (uint8_t i = 0; i < channel_count_; i++) {
+        Channel& channel = channels_[i];
+        if (channel.radio != nullptr && (freq == (RFFrequency)0xFF || BandIndex(freq) == BandIndex(channel.config.band))) {
+            channel.radio->setProtocol(protocol);
+        }
+    }
+}
+
+void RFModule::SetPulseLength(uint16_t pulse_length, RFFrequency freq) {
+    // If freq is 0xFF (not specified), set both frequencies
+    for (size_t band = 0; band < kBandCount; band++) {
+        if (freq == (RFFrequency)0xFF || BandIndex(freq) == band) {
+            bands_[band].pulse_length = pulse_length;
+        }
+    }
+    for (uint8_t i = 0; i < channel_count_; i++) {
+        Channel& channel = channels_[i];
+        if (channel.radio != nullptr && (freq == (RFFrequency)0xFF || BandIndex(freq) == BandIndex(channel.config.band))) {
+            channel.radio->setPulseLength(pulse_length);
+        }
+    }
+}
+
+void RFModule::SetFrequency(RFFrequency freq) {
+    current_frequency_ = freq;
+}
+
+void RFModule::EnableCaptureMode() {
+    capture_mode_ = true;
+    has_captured_signal_ = false;
+    captured_signal_ = RFSignal();
+}
+
+void RFModule::DisableCaptureMode() {
+    capture_mode_ = false;
+}
+
+void RFModule::SetCapturedSignalName(const std::string& name) {
+    if (has_captured_signal_) {
+        captured_signal_.SetName(name);
+    }
+}
+
+void RFModule::ClearCapturedSignal() {
+    has_captured_signal_ = false;
+    captured_signal_ = RFSignal();
+#if CONFIG_RF_MODULE_ENABLE_FLASH_STORAGE
+    if (flash_storage_enabled_) {
+        ClearFlash();
+    }
+#endif // CONFIG_RF_MODULE_ENABLE_FLASH_STORAGE
+}
+
+void RFModule::EnableRawCapture() {
+    raw_capture_ = true;
+    for (uint8_t i = 0; i < channel_count_; i++) {
+        if (channels_[i].radio != nullptr) {
+            channels_[i].radio->setRawCapture(true);
+        }
+    }
+}
+
+void RFModule::DisableRawCapture() {
+    raw_capture_ = false;
+    for (uint8_t i = 0; i < channel_count_; i++) {
+        if (channels_[i].radio != nullptr) {
+            channels_[i].radio->setRawCapture(false);
+        }
+    }
+}
+
+void RFModule::SetReceiveCallback(ReceiveCallback callback) {
+    receive_callback_ = callback;
+}
+
+void RFModule::EnableReplayBuffer(uint8_t size) {
+    if (replay_buffer_ != nullptr) {
+        delete[] replay_buffer_;
+    }
+    replay_buffer_size_ = size;
+    replay_buffer_ = new RFSignal[size];
+    replay_buffer_index_ = 0;
+    replay_buffer_count_ = 0;
+    replay_buffer_enabled_ = true;
+}
+
+void RFModule::DisableReplayBuffer() {
+    if (replay_buffer_ != nullptr) {
+        delete[] replay_buffer_;
+        replay_buffer_ = nullptr;
+    }
+    replay_buffer_enabled_ = false;
+    replay_buffer_size_ = 0;
+    replay_buffer_index_ = 0;
+    replay_buffer_count_ = 0;
+}
+
+uint8_t RFModule::GetReplayBufferCount() const {
+    return replay_buffer_count_;
+}
+
+bool RFModule::GetReplaySignal(uint8_t index, RFSignal& signal) const {
+    if (!replay_buffer_enabled_ || replay_buffer_ == nullptr || index >= replay_buffer_count_) {
+        return false;
+    }
+    int start_idx = (replay_buffer_index_ - replay_buffer_count_ + replay_buffer_size_) % replay_buffer_size_;
+    int idx = (start_idx + index) % replay_buffer_size_;
+    signal = replay_buffer_[idx];
+    return true;
+}
+
+void RFModule::ClearReplayBuffer() {
+    replay_buffer_index_ = 0;
+    replay_buffer_count_ = 0;
+}
+
+void RFModule::EnableFlashStorage(const char* namespace_name) {
+    flash_storage_enabled_ = true;
+    flash_namespace_ = namespace_name;
+    if (flash_mirror_ == nullptr) {
+        flash_mirror_ = new RFSignal[MAX_FLASH_SIGNALS];
+        flash_slots_.Reset(MAX_FLASH_SIGNALS);
+        flash_code_index_.Reset(MAX_FLASH_SIGNALS);
+        flash_name_index_.Reset(MAX_FLASH_SIGNALS);
+    }
+    if (nvs_handle_ == 0) {
+        esp_err_t err = nvs_open(namespace_name, NVS_READWRITE, &nvs_handle_);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to open NVS namespace: %s", esp_err_to_name(err));
+            nvs_handle_ = 0;
+            flash_storage_enabled_ = false;
+            return;
+        }
+    }
+    MountSignalLog();
+    StartPersistTask();
+}
+
+void RFModule::DisableFlashStorage() {
+    Flush();
+    StopPersistTask();
+    flash_storage_enabled_ = false;
+    StopCompactionTask();
+    if (flash_lock_ != nullptr) {
+        vSemaphoreDelete(flash_lock_);
+        flash_lock_ = nullptr;
+    }
+    signal_log_.Unmount();
+    delete log_medium_;
+    log_medium_ = nullptr;
+    flash_log_active_ = false;
+    if (nvs_handle_ != 0) {
+        nvs_close(nvs_handle_);
+        nvs_handle_ = 0;
+    }
+    delete[] flash_mirror_;
+    flash_mirror_ = nullptr;
+    flash_slots_.Clear();
+    flash_code_index_.Clear();
+    flash_name_index_.Clear();
+    flash_code_copies_ = 0;
+}
+
+bool RFModule::SaveToFlash() {
+    if (!flash_storage_enabled_ || nvs_handle_ == 0) {
+        ESP_LOGW(TAG, "[闪存] SaveToFlash: flash_storage_enabled_=%d, nvs_handle_=%lu", 
+                flash_storage_enabled_, (unsigned long)nvs_handle_);
+        return false;
+    }
+    
+    if (!has_captured_signal_ || captured_signal_.Empty()) {
+        ESP_LOGW(TAG, "[闪存] SaveToFlash: has_captured_signal_=%d, empty=%d", 
+                has_captured_signal_, captured_signal_.Empty());
+        return false;
+    }
+    
+    char address[RFSignal::kAddressHexSize];
+    captured_signal_.FormatAddress(address, sizeof(address));
+    
+    // Check for duplicate signal BEFORE saving
+    uint16_t duplicate_index = 0;
+    bool is_duplicate = CheckDuplicateSignal(captured_signal_, duplicate_index);
+    if (is_duplicate) {
+        ESP_LOGW(TAG, "[闪存] 检测到重复信号，不保存: %s00 (%sMHz) - 与闪存中索引%d的信号相同", 
+                address,
+                captured_signal_.frequency == RF_315MHZ ? "315" : "433",
+                duplicate_index);
+        return false;  // 不保存重复信号
+    }
+    
+    // Storage full: the oldest signal gives up its slot, but we warn user
+    if (flash_slots_.Count() >= MAX_FLASH_SIGNALS) {
+        ESP_LOGW(TAG, "[闪存] 信号存储已满 (%d/%d)，将覆盖最旧的信号", 
+                flash_slots_.Count(), MAX_FLASH_SIGNALS);
+        flash_slots_.Free(flash_slots_.SlotAt(flash_slots_.Count() - 1));
+    }
+    
+    // The slot freed last (or the lowest free one) holds the new signal
+    uint32_t sequence = 0;
+    const uint16_t slot = flash_slots_.Allocate(sequence);
+    if (!WriteFlashRecord(slot, captured_signal_, sequence)) {
+        flash_slots_.Free(slot);
+        SetFlashMirrorSlot(slot, nullptr);  // An evicted record stays in flash and is back after a reboot
+        return false;
+    }
+    
+    if (!CommitFlash()) {
+        return false;
+    }
+    
+    // 显示用户索引：最新信号索引最大，按录入顺序递增
+    uint16_t user_index = flash_slots_.Count();
+    ESP_LOGI(TAG, "[闪存] 信号已保存到索引 %d (共%d个信号)", 
+             user_index, 
+             flash_slots_.Count());
+    return true;
+}
+
+bool RFModule::LoadFromFlash() {
+    if (!flash_storage_enabled_ || nvs_handle_ == 0) {
+        return false;
+    }
+    
+    // Format conversions below read back what they write, so nothing may be left queued
+    Flush();
+    flash_loading_ = true;
+    if (flash_log_active_) {
+        if (!signal_log_.Contains(kFlashFormatKey)) {
+            ImportNvsSignals();  // First boot with the partition
+        }
+    } else {
+        MigrateLegacyFlash();
+    }
+    
+    // The stored records themselves give the count and order
+    LoadFlashMirror();
+    flash_loading_ = false;
+    
+    if (flash_slots_.Count() == 0) {
+        has_captured_signal_ = false;
+        return false;
+    }
+    
+    // Load the most recent signal (internal index 0)
+    if (ReadFlashSignal(0, captured_signal_, true)) {
+        has_captured_signal_ = true;
+        char address[RFSignal::kAddressHexSize];
+        captured_signal_.FormatAddress(address, sizeof(address));
+        ESP_LOGI(TAG, "[闪存] 已加载信号: %s00 (%sMHz, 共%d个信号%s%s)", 
+                address,
+                captured_signal_.frequency == RF_315MHZ ? "315" : "433",
+                flash_slots_.Count(),
+                captured_signal_.HasName() ? ", 名称:" : "", captured_signal_.name);
+        return true;
+    }
+    
+    has_captured_signal_ = false;
+    return false;
+}
+
+void RFModule::ClearFlash() {
+    if (!flash_storage_enabled_ || nvs_handle_ == 0) {
+        return;
+    }
+    
+    // Erase all signal entries
+    FlashMutation mutation;
+    mutation.op = kFlashClear;
+    SubmitFlashMutation(mutation);
+    CommitFlash();
+    
+    flash_slots_.Clear();
+    for (uint16_t slot = 0; slot < MAX_FLASH_SIGNALS; slot++) {
+        flash_mirror_[slot] = RFSignal();
+    }
+    flash_code_index_.Clear();
+    flash_name_index_.Clear();
+    flash_code_copies_ = 0;
+    ESP_LOGI(TAG, "[闪存] 已清除所有保存的信号");
+}
+
+bool RFModule::ClearFlashSignal(uint16_t index) {
+    // index is 0-based internal index (0 = latest signal)
+    if (!flash_storage_enabled_ || nvs_handle_ == 0 || index >= flash_slots_.Count()) {
+        return false;
+    }
+    
+    // Erase the signal entry and free its slot; newer signals move down one index
+    uint16_t user_index = flash_slots_.Count() - index;
+    const uint16_t slot = flash_slots_.SlotAt(index);
+    EraseFlashRecord(slot);
+    flash_slots_.Free(slot);
+    CommitFlash();
+    
+    ESP_LOGI(TAG, "[闪存] 已清除信号索引 %d (剩余%d个信号)", user_index, flash_slots_.Count());
+    return true;
+}
+
+uint16_t RFModule::GetFlashSignalCapacity() const {
+    return MAX_FLASH_SIGNALS;
+}
+
+bool RFModule::GetFlashSignal(uint16_t index, RFSignal& signal) const {
+    return ReadFlashSignal(index, signal, true);
+}
+
+bool RFModule::ReadFlashSignal(uint16_t index, RFSignal& signal, bool load_raw) const {
+    if (!flash_storage_enabled_ || nvs_handle_ == 0 || index >= flash_slots_.Count()) {
+        return false;
+    }
+    
+    const uint16_t slot = flash_slots_.SlotAt(index);
+    if (flash_mirror_[slot].Empty()) {
+        return false;
+    }
+    signal = flash_mirror_[slot];
+    if (load_raw && signal.type == RF_SIGNAL_RAW && raw_pool_.Get(signal.raw_handle) == nullptr) {
+        // Timings were evicted from the pool by newer raw frames: the only case that reads flash
+        PersistBarrier();  // The record may still be queued
+        return ReadFlashRecord(slot, signal, true);
+    }
+    return true;
+}
+
+// Reads every slot once and rebuilds the save order from the record sequence numbers
+void RFModule::LoadFlashMirror() {
+    flash_code_index_.Clear();
+    flash_name_index_.Clear();
+    flash_code_copies_ = 0;
+    flash_slots_.Clear();
+    for (uint16_t slot = 0; slot < MAX_FLASH_SIGNALS; slot++) {
+        flash_mirror_[slot] = RFSignal();
+        RFSignal signal;
+        uint32_t sequence = 0;
+        if (!ReadFlashRecord(slot, signal, true, &sequence)) {
+            continue;
+        }
+        SetFlashMirrorSlot(slot, &signal);
+        flash_slots_.Restore(slot, sequence);
+    }
+    flash_slots_.FinishRestore();
+}
+
+void RFModule::SetFlashMirrorSlot(uint16_t slot, const RFSignal* signal) {
+    if (!flash_mirror_[slot].Empty()) {
+        const RFSignal old = flash_mirror_[slot];
+        flash_mirror_[slot] = RFSignal();
+        flash_name_index_.Remove(slot);
+        if (!flash_code_index_.Remove(old, slot)) {
+            flash_code_copies_--;  // The entry belongs to the other copy
+        } else if (flash_code_copies_ > 0) {
+            // A copy of the same code in another slot takes over. Saves refuse duplicates and
+            // migration drops them, so this scan only runs for stores written some other way.
+            for (uint16_t other = 0; other < MAX_FLASH_SIGNALS; other++) {
+                if (!flash_mirror_[other].Empty() && flash_code_index_.Insert(flash_mirror_[other], other)) {
+                    flash_code_copies_--;
+                    break;
+                }
+            }
+        }
+    }
+    if (signal != nullptr) {
+        flash_mirror_[slot] = *signal;
+        if (!flash_code_index_.Insert(*signal, slot)) {
+            flash_code_copies_++;
+        }
+        flash_name_index_.Insert(signal->name, slot);
+    }
+}
+
+bool RFModule::UpdateFlashSignalName(uint16_t index, const std::string& name) {
+    // index is 0-based internal index (0 = latest signal)
+    if (!flash_storage_enabled_ || nvs_handle_ == 0 || index >= flash_slots_.Count()) {
+        return false;
+    }
+    
+    // Rewrite the whole record with the new name (cut to what RFSignal::name holds)
+    RFSignal signal;
+    if (!ReadFlashSignal(index, signal, true)) {
+        return false;
+    }
+    signal.SetName(name);
+    const uint16_t slot = flash_slots_.SlotAt(index);
+    if (!WriteFlashRecord(slot, signal, flash_slots_.Sequence(slot))) {  // Keeps its place in the order
+        return false;
+    }
+    
+    if (!CommitFlash()) {
+        return false;
+    }
+    
+    uint16_t user_index = flash_slots_.Count() - index;  // Convert to 1-based user index
+    ESP_LOGI(TAG, "[闪存] 已更新信号索引 %d 的名称: %s", user_index, signal.name);
+    return true;
+}
+
+void RFModule::FlashRecordKey(uint16_t slot, char* key, size_t size) {
+    snprintf(key, size, "sig_%d", slot);
+}
+
+// One RfSignalRecord per slot. The record is encoded here, while the raw timings are
+// still in the pool; the write itself is queued (or done at once with no commit, callers
+// use CommitFlash())
+bool RFModule::WriteFlashRecord(uint16_t slot, const RFSignal& signal, uint32_t sequence) {
+    const RfRawCode* raw = nullptr;
+    if (signal.type == RF_SIGNAL_RAW) {
+        raw = raw_pool_.Get(signal.raw_handle);
+        if (raw == nullptr) {
+            ESP_LOGE(TAG, "[闪存] 原始信号时序已被新信号替换，无法保存");
+            return false;
+        }
+    }
+    
+    FlashMutation mutation;
+    mutation.op = kFlashWrite;
+    mutation.slot = slot;
+    mutation.size = RfSignalRecord::Encode(signal, raw, sequence, mutation.record, sizeof(mutation.record));
+    if (mutation.size == 0) {
+        return false;
+    }
+    if (!SubmitFlashMutation(mutation)) {
+        return false;
+    }
+    SetFlashMirrorSlot(slot, &signal);
+    return true;
+}
+
+// Single read into a stack buffer (boot-time mirror load and evicted raw timings)
+bool RFModule::ReadFlashRecord(uint16_t slot, RFSignal& signal, bool load_raw, uint32_t* sequence) const {
+    uint8_t record[RfSignalRecord::kMaxSize];
+    size_t size = sizeof(record);
+    if (flash_log_active_) {
+        FlashLockGuard lock(flash_lock_);
+        if (!signal_log_.Read(slot + 1, record, sizeof(record), size)) {
+            return false;
+        }
+    } else {
+        char key[16];
+        FlashRecordKey(slot, key, sizeof(key));
+        if (nvs_get_blob(nvs_handle_, key, record, &size) != ESP_OK) {
+            return false;
+        }
+    }
+    
+    RfRawCode raw;
+    if (!RfSignalRecord::Decode(record, size, signal, load_raw ? &raw : nullptr, sequence)) {
+        ESP_LOGW(TAG, "[闪存] 槽位%d的信号记录损坏或版本不支持，已忽略", slot);
+        return false;
+    }
+    if (load_raw && signal.type == RF_SIGNAL_RAW) {
+        signal.raw_handle = raw_pool_.Intern(raw);
+    }
+    return true;
+}
+
+void RFModule::EraseFlashRecord(uint16_t slot) {
+    FlashMutation mutation;
+    mutation.op = kFlashErase;
+    mutation.slot = slot;
+    SubmitFlashMutation(mutation);
+    SetFlashMirrorSlot(slot, nullptr);
+}
+
+bool RFModule::CommitFlash() {
+    if (flash_log_active_ || PersistQueued()) {
+        return true;
+    }
+    esp_err_t err = nvs_commit(nvs_handle_);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to commit NVS: %s", esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+bool RFModule::Flush() {
+    return PersistBarrier();
+}
+
+bool RFModule::SubmitFlashMutation(const FlashMutation& mutation) {
+    if (!PersistQueued()) {
+        return ApplyFlashMutation(mutation);
+    }
+    return xQueueSend(persist_queue_, &mutation, portMAX_DELAY) == pdTRUE;  // Full: wait for the task
+}
+
+// Writes one change to the log or NVS, without committing
+bool RFModule::ApplyFlashMutation(const FlashMutation& mutation) {
+    char key[16];
+    switch (mutation.op) {
+    case kFlashWrite:
+        if (flash_log_active_) {
+            FlashLockGuard lock(flash_lock_);
+            if (!signal_log_.Write(mutation.slot + 1, mutation.record, mutation.size)) {
+                ESP_LOGE(TAG, "[闪存] 信号日志已满或写入失败 (有效数据%u字节)", (unsigned)signal_log_.LiveBytes());
+                return false;
+            }
+            KickCompaction();
+        } else {
+            FlashRecordKey(mutation.slot, key, sizeof(key));
+            esp_err_t err = nvs_set_blob(nvs_handle_, key, mutation.record, mutation.size);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to save signal: %s", esp_err_to_name(err));
+                return false;
+            }
+        }
+        return true;
+    case kFlashErase:
+        if (flash_log_active_) {
+            FlashLockGuard lock(flash_lock_);
+            signal_log_.Erase(mutation.slot + 1);
+            KickCompaction();
+        } else {
+            FlashRecordKey(mutation.slot, key, sizeof(key));
+            nvs_erase_key(nvs_handle_, key);
+        }
+        return true;
+    case kFlashClear:
+        if (flash_log_active_) {
+            FlashLockGuard lock(flash_lock_);
+            signal_log_.Clear();  // One marker record, whatever the number of signals
+            const uint8_t format = RfSignalRecord::kVersion;
+            return signal_log_.Write(kFlashFormatKey, &format, sizeof(format));  // Still initialised: no NVS import
+        }
+        for (uint16_t slot = 0; slot < MAX_FLASH_SIGNALS; slot++) {
+            FlashRecordKey(slot, key, sizeof(key));
+            nvs_erase_key(nvs_handle_, key);
+        }
+        return true;
+    default:
+        return true;
+    }
+}
+
+// Applies a batch in order with one NVS commit. A write or erase is skipped when a later
+// entry of the batch replaces it (same slot, or a clear): renaming a signal twice or
+// saving and deleting it within the window touches flash once or not at all.
+void RFModule::ApplyFlashBatch(FlashMutation* batch, size_t count) {
+#if CONFIG_RF_MODULE_ENABLE_TRACE
+    const int64_t start = esp_timer_get_time();
+#endif
+    uint16_t applied = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (batch[i].op == kFlashBarrier || batch[i].op == kFlashStop) {
+            continue;
+        }
+        bool superseded = false;
+        for (size_t j = i + 1; j < count && !superseded; j++) {
+            superseded = batch[j].op == kFlashClear ||
+                         ((batch[j].op == kFlashWrite || batch[j].op == kFlashErase) && batch[j].slot == batch[i].slot);
+        }
+        if (superseded) {
+            continue;
+        }
+        if (!ApplyFlashMutation(batch[i])) {
+            persist_failed_ = true;
+        }
+        applied++;
+    }
+    if (applied > 0 && !flash_log_active_) {
+        esp_err_t err = nvs_commit(nvs_handle_);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to commit NVS: %s", esp_err_to_name(err));
+            persist_failed_ = true;
+        }
+    }
+    ESP_LOGD(TAG, "[闪存] 批量写入: %u条变更, 实际写入%u条", (unsigned)count, applied);
+#if CONFIG_RF_MODULE_ENABLE_TRACE
+    if (applied > 0) {
+        const int64_t now = esp_timer_get_time();
+        RF_TRACE(flash_trace_, Record(static_cast<uint32_t>(now), RF_TRACE_FLASH_COMMIT, RfTraceEvent::kNoChannel,
+                                      applied, static_cast<uint32_t>(now - start)));
+    }
+#endif
+    
+    for (size_t i = 0; i < count; i++) {
+        if (batch[i].op == kFlashBarrier) {
+            *batch[i].result = !persist_failed_;
+            persist_failed_ = false;
+            xSemaphoreGive(batch[i].done);
+        }
+    }
+}
+
+// Waits until every change queued before it has been written and committed
+bool RFModule::PersistBarrier() const {
+    if (!PersistQueued()) {
+        return true;  // Writes are not deferred
+    }
+    bool result = false;
+    FlashMutation barrier;
+    barrier.op = kFlashBarrier;
+    barrier.result = &result;
+    barrier.done = xSemaphoreCreateBinary();
+    if (barrier.done == nullptr) {
+        return false;
+    }
+    xQueueSend(persist_queue_, &barrier, portMAX_DELAY);
+    xSemaphoreTake(barrier.done, portMAX_DELAY);
+    vSemaphoreDelete(barrier.done);
+    return result;
+}
+
+void RFModule::StartPersistTask() {
+    if (persist_task_ != nullptr) {
+        return;
+    }
+    persist_queue_ = xQueueCreate(CONFIG_RF_MODULE_PERSIST_QUEUE_LENGTH, sizeof(FlashMutation));
+    persist_batch_ = new FlashMutation[CONFIG_RF_MODULE_PERSIST_QUEUE_LENGTH];
+    if (persist_queue_ == nullptr ||
+        xTaskCreate(PersistTask, "rf_persist", CONFIG_RF_MODULE_PERSIST_TASK_STACK, this,
+                    CONFIG_RF_MODULE_PERSIST_TASK_PRIORITY, &persist_task_) != pdPASS) {
+        persist_task_ = nullptr;  // Changes are written on the caller's thread
+        StopPersistTask();
+        ESP_LOGW(TAG, "[闪存] 无法创建后台写入任务，改为同步写入");
+    }
+}
+
+// Queues kFlashStop behind whatever is pending and deletes the task once it acknowledged
+// it: a Flush() returns while the task may still be finishing the batch it completed
+void RFModule::StopPersistTask() {
+    if (persist_task_ != nullptr) {
+        FlashMutation stop;
+        stop.op = kFlashStop;
+        stop.done = xSemaphoreCreateBinary();
+        if (stop.done != nullptr) {
+            xQueueSend(persist_queue_, &stop, portMAX_DELAY);
+            xSemaphoreTake(stop.done, portMAX_DELAY);
+            vSemaphoreDelete(stop.done);
+        }
+        vTaskDelete(persist_task_);
+        persist_task_ = nullptr;
+    }
+    if (persist_queue_ != nullptr) {
+        vQueueDelete(persist_queue_);
+        persist_queue_ = nullptr;
+    }
+    delete[] persist_batch_;
+    persist_batch_ = nullptr;
+}
+
+// Takes the first change, then whatever else arrives within the commit window (a
+// barrier or a stop closes the batch early), and writes them with one commit
+void RFModule::PersistTask(void* arg) {
+    RFModule* self = static_cast<RFModule*>(arg);
+    FlashMutation* batch = self->persist_batch_;
+    while (true) {
+        size_t count = 0;
+        xQueueReceive(self->persist_queue_, &batch[count++], portMAX_DELAY);
+        const TickType_t start = xTaskGetTickCount();
+        const TickType_t window = pdMS_TO_TICKS(CONFIG_RF_MODULE_FLASH_COMMIT_WINDOW_MS);
+        while (count < CONFIG_RF_MODULE_PERSIST_QUEUE_LENGTH && batch[count - 1].op != kFlashBarrier &&
+               batch[count - 1].op != kFlashStop) {
+            const TickType_t elapsed = xTaskGetTickCount() - start;
+            if (xQueueReceive(self->persist_queue_, &batch[count], elapsed < window ? window - elapsed : 0) != pdTRUE) {
+                break;
+            }
+            count++;
+        }
+        self->ApplyFlashBatch(batch, count);
+        if (batch[count - 1].op == kFlashStop) {
+            // Batch applied and no lock held: StopPersistTask() deletes the task
+            xSemaphoreGive(batch[count - 1].done);
+            vTaskSuspend(nullptr);
+        }
+    }
+}
+
+// The original firmware saved each signal as six keys (sig_N_addr, _key, _freq, _proto,
+// _pulse, _name) round a circular buffer; "index" was its write position, so the slot
+// there was the oldest. Convert them once, in place, newest first: a copy of a code
+// already converted is dropped, as SaveToFlash() would have refused it.
+void RFModule::MigrateLegacyFlash() {
+    uint8_t format = 0;
+    if (nvs_get_u8(nvs_handle_, "sig_format", &format) == ESP_OK) {
+        return;  // Already in the record format
+    }
+    
+    static const char* const kLegacyFields[] = { "addr", "key", "freq", "proto", "pulse", "name" };
+    static const char* const kLegacyMetadata[] = { "count", "index", "has_signal" };
+    uint8_t write_index = 0;
+    nvs_get_u8(nvs_handle_, "index", &write_index);
+    flash_code_index_.Clear();  // Tracks the codes converted so far; LoadFlashMirror() rebuilds it
+    uint16_t migrated = 0;
+    bool complete = true;
+    for (uint16_t age = 1; age <= MAX_FLASH_SIGNALS; age++) {
+        // RF_MODULE_MAX_FLASH_SIGNALS may have changed since the signals were saved
+        const uint16_t slot = (write_index + MAX_FLASH_SIGNALS - age % MAX_FLASH_SIGNALS) % MAX_FLASH_SIGNALS;
+        char key[16];
+        char address[9];
+        size_t size = sizeof(address);
+        snprintf(key, sizeof(key), "sig_%d_addr", slot);
+        if (nvs_get_str(nvs_handle_, key, address, &size) != ESP_OK) {
+            continue;
+        }
+    
+        RFSignal signal;
+        signal.code = HexToUint64(address, 6);
+        signal.bit_length = 24;  // The old layout did not keep it; everything was sent as 24 bits
+        uint8_t freq = 0;
+        snprintf(key, sizeof(key), "sig_%d_freq", slot);
+        nvs_get_u8(nvs_handle_, key, &freq);
+        signal.frequency = freq == RF_315MHZ ? RF_315MHZ : RF_433MHZ;
+        snprintf(key, sizeof(key), "sig_%d_proto", slot);
+        nvs_get_u8(nvs_handle_, key, &signal.protocol);
+        snprintf(key, sizeof(key), "sig_%d_pulse", slot);
+        nvs_get_u16(nvs_handle_, key, &signal.pulse_length);
+        char name[64];
+        size = sizeof(name);
+        snprintf(key, sizeof(key), "sig_%d_name", slot);
+        if (nvs_get_str(nvs_handle_, key, name, &size) == ESP_OK) {
+            signal.SetName(name);
+        }
+    
+        if (address[0] != '\0' && flash_code_index_.Insert(signal, slot)) {
+            const uint32_t sequence = MAX_FLASH_SIGNALS + 1 - age;  // Oldest first
+            if (!WriteFlashRecord(slot, signal, sequence)) {
+                complete = false;  // Keep the old keys, retried on next boot
+                continue;
+            }
+            migrated++;
         }
-#endif // CONFIG_RF_MODULE_ENABLE_315MHZ
-    } else {
-#if CONFIG_RF_MODULE_ENABLE_433MHZ
-        pulse_length_433_ = pulse_length;
-        if (rc_switch_ != nullptr) {
-            rc_switch_->setPulseLength(pulse_length);
+        for (const char* field : kLegacyFields) {
+            snprintf(key, sizeof(key), "sig_%d_%s", slot, field);
+            nvs_erase_key(nvs_handle_, key);
         }
-#endif // CONFIG_RF_MODULE_ENABLE_433MHZ
+    }
+    
+    if (complete) {
+        for (const char* metadata : kLegacyMetadata) {
+            nvs_erase_key(nvs_handle_, metadata);
+        }
+        nvs_set_u8(nvs_handle_, "sig_format", RfSignalRecord::kVersion);
+    }
+    esp_err_t err = nvs_commit(nvs_handle_);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to commit NVS: %s", esp_err_to_name(err));
+        return;
+    }
+    if (migrated > 0) {
+        ESP_LOGI(TAG, "[闪存] 已将%d个旧格式信号转换为单条记录格式", migrated);
     }
 }
 
-void RFModule::SetFrequency(RFFrequency freq) {
-    current_frequency_ = freq;
+// The log is used when the partition table has a data partition with this label, e.g.
+//   rf_signals, data, 0x40, , 256K
+void RFModule::MountSignalLog() {
+    if (flash_log_active_) {
+        return;
+    }
+    const esp_partition_t* partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                                CONFIG_RF_MODULE_SIGNAL_PARTITION);
+    if (partition == nullptr) {
+        ESP_LOGI(TAG, "[闪存] 未找到数据分区 %s，信号保存在NVS", CONFIG_RF_MODULE_SIGNAL_PARTITION);
+        return;
+    }
+    
+    log_medium_ = new RfPartitionMedium(partition);
+    if (!signal_log_.Mount(log_medium_, MAX_FLASH_SIGNALS + 1)) {
+        ESP_LOGE(TAG, "[闪存] 数据分区 %s 太小 (%lu字节)，信号保存在NVS",
+                CONFIG_RF_MODULE_SIGNAL_PARTITION, (unsigned long)partition->size);
+        delete log_medium_;
+        log_medium_ = nullptr;
+        return;
+    }
+    flash_lock_ = xSemaphoreCreateMutex();
+    compaction_stopped_ = xSemaphoreCreateBinary();
+    compaction_stopping_.store(false);
+    if (compaction_stopped_ == nullptr ||
+        xTaskCreate(CompactionTask, "rf_compact", CONFIG_RF_MODULE_COMPACTION_TASK_STACK, this,
+                    CONFIG_RF_MODULE_COMPACTION_TASK_PRIORITY, &compaction_task_) != pdPASS) {
+        compaction_task_ = nullptr;  // Writes still compact in the foreground when they run out of room
+        StopCompactionTask();
+        ESP_LOGW(TAG, "[闪存] 无法创建后台整理任务");
+    }
+    flash_log_active_ = true;
+    ESP_LOGI(TAG, "[闪存] 信号日志: 分区 %s, %u个扇区 (空闲%u个), 有效数据%u字节",
+            CONFIG_RF_MODULE_SIGNAL_PARTITION, (unsigned)signal_log_.SectorCount(),
+            (unsigned)signal_log_.FreeSectors(), (unsigned)signal_log_.LiveBytes());
+    KickCompaction();
 }
 
-void RFModule::EnableCaptureMode() {
-    capture_mode_ = true;
-    has_captured_signal_ = false;
-    captured_signal_ = RFSignal();
+// First boot with the partition: load the NVS records (upgrading old formats), copy them
+// over as they are, keeping their slots, then drop them from NVS. The format record is
+// written last; until it exists the import is simply redone.
+void RFModule::ImportNvsSignals() {
+    flash_log_active_ = false;
+    MigrateLegacyFlash();
+    LoadFlashMirror();
+    flash_log_active_ = true;
+    
+    uint16_t imported = 0;
+    {
+        FlashLockGuard lock(flash_lock_);
+        signal_log_.Clear();  // Leftovers of an interrupted import
+        for (uint16_t slot = 0; slot < MAX_FLASH_SIGNALS; slot++) {
+            if (!flash_slots_.Used(slot)) {
+                continue;
+            }
+            uint8_t record[RfSignalRecord::kMaxSize];
+            size_t size = sizeof(record);
+            char key[16];
+            FlashRecordKey(slot, key, sizeof(key));
+            if (nvs_get_blob(nvs_handle_, key, record, &size) == ESP_OK &&
+                signal_log_.Write(slot + 1, record, size)) {
+                imported++;
+            }
+        }
+        const uint8_t format = RfSignalRecord::kVersion;
+        if (!signal_log_.Write(kFlashFormatKey, &format, sizeof(format))) {
+            ESP_LOGE(TAG, "[闪存] 信号日志已满或写入失败 (有效数据%u字节)", (unsigned)signal_log_.LiveBytes());
+            return;
+        }
+    }
+    
+    for (uint16_t slot = 0; slot < MAX_FLASH_SIGNALS; slot++) {
+        char key[16];
+        FlashRecordKey(slot, key, sizeof(key));
+        nvs_erase_key(nvs_handle_, key);
+    }
+    static const char* const kMetadataKeys[] = { "count", "index", "has_signal", "sig_format" };
+    for (const char* key : kMetadataKeys) {
+        nvs_erase_key(nvs_handle_, key);
+    }
+    nvs_commit(nvs_handle_);
+    if (imported > 0) {
+        ESP_LOGI(TAG, "[闪存] 已将NVS中的%d个信号导入数据分区", imported);
+    }
 }
 
-void RFModule::DisableCaptureMode() {
-    capture_mode_ = false;
+void RFModule::KickCompaction() {
+    if (compaction_task_ != nullptr && signal_log_.NeedsCompaction()) {
+        xTaskNotifyGive(compaction_task_);
+    }
 }
 
-void RFModule::SetCapturedSignalName(const std::string& name) {
-    if (has_captured_signal_) {
-        captured_signal_.name = name;
+void RFModule::StopCompactionTask() {
+    if (compaction_task_ != nullptr) {
+        compaction_stopping_.store(true);
+        xTaskNotifyGive(compaction_task_);
+        xSemaphoreTake(compaction_stopped_, portMAX_DELAY);
+        vTaskDelete(compaction_task_);
+        compaction_task_ = nullptr;
+    }
+    if (compaction_stopped_ != nullptr) {
+        vSemaphoreDelete(compaction_stopped_);
+        compaction_stopped_ = nullptr;
     }
 }
 
-void RFModule::ClearCapturedSignal() {
-    has_captured_signal_ = false;
-    captured_signal_ = RFSignal();
-#if CONFIG_RF_MODULE_ENABLE_FLASH_STORAGE
-    if (flash_storage_enabled_) {
-        ClearFlash();
+// Reclaims log sectors in the background so saves rarely wait for an erase
+void RFModule::CompactionTask(void* arg) {
+    RFModule* self = static_cast<RFModule*>(arg);
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        uint16_t sectors = 0;
+        bool more = !self->compaction_stopping_.load();
+        while (more) {
+            // One sector per lock hold: a save waits for at most one copy and erase
+            xSemaphoreTake(self->flash_lock_, portMAX_DELAY);
+            more = self->signal_log_.NeedsCompaction() && self->signal_log_.Compact();
+            xSemaphoreGive(self->flash_lock_);
+            if (more) {
+                sectors++;
+                more = !self->compaction_stopping_.load();
+            }
+        }
+        ESP_LOGD(TAG, "[闪存] 后台整理了%d个扇区 (空闲%u个)", sectors, (unsigned)self->signal_log_.FreeSectors());
+        if (self->compaction_stopping_.load()) {
+            // Lock released, no sector half copied: StopCompactionTask() deletes the task
+            xSemaphoreGive(self->compaction_stopped_);
+            vTaskSuspend(nullptr);
+        }
     }
-#endif // CONFIG_RF_MODULE_ENABLE_FLASH_STORAGE
 }
 
-void RFModule::SetReceiveCallback(ReceiveCallback callback) {
-    receive_callback_ = callback;
+bool RFModule::CheckDuplicateSignal(const RFSignal& signal, uint16_t& duplicate_index) const {
+    if (!flash_storage_enabled_ || flash_slots_.Count() == 0) {
+        return false;
+    }
+    
+    // Same band, code and bit length (raw signals: timing fingerprint); protocol and
+    // pulse_length may vary slightly between captures of one remote
+    uint16_t slot = 0;
+    if (!flash_code_index_.Find(signal, slot)) {
+        return false;
+    }
+    
+    // 与 list_signals 保持一致：索引按录入顺序递增，最新信号索引最大
+    // 内部索引0为最新的信号，对应用户索引 GetFlashSignalCount()
+    uint16_t internal_index = flash_slots_.IndexOf(slot);
+    if (internal_index == RfSlotTable::kNoSlot) {
+        return false;
+    }
+    duplicate_index = flash_slots_.Count() - internal_index;  // 1-based index for user
+    return true;
 }
 
-void RFModule::EnableReplayBuffer(uint8_t size) {
-    if (replay_buffer_ != nullptr) {
-        delete[] replay_buffer_;
+size_t RFModule::FindSignalsByName(const std::string& name, RfNameMatch* matches, size_t max_matches) const {
+    if (!flash_storage_enabled_ || flash_slots_.Count() == 0 || max_matches == 0) {
+        return 0;
     }
-    replay_buffer_size_ = size;
-    replay_buffer_ = new RFSignal[size];
-    replay_buffer_index_ = 0;
-    replay_buffer_count_ = 0;
-    replay_buffer_enabled_ = true;
+    
+    RfNameMatch found[kMaxNameCandidates];
+    const size_t found_count = flash_name_index_.Lookup(name.c_str(), found, kMaxNameCandidates);
+    size_t count = 0;
+    for (size_t i = 0; i < found_count; i++) {
+        RfNameMatch match = found[i];
+        match.index = flash_slots_.IndexOf(match.index);
+        if (match.index == RfSlotTable::kNoSlot) {
+            continue;
+        }
+        // Same rank: the most recently saved signal first, as the old linear search did
+        size_t pos = count;
+        while (pos > 0 && found[pos - 1].kind == match.kind && found[pos - 1].distance == match.distance &&
+               found[pos - 1].index > match.index) {
+            found[pos] = found[pos - 1];
+            pos--;
+        }
+        found[pos] = match;
+        count++;
+    }
+    if (count > max_matches) {
+        count = max_matches;
+    }
+    memcpy(matches, found, count * sizeof(RfNameMatch));
+    return count;
 }
 
-void RFModule::DisableReplayBuffer() {
-    if (replay_buffer_ != nullptr) {
-        delete[] replay_buffer_;
-        replay_buffer_ = nullptr;
+uint8_t RFModule::RegisterProtocol(const RfProtocol& protocol) {
+    if (protocol.pulseLength == 0 || (protocol.syncFactor.high == 0 && protocol.syncFactor.low == 0)) {
+        ESP_LOGE(TAG, "[协议] 无效的协议时序");
+        return 0;
     }
-    replay_buffer_enabled_ = false;
-    replay_buffer_size_ = 0;
-    replay_buffer_index_ = 0;
-    replay_buffer_count_ = 0;
+    unsigned int number = RfProtocolRegistry::GetInstance().Register(protocol);
+    if (number == 0) {
+        ESP_LOGW(TAG, "[协议] 自定义协议已满 (最多%d个)",
+                RfProtocolRegistry::kMaxProtocols - RfProtocolRegistry::kBuiltinCount);
+        return 0;
+    }
+    ESP_LOGI(TAG, "[协议] 已注册自定义协议 %d: 脉冲:%dμs, 同步:%d/%d, 0:%d/%d, 1:%d/%d%s",
+             number, protocol.pulseLength, protocol.syncFactor.high, protocol.syncFactor.low,
+             protocol.zero.high, protocol.zero.low, protocol.one.high, protocol.one.low,
+             protocol.invertedSignal ? ", 反相" : "");
+    SaveProtocolsToFlash();
+    return number;
 }
 
-uint8_t RFModule::GetReplayBufferCount() const {
-    return replay_buffer_count_;
+bool RFModule::RemoveProtocol(uint8_t protocol) {
+    if (!RfProtocolRegistry::GetInstance().Remove(protocol)) {
+        return false;
+    }
+    ESP_LOGI(TAG, "[协议] 已删除自定义协议 %d", protocol);
+    SaveProtocolsToFlash();
+    return true;
 }
 
-bool RFModule::GetReplaySignal(uint8_t index, RFSignal& signal) const {
-    if (!replay_buffer_enabled_ || replay_buffer_ == nullptr || index >= replay_buffer_count_) {
+bool RFModule::SetProtocolEnabled(uint8_t protocol, bool enabled) {
+    if (!RfProtocolRegistry::GetInstance().SetEnabled(protocol, enabled)) {
         return false;
     }
-    int start_idx = (replay_buffer_index_ - replay_buffer_count_ + replay_buffer_size_) % replay_buffer_size_;
-    int idx = (start_idx + index) % replay_buffer_size_;
-    signal = replay_buffer_[idx];
+    ESP_LOGI(TAG, "[协议] 协议 %d 已%s", protocol, enabled ? "启用" : "禁用");
+    SaveProtocolsToFlash();
     return true;
 }
 
-void RFModule::ClearReplayBuffer() {
-    replay_buffer_index_ = 0;
-    replay_buffer_count_ = 0;
+bool RFModule::GetProtocol(uint8_t protocol, RfProtocol& timing) const {
+    return RfProtocolRegistry::GetInstance().Get(protocol, timing);
 }
 
-void RFModule::EnableFlashStorage(const char* namespace_name) {
-    flash_storage_enabled_ = true;
-    flash_namespace_ = namespace_name;
-    if (nvs_handle_ == 0) {
-        esp_err_t err = nvs_open(namespace_name, NVS_READWRITE, &nvs_handle_);
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to open NVS namespace: %s", esp_err_to_name(err));
-            nvs_handle_ = 0;
-            flash_storage_enabled_ = false;
-        }
-    }
+uint32_t RFModule::GetEnabledProtocols() const {
+    return RfProtocolRegistry::GetInstance().EnabledMask();
 }
 
-void RFModule::DisableFlashStorage() {
-    flash_storage_enabled_ = false;
-    if (nvs_handle_ != 0) {
-        nvs_close(nvs_handle_);
-        nvs_handle_ = 0;
-    }
+// One RfSceneRecord per scene ("scene_0" .. "scene_15"), committed at once like the protocols
+void RFModule::SceneKey(size_t slot, char* key, size_t size) {
+    snprintf(key, size, "scene_%u", static_cast<unsigned int>(slot % kMaxScenes));  // The modulo lets the compiler see the key fits
 }
 
-bool RFModule::SaveToFlash() {
+// Slot holding the scene called name, or with free_slot the first empty one if there is none
+int RFModule::FindSceneSlot(const std::string& name, bool free_slot) const {
     if (!flash_storage_enabled_ || nvs_handle_ == 0) {
-        ESP_LOGW(TAG, "[闪存] SaveToFlash: flash_storage_enabled_=%d, nvs_handle_=%lu", 
-                flash_storage_enabled_, (unsigned long)nvs_handle_);
-        return false;
-    }
-    
-    if (!has_captured_signal_ || captured_signal_.address.empty()) {
-        ESP_LOGW(TAG, "[闪存] SaveToFlash: has_captured_signal_=%d, address.empty()=%d", 
-                has_captured_signal_, captured_signal_.address.empty());
-        return false;
-    }
-    
-    // Check for duplicate signal BEFORE saving
-    uint8_t duplicate_index = 0;
-    bool is_duplicate = CheckDuplicateSignal(captured_signal_, duplicate_index);
-    if (is_duplicate) {
-        ESP_LOGW(TAG, "[闪存] 检测到重复信号，不保存: %s%s (%sMHz) - 与闪存中索引%d的信号相同", 
-                captured_signal_.address.c_str(), captured_signal_.key.c_str(),
-                captured_signal_.frequency == RF_315MHZ ? "315" : "433",
-                duplicate_index);
-        return false;  // 不保存重复信号
+        return -1;
     }
     
-    // Check if flash storage is full (circular buffer allows overwriting, but we warn user)
-    // Note: Circular buffer will overwrite oldest signal when full, but we should warn
-    if (flash_signal_count_ >= MAX_FLASH_SIGNALS) {
-        ESP_LOGW(TAG, "[闪存] 信号存储已满 (%d/%d)，将覆盖最旧的信号", 
-                flash_signal_count_, MAX_FLASH_SIGNALS);
-        // Continue to save (overwrite oldest), but log warning
+    uint8_t* record = new uint8_t[RfSceneRecord::kMaxSize];
+    int empty = -1;
+    int found = -1;
+    char key[16];
+    char stored[RfSceneRecord::kMaxNameLength + 1];
+    for (size_t slot = 0; slot < kMaxScenes && found < 0; slot++) {
+        SceneKey(slot, key, sizeof(key));
+        size_t size = RfSceneRecord::kMaxSize;
+        if (nvs_get_blob(nvs_handle_, key, record, &size) != ESP_OK ||
+            !RfSceneRecord::DecodeName(record, size, stored)) {
+            if (empty < 0) {
+                empty = static_cast<int>(slot);
+            }
+            continue;
+        }
+        if (name == stored) {
+            found = static_cast<int>(slot);
+        }
     }
-    
-    // Use circular buffer: save to current index, then advance
-    char key_prefix[32];
-    snprintf(key_prefix, sizeof(key_prefix), "sig_%d_", flash_signal_index_);
-    
-    esp_err_t err;
-    std::string addr_key = std::string(key_prefix) + "addr";
-    std::string key_key = std::string(key_prefix) + "key";
-    std::string freq_key = std::string(key_prefix) + "freq";
-    std::string proto_key = std::string(key_prefix) + "proto";
-    std::string pulse_key = std::string(key_prefix) + "pulse";
-    std::string name_key = std::string(key_prefix) + "name";
-    
-    err = nvs_set_str(nvs_handle_, addr_key.c_str(), captured_signal_.address.c_str());
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to save address: %s", esp_err_to_name(err));
+    delete[] record;
+    return found >= 0 || !free_slot ? found : empty;
+}
+
+bool RFModule::SaveScene(const std::string& name, const RfSceneStep* steps, size_t count) {
+    if (!flash_storage_enabled_ || nvs_handle_ == 0) {
+        ESP_LOGW(TAG, "[场景] 闪存存储未启用");
         return false;
     }
-    
-    err = nvs_set_str(nvs_handle_, key_key.c_str(), captured_signal_.key.c_str());
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to save key: %s", esp_err_to_name(err));
+    if (name.empty() || name.size() > RfSceneRecord::kMaxNameLength ||
+        count == 0 || count > RfSceneBuilder::kMaxSteps) {
+        ESP_LOGE(TAG, "[场景] 名称或步骤数无效");
         return false;
     }
     
-    nvs_set_u8(nvs_handle_, freq_key.c_str(), captured_signal_.frequency);
-    nvs_set_u8(nvs_handle_, proto_key.c_str(), captured_signal_.protocol);
-    nvs_set_u16(nvs_handle_, pulse_key.c_str(), captured_signal_.pulse_length);
-    
-    // Save name field (empty string if not set)
-    err = nvs_set_str(nvs_handle_, name_key.c_str(), 
-                      captured_signal_.name.empty() ? "" : captured_signal_.name.c_str());
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to save name: %s", esp_err_to_name(err));
+    const RfRawCode* raws[RfSceneBuilder::kMaxSteps] = {};
+    for (size_t i = 0; i < count; i++) {
+        if (steps[i].signal.type == RF_SIGNAL_RAW) {
+            raws[i] = raw_pool_.Get(steps[i].signal.raw_handle);
+            if (raws[i] == nullptr) {
+                ESP_LOGE(TAG, "[场景] 第%d步: 原始信号时序已被新信号替换，无法保存", (int)i + 1);
+                return false;
+            }
+        }
+    }
+    const int slot = FindSceneSlot(name, true);
+    if (slot < 0) {
+        ESP_LOGE(TAG, "[场景] 场景已满 (最多%d个)", (int)kMaxScenes);
         return false;
     }
     
-    // Update circular buffer index and count
-    flash_signal_index_ = (flash_signal_index_ + 1) % MAX_FLASH_SIGNALS;
-    if (flash_signal_count_ < MAX_FLASH_SIGNALS) {
-        flash_signal_count_++;
+    uint8_t* record = new uint8_t[RfSceneRecord::kMaxSize];
+    const size_t size = RfSceneRecord::Encode(name.c_str(), steps, raws, count, record, RfSceneRecord::kMaxSize);
+    char key[16];
+    SceneKey(slot, key, sizeof(key));
+    esp_err_t err = size > 0 ? nvs_set_blob(nvs_handle_, key, record, size) : ESP_ERR_INVALID_ARG;
+    delete[] record;
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle_);
     }
-    
-    // Save metadata
-    nvs_set_u8(nvs_handle_, "count", flash_signal_count_);
-    nvs_set_u8(nvs_handle_, "index", flash_signal_index_);
-    nvs_set_u8(nvs_handle_, "has_signal", 1);
-    
-    err = nvs_commit(nvs_handle_);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to commit NVS: %s", esp_err_to_name(err));
+        ESP_LOGE(TAG, "[场景] 保存场景失败: %s", esp_err_to_name(err));
         return false;
     }
-    
-    // 显示用户索引：最新信号索引最大，按录入顺序递增
-    uint8_t user_index = flash_signal_count_;
-    ESP_LOGI(TAG, "[闪存] 信号已保存到索引 %d (共%d个信号)", 
-             user_index, 
-             flash_signal_count_);
+    ESP_LOGI(TAG, "[场景] 已保存场景\"%s\": %d步", name.c_str(), (int)count);
     return true;
 }
 
-bool RFModule::LoadFromFlash() {
-    if (!flash_storage_enabled_ || nvs_handle_ == 0) {
-        return false;
-    }
-    
-    // Load metadata
-    uint8_t has_signal = 0;
-    esp_err_t err = nvs_get_u8(nvs_handle_, "has_signal", &has_signal);
-    if (err != ESP_OK || !has_signal) {
-        flash_signal_count_ = 0;
-        flash_signal_index_ = 0;
-        has_captured_signal_ = false;
-        return false;
-    }
-    
-    // Load count and index
-    nvs_get_u8(nvs_handle_, "count", &flash_signal_count_);
-    nvs_get_u8(nvs_handle_, "index", &flash_signal_index_);
-    
-    if (flash_signal_count_ == 0) {
-        has_captured_signal_ = false;
-        return false;
+RfTxHandle RFModule::PlayScene(const std::string& name, uint8_t priority, RfTxCallback callback, void* context) {
+    const int slot = FindSceneSlot(name, false);
+    if (slot < 0) {
+        ESP_LOGW(TAG, "[场景] 未找到场景\"%s\"", name.c_str());
+        return 0;
     }
     
-    // Load the most recent signal (index - 1, wrapping around)
-    uint8_t load_index = (flash_signal_index_ - 1 + MAX_FLASH_SIGNALS) % MAX_FLASH_SIGNALS;
-    char key_prefix[32];
-    snprintf(key_prefix, sizeof(key_prefix), "sig_%d_", load_index);
-    
-    std::string addr_key = std::string(key_prefix) + "addr";
-    std::string key_key = std::string(key_prefix) + "key";
-    std::string freq_key = std::string(key_prefix) + "freq";
-    std::string proto_key = std::string(key_prefix) + "proto";
-    std::string pulse_key = std::string(key_prefix) + "pulse";
-    std::string name_key = std::string(key_prefix) + "name";
-    
-    size_t required_size = 0;
-    err = nvs_get_str(nvs_handle_, addr_key.c_str(), nullptr, &required_size);
-    if (err == ESP_OK && required_size > 0) {
-        char* addr_buf = new char[required_size];
-        err = nvs_get_str(nvs_handle_, addr_key.c_str(), addr_buf, &required_size);
-        if (err == ESP_OK) {
-            captured_signal_.address = addr_buf;
-            
-            required_size = 0;
-            err = nvs_get_str(nvs_handle_, key_key.c_str(), nullptr, &required_size);
-            if (err == ESP_OK && required_size > 0) {
-                char* key_buf = new char[required_size];
-                err = nvs_get_str(nvs_handle_, key_key.c_str(), key_buf, &required_size);
-                if (err == ESP_OK) {
-                    captured_signal_.key = key_buf;
-                    
-                    uint8_t freq = 0;
-                    nvs_get_u8(nvs_handle_, freq_key.c_str(), &freq);
-                    captured_signal_.frequency = (RFFrequency)freq;
-                    
-                    nvs_get_u8(nvs_handle_, proto_key.c_str(), &captured_signal_.protocol);
-                    nvs_get_u16(nvs_handle_, pulse_key.c_str(), &captured_signal_.pulse_length);
-                    
-                    // Read name field (backward compatible: if not exists, default to empty string)
-                    required_size = 0;
-                    err = nvs_get_str(nvs_handle_, name_key.c_str(), nullptr, &required_size);
-                    if (err == ESP_OK && required_size > 0) {
-                        char* name_buf = new char[required_size];
-                        err = nvs_get_str(nvs_handle_, name_key.c_str(), name_buf, &required_size);
-                        if (err == ESP_OK) {
-                            captured_signal_.name = name_buf;
-                        }
-                        delete[] name_buf;
-                    } else {
-                        // Name field doesn't exist (old data), default to empty string
-                        captured_signal_.name = "";
-                    }
-                    
-                    delete[] key_buf;
-                    delete[] addr_buf;
-                    
-                    if (!captured_signal_.address.empty() && !captured_signal_.key.empty()) {
-                        has_captured_signal_ = true;
-                        ESP_LOGI(TAG, "[闪存] 已加载信号: %s%s (%sMHz, 共%d个信号%s)", 
-                                captured_signal_.address.c_str(), captured_signal_.key.c_str(),
-                                captured_signal_.frequency == RF_315MHZ ? "315" : "433",
-                                flash_signal_count_,
-                                captured_signal_.name.empty() ? "" : (", 名称:" + captured_signal_.name).c_str());
-                        return true;
-                    }
-                } else {
-                    delete[] key_buf;
-                }
-            }
-            delete[] addr_buf;
+    uint8_t* record = new uint8_t[RfSceneRecord::kMaxSize];
+    RfSceneStep* steps = new RfSceneStep[RfSceneBuilder::kMaxSteps];
+    RfRawCode* raws = new RfRawCode[RfSceneBuilder::kMaxSteps];
+    char key[16];
+    SceneKey(slot, key, sizeof(key));
+    size_t size = RfSceneRecord::kMaxSize;
+    char stored[RfSceneRecord::kMaxNameLength + 1];
+    size_t count = 0;
+    RfTxHandle handle = 0;
+    if (nvs_get_blob(nvs_handle_, key, record, &size) == ESP_OK &&
+        RfSceneRecord::Decode(record, size, stored, steps, raws, count)) {
+        const RfRawCode* raw_steps[RfSceneBuilder::kMaxSteps] = {};
+        for (size_t i = 0; i < count; i++) {
+            raw_steps[i] = steps[i].signal.type == RF_SIGNAL_RAW ? &raws[i] : nullptr;
         }
+        handle = SubmitScene(steps, raw_steps, count, priority, callback, context);
+    } else {
+        ESP_LOGW(TAG, "[场景] 场景\"%s\"的记录损坏或版本不支持", name.c_str());
     }
-    
-    has_captured_signal_ = false;
-    return false;
-}
-
-void RFModule::ClearFlash() {
-    if (!flash_storage_enabled_ || nvs_handle_ == 0) {
-        return;
-    }
-    
-    // Erase all signal entries
-    for (uint8_t i = 0; i < MAX_FLASH_SIGNALS; i++) {
-        char key_prefix[32];
-        snprintf(key_prefix, sizeof(key_prefix), "sig_%d_", i);
-        nvs_erase_key(nvs_handle_, (std::string(key_prefix) + "addr").c_str());
-        nvs_erase_key(nvs_handle_, (std::string(key_prefix) + "key").c_str());
-        nvs_erase_key(nvs_handle_, (std::string(key_prefix) + "freq").c_str());
-        nvs_erase_key(nvs_handle_, (std::string(key_prefix) + "proto").c_str());
-        nvs_erase_key(nvs_handle_, (std::string(key_prefix) + "pulse").c_str());
-        nvs_erase_key(nvs_handle_, (std::string(key_prefix) + "name").c_str());
-    }
-    
-    // Clear metadata
-    nvs_erase_key(nvs_handle_, "count");
-    nvs_erase_key(nvs_handle_, "index");
-    nvs_set_u8(nvs_handle_, "has_signal", 0);
-    nvs_commit(nvs_handle_);
-    
-    flash_signal_count_ = 0;
-    flash_signal_index_ = 0;
-    ESP_LOGI(TAG, "[闪存] 已清除所有保存的信号");
+    delete[] raws;
+    delete[] steps;
+    delete[] record;
+    return handle;
 }
 
-bool RFModule::ClearFlashSignal(uint8_t index) {
-    // index is 0-based internal index (0 = latest signal)
-    if (!flash_storage_enabled_ || nvs_handle_ == 0 || index >= flash_signal_count_) {
+bool RFModule::DeleteScene(const std::string& name) {
+    const int slot = FindSceneSlot(name, false);
+    if (slot < 0) {
         return false;
     }
-    
-    // Calculate the actual index in the circular buffer
-    uint8_t actual_index = (flash_signal_index_ - 1 - index + MAX_FLASH_SIGNALS) % MAX_FLASH_SIGNALS;
-    
-    // Erase the signal entry
-    char key_prefix[32];
-    snprintf(key_prefix, sizeof(key_prefix), "sig_%d_", actual_index);
-    nvs_erase_key(nvs_handle_, (std::string(key_prefix) + "addr").c_str());
-    nvs_erase_key(nvs_handle_, (std::string(key_prefix) + "key").c_str());
-    nvs_erase_key(nvs_handle_, (std::string(key_prefix) + "freq").c_str());
-    nvs_erase_key(nvs_handle_, (std::string(key_prefix) + "proto").c_str());
-    nvs_erase_key(nvs_handle_, (std::string(key_prefix) + "pulse").c_str());
-    nvs_erase_key(nvs_handle_, (std::string(key_prefix) + "name").c_str());
-    
-    // Update count
-    if (flash_signal_count_ > 0) {
-        flash_signal_count_--;
-    }
-    
-    // Update metadata
-    if (flash_signal_count_ == 0) {
-        nvs_set_u8(nvs_handle_, "has_signal", 0);
-        flash_signal_index_ = 0;
-    } else {
-        nvs_set_u8(nvs_handle_, "has_signal", 1);
-    }
-    nvs_set_u8(nvs_handle_, "count", flash_signal_count_);
-    nvs_set_u8(nvs_handle_, "index", flash_signal_index_);
-    nvs_commit(nvs_handle_);
-    
-    ESP_LOGI(TAG, "[闪存] 已清除信号索引 %d (剩余%d个信号)", index + 1, flash_signal_count_);
-    return true;
+    char key[16];
+    SceneKey(slot, key, sizeof(key));
+    return nvs_erase_key(nvs_handle_, key) == ESP_OK && nvs_commit(nvs_handle_) == ESP_OK;
 }
 
-bool RFModule::GetFlashSignal(uint8_t index, RFSignal& signal) const {
-    if (!flash_storage_enabled_ || nvs_handle_ == 0 || index >= flash_signal_count_) {
-        return false;
+size_t RFModule::ListScenes(std::string* names, size_t max_count) const {
+    if (!flash_storage_enabled_ || nvs_handle_ == 0) {
+        return 0;
     }
     
-    // Calculate the actual index in the circular buffer
-    // Most recent signal is at (flash_signal_index_ - 1 + MAX_FLASH_SIGNALS) % MAX_FLASH_SIGNALS
-    // Older signals go backwards from there
-    uint8_t actual_index = (flash_signal_index_ - 1 - index + MAX_FLASH_SIGNALS) % MAX_FLASH_SIGNALS;
-    
-    char key_prefix[32];
-    snprintf(key_prefix, sizeof(key_prefix), "sig_%d_", actual_index);
-    
-    std::string addr_key = std::string(key_prefix) + "addr";
-    std::string key_key = std::string(key_prefix) + "key";
-    std::string freq_key = std::string(key_prefix) + "freq";
-    std::string proto_key = std::string(key_prefix) + "proto";
-    std::string pulse_key = std::string(key_prefix) + "pulse";
-    std::string name_key = std::string(key_prefix) + "name";
-    
-    size_t required_size = 0;
-    esp_err_t err = nvs_get_str(nvs_handle_, addr_key.c_str(), nullptr, &required_size);
-    if (err == ESP_OK && required_size > 0) {
-        char* addr_buf = new char[required_size];
-        err = nvs_get_str(nvs_handle_, addr_key.c_str(), addr_buf, &required_size);
-        if (err == ESP_OK) {
-            signal.address = addr_buf;
-            
-            required_size = 0;
-            err = nvs_get_str(nvs_handle_, key_key.c_str(), nullptr, &required_size);
-            if (err == ESP_OK && required_size > 0) {
-                char* key_buf = new char[required_size];
-                err = nvs_get_str(nvs_handle_, key_key.c_str(), key_buf, &required_size);
-                if (err == ESP_OK) {
-                    signal.key = key_buf;
-                    
-                    uint8_t freq = 0;
-                    nvs_get_u8(nvs_handle_, freq_key.c_str(), &freq);
-                    signal.frequency = (RFFrequency)freq;
-                    
-                    nvs_get_u8(nvs_handle_, proto_key.c_str(), &signal.protocol);
-                    nvs_get_u16(nvs_handle_, pulse_key.c_str(), &signal.pulse_length);
-                    
-                    // Read name field (backward compatible: if not exists, default to empty string)
-                    required_size = 0;
-                    err = nvs_get_str(nvs_handle_, name_key.c_str(), nullptr, &required_size);
-                    if (err == ESP_OK && required_size > 0) {
-                        char* name_buf = new char[required_size];
-                        err = nvs_get_str(nvs_handle_, name_key.c_str(), name_buf, &required_size);
-                        if (err == ESP_OK) {
-                            signal.name = name_buf;
-                        }
-                        delete[] name_buf;
-                    } else {
-                        // Name field doesn't exist (old data), default to empty string
-                        signal.name = "";
-                    }
-                    
-                    delete[] key_buf;
-                    delete[] addr_buf;
-                    return true;
-                }
-                delete[] key_buf;
-            }
-            delete[] addr_buf;
+    uint8_t* record = new uint8_t[RfSceneRecord::kMaxSize];
+    size_t count = 0;
+    char key[16];
+    char name[RfSceneRecord::kMaxNameLength + 1];
+    for (size_t slot = 0; slot < kMaxScenes && count < max_count; slot++) {
+        SceneKey(slot, key, sizeof(key));
+        size_t size = RfSceneRecord::kMaxSize;
+        if (nvs_get_blob(nvs_handle_, key, record, &size) == ESP_OK &&
+            RfSceneRecord::DecodeName(record, size, name)) {
+            names[count++] = name;
         }
     }
-    
-    return false;
+    delete[] record;
+    return count;
 }
 
-bool RFModule::UpdateFlashSignalName(uint8_t index, const std::string& name) {
-    // index is 0-based internal index (0 = latest signal)
-    if (!flash_storage_enabled_ || nvs_handle_ == 0 || index >= flash_signal_count_) {
+// Enabled mask plus one blob per custom protocol ("proto_13" .. "proto_32")
+bool RFModule::SaveProtocolsToFlash() {
+    if (!flash_storage_enabled_ || nvs_handle_ == 0) {
         return false;
     }
     
-    // Calculate the actual index in the circular buffer
-    uint8_t actual_index = (flash_signal_index_ - 1 - index + MAX_FLASH_SIGNALS) % MAX_FLASH_SIGNALS;
-    
-    // Update name field
-    char key_prefix[32];
-    snprintf(key_prefix, sizeof(key_prefix), "sig_%d_", actual_index);
-    std::string name_key = std::string(key_prefix) + "name";
-    
-    esp_err_t err = nvs_set_str(nvs_handle_, name_key.c_str(), name.c_str());
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to update signal name: %s", esp_err_to_name(err));
-        return false;
+    RfProtocolRegistry& registry = RfProtocolRegistry::GetInstance();
+    const uint32_t custom = registry.CustomMask();
+    char key[16];
+    for (unsigned int number = RfProtocolRegistry::kBuiltinCount + 1; number <= RfProtocolRegistry::kMaxProtocols; number++) {
+        snprintf(key, sizeof(key), "proto_%u", number);
+        RfProtocol protocol;
+        if ((custom & (1UL << (number - 1))) && registry.Get(number, protocol)) {
+            nvs_set_blob(nvs_handle_, key, &protocol, sizeof(protocol));
+        } else {
+            nvs_erase_key(nvs_handle_, key);
+        }
     }
+    nvs_set_u32(nvs_handle_, "proto_custom", custom);
+    nvs_set_u32(nvs_handle_, "proto_mask", registry.EnabledMask());
     
-    err = nvs_commit(nvs_handle_);
+    esp_err_t err = nvs_commit(nvs_handle_);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to commit NVS: %s", esp_err_to_name(err));
         return false;
     }
-    
-    uint8_t user_index = flash_signal_count_ - index;  // Convert to 1-based user index
-    ESP_LOGI(TAG, "[闪存] 已更新信号索引 %d 的名称: %s", user_index, name.c_str());
     return true;
 }
 
-bool RFModule::CheckDuplicateSignal(const RFSignal& signal, uint8_t& duplicate_index) const {
-    if (!flash_storage_enabled_ || flash_signal_count_ == 0) {
-        return false;
+void RFModule::LoadProtocolsFromFlash() {
+    if (!flash_storage_enabled_ || nvs_handle_ == 0) {
+        return;
     }
     
-    // Check all signals in flash storage
-    for (uint8_t i = 0; i < flash_signal_count_; i++) {
-        RFSignal stored_signal;
-        if (GetFlashSignal(i, stored_signal)) {
-            // Compare address, key, and frequency (protocol and pulse_length may vary slightly)
-            if (stored_signal.address == signal.address &&
-                stored_signal.key == signal.key &&
-                stored_signal.frequency == signal.frequency) {
-                // 与 list_signals 保持一致：索引按录入顺序递增，最新信号索引最大
-                // GetFlashSignal(i=0) 返回最新的信号，对应用户索引 flash_signal_count_
-                // GetFlashSignal(i=1) 返回第二新的信号，对应用户索引 flash_signal_count_ - 1
-                duplicate_index = flash_signal_count_ - i;  // 1-based index for user
-                return true;
-            }
+    uint32_t mask = 0;
+    if (nvs_get_u32(nvs_handle_, "proto_mask", &mask) != ESP_OK) {
+        return;  // Nothing saved yet, keep CONFIG_RF_MODULE_DEFAULT_PROTOCOL_MASK
+    }
+    uint32_t custom = 0;
+    nvs_get_u32(nvs_handle_, "proto_custom", &custom);
+    
+    RfProtocolRegistry& registry = RfProtocolRegistry::GetInstance();
+    char key[16];
+    for (unsigned int number = RfProtocolRegistry::kBuiltinCount + 1; number <= RfProtocolRegistry::kMaxProtocols; number++) {
+        if (!(custom & (1UL << (number - 1)))) {
+            continue;
+        }
+        snprintf(key, sizeof(key), "proto_%u", number);
+        RfProtocol protocol;
+        size_t size = sizeof(protocol);
+        if (nvs_get_blob(nvs_handle_, key, &protocol, &size) == ESP_OK && size == sizeof(protocol)) {
+            registry.Register(number, protocol, false);
         }
     }
-    
-    return false;
+    registry.SetEnabledMask(mask);
+    ESP_LOGI(TAG, "[协议] 已加载协议配置: 启用掩码=0x%08lX, 自定义=0x%08lX",
+             (unsigned long)registry.EnabledMask(), (unsigned long)registry.CustomMask());
 }
 
 void RFModule::ResetCounters() {
@@ -953,51 +2257,28 @@ void RFModule::ResetCounters() {
 }
 
 void RFModule::EnableReceive(RFFrequency freq) {
-    if (freq == RF_315MHZ) {
-#if CONFIG_RF_MODULE_ENABLE_315MHZ
-        receive_enabled_315_ = true;
-        if (tc_switch_ != nullptr && enabled_) {
-            tc_switch_->enableReceive(static_cast<int>(rx315_pin_));
-        }
-#else
-        ESP_LOGW(TAG, "315MHz frequency support is disabled");
-#endif // CONFIG_RF_MODULE_ENABLE_315MHZ
-    } else {
-#if CONFIG_RF_MODULE_ENABLE_433MHZ
-        receive_enabled_433_ = true;
-        if (rc_switch_ != nullptr && enabled_) {
-            rc_switch_->enableReceive(static_cast<int>(rx433_pin_));
+    bands_[BandIndex(freq)].receive_enabled = true;
+    for (uint8_t i = 0; i < channel_count_; i++) {
+        Channel& channel = channels_[i];
+        if (channel.radio != nullptr && enabled_ && BandIndex(channel.config.band) == BandIndex(freq) &&
+            IsReceivingChannel(channel)) {
+            channel.radio->enableReceive(static_cast<int>(channel.config.rx_pin));
         }
-#else
-        ESP_LOGW(TAG, "433MHz frequency support is disabled");
-#endif // CONFIG_RF_MODULE_ENABLE_433MHZ
     }
 }
 
 void RFModule::DisableReceive(RFFrequency freq) {
-    if (freq == RF_315MHZ) {
-#if CONFIG_RF_MODULE_ENABLE_315MHZ
-        receive_enabled_315_ = false;
-        if (tc_switch_ != nullptr) {
-            tc_switch_->disableReceive();
-        }
-#endif // CONFIG_RF_MODULE_ENABLE_315MHZ
-    } else {
-#if CONFIG_RF_MODULE_ENABLE_433MHZ
-        receive_enabled_433_ = false;
-        if (rc_switch_ != nullptr) {
-            rc_switch_->disableReceive();
+    bands_[BandIndex(freq)].receive_enabled = false;
+    for (uint8_t i = 0; i < channel_count_; i++) {
+        Channel& channel = channels_[i];
+        if (channel.radio != nullptr && BandIndex(channel.config.band) == BandIndex(freq)) {
+            channel.radio->disableReceive();
         }
-#endif // CONFIG_RF_MODULE_ENABLE_433MHZ
     }
 }
 
 bool RFModule::IsReceiving(RFFrequency freq) const {
-    if (freq == RF_315MHZ) {
-        return receive_enabled_315_;
-    } else {
-        return receive_enabled_433_;
-    }
+    return bands_[BandIndex(freq)].receive_enabled;
 }
 
 uint8_t RFModule::HexToNum(char c) {
@@ -1007,66 +2288,52 @@ uint8_t RFModule::HexToNum(char c) {
     return 0;
 }
 
-void RFModule::SendSignalRCSwitch(const std::string& address, const std::string& key, uint16_t pulse_length, uint8_t protocol) {
-    if (rc_switch_ == nullptr || !enabled_) {
-        return;
+bool RFModule::SendSignalCode(uint8_t channel, const RFSignal& signal) {
+    RfRadioChannel* radio = channels_[channel].radio;
+    if (radio == nullptr || !enabled_) {
+        return false;
     }
-    
-    uint32_t code24bit = 0;
-    
-    // 直接解析address（6位十六进制 = 24位）
-    for (size_t i = 0; i < 6 && i < address.length(); i++) {
-        uint8_t val = HexToNum(address[i]);
-        code24bit = (code24bit << 4) | val;
+    const uint8_t repeat_count = bands_[BandIndex(radio->band())].repeat_count;
+    // 直接使用信号中保存的参数发送，确保脉冲长度、协议和位长正确
+    // 位长为0的旧数据按24位发送
+    const uint16_t bit_length = signal.bit_length ? signal.bit_length : 24;
+    if (bit_length > RFSignal::kMaxCodeBits) {
+        ESP_LOGE(TAG, "[%sMHz发送] 位长无效: %d (最多%d位)", BandName(radio->band()), bit_length,
+                 (int)RFSignal::kMaxCodeBits);
+        return false;
     }
     
     // Use provided pulse_length and protocol instead of global variables
     // This ensures signals are sent with their captured pulse length
-    rc_switch_->setProtocol(protocol);
-    rc_switch_->setPulseLength(pulse_length);
-    rc_switch_->setRepeatTransmit(repeat_count_433_);
-    
-    ESP_LOGI(TAG, "[433MHz发送] 开始发送信号: %s%s (24位:0x%06lX, 协议:%d, 脉冲:%dμs, 重复:%d次)",
-             address.c_str(), key.c_str(), code24bit, protocol, pulse_length, repeat_count_433_);
-    
-    // Send 24-bit data (standard industry practice: repeat 3 times)
-    int64_t send_start_time = esp_timer_get_time();
-    rc_switch_->send(code24bit, 24);
-    int64_t send_duration = (esp_timer_get_time() - send_start_time) / 1000;  // Convert to milliseconds
-    
-    ESP_LOGI(TAG, "[433MHz发送] ✓ 发送完成: %s%s (24位:0x%06lX, 协议:%d, 脉冲:%dμs, 重复:%d次, 耗时:%ldms)",
-             address.c_str(), key.c_str(), (unsigned long)code24bit, protocol, pulse_length, repeat_count_433_, (long)send_duration);
+    radio->setProtocol(signal.protocol);
+    radio->setPulseLength(signal.pulse_length);
+    radio->setRepeatTransmit(repeat_count);
+    
+    char address[RFSignal::kAddressHexSize];
+    signal.FormatAddress(address, sizeof(address));
+    ESP_LOGI(TAG, "[%sMHz发送] 开始发送信号: %s00 (%d位:0x%llX, 协议:%d, 脉冲:%dμs, 重复:%d次, 通道:%d)",
+             BandName(radio->band()), address, bit_length, (unsigned long long)signal.code,
+             signal.protocol, signal.pulse_length, repeat_count, channel);
+    
+    // Standard industry practice: repeat 3 times. Returns once queued when RMT TX is active,
+    // TransmitOnChannels() waits for the end of the frame
+    radio->send(signal.code, bit_length);
+    return true;
 }
 
-void RFModule::SendSignalTCSwitch(const std::string& address, const std::string& key, uint16_t pulse_length, uint8_t protocol) {
-    if (tc_switch_ == nullptr || !enabled_) {
-        return;
-    }
-    
-    uint32_t code24bit = 0;
-    
-    // 直接解析address（6位十六进制 = 24位）
-    for (size_t i = 0; i < 6 && i < address.length(); i++) {
-        uint8_t val = HexToNum(address[i]);
-        code24bit = (code24bit << 4) | val;
+bool RFModule::SendRawSignal(uint8_t channel, const RFSignal& signal, const RfRawCode& raw) {
+    RfRadioChannel* radio = channels_[channel].radio;
+    if (radio == nullptr || raw.Empty()) {
+        return false;
     }
     
-    // Use provided pulse_length and protocol instead of global variables
-    // This ensures signals are sent with their captured pulse length
-    tc_switch_->setProtocol(protocol);
-    tc_switch_->setPulseLength(pulse_length);
-    tc_switch_->setRepeatTransmit(repeat_count_315_);
-    
-    ESP_LOGI(TAG, "[315MHz发送] 开始发送信号: %s%s (24位:0x%06lX, 协议:%d, 脉冲:%dμs, 重复:%d次)",
-             address.c_str(), key.c_str(), code24bit, protocol, pulse_length, repeat_count_315_);
+    ESP_LOGI(TAG, "[%sMHz发送] 开始发送原始信号: %016llX (%d个时序, 帧长:%luμs, 通道:%d)",
+             BandName(signal.frequency), (unsigned long long)signal.code, (int)raw.TimingCount(),
+             (unsigned long)raw.DurationUs(), channel);
     
-    // Send 24-bit data (standard industry practice: repeat 3 times)
-    int64_t send_start_time = esp_timer_get_time();
-    tc_switch_->send(code24bit, 24);
-    int64_t send_duration = (esp_timer_get_time() - send_start_time) / 1000;  // Convert to milliseconds
-    
-    ESP_LOGI(TAG, "[315MHz发送] ✓ 发送完成: %s%s (24位:0x%06lX, 协议:%d, 脉冲:%dμs, 重复:%d次, 耗时:%ldms)",
-             address.c_str(), key.c_str(), (unsigned long)code24bit, protocol, pulse_length, repeat_count_315_, (long)send_duration);
+    radio->setRepeatTransmit(bands_[BandIndex(signal.frequency)].repeat_count);
+    radio->sendRaw(raw);
+    return true;
 }
 
 void RFModule::AddToReplayBuffer(const RFSignal& signal) {
@@ -1106,15 +2373,9 @@ void RFModule::CheckCaptureMode(const RFSignal& signal) {
     }
 }
 
-std::string RFModule::Uint32ToHex(uint32_t value, int length) {
-    std::stringstream ss;
-    ss << std::hex << std::uppercase << std::setfill('0') << std::setw(length) << value;
-    return ss.str();
-}
-
-uint32_t RFModule::HexToUint32(const std::string& hex) {
-    uint32_t result = 0;
-    for (size_t i = 0; i < hex.length() && i < 8; i++) {
+uint64_t RFModule::HexToUint64(const char* hex, size_t max_digits) {
+    uint64_t result = 0;
+    for (size_t i = 0; hex[i] != '\0' && i < max_digits && i < 16; i++) {
         result = (result << 4) | HexToNum(hex[i]);
     }
     return result;
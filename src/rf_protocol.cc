@@ -0,0 +1,148 @@
+#include "rf_protocol.h"
+#include "rf_module_config.h"
+#include <string.h>
+
+// Upstream rc-switch protocol set, numbered from 1
+static const RfProtocol kBuiltinProtocols[RfProtocolRegistry::kBuiltinCount] = {
+    { 350, {  1, 31 }, {  1,  3 }, {  3,  1 }, false },    // protocol 1
+    { 650, {  1, 10 }, {  1,  2 }, {  2,  1 }, false },    // protocol 2
+    { 100, { 30, 71 }, {  4, 11 }, {  9,  6 }, false },    // protocol 3
+    { 380, {  1,  6 }, {  1,  3 }, {  3,  1 }, false },    // protocol 4
+    { 500, {  6, 14 }, {  1,  2 }, {  2,  1 }, false },    // protocol 5
+    { 450, { 23,  1 }, {  1,  2 }, {  2,  1 }, true },     // protocol 6 (HT6P20B)
+    { 150, {  2, 62 }, {  1,  6 }, {  6,  1 }, false },    // protocol 7 (HS2303-PT, i.e. used in AUKEY Remote)
+    { 200, {  3, 130}, {  7, 16 }, {  3,  16}, false },    // protocol 8 Conrad RS-200 RX
+    { 200, { 130, 7 }, {  16, 7 }, { 16,  3 }, true },     // protocol 9 Conrad RS-200 TX
+    { 365, { 18,  1 }, {  3,  1 }, {  1,  3 }, true },     // protocol 10 (1ByOne Doorbell)
+    { 270, { 36,  1 }, {  1,  2 }, {  2,  1 }, true },     // protocol 11 (HT12E)
+    { 320, { 36,  1 }, {  1,  2 }, {  2,  1 }, true }      // protocol 12 (SM5212)
+};
+
+RfProtocolRegistry& RfProtocolRegistry::GetInstance() {
+    static RfProtocolRegistry instance;
+    return instance;
+}
+
+RfProtocolRegistry::RfProtocolRegistry()
+    : defined_mask_((1UL << kBuiltinCount) - 1),
+      enabled_mask_((uint32_t)(CONFIG_RF_MODULE_DEFAULT_PROTOCOL_MASK) & ((1UL << kBuiltinCount) - 1)),
+      generation_(0) {
+    memset(protocols_, 0, sizeof(protocols_));
+    memcpy(protocols_, kBuiltinProtocols, sizeof(kBuiltinProtocols));
+}
+
+void RfProtocolRegistry::BeginWrite() {
+    generation_.fetch_add(1, std::memory_order_relaxed);  // Odd: readers retry
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void RfProtocolRegistry::EndWrite() {
+    generation_.fetch_add(1, std::memory_order_release);
+}
+
+bool RfProtocolRegistry::Get(unsigned int number, RfProtocol& protocol) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (!IsDefined(number)) {
+        return false;
+    }
+    protocol = protocols_[number - 1];
+    return true;
+}
+
+unsigned int RfProtocolRegistry::Register(const RfProtocol& protocol, bool enabled) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    const uint32_t defined = defined_mask_.load(std::memory_order_relaxed);
+    for (unsigned int number = kBuiltinCount + 1; number <= kMaxProtocols; number++) {
+        if (defined & (1UL << (number - 1))) {
+            continue;
+        }
+        BeginWrite();
+        protocols_[number - 1] = protocol;
+        defined_mask_.fetch_or(1UL << (number - 1), std::memory_order_release);
+        if (enabled) {
+            enabled_mask_.fetch_or(1UL << (number - 1), std::memory_order_release);
+        }
+        EndWrite();
+        return number;
+    }
+    return 0;
+}
+
+bool RfProtocolRegistry::Register(unsigned int number, const RfProtocol& protocol, bool enabled) {
+    if (!IsCustom(number)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    const uint32_t bit = 1UL << (number - 1);
+    BeginWrite();
+    protocols_[number - 1] = protocol;
+    defined_mask_.fetch_or(bit, std::memory_order_release);
+    if (enabled) {
+        enabled_mask_.fetch_or(bit, std::memory_order_release);
+    } else {
+        enabled_mask_.fetch_and(~bit, std::memory_order_release);
+    }
+    EndWrite();
+    return true;
+}
+
+bool RfProtocolRegistry::Remove(unsigned int number) {
+    if (!IsCustom(number) || !IsDefined(number)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    const uint32_t bit = 1UL << (number - 1);
+    BeginWrite();
+    enabled_mask_.fetch_and(~bit, std::memory_order_release);
+    defined_mask_.fetch_and(~bit, std::memory_order_release);
+    memset(&protocols_[number - 1], 0, sizeof(RfProtocol));
+    EndWrite();
+    return true;
+}
+
+bool RfProtocolRegistry::SetEnabled(unsigned int number, bool enabled) {
+    if (!IsDefined(number)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    const uint32_t bit = 1UL << (number - 1);
+    BeginWrite();
+    if (enabled) {
+        enabled_mask_.fetch_or(bit, std::memory_order_release);
+    } else {
+        enabled_mask_.fetch_and(~bit, std::memory_order_release);
+    }
+    EndWrite();
+    return true;
+}
+
+void RfProtocolRegistry::SetEnabledMask(uint32_t mask) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    BeginWrite();
+    enabled_mask_.store(mask & defined_mask_.load(std::memory_order_relaxed), std::memory_order_release);
+    EndWrite();
+}
+
+bool RfProtocolRegistry::IsDefined(unsigned int number) const {
+    return number >= 1 && number <= kMaxProtocols && (DefinedMask() & (1UL << (number - 1)));
+}
+
+bool RfProtocolRegistry::IsEnabled(unsigned int number) const {
+    return number >= 1 && number <= kMaxProtocols && (EnabledMask() & (1UL << (number - 1)));
+}
+
+bool RfProtocolRegistry::TrySnapshot(RfProtocol* table, uint32_t& enabled_mask, uint32_t& generation) const {
+    // Never spin here: the decoder task may outrank a writer that was preempted mid-update
+    const uint32_t gen = Generation();
+    if (gen & 1) {
+        return false;
+    }
+    memcpy(table, protocols_, sizeof(protocols_));
+    enabled_mask = EnabledMask();
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (gen != generation_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    generation = gen;
+    return true;
+}
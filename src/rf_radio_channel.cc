@@ -0,0 +1,540 @@
+#include "rf_radio_channel.h"
+#include <esp_log.h>
+#include <driver/gpio.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <soc/soc_caps.h>
+#include <stdio.h>
+#include <string.h>
+#include "rf_module_config.h"
+
+#define TAG "RfRadio"
+
+// Transmissions are timed for the TX jitter metric and the TX trace events
+#define RF_TX_TIMING (CONFIG_RF_MODULE_ENABLE_METRICS || CONFIG_RF_MODULE_ENABLE_TRACE)
+
+// Set once this component installed the IRAM GPIO ISR service itself, so
+// the second and later channels do not warn about it
+static bool isr_service_installed = false;
+
+RfRadioChannel::RfRadioChannel(RFFrequency band, uint32_t protocolMask)
+    : channelBand(band),
+      decoderMask(protocolMask),
+      decoder(RfProtocolRegistry::GetInstance(), protocolMask) {
+    nTransmitterPin = GPIO_NUM_NC;
+    nRepeatTransmit = 10;
+    txChannel = nullptr;
+    txEncoder = nullptr;
+    txSymbols = nullptr;
+    txSymbolCapacity = 0;
+    txStartedAt = 0;
+    txPlannedUs = 0;
+    nReceiverInterrupt = -1;
+    edgeCapture = RfEdgeCapture::Create();
+    decoderTaskHandle = nullptr;
+    decoderStopping.store(false);
+    decoderStopped = nullptr;
+    frameEventGroup = nullptr;
+    frameEventBits = 0;
+    rawCaptureEnabled.store(false);
+    decoder.SetConfirmRepeat(CONFIG_RF_MODULE_RX_CONFIRM_REPEAT);
+    decoder.SetMetrics(edgeCapture != nullptr ? edgeCapture->metrics : nullptr);
+    decoder.SetTrace(edgeCapture != nullptr ? edgeCapture->trace : nullptr);
+    setProtocol(1);
+}
+
+RfRadioChannel::~RfRadioChannel() {
+    disableReceive();
+    disableTransmit();
+    if (txSymbols != nullptr) {
+        heap_caps_free(txSymbols);
+        txSymbols = nullptr;
+        txSymbolCapacity = 0;
+    }
+    RfEdgeCapture::Destroy(edgeCapture);
+}
+
+void RfRadioChannel::enableTransmit(int nTransmitterPin) {
+    this->nTransmitterPin = static_cast<gpio_num_t>(nTransmitterPin);
+    gpio_set_direction(this->nTransmitterPin, GPIO_MODE_OUTPUT);
+    gpio_set_level(this->nTransmitterPin, 0);
+#if CONFIG_RF_MODULE_ENABLE_RMT_TX
+    if (!enableRmtTransmit()) {
+        ESP_LOGW(TAG, "RMT TX unavailable on GPIO %d, falling back to busy-wait transmit", nTransmitterPin);
+    }
+#endif // CONFIG_RF_MODULE_ENABLE_RMT_TX
+}
+
+void RfRadioChannel::disableTransmit() {
+    disableRmtTransmit();
+    if (nTransmitterPin != GPIO_NUM_NC) {
+        gpio_set_level(nTransmitterPin, 0);
+        nTransmitterPin = GPIO_NUM_NC;
+    }
+}
+
+bool RfRadioChannel::enableRmtTransmit() {
+    rmt_tx_channel_config_t tx_config = {};
+    tx_config.gpio_num = nTransmitterPin;
+    tx_config.clk_src = RMT_CLK_SRC_DEFAULT;
+    tx_config.resolution_hz = RF_PULSE_RESOLUTION_HZ;
+    tx_config.mem_block_symbols = SOC_RMT_MEM_WORDS_PER_CHANNEL;
+    tx_config.trans_queue_depth = 1;
+    if (rmt_new_tx_channel(&tx_config, &txChannel) != ESP_OK) {
+        txChannel = nullptr;
+        return false;
+    }
+    
+    rmt_copy_encoder_config_t encoder_config = {};
+    if (rmt_new_copy_encoder(&encoder_config, &txEncoder) != ESP_OK ||
+        rmt_enable(txChannel) != ESP_OK) {
+        disableRmtTransmit();
+        return false;
+    }
+    return true;
+}
+
+void RfRadioChannel::disableRmtTransmit() {
+    if (txChannel != nullptr) {
+        rmt_tx_wait_all_done(txChannel, -1);
+        rmt_disable(txChannel);
+        rmt_del_channel(txChannel);
+        txChannel = nullptr;
+    }
+    if (txEncoder != nullptr) {
+        rmt_del_encoder(txEncoder);
+        txEncoder = nullptr;
+    }
+}
+
+void RfRadioChannel::waitTransmitDone() {
+    if (txChannel != nullptr) {
+        rmt_tx_wait_all_done(txChannel, -1);
+    }
+    finishTxTiming();
+}
+
+// TX jitter metric and trace: the planned airtime of what was just started, measured again
+// in finishTxTiming()
+void RfRadioChannel::startTxTiming(uint32_t plannedUs) {
+#if RF_TX_TIMING
+    txStartedAt = esp_timer_get_time();
+    txPlannedUs = plannedUs;
+    RF_TRACE(edgeCapture->trace, tx.Record(static_cast<uint32_t>(txStartedAt), RF_TRACE_TX_START,
+                                           edgeCapture->trace->channel, 0, plannedUs));
+#else
+    (void)plannedUs;
+#endif
+}
+
+void RfRadioChannel::finishTxTiming() {
+#if RF_TX_TIMING
+    if (txStartedAt == 0) {
+        return;
+    }
+    const int64_t now = esp_timer_get_time();
+    const int64_t airtime = now - txStartedAt;
+    const int64_t jitter = airtime > txPlannedUs ? airtime - txPlannedUs : txPlannedUs - airtime;
+    RF_METRIC(edgeCapture->metrics, transmissions.Add());
+    RF_METRIC(edgeCapture->metrics, tx_jitter_us.Record(jitter < UINT32_MAX ? static_cast<uint32_t>(jitter) : UINT32_MAX));
+    RF_TRACE(edgeCapture->trace, tx.Record(static_cast<uint32_t>(now), RF_TRACE_TX_END, edgeCapture->trace->channel, 0,
+                                           static_cast<uint32_t>(airtime)));
+    txStartedAt = 0;
+#endif
+}
+
+uint32_t RfRadioChannel::symbolsDuration(const RfSymbol* symbols, size_t count) {
+    uint32_t total = 0;
+#if RF_TX_TIMING
+    for (size_t i = 0; i < count; i++) {
+        total += symbols[i].duration0 + symbols[i].duration1;
+    }
+#else
+    (void)symbols;
+    (void)count;
+#endif
+    return total;
+}
+
+void RfRadioChannel::setTraceChannel(uint8_t channel) {
+    if (edgeCapture != nullptr && edgeCapture->trace != nullptr) {
+        edgeCapture->trace->channel = channel;
+    }
+}
+
+size_t RfRadioChannel::snapshotTrace(RfTraceEvent* events) const {
+    if (edgeCapture == nullptr || edgeCapture->trace == nullptr) {
+        return 0;
+    }
+    return edgeCapture->trace->Snapshot(events);
+}
+
+bool RfRadioChannel::getMetrics(RfMetrics& metrics) const {
+    if (edgeCapture == nullptr || edgeCapture->metrics == nullptr) {
+        return false;
+    }
+    edgeCapture->metrics->Read(metrics);
+    return true;
+}
+
+void RfRadioChannel::setPulseLength(int nPulseLength) {
+    protocol.pulseLength = nPulseLength;
+}
+
+void RfRadioChannel::setRepeatTransmit(int nRepeatTransmit) {
+    this->nRepeatTransmit = nRepeatTransmit;
+}
+
+void RfRadioChannel::setProtocol(int nProtocol) {
+    RfProtocolRegistry& registry = RfProtocolRegistry::GetInstance();
+    if (!registry.Get(nProtocol, protocol)) {
+        registry.Get(1, protocol);  // Default to protocol 1
+    }
+}
+
+void RfRadioChannel::send(uint64_t code, unsigned int length) {
+    if (nTransmitterPin == GPIO_NUM_NC) {
+        return;
+    }
+    if (length > RfDecoder::kMaxCodeBits) {
+        length = RfDecoder::kMaxCodeBits;
+    }
+    
+    if (txChannel != nullptr && sendRmt(code, length)) {
+        return;
+    }
+    
+#if RF_TX_TIMING
+    unsigned int units = 2 * (protocol.syncFactor.high + protocol.syncFactor.low);
+    for (int i = length - 1; i >= 0; i--) {
+        const HighLow& bit = (code & (1ULL << i)) ? protocol.one : protocol.zero;
+        units += bit.high + bit.low;
+    }
+    startTxTiming(units * protocol.pulseLength * nRepeatTransmit);
+#endif
+    for (int nRepeat = 0; nRepeat < nRepeatTransmit; nRepeat++) {
+        // Send sync
+        transmit(protocol.syncFactor);
+        
+        // Send code bits
+        for (int i = length - 1; i >= 0; i--) {
+            if (code & (1ULL << i)) {
+                transmit(protocol.one);
+            } else {
+                transmit(protocol.zero);
+            }
+        }
+        
+        // Send sync again
+        transmit(protocol.syncFactor);
+    }
+    finishTxTiming();
+}
+
+bool RfRadioChannel::reserveTxSymbols(size_t needed) {
+    if (needed <= txSymbolCapacity) {
+        return true;
+    }
+    RfSymbol* buffer = static_cast<RfSymbol*>(
+        heap_caps_malloc(needed * sizeof(RfSymbol), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    if (buffer == nullptr) {
+        return false;
+    }
+    if (txSymbols != nullptr) {
+        heap_caps_free(txSymbols);
+    }
+    txSymbols = buffer;
+    txSymbolCapacity = needed;
+    return true;
+}
+
+bool RfRadioChannel::sendRmt(uint64_t code, unsigned int length) {
+    // The previous frame may still be clocked out of txSymbols
+    rmt_tx_wait_all_done(txChannel, -1);
+    
+    size_t needed = RfPulseEncoder::SymbolsPerFrame(length) * nRepeatTransmit;
+    for (;;) {
+        if (!reserveTxSymbols(needed)) {
+            return false;
+        }
+        
+        RfPulseEncoder encoder(txSymbols, txSymbolCapacity);
+        for (int nRepeat = 0; nRepeat < nRepeatTransmit; nRepeat++) {
+            encoder.AddFrame(protocol, code, length);
+        }
+        if (encoder.Finish()) {
+            rmt_transmit_config_t transmit_config = {};
+            transmit_config.flags.eot_level = protocol.invertedSignal ? 1 : 0;
+            startTxTiming(symbolsDuration(txSymbols, encoder.Size()));
+            return rmt_transmit(txChannel, txEncoder, txSymbols,
+                                encoder.Size() * sizeof(RfSymbol), &transmit_config) == ESP_OK;
+        }
+        // Pulses longer than one symbol were split, retry with room for it
+        needed = txSymbolCapacity * 2;
+    }
+}
+
+void RfRadioChannel::sendRaw(const RfRawCode& raw) {
+    if (nTransmitterPin == GPIO_NUM_NC || raw.Empty()) {
+        return;
+    }
+    
+    if (txChannel != nullptr && sendRawRmt(raw)) {
+        return;
+    }
+    
+#if RF_TX_TIMING
+    uint32_t frame_us = 0;
+    for (size_t i = 0; i < raw.TimingCount(); i++) {
+        frame_us += raw.Duration(i);
+    }
+    startTxTiming(frame_us * nRepeatTransmit);
+#endif
+    for (int nRepeat = 0; nRepeat < nRepeatTransmit; nRepeat++) {
+        for (size_t i = 0; i < raw.TimingCount(); i++) {
+            gpio_set_level(nTransmitterPin, raw.Level(i));
+            delayMicroseconds(raw.Duration(i));
+        }
+    }
+    gpio_set_level(nTransmitterPin, raw.IdleLevel());
+    finishTxTiming();
+}
+
+bool RfRadioChannel::sendRawRmt(const RfRawCode& raw) {
+    rmt_tx_wait_all_done(txChannel, -1);
+    
+    size_t needed = RfPulseEncoder::SymbolsPerRawFrame(raw.TimingCount()) * nRepeatTransmit;
+    for (;;) {
+        if (!reserveTxSymbols(needed)) {
+            return false;
+        }
+        
+        RfPulseEncoder encoder(txSymbols, txSymbolCapacity);
+        for (int nRepeat = 0; nRepeat < nRepeatTransmit; nRepeat++) {
+            encoder.AddRaw(raw);
+        }
+        if (encoder.Finish()) {
+            rmt_transmit_config_t transmit_config = {};
+            transmit_config.flags.eot_level = raw.IdleLevel();
+            startTxTiming(symbolsDuration(txSymbols, encoder.Size()));
+            return rmt_transmit(txChannel, txEncoder, txSymbols,
+                                encoder.Size() * sizeof(RfSymbol), &transmit_config) == ESP_OK;
+        }
+        needed = txSymbolCapacity * 2;
+    }
+}
+
+bool RfRadioChannel::sendSymbols(const RfSymbol* symbols, size_t count, uint8_t idleLevel) {
+    if (nTransmitterPin == GPIO_NUM_NC || count == 0) {
+        return false;
+    }
+    
+    if (txChannel != nullptr) {
+        rmt_tx_wait_all_done(txChannel, -1);
+        rmt_transmit_config_t transmit_config = {};
+        transmit_config.flags.eot_level = idleLevel;
+        startTxTiming(symbolsDuration(symbols, count));
+        if (rmt_transmit(txChannel, txEncoder, symbols, count * sizeof(RfSymbol), &transmit_config) == ESP_OK) {
+            return true;
+        }
+    }
+    
+    startTxTiming(symbolsDuration(symbols, count));
+    for (size_t i = 0; i < count; i++) {
+        gpio_set_level(nTransmitterPin, symbols[i].level0);
+        delayMicroseconds(symbols[i].duration0);
+        if (symbols[i].duration1 == 0) {
+            break;  // End marker
+        }
+        gpio_set_level(nTransmitterPin, symbols[i].level1);
+        delayMicroseconds(symbols[i].duration1);
+    }
+    gpio_set_level(nTransmitterPin, idleLevel);
+    finishTxTiming();
+    return true;
+}
+
+void RfRadioChannel::delayMicroseconds(uint32_t us) {
+    uint64_t start = esp_timer_get_time();
+    while ((esp_timer_get_time() - start) < us) {
+        // Busy wait
+    }
+}
+
+void RfRadioChannel::transmit(HighLow pulses) {
+    int pulse_length = protocol.pulseLength;
+    
+    if (protocol.invertedSignal) {
+        gpio_set_level(nTransmitterPin, 0);
+        delayMicroseconds(pulse_length * pulses.high);
+        gpio_set_level(nTransmitterPin, 1);
+        delayMicroseconds(pulse_length * pulses.low);
+    } else {
+        gpio_set_level(nTransmitterPin, 1);
+        delayMicroseconds(pulse_length * pulses.high);
+        gpio_set_level(nTransmitterPin, 0);
+        delayMicroseconds(pulse_length * pulses.low);
+    }
+}
+
+// Registered with ESP_INTR_FLAG_IRAM and given the RfEdgeCapture, not the object: keeps
+// capturing while the flash cache is off
+void IRAM_ATTR RfRadioChannel::handleInterrupt(void* arg) {
+    // Only timestamp the edge here, protocol matching runs in decoderTask
+    static_cast<RfEdgeCapture*>(arg)->OnEdge();
+}
+
+void RfRadioChannel::decoderTask(void* arg) {
+    RfRadioChannel* self = static_cast<RfRadioChannel*>(arg);
+    RfSpscRing<RfEdge, kEdgeRingSize>& edgeRing = self->edgeCapture->ring;
+    uint32_t dropped = edgeRing.Dropped();
+    RfEdge edge;
+    RfDecodedFrame frame;
+    RfRawCode raw;
+    
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        self->decoder.SetRawCapture(self->rawCaptureEnabled.load(std::memory_order_relaxed));
+        
+        // Edges went missing while the ring was full, the partial frame is useless
+        if (edgeRing.Dropped() != dropped) {
+            dropped = edgeRing.Dropped();
+            self->decoder.Reset();
+            RF_METRIC(self->edgeCapture->metrics, resyncs.Add());
+            RF_TRACE(self->edgeCapture->trace, rx.Record(static_cast<uint32_t>(esp_timer_get_time()), RF_TRACE_RESYNC,
+                                                         self->edgeCapture->trace->channel, 0, dropped));
+        }
+        
+        while (edgeRing.Pop(edge)) {
+            if (self->decoder.ProcessEdge(edge.timestamp, edge.level, frame)) {
+                RF_METRIC(self->edgeCapture->metrics,
+                          decode_latency_us.Record(static_cast<uint32_t>(esp_timer_get_time()) - frame.timestamp));
+                // A full queue drops the new frame and counts it in getDroppedFrames()
+                self->frameQueue.Push(frame);
+                if (self->frameEventGroup != nullptr) {
+                    xEventGroupSetBits(self->frameEventGroup, self->frameEventBits);
+                }
+            } else if (self->decoder.RawFrameReady() && self->decoder.PopRawFrame(raw)) {
+                self->rawQueue.Push(raw);
+                if (self->frameEventGroup != nullptr) {
+                    xEventGroupSetBits(self->frameEventGroup, self->frameEventBits);
+                }
+            }
+        }
+        if (self->decoderStopping.load()) {
+            // Between edges, with nothing half pushed: disableReceive() deletes the task
+            xSemaphoreGive(self->decoderStopped);
+            vTaskSuspend(nullptr);
+        }
+    }
+}
+
+void RfRadioChannel::enableReceive(int interrupt) {
+    if (nReceiverInterrupt >= 0) {
+        disableReceive();
+    }
+    if (edgeCapture == nullptr) {
+        ESP_LOGE(TAG, "No internal RAM for the receive ISR state");
+        return;
+    }
+    nReceiverInterrupt = interrupt;
+    gpio_num_t pin = static_cast<gpio_num_t>(interrupt);
+    
+    gpio_config_t io_conf = {};
+    io_conf.pin_bit_mask = (1ULL << pin);
+    io_conf.mode = GPIO_MODE_INPUT;
+    io_conf.pull_up_en = GPIO_PULLUP_ENABLE;
+    io_conf.intr_type = GPIO_INTR_ANYEDGE;
+    gpio_config(&io_conf);
+    
+    edgeCapture->ring.Clear();
+    edgeCapture->pin = pin;
+    edgeCapture->lastTime = 0;
+    frameQueue.Clear();
+    rawQueue.Clear();
+    decoder.Reset();
+    
+    char task_name[configMAX_TASK_NAME_LEN];
+    snprintf(task_name, sizeof(task_name), "rf_rx_%d", interrupt);
+    decoderStopped = xSemaphoreCreateBinary();
+    decoderStopping.store(false);
+    if (decoderStopped == nullptr ||
+        xTaskCreate(decoderTask, task_name, CONFIG_RF_MODULE_DECODER_TASK_STACK, this,
+                    CONFIG_RF_MODULE_DECODER_TASK_PRIORITY, &decoderTaskHandle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create decoder task");
+        decoderTaskHandle = nullptr;
+        nReceiverInterrupt = -1;
+        disableReceive();
+        return;
+    }
+    edgeCapture->decoderTask = decoderTaskHandle;
+    
+    // IRAM service: edges are still timestamped while NVS or the signal log write flash
+    esp_err_t err = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+    if (err == ESP_OK) {
+        isr_service_installed = true;
+    } else if (err == ESP_ERR_INVALID_STATE && !isr_service_installed) {
+        ESP_LOGW(TAG, "GPIO ISR service already installed; edges during flash writes are lost unless it has ESP_INTR_FLAG_IRAM");
+    }
+    gpio_isr_handler_add(pin, handleInterrupt, edgeCapture);
+}
+
+void RfRadioChannel::disableReceive() {
+    if (nReceiverInterrupt >= 0) {
+        gpio_isr_handler_remove(static_cast<gpio_num_t>(nReceiverInterrupt));
+        nReceiverInterrupt = -1;
+    }
+    // The ISR is gone, so nothing but this notification wakes the task any more
+    if (decoderTaskHandle != nullptr) {
+        decoderStopping.store(true);
+        xTaskNotifyGive(decoderTaskHandle);
+        xSemaphoreTake(decoderStopped, portMAX_DELAY);
+        vTaskDelete(decoderTaskHandle);
+        decoderTaskHandle = nullptr;
+        edgeCapture->decoderTask = nullptr;
+    }
+    if (decoderStopped != nullptr) {
+        vSemaphoreDelete(decoderStopped);
+        decoderStopped = nullptr;
+    }
+}
+
+bool RfRadioChannel::available() {
+    return !frameQueue.Empty();
+}
+
+void RfRadioChannel::resetAvailable() {
+    RfDecodedFrame frame;
+    frameQueue.Pop(frame);
+}
+
+bool RfRadioChannel::popReceived(RfDecodedFrame& frame) {
+    return frameQueue.Pop(frame);
+}
+
+void RfRadioChannel::setFrameNotify(EventGroupHandle_t group, EventBits_t bits) {
+    frameEventGroup = group;
+    frameEventBits = bits;
+}
+
+uint64_t RfRadioChannel::getReceivedValue() {
+    const RfDecodedFrame* frame = frameQueue.Peek();
+    return frame ? frame->value : 0;
+}
+
+unsigned int RfRadioChannel::getReceivedBitlength() {
+    const RfDecodedFrame* frame = frameQueue.Peek();
+    return frame ? frame->bitlength : 0;
+}
+
+unsigned int RfRadioChannel::getReceivedDelay() {
+    const RfDecodedFrame* frame = frameQueue.Peek();
+    return frame ? frame->delay : 0;
+}
+
+unsigned int RfRadioChannel::getReceivedProtocol() {
+    const RfDecodedFrame* frame = frameQueue.Peek();
+    return frame ? frame->protocol : 0;
+}